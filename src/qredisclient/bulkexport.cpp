@@ -0,0 +1,241 @@
+#include "bulkexport.h"
+#include "connection.h"
+#include "private/dumpfile.h"
+
+namespace {
+const int WRITE_BUFFER_SIZE = 1024 * 1024;
+}
+
+RedisClient::BulkExport::Options::Options()
+    : pattern("*"), dbIndex(0), window(1000), progressInterval(250) {}
+
+RedisClient::BulkExport::Progress::Progress()
+    : scannedKeys(0),
+      exportedKeys(0),
+      skippedKeys(0),
+      errors(0),
+      bytesWritten(0),
+      elapsed(0) {}
+
+double RedisClient::BulkExport::Progress::rate() const {
+  return elapsed > 0 ? exportedKeys * 1000.0 / elapsed : 0.0;
+}
+
+RedisClient::BulkExport::BulkExport(Connection *connection,
+                                    const QString &path,
+                                    const Options &options, QObject *parent)
+    : QObject(parent),
+      m_connection(connection),
+      m_path(path),
+      m_options(options),
+      m_iterator(connection, iteratorOptions(options)),
+      m_running(false),
+      m_page(0),
+      m_pendingReplies(0),
+      m_finalPage(false),
+      m_lastProgress(0) {}
+
+bool RedisClient::BulkExport::start() {
+  if (m_running) return false;
+
+  if (!m_connection) {
+    m_error = QString("Cannot export keys: connection was removed");
+    return false;
+  }
+
+  m_file.setFileName(m_path);
+
+  if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    m_error =
+        QString("Cannot create file %1: %2").arg(m_path, m_file.errorString());
+    return false;
+  }
+
+  m_error.clear();
+  m_progress = Progress();
+  m_writeBuffer.clear();
+  m_writeBuffer.reserve(WRITE_BUFFER_SIZE + WRITE_BUFFER_SIZE / 4);
+  m_writeBuffer.append(DumpFile::MAGIC, DumpFile::MAGIC_SIZE);
+  m_iterator.reset();
+  m_running = true;
+  m_timer.start();
+  m_lastProgress = 0;
+
+  requestPage();
+  return true;
+}
+
+void RedisClient::BulkExport::cancel() {
+  if (!m_running) return;
+
+  finish(QString("Export was cancelled"));
+}
+
+bool RedisClient::BulkExport::isRunning() const { return m_running; }
+
+RedisClient::BulkExport::Progress RedisClient::BulkExport::progress() const {
+  Progress p = m_progress;
+
+  if (m_running) p.elapsed = m_timer.elapsed();
+
+  return p;
+}
+
+QString RedisClient::BulkExport::error() const { return m_error; }
+
+void RedisClient::BulkExport::requestPage() {
+  QPointer<BulkExport> self(this);
+
+  m_iterator.next([self](const KeyIterator::Page &keys, const QString &err,
+                         bool final) {
+    if (self) self->processPage(keys, err, final);
+  });
+}
+
+void RedisClient::BulkExport::processPage(const KeyIterator::Page &keys,
+                                          const QString &err, bool final) {
+  if (!m_running) return;
+
+  if (!err.isEmpty()) return finish(err);
+
+  m_page++;
+  m_keys = keys;
+  m_finalPage = final;
+  m_progress.scannedKeys += keys.size();
+
+  if (keys.isEmpty()) return writePage();
+
+  m_dumps.fill(QByteArray(), keys.size());
+  m_ttls.fill(-2, keys.size());
+  m_pendingReplies = keys.size() * 2;
+
+  QList<Command> commands;
+  commands.reserve(m_pendingReplies);
+
+  quint64 page = m_page;
+
+  for (int i = 0; i < keys.size(); ++i) {
+    commands.append(Command({"DUMP", keys.at(i)}, this,
+                            [this, page, i](const Response &r,
+                                            const QString &err) {
+                              processReply(page, i, true, r, err);
+                            },
+                            m_options.dbIndex));
+    commands.append(Command({"PTTL", keys.at(i)}, this,
+                            [this, page, i](const Response &r,
+                                            const QString &err) {
+                              processReply(page, i, false, r, err);
+                            },
+                            m_options.dbIndex));
+  }
+
+  try {
+    m_connection->runCommands(commands);
+  } catch (const Connection::Exception &e) {
+    finish(QString("Cannot export keys: %1").arg(e.what()));
+  }
+}
+
+void RedisClient::BulkExport::processReply(quint64 page, int index,
+                                           bool isDump, const Response &r,
+                                           const QString &err) {
+  if (!m_running || page != m_page) return;
+
+  if (!err.isEmpty() || r.isErrorMessage()) {
+    m_progress.errors++;
+    m_progress.lastError =
+        err.isEmpty() ? QString::fromUtf8(r.asBytes()) : err;
+  } else if (isDump) {
+    if (!r.isNil()) m_dumps[index] = r.asBytes();
+  } else {
+    m_ttls[index] = r.view().toInteger();
+  }
+
+  if (--m_pendingReplies == 0) writePage();
+}
+
+void RedisClient::BulkExport::writePage() {
+  for (int i = 0; i < m_dumps.size(); ++i) {
+    // -2 - key was removed, -1 - key without TTL
+    if (m_dumps.at(i).isEmpty() || m_ttls.at(i) == -2) {
+      m_progress.skippedKeys++;
+      continue;
+    }
+
+    DumpFile::appendRecord(m_writeBuffer, m_keys.at(i),
+                           qMax(Q_INT64_C(0), m_ttls.at(i)), m_dumps.at(i));
+    m_progress.exportedKeys++;
+  }
+
+  m_keys.clear();
+  m_dumps.clear();
+  m_ttls.clear();
+
+  if (!write(m_finalPage)) return;
+
+  if (m_finalPage) return finish(QString());
+
+  reportProgress(false);
+  requestPage();
+}
+
+bool RedisClient::BulkExport::write(bool force) {
+  if (m_writeBuffer.isEmpty() ||
+      (!force && m_writeBuffer.size() < WRITE_BUFFER_SIZE))
+    return true;
+
+  qint64 written = m_file.write(m_writeBuffer);
+
+  if (written != m_writeBuffer.size()) {
+    m_writeBuffer.clear();
+    finish(
+        QString("Cannot write file %1: %2").arg(m_path, m_file.errorString()));
+    return false;
+  }
+
+  m_progress.bytesWritten += written;
+  m_writeBuffer.resize(0);
+  return true;
+}
+
+void RedisClient::BulkExport::reportProgress(bool force) {
+  qint64 elapsed = m_timer.elapsed();
+
+  if (!force && elapsed - m_lastProgress < m_options.progressInterval) return;
+
+  m_lastProgress = elapsed;
+  m_progress.elapsed = elapsed;
+
+  emit progressChanged(m_progress);
+}
+
+void RedisClient::BulkExport::finish(const QString &err) {
+  m_running = false;
+  m_page++;
+
+  // Pages loaded so far are kept on cancel and errors
+  if (!m_writeBuffer.isEmpty() &&
+      m_file.write(m_writeBuffer) == m_writeBuffer.size())
+    m_progress.bytesWritten += m_writeBuffer.size();
+
+  m_writeBuffer.clear();
+  m_file.close();
+
+  m_error = err;
+  m_progress.elapsed = m_timer.elapsed();
+
+  emit progressChanged(m_progress);
+  emit finished(m_progress, err);
+}
+
+RedisClient::KeyIterator::Options RedisClient::BulkExport::iteratorOptions(
+    const Options &options) {
+  KeyIterator::Options result;
+  result.pattern = options.pattern;
+  result.type = options.type;
+  result.dbIndex = options.dbIndex;
+  result.maxCount = qMax(1u, options.window);
+  result.count = qMin(result.count, result.maxCount);
+  result.minCount = qMin(result.minCount, result.count);
+  return result;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+#include "exception.h"
+#include "keyiterator.h"
+#include "response.h"
+
+namespace RedisClient {
+
+class Connection;
+
+/**
+ * @brief The BulkExport class
+ * Dumps keys of a database into a binary file which can be loaded with
+ * BulkImport. Keys are streamed with SCAN, DUMP and PTTL of each page are
+ * pipelined and written through a buffered writer, so only one page of
+ * values is kept in memory. Keys removed during export are skipped.
+ */
+class BulkExport : public QObject {
+  Q_OBJECT
+  ADD_EXCEPTION
+
+ public:
+  struct Options {
+    Options();
+
+    QByteArray pattern;
+    QByteArray type;  // SCAN ... TYPE, requires redis-server >= 6.0
+    int dbIndex;
+    uint window;            // max keys per page, values of page are in flight
+    uint progressInterval;  // in ms
+  };
+
+  struct Progress {
+    Progress();
+
+    quint64 scannedKeys;
+    quint64 exportedKeys;
+    quint64 skippedKeys;  // removed after SCAN
+    quint64 errors;
+    qint64 bytesWritten;
+    qint64 elapsed;  // in ms
+    QString lastError;
+
+    /**
+     * @brief Exported keys per second
+     */
+    double rate() const;
+  };
+
+ public:
+  BulkExport(Connection *connection, const QString &path,
+             const Options &options = Options(), QObject *parent = nullptr);
+
+  /**
+   * @brief Create file and start SCAN.
+   * finished() is emitted when the last page is written.
+   * @return false if file cannot be created, see error()
+   */
+  bool start();
+
+  /**
+   * @brief Stop export, file contains all pages written so far
+   */
+  void cancel();
+
+  bool isRunning() const;
+  Progress progress() const;
+  QString error() const;
+
+ signals:
+  void progressChanged(const RedisClient::BulkExport::Progress &progress);
+  void finished(const RedisClient::BulkExport::Progress &progress,
+                const QString &err);
+
+ private:
+  void requestPage();
+  void processPage(const KeyIterator::Page &keys, const QString &err,
+                   bool final);
+  void processReply(quint64 page, int index, bool isDump, const Response &r,
+                    const QString &err);
+  void writePage();
+  bool write(bool force);
+  void reportProgress(bool force);
+  void finish(const QString &err);
+
+  static KeyIterator::Options iteratorOptions(const Options &options);
+
+ private:
+  QPointer<Connection> m_connection;
+  QString m_path;
+  Options m_options;
+  KeyIterator m_iterator;
+  QFile m_file;
+  QByteArray m_writeBuffer;
+  bool m_running;
+
+  // Page which is loaded with DUMP and PTTL
+  quint64 m_page;
+  KeyIterator::Page m_keys;
+  QVector<QByteArray> m_dumps;
+  QVector<qint64> m_ttls;
+  int m_pendingReplies;
+  bool m_finalPage;
+
+  Progress m_progress;
+  QString m_error;
+  QElapsedTimer m_timer;
+  qint64 m_lastProgress;
+};
+
+}  // namespace RedisClient
+
+Q_DECLARE_METATYPE(RedisClient::BulkExport::Progress)
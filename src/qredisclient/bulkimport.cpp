@@ -0,0 +1,336 @@
+#include "bulkimport.h"
+#include "connection.h"
+#include "private/dumpfile.h"
+
+namespace {
+const int READ_CHUNK_SIZE = 1024 * 1024;
+
+// RESP headers are short, longer line without CRLF is a syntax error
+const int MAX_HEADER_SIZE = 32;
+
+/*
+ * Parse "<prefix><integer>\r\n" at pos.
+ * Returns position after the line, 0 if the line is incomplete
+ * or -1 on syntax error.
+ */
+int parseHeader(const QByteArray &buffer, int pos, char prefix, int &value) {
+  if (pos >= buffer.size()) return 0;
+
+  if (buffer.at(pos) != prefix) return -1;
+
+  int end = buffer.indexOf("\r\n", pos);
+
+  if (end < 0) return buffer.size() - pos > MAX_HEADER_SIZE ? -1 : 0;
+
+  bool ok = false;
+  value = QByteArray::fromRawData(buffer.constData() + pos + 1, end - pos - 1)
+              .toInt(&ok);
+
+  return (ok && value >= 0) ? end + 2 : -1;
+}
+}  // namespace
+
+RedisClient::BulkImport::Options::Options()
+    : format(Format::Auto),
+      dbIndex(-1),
+      window(1000),
+      progressInterval(250),
+      replace(false) {}
+
+RedisClient::BulkImport::Progress::Progress()
+    : commands(0),
+      replies(0),
+      errors(0),
+      bytesRead(0),
+      totalBytes(0),
+      elapsed(0) {}
+
+double RedisClient::BulkImport::Progress::rate() const {
+  return elapsed > 0 ? replies * 1000.0 / elapsed : 0.0;
+}
+
+RedisClient::BulkImport::BulkImport(Connection *connection,
+                                    const QString &path,
+                                    const Options &options, QObject *parent)
+    : QObject(parent),
+      m_connection(connection),
+      m_path(path),
+      m_options(options),
+      m_format(options.format),
+      m_bufferPos(0),
+      m_eof(false),
+      m_running(false),
+      m_filling(false),
+      m_inFlight(0),
+      m_lastProgress(0) {
+  if (m_options.window == 0) m_options.window = 1;
+}
+
+bool RedisClient::BulkImport::start() {
+  if (m_running) return false;
+
+  m_file.setFileName(m_path);
+
+  if (!m_connection) {
+    m_error = QString("Cannot import file: connection was removed");
+    return false;
+  }
+
+  if (!m_file.open(QIODevice::ReadOnly)) {
+    m_error =
+        QString("Cannot open file %1: %2").arg(m_path, m_file.errorString());
+    return false;
+  }
+
+  m_buffer = m_file.read(READ_CHUNK_SIZE);
+  m_bufferPos = 0;
+  m_eof = m_file.atEnd();
+  m_inFlight = 0;
+  m_error.clear();
+  m_progress = Progress();
+  m_progress.bytesRead = m_buffer.size();
+  m_progress.totalBytes = m_file.size();
+
+  if (m_format == Format::Auto) {
+    if (DumpFile::hasMagic(m_buffer))
+      m_format = Format::Dump;
+    else if (m_buffer.startsWith('*'))
+      m_format = Format::Resp;
+    else
+      m_format = Format::Inline;
+  }
+
+  if (m_format == Format::Dump) {
+    if (!DumpFile::hasMagic(m_buffer)) {
+      m_error =
+          QString("Cannot import file %1: invalid dump header").arg(m_path);
+      m_file.close();
+      return false;
+    }
+
+    m_bufferPos = DumpFile::MAGIC_SIZE;
+  }
+
+  m_running = true;
+  m_timer.start();
+  m_lastProgress = 0;
+
+  fill();
+  return true;
+}
+
+void RedisClient::BulkImport::cancel() {
+  if (!m_running) return;
+
+  finish(QString("Import was cancelled"));
+}
+
+bool RedisClient::BulkImport::isRunning() const { return m_running; }
+
+RedisClient::BulkImport::Progress RedisClient::BulkImport::progress() const {
+  Progress p = m_progress;
+
+  if (m_running) p.elapsed = m_timer.elapsed();
+
+  return p;
+}
+
+QString RedisClient::BulkImport::error() const { return m_error; }
+
+void RedisClient::BulkImport::fill() {
+  if (!m_running || m_filling) return;
+
+  m_filling = true;
+
+  bool hasMore = true;
+  QList<QByteArray> args;
+
+  while (m_running && hasMore && m_inFlight < m_options.window) {
+    QList<Command> batch;
+
+    while (m_inFlight + batch.size() < m_options.window &&
+           (hasMore = readCommand(args))) {
+      batch.append(Command(args, this,
+                           [this](const Response &r, const QString &err) {
+                             processReply(r, err);
+                           },
+                           m_options.dbIndex));
+    }
+
+    if (batch.isEmpty()) break;
+
+    m_inFlight += batch.size();
+    m_progress.commands += batch.size();
+
+    try {
+      m_connection->runCommands(batch);
+    } catch (const Connection::Exception &e) {
+      m_inFlight -= batch.size();
+      m_filling = false;
+      return finish(QString("Cannot import commands: %1").arg(e.what()));
+    }
+  }
+
+  m_filling = false;
+
+  if (m_running && !hasMore && m_inFlight == 0) finish(m_error);
+}
+
+bool RedisClient::BulkImport::readCommand(QList<QByteArray> &args) {
+  if (!m_error.isEmpty()) return false;
+
+  while (true) {
+    if (m_eof && m_bufferPos >= m_buffer.size()) return false;
+
+    ReadResult result = parseCommand(args);
+
+    if (result == ReadResult::Command) return true;
+
+    // Only empty lines are left
+    if (m_eof && m_bufferPos >= m_buffer.size()) return false;
+
+    if (result == ReadResult::Error || m_eof) {
+      qint64 offset = m_progress.bytesRead - (m_buffer.size() - m_bufferPos);
+
+      m_error = result == ReadResult::Error
+                    ? QString("Invalid command at offset %1").arg(offset)
+                    : QString("Unexpected end of file at offset %1")
+                          .arg(offset);
+      return false;
+    }
+
+    // Keep only unparsed tail of buffer
+    m_buffer.remove(0, m_bufferPos);
+    m_bufferPos = 0;
+
+    QByteArray chunk = m_file.read(READ_CHUNK_SIZE);
+    m_progress.bytesRead += chunk.size();
+    m_buffer.append(chunk);
+    m_eof = chunk.isEmpty() || m_file.atEnd();
+  }
+}
+
+RedisClient::BulkImport::ReadResult RedisClient::BulkImport::parseCommand(
+    QList<QByteArray> &args) {
+  switch (m_format) {
+    case Format::Resp:
+      return parseResp(args);
+    case Format::Dump:
+      return parseDump(args);
+    default:
+      return parseInline(args);
+  }
+}
+
+RedisClient::BulkImport::ReadResult RedisClient::BulkImport::parseResp(
+    QList<QByteArray> &args) {
+  int count = 0;
+  int pos = parseHeader(m_buffer, m_bufferPos, '*', count);
+
+  if (pos <= 0) return pos < 0 ? ReadResult::Error : ReadResult::NeedMoreData;
+
+  if (count == 0) return ReadResult::Error;
+
+  args.clear();
+  args.reserve(count);
+
+  for (int i = 0; i < count; ++i) {
+    int size = 0;
+    pos = parseHeader(m_buffer, pos, '$', size);
+
+    if (pos <= 0)
+      return pos < 0 ? ReadResult::Error : ReadResult::NeedMoreData;
+
+    if (m_buffer.size() - pos < size + 2) return ReadResult::NeedMoreData;
+
+    args.append(m_buffer.mid(pos, size));
+    pos += size + 2;
+  }
+
+  m_bufferPos = pos;
+  return ReadResult::Command;
+}
+
+RedisClient::BulkImport::ReadResult RedisClient::BulkImport::parseInline(
+    QList<QByteArray> &args) {
+  while (m_bufferPos < m_buffer.size()) {
+    int end = m_buffer.indexOf('\n', m_bufferPos);
+
+    if (end < 0 && !m_eof) return ReadResult::NeedMoreData;
+
+    if (end < 0) end = m_buffer.size();
+
+    QByteArray line = m_buffer.mid(m_bufferPos, end - m_bufferPos);
+    m_bufferPos = end + 1;
+
+    if (line.endsWith('\r')) line.chop(1);
+
+    args = Command::splitCommandString(QString::fromUtf8(line));
+
+    if (!args.isEmpty()) return ReadResult::Command;
+  }
+
+  return ReadResult::NeedMoreData;
+}
+
+RedisClient::BulkImport::ReadResult RedisClient::BulkImport::parseDump(
+    QList<QByteArray> &args) {
+  QByteArray key;
+  QByteArray dump;
+  qint64 pttl = 0;
+
+  int size = DumpFile::readRecord(m_buffer, m_bufferPos, key, pttl, dump);
+
+  if (size == 0) return ReadResult::NeedMoreData;
+
+  m_bufferPos += size;
+
+  args.clear();
+  args << "RESTORE" << key << QByteArray::number(qMax(Q_INT64_C(0), pttl))
+       << dump;
+
+  if (m_options.replace) args << "REPLACE";
+
+  return ReadResult::Command;
+}
+
+void RedisClient::BulkImport::processReply(const Response &r,
+                                           const QString &err) {
+  if (!m_running) return;
+
+  m_inFlight--;
+  m_progress.replies++;
+
+  if (!err.isEmpty() || r.isErrorMessage()) {
+    m_progress.errors++;
+    m_progress.lastError =
+        err.isEmpty() ? QString::fromUtf8(r.asBytes()) : err;
+  }
+
+  reportProgress(false);
+
+  if (m_inFlight <= m_options.window / 2) fill();
+}
+
+void RedisClient::BulkImport::reportProgress(bool force) {
+  qint64 elapsed = m_timer.elapsed();
+
+  if (!force && elapsed - m_lastProgress < m_options.progressInterval) return;
+
+  m_lastProgress = elapsed;
+  m_progress.elapsed = elapsed;
+
+  emit progressChanged(m_progress);
+}
+
+void RedisClient::BulkImport::finish(const QString &err) {
+  m_running = false;
+  m_error = err;
+  m_progress.elapsed = m_timer.elapsed();
+  m_file.close();
+  m_buffer.clear();
+  m_bufferPos = 0;
+
+  emit progressChanged(m_progress);
+  emit finished(m_progress, err);
+}
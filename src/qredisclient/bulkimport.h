@@ -0,0 +1,119 @@
+#pragma once
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include "exception.h"
+#include "response.h"
+
+namespace RedisClient {
+
+class Connection;
+
+/**
+ * @brief The BulkImport class
+ * Mass insertion of commands from a file. Commands are read page by page
+ * and pipelined to the transporter with at most Options::window commands
+ * in flight, so memory usage doesn't depend on file size. Replies are only
+ * counted, errors don't interrupt import.
+ *
+ * Supported formats:
+ * Resp - RESP arrays of bulk strings (input of redis-cli --pipe),
+ * Inline - one command per line as typed in redis-cli,
+ * Dump - file written by BulkExport, keys are restored with RESTORE.
+ */
+class BulkImport : public QObject {
+  Q_OBJECT
+  ADD_EXCEPTION
+
+ public:
+  enum class Format { Auto = 0, Resp = 1, Inline = 2, Dump = 3 };
+
+  struct Options {
+    Options();
+
+    Format format;
+    int dbIndex;
+    uint window;            // max commands in flight
+    uint progressInterval;  // in ms
+    bool replace;           // RESTORE ... REPLACE for Dump files
+  };
+
+  struct Progress {
+    Progress();
+
+    quint64 commands;  // sent to redis-server
+    quint64 replies;
+    quint64 errors;
+    qint64 bytesRead;
+    qint64 totalBytes;
+    qint64 elapsed;  // in ms
+    QString lastError;
+
+    /**
+     * @brief Commands per second
+     */
+    double rate() const;
+  };
+
+ public:
+  BulkImport(Connection *connection, const QString &path,
+             const Options &options = Options(), QObject *parent = nullptr);
+
+  /**
+   * @brief Open file and send first window of commands.
+   * finished() is emitted when all replies are received.
+   * @return false if file cannot be read, see error()
+   */
+  bool start();
+
+  /**
+   * @brief Stop reading file, replies of sent commands are ignored
+   */
+  void cancel();
+
+  bool isRunning() const;
+  Progress progress() const;
+  QString error() const;
+
+ signals:
+  void progressChanged(const RedisClient::BulkImport::Progress &progress);
+  void finished(const RedisClient::BulkImport::Progress &progress,
+                const QString &err);
+
+ private:
+  enum class ReadResult { Command, NeedMoreData, Error };
+
+  void fill();
+  bool readCommand(QList<QByteArray> &args);
+  ReadResult parseCommand(QList<QByteArray> &args);
+  ReadResult parseResp(QList<QByteArray> &args);
+  ReadResult parseInline(QList<QByteArray> &args);
+  ReadResult parseDump(QList<QByteArray> &args);
+  void processReply(const Response &r, const QString &err);
+  void reportProgress(bool force);
+  void finish(const QString &err);
+
+ private:
+  QPointer<Connection> m_connection;
+  QString m_path;
+  Options m_options;
+  Format m_format;
+  QFile m_file;
+  QByteArray m_buffer;
+  int m_bufferPos;
+  bool m_eof;
+  bool m_running;
+  bool m_filling;
+  uint m_inFlight;
+  Progress m_progress;
+  QString m_error;
+  QElapsedTimer m_timer;
+  qint64 m_lastProgress;
+};
+
+}  // namespace RedisClient
+
+Q_DECLARE_METATYPE(RedisClient::BulkImport::Progress)
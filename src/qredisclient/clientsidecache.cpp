@@ -0,0 +1,157 @@
+#include "clientsidecache.h"
+#include <QMutexLocker>
+
+namespace {
+// Approximate overhead of hash entries and LRU list nodes
+const qint64 ENTRY_OVERHEAD = 128;
+}  // namespace
+
+RedisClient::ClientSideCache::ClientSideCache(qint64 maxMemory)
+    : m_maxMemory(maxMemory),
+      m_memoryUsage(0),
+      m_hits(0),
+      m_misses(0),
+      m_evictions(0),
+      m_invalidations(0) {}
+
+bool RedisClient::ClientSideCache::isCacheable(const Command &cmd) {
+  if (cmd.length() < 2 || cmd.isPipelineCommand() || cmd.getCallBack() ||
+      cmd.getStreamCallback())
+    return false;
+
+  return cmd.info().is(CommandInfo::Cacheable);
+}
+
+bool RedisClient::ClientSideCache::lookup(const Command &cmd, int db,
+                                          Response &result) {
+  QByteArray key = cacheKey(cmd, db);
+  QMutexLocker lock(&m_lock);
+
+  auto entry = m_entries.find(key);
+
+  if (entry == m_entries.end()) {
+    m_misses++;
+    return false;
+  }
+
+  m_lru.splice(m_lru.begin(), m_lru, entry->lruPosition);
+  m_hits++;
+  result = entry->response;
+  return true;
+}
+
+void RedisClient::ClientSideCache::store(const Command &cmd, int db,
+                                         const Response &response) {
+  QByteArray key = cacheKey(cmd, db);
+  QList<QByteArray> keys = keysOf(cmd);
+
+  qint64 size = key.size() + response.approximateSize() + ENTRY_OVERHEAD;
+  for (const QByteArray &k : keys) size += k.size();
+
+  if (size > m_maxMemory) return;
+
+  QMutexLocker lock(&m_lock);
+
+  remove(key);
+
+  m_lru.push_front(key);
+
+  Entry entry{response, keys, size, m_lru.begin()};
+  m_entries.insert(key, entry);
+  m_memoryUsage += size;
+
+  for (const QByteArray &k : keys) m_keyIndex[k].insert(key);
+
+  evict();
+}
+
+void RedisClient::ClientSideCache::invalidate(const QList<QByteArray> &keys) {
+  QMutexLocker lock(&m_lock);
+
+  for (const QByteArray &k : keys) {
+    auto dependent = m_keyIndex.find(k);
+
+    if (dependent == m_keyIndex.end()) continue;
+
+    // remove() modifies index
+    QSet<QByteArray> cacheKeys = dependent.value();
+
+    for (const QByteArray &cacheKey : cacheKeys) {
+      remove(cacheKey);
+      m_invalidations++;
+    }
+  }
+}
+
+void RedisClient::ClientSideCache::clear() {
+  QMutexLocker lock(&m_lock);
+
+  m_invalidations += m_entries.size();
+  m_entries.clear();
+  m_keyIndex.clear();
+  m_lru.clear();
+  m_memoryUsage = 0;
+}
+
+qint64 RedisClient::ClientSideCache::maxMemory() const { return m_maxMemory; }
+
+RedisClient::ClientSideCache::Stats RedisClient::ClientSideCache::stats()
+    const {
+  QMutexLocker lock(&m_lock);
+
+  Stats s;
+  s.hits = m_hits;
+  s.misses = m_misses;
+  s.evictions = m_evictions;
+  s.invalidations = m_invalidations;
+  s.memoryUsage = m_memoryUsage;
+  s.entries = m_entries.size();
+  return s;
+}
+
+QByteArray RedisClient::ClientSideCache::cacheKey(const Command &cmd,
+                                                  int db) {
+  QList<QByteArray> args = cmd.getSplitedRepresentattion();
+  args[0] = cmd.info().isKnown() ? QByteArray(cmd.info().name)
+                                  : args[0].toLower();
+
+  // Length-prefixed args to keep keys with binary data unambiguous
+  QByteArray key = QByteArray::number(db);
+
+  for (const QByteArray &arg : args) {
+    key.append(' ').append(QByteArray::number(arg.size()));
+    key.append(':').append(arg);
+  }
+
+  return key;
+}
+
+QList<QByteArray> RedisClient::ClientSideCache::keysOf(const Command &cmd) {
+  return cmd.keys();
+}
+
+void RedisClient::ClientSideCache::remove(const QByteArray &cacheKey) {
+  auto entry = m_entries.find(cacheKey);
+
+  if (entry == m_entries.end()) return;
+
+  for (const QByteArray &k : entry->keys) {
+    auto dependent = m_keyIndex.find(k);
+    if (dependent == m_keyIndex.end()) continue;
+
+    dependent->remove(cacheKey);
+    if (dependent->isEmpty()) m_keyIndex.erase(dependent);
+  }
+
+  m_memoryUsage -= entry->size;
+  m_lru.erase(entry->lruPosition);
+  m_entries.erase(entry);
+}
+
+void RedisClient::ClientSideCache::evict() {
+  while (m_memoryUsage > m_maxMemory && !m_lru.empty()) {
+    QByteArray leastRecentlyUsed = m_lru.back();
+    remove(leastRecentlyUsed);
+    m_evictions++;
+  }
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <list>
+#include "command.h"
+#include "response.h"
+
+namespace RedisClient {
+
+/**
+ * @brief The ClientSideCache class
+ * LRU cache of read-only command replies kept coherent by
+ * redis-server CLIENT TRACKING invalidation messages.
+ * Cache is thread-safe: lookups are done in caller thread and
+ * replies/invalidations are stored from transporter thread.
+ */
+class ClientSideCache {
+ public:
+  struct Stats {
+    quint64 hits;
+    quint64 misses;
+    quint64 evictions;
+    quint64 invalidations;
+    qint64 memoryUsage;
+    int entries;
+  };
+
+ public:
+  /**
+   * @brief ClientSideCache
+   * @param maxMemory - approximate memory limit in bytes
+   */
+  ClientSideCache(qint64 maxMemory);
+
+  /**
+   * @brief Check if reply of the command can be cached
+   * (read-only command without callbacks, streaming or pipelining)
+   */
+  static bool isCacheable(const Command& cmd);
+
+  /**
+   * @brief Find cached reply
+   * @param cmd
+   * @param db - Database index where command is executed
+   * @param result - cached reply
+   * @return true on cache hit
+   */
+  bool lookup(const Command& cmd, int db, Response& result);
+
+  void store(const Command& cmd, int db, const Response& response);
+
+  /**
+   * @brief Remove replies which depend on specified keys
+   */
+  void invalidate(const QList<QByteArray>& keys);
+  void clear();
+
+  qint64 maxMemory() const;
+  Stats stats() const;
+
+ private:
+  struct Entry {
+    Response response;
+    QList<QByteArray> keys;
+    qint64 size;
+    std::list<QByteArray>::iterator lruPosition;
+  };
+
+  static QByteArray cacheKey(const Command& cmd, int db);
+  static QList<QByteArray> keysOf(const Command& cmd);
+  void remove(const QByteArray& cacheKey);
+  void evict();
+
+ private:
+  mutable QMutex m_lock;
+  qint64 m_maxMemory;
+  qint64 m_memoryUsage;
+  QHash<QByteArray, Entry> m_entries;
+  QHash<QByteArray, QSet<QByteArray>> m_keyIndex;
+  std::list<QByteArray> m_lru;  // most recently used first
+
+  quint64 m_hits;
+  quint64 m_misses;
+  quint64 m_evictions;
+  quint64 m_invalidations;
+};
+
+}  // namespace RedisClient
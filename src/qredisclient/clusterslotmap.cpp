@@ -0,0 +1,158 @@
+#include "clusterslotmap.h"
+#include <QReadLocker>
+#include <QWriteLocker>
+
+namespace {
+// CRC16-CCITT (XMODEM) as specified in Redis Cluster specification
+const quint16 *crc16Table() {
+  static quint16 table[256];
+  static bool initialized = false;
+
+  if (!initialized) {
+    for (int i = 0; i < 256; ++i) {
+      quint16 crc = static_cast<quint16>(i << 8);
+      for (int bit = 0; bit < 8; ++bit)
+        crc = (crc & 0x8000) ? static_cast<quint16>((crc << 1) ^ 0x1021)
+                             : static_cast<quint16>(crc << 1);
+      table[i] = crc;
+    }
+    initialized = true;
+  }
+  return table;
+}
+
+// Initialize table before any thread can use it
+const quint16 *const CRC16_TABLE = crc16Table();
+
+quint16 crc16(const char *buf, int len) {
+  quint16 crc = 0;
+  for (int i = 0; i < len; ++i)
+    crc = static_cast<quint16>(
+        (crc << 8) ^ CRC16_TABLE[((crc >> 8) ^ static_cast<uchar>(buf[i])) &
+                                 0xFF]);
+  return crc;
+}
+
+}  // namespace
+
+RedisClient::ClusterSlotMap::ClusterSlotMap() : m_slots(SLOTS_COUNT, -1) {}
+
+int RedisClient::ClusterSlotMap::keySlot(const QByteArray &key) {
+  int start = key.indexOf('{');
+
+  if (start >= 0) {
+    int end = key.indexOf('}', start + 1);
+
+    // Hash only tag content if it's not empty
+    if (end > start + 1)
+      return crc16(key.constData() + start + 1, end - start - 1) &
+             (SLOTS_COUNT - 1);
+  }
+
+  return crc16(key.constData(), key.size()) & (SLOTS_COUNT - 1);
+}
+
+int RedisClient::ClusterSlotMap::commandSlot(const Command &cmd) {
+  if (cmd.length() < 2 || cmd.isPipelineCommand()) return -1;
+
+  const QList<QByteArray> &args = cmd.getSplitedRepresentattion();
+  int index = cmd.info().firstKeyIndex(args);
+
+  return index < 0 ? -1 : keySlot(args.at(index));
+}
+
+bool RedisClient::ClusterSlotMap::load(const Response &clusterSlots) {
+  if (!clusterSlots.isArray()) return false;
+
+  QWriteLocker lock(&m_lock);
+
+  m_slots.fill(-1);
+  m_nodes.clear();
+  m_replicas.clear();
+
+  // 1) 1) start slot 2) end slot 3) 1) master host 2) master port ...
+  // 4) 1) replica host 2) replica port ...
+  for (int i = 0; i < clusterSlots.arraySize(); ++i) {
+    ResponseView range = clusterSlots.at(i);
+
+    if (range.arraySize() < 3 || range.at(2).arraySize() < 2) continue;
+
+    int start = static_cast<int>(range.at(0).toInteger());
+    int end = static_cast<int>(range.at(1).toInteger());
+
+    Host master{QString::fromUtf8(range.at(2).at(0).asBytes()),
+                static_cast<int>(range.at(2).at(1).toInteger())};
+
+    qint16 index = static_cast<qint16>(nodeIndex(master));
+
+    QList<Host> replicas;
+
+    for (int r = 3; r < range.arraySize(); ++r) {
+      if (range.at(r).arraySize() < 2) continue;
+
+      replicas.append(Host{QString::fromUtf8(range.at(r).at(0).asBytes()),
+                           static_cast<int>(range.at(r).at(1).toInteger())});
+    }
+
+    m_replicas.insert(index, replicas);
+
+    for (int slot = qMax(0, start); slot <= end && slot < SLOTS_COUNT; ++slot)
+      m_slots[slot] = index;
+  }
+
+  return true;
+}
+
+void RedisClient::ClusterSlotMap::clear() {
+  QWriteLocker lock(&m_lock);
+  m_slots.fill(-1);
+  m_nodes.clear();
+  m_replicas.clear();
+}
+
+bool RedisClient::ClusterSlotMap::isEmpty() const {
+  QReadLocker lock(&m_lock);
+  return m_nodes.isEmpty();
+}
+
+RedisClient::ClusterSlotMap::Host RedisClient::ClusterSlotMap::nodeForSlot(
+    int slot) const {
+  if (slot < 0 || slot >= SLOTS_COUNT) return Host();
+
+  QReadLocker lock(&m_lock);
+
+  int index = m_slots.at(slot);
+
+  return index >= 0 ? m_nodes.at(index) : Host();
+}
+
+void RedisClient::ClusterSlotMap::setNodeForSlot(int slot, const Host &node) {
+  if (slot < 0 || slot >= SLOTS_COUNT) return;
+
+  QWriteLocker lock(&m_lock);
+  m_slots[slot] = static_cast<qint16>(nodeIndex(node));
+}
+
+QList<RedisClient::ClusterSlotMap::Host>
+RedisClient::ClusterSlotMap::replicasForSlot(int slot) const {
+  if (slot < 0 || slot >= SLOTS_COUNT) return QList<Host>();
+
+  QReadLocker lock(&m_lock);
+
+  return m_replicas.value(m_slots.at(slot));
+}
+
+QList<RedisClient::ClusterSlotMap::Host> RedisClient::ClusterSlotMap::masters()
+    const {
+  QReadLocker lock(&m_lock);
+  return m_nodes;
+}
+
+int RedisClient::ClusterSlotMap::nodeIndex(const Host &node) {
+  int index = m_nodes.indexOf(node);
+
+  if (index >= 0) return index;
+
+  m_nodes.append(node);
+  return m_nodes.size() - 1;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+#include "command.h"
+#include "response.h"
+
+namespace RedisClient {
+
+/**
+ * @brief The ClusterSlotMap class
+ * Maps cluster hash slots to master nodes and their replicas.
+ * Map is loaded from CLUSTER SLOTS reply and updated in place
+ * on MOVED redirects. Thread-safe.
+ */
+class ClusterSlotMap {
+ public:
+  typedef QPair<QString, int> Host;
+
+  static const int SLOTS_COUNT = 16384;
+
+ public:
+  ClusterSlotMap();
+
+  /**
+   * @brief CRC16 hash slot of the key with support of {hash tags}
+   */
+  static int keySlot(const QByteArray& key);
+
+  /**
+   * @brief Hash slot of the first key of the command
+   * @return -1 if command doesn't have keys
+   */
+  static int commandSlot(const Command& cmd);
+
+  /**
+   * @brief Load map from CLUSTER SLOTS reply
+   * @return false if reply is not valid
+   */
+  bool load(const Response& clusterSlots);
+  void clear();
+  bool isEmpty() const;
+
+  /**
+   * @brief Master node which serves slot
+   * @return Host with empty name if slot is not covered
+   */
+  Host nodeForSlot(int slot) const;
+  void setNodeForSlot(int slot, const Host& node);
+
+  /**
+   * @brief Replicas of master node which serves slot
+   */
+  QList<Host> replicasForSlot(int slot) const;
+
+  /**
+   * @brief Unique master nodes in order of slot ranges
+   */
+  QList<Host> masters() const;
+
+ private:
+  int nodeIndex(const Host& node);
+
+ private:
+  mutable QReadWriteLock m_lock;
+  QVector<qint16> m_slots;  // index in m_nodes or -1
+  QList<Host> m_nodes;
+  QHash<int, QList<Host>> m_replicas;  // by index of master in m_nodes
+};
+
+}  // namespace RedisClient
@@ -1,55 +1,157 @@
 #include "command.h"
 #include <QSet>
+#include <QThread>
+#include <cstring>
 #include "qredisclient/utils/compat.h"
 #include "qredisclient/utils/text.h"
 
+namespace {
 
-RedisClient::Command::Command()
-    : m_owner(nullptr), m_commandWithArguments(), m_dbIndex(-1),
-      m_hiPriorityCommand(false), m_isPipeline(false)
+inline int decimalLength(int value) {
+  int length = 1;
+  while (value >= 10) {
+    value /= 10;
+    ++length;
+  }
+  return length;
+}
+
+inline char* writeHeader(char* out, char prefix, int value) {
+  *out++ = prefix;
+
+  int length = decimalLength(value);
+  char* end = out + length;
+
+  do {
+    *--end = '0' + (value % 10);
+    value /= 10;
+  } while (value > 0);
+
+  out += length;
+  *out++ = '\r';
+  *out++ = '\n';
+  return out;
+}
+
+inline void appendHeader(QByteArray& buffer, char prefix, int value) {
+  char header[16];
+  char* end = writeHeader(header, prefix, value);
+  buffer.append(header, end - header);
+}
+
+// Index of server-side timeout argument, -1 if command doesn't block
+int blockingTimeoutIndex(const RedisClient::CommandInfo& info,
+                         const QList<QByteArray>& args, bool& inMsecs) {
+  using RedisClient::CommandInfo;
+
+  inMsecs = false;
+
+  if (args.size() < 3 || !info.is(CommandInfo::Blocking)) return -1;
+
+  const char* name = info.name;
+
+  if (strcmp(name, "blmpop") == 0 || strcmp(name, "bzmpop") == 0) return 1;
+
+  if (strcmp(name, "wait") == 0) {
+    inMsecs = true;
+    return 2;
+  }
+
+  if (strcmp(name, "xread") != 0 && strcmp(name, "xreadgroup") != 0)
+    return args.size() - 1;
+
+  inMsecs = true;
+
+  for (int i = 1; i < args.size() - 1; ++i) {
+    const QByteArray& option = args.at(i);
+
+    if (CommandInfo::nameEquals(option, "streams")) break;
+
+    if (CommandInfo::nameEquals(option, "block")) return i + 1;
+
+    // Skip values which can look like options
+    if (CommandInfo::nameEquals(option, "group"))
+      i += 2;
+    else if (CommandInfo::nameEquals(option, "count"))
+      ++i;
+  }
+
+  return -1;
+}
+
+}  // namespace
+
+
+RedisClient::Command::Command() : m_data(new Data())
 {
 }
 
 RedisClient::Command::Command(const QList<QByteArray> &cmd, int db)
-    : m_owner(nullptr), m_commandWithArguments(cmd), m_dbIndex(db),
-      m_hiPriorityCommand(false), m_isPipeline(false)
+    : m_data(new Data())
 {
+  m_data->m_commandWithArguments = cmd;
+  m_data->m_dbIndex = db;
+
+  if (!cmd.isEmpty()) m_data->m_info = &CommandInfo::lookup(cmd.first());
 }
 
 RedisClient::Command::Command(const QList<QByteArray> &cmd, QObject *context,
                               Callback callback, int db)
-    : m_owner(context), m_commandWithArguments(cmd), m_dbIndex(db),
-      m_hiPriorityCommand(false), m_isPipeline(false), m_callback(callback)
+    : m_data(new Data())
 {
+  setOwner(context);
+  m_data->m_commandWithArguments = cmd;
+  m_data->m_dbIndex = db;
+
+  if (!cmd.isEmpty()) m_data->m_info = &CommandInfo::lookup(cmd.first());
+
+  m_data->m_callback = callback;
 }
 
 RedisClient::Command::~Command() {}
 
 RedisClient::Command &RedisClient::Command::append(const QByteArray &part) {
-  if (!m_isPipeline)
-    m_commandWithArguments.append(part);
-  else
-    m_pipelineCommands.last().append(part);
+  if (!m_data->m_isPipeline) {
+    m_data->m_commandWithArguments.append(part);
+
+    if (m_data->m_commandWithArguments.size() == 1)
+      m_data->m_info = &CommandInfo::lookup(part);
+  } else
+    m_data->m_pipelineCommands.last().append(part);
   return *this;
 }
 
 RedisClient::Command &RedisClient::Command::addToPipeline(const QList<QByteArray> cmd) {
-  if(!m_isPipeline) {
+  if(!m_data->m_isPipeline) {
     // Convert and use existing command arguments if there any
     if (!isEmpty())
-      m_pipelineCommands.append(m_commandWithArguments);
-    m_isPipeline = true;
+      m_data->m_pipelineCommands.append(m_data->m_commandWithArguments);
+    m_data->m_isPipeline = true;
   }
-  m_pipelineCommands.append(cmd);
+  m_data->m_pipelineCommands.append(cmd);
   return *this;
 }
 
 int RedisClient::Command::length() const
 {
-  if (!m_isPipeline)
-    return m_commandWithArguments.length();
+  if (!m_data->m_isPipeline)
+    return m_data->m_commandWithArguments.length();
   else
-    return m_pipelineCommands.length();
+    return m_data->m_pipelineCommands.length();
+}
+
+qint64 RedisClient::Command::payloadSize() const
+{
+  qint64 size = 0;
+
+  for (const QByteArray &arg : m_data->m_commandWithArguments)
+    size += arg.size();
+
+  for (const QList<QByteArray> &cmd : m_data->m_pipelineCommands) {
+    for (const QByteArray &arg : cmd) size += arg.size();
+  }
+
+  return size;
 }
 
 QList<QByteArray> RedisClient::Command::splitCommandString(const QString &rawCommand)
@@ -94,116 +196,298 @@ QList<QByteArray> RedisClient::Command::splitCommandString(const QString &rawCom
   return parts;
 }
 
-bool RedisClient::Command::hasCallback() const { return (bool)m_callback; }
+bool RedisClient::Command::hasCallback() const {
+  return (bool)m_data->m_callback;
+}
 
 AsyncFuture::Deferred<RedisClient::Response> RedisClient::Command::getDeferred()
     const {
-  return m_deferred;
+  return m_data->m_deferred;
 }
 
 void RedisClient::Command::setCallBack(QObject *context, Callback callback) {
-  m_owner = context;
-  m_callback = callback;
+  setOwner(context);
+  m_data->m_callback = callback;
+}
+
+const RedisClient::Command::Callback &RedisClient::Command::getCallBack()
+    const {
+  return m_data->m_callback;
+}
+
+void RedisClient::Command::setCompletionHandler(Callback handler) {
+  m_data->m_completionHandler = handler;
 }
 
-RedisClient::Command::Callback RedisClient::Command::getCallBack() const {
-  return m_callback;
+const RedisClient::Command::Callback &
+RedisClient::Command::getCompletionHandler() const {
+  return m_data->m_completionHandler;
 }
 
-bool RedisClient::Command::hasDbIndex() const { return m_dbIndex >= 0; }
+void RedisClient::Command::setStreamCallback(StreamCallback callback) {
+  m_data->m_streamCallback = callback;
+}
+
+const RedisClient::Command::StreamCallback &
+RedisClient::Command::getStreamCallback() const {
+  return m_data->m_streamCallback;
+}
+
+bool RedisClient::Command::isStreamingCommand() const {
+  return (bool)m_data->m_streamCallback && !m_data->m_isPipeline;
+}
+
+void RedisClient::Command::setMessageBatchCallback(
+    MessageBatchCallback callback) {
+  m_data->m_messageBatchCallback = callback;
+}
+
+const RedisClient::Command::MessageBatchCallback &
+RedisClient::Command::getMessageBatchCallback() const {
+  return m_data->m_messageBatchCallback;
+}
+
+bool RedisClient::Command::hasDbIndex() const { return m_data->m_dbIndex >= 0; }
+
+bool RedisClient::Command::isScanCommand() const {
+  return info().is(CommandInfo::KeyScan) || info().is(CommandInfo::ValueScan);
+}
 
 bool RedisClient::Command::isSelectCommand() const {
-  if (m_commandWithArguments.length() < 2) return false;
+  if (m_data->m_commandWithArguments.length() < 2) return false;
 
-  return m_commandWithArguments.at(0).toLower() == "select";
+  return info().is(CommandInfo::Select);
 }
 
 bool RedisClient::Command::isSubscriptionCommand() const {
-  if (m_commandWithArguments.length() < 2) return false;
+  if (m_data->m_commandWithArguments.length() < 2) return false;
 
-  return m_commandWithArguments.at(0).toLower() == "subscribe" ||
-         m_commandWithArguments.at(0).toLower() == "psubscribe";
+  return info().is(CommandInfo::Subscribe);
 }
 
 bool RedisClient::Command::isUnSubscriptionCommand() const {
-  if (m_commandWithArguments.length() < 2) return false;
+  if (m_data->m_commandWithArguments.length() < 2) return false;
 
-  return m_commandWithArguments.at(0).toLower() == "unsubscribe" ||
-         m_commandWithArguments.at(0).toLower() == "punsubscribe";
+  return info().is(CommandInfo::Unsubscribe);
 }
 
 bool RedisClient::Command::isAuthCommand() const {
-  if (m_commandWithArguments.length() < 2) return false;
+  if (m_data->m_commandWithArguments.length() < 2) return false;
+
+  return info().is(CommandInfo::Auth);
+}
+
+bool RedisClient::Command::isReadOnlyCommand() const {
+  if (m_data->m_commandWithArguments.isEmpty() || m_data->m_isPipeline)
+    return false;
+
+  const QList<QByteArray>& args = m_data->m_commandWithArguments;
 
-  return m_commandWithArguments.at(0).toLower() == "auth";
+  // Only key inspection subcommands of MEMORY and OBJECT
+  if (info().is(CommandInfo::ReadOnlySubcommands))
+    return args.size() > 1 && (CommandInfo::nameEquals(args.at(1), "usage") ||
+                               CommandInfo::nameEquals(args.at(1), "encoding") ||
+                               CommandInfo::nameEquals(args.at(1), "freq") ||
+                               CommandInfo::nameEquals(args.at(1), "idletime") ||
+                               CommandInfo::nameEquals(args.at(1), "refcount"));
+
+  return info().is(CommandInfo::ReadOnly);
+}
+
+const RedisClient::CommandInfo& RedisClient::Command::info() const {
+  return *m_data->m_info;
+}
+
+QList<QByteArray> RedisClient::Command::keys() const {
+  if (m_data->m_isPipeline) return QList<QByteArray>();
+
+  return info().keys(m_data->m_commandWithArguments);
 }
 
 bool RedisClient::Command::isHiPriorityCommand() const {
-  return m_hiPriorityCommand;
+  return m_data->m_priority == static_cast<int>(Priority::High);
+}
+
+void RedisClient::Command::setPriority(Priority priority) {
+  m_data->m_priority = static_cast<int>(priority);
+}
+
+RedisClient::Command::Priority RedisClient::Command::priority() const {
+  if (m_data->m_priority >= 0)
+    return static_cast<Priority>(m_data->m_priority);
+
+  if (m_data->m_isPipeline || m_data->m_commandWithArguments.isEmpty())
+    return Priority::Normal;
+
+  return info().is(CommandInfo::Bulk) ? Priority::Bulk : Priority::Normal;
+}
+
+void RedisClient::Command::setTimeout(uint msecs) {
+  m_data->m_timeout = msecs;
+}
+
+uint RedisClient::Command::timeout() const {
+  return m_data.constData()->m_timeout;
+}
+
+bool RedisClient::Command::isBlockingCommand() const {
+  if (m_data->m_isPipeline) return false;
+
+  bool inMsecs = false;
+  return blockingTimeoutIndex(info(), m_data->m_commandWithArguments,
+                              inMsecs) >= 0;
+}
+
+bool RedisClient::Command::limitBlockingTimeout(qint64 msecs,
+                                                bool fractionalSeconds) {
+  const Data* data = m_data.constData();
+
+  if (data->m_isPipeline) return false;
+
+  bool inMsecs = false;
+  int index =
+      blockingTimeoutIndex(info(), data->m_commandWithArguments, inMsecs);
+
+  if (index < 0) return false;
+
+  bool ok = false;
+  double current = data->m_commandWithArguments.at(index).toDouble(&ok);
+
+  if (!ok) return false;
+
+  // Zero timeout blocks forever
+  msecs = qMax(Q_INT64_C(1), msecs);
+  qint64 currentMsecs = static_cast<qint64>(inMsecs ? current : current * 1000);
+
+  if (current > 0 && currentMsecs <= msecs) return false;
+
+  QByteArray timeout;
+
+  if (inMsecs)
+    timeout = QByteArray::number(msecs);
+  else if (fractionalSeconds)
+    timeout = QByteArray::number(msecs / 1000.0, 'f', 3);
+  else
+    timeout = QByteArray::number((msecs + 999) / 1000);
+
+  m_data->m_commandWithArguments[index] = timeout;
+  return true;
 }
 
 bool RedisClient::Command::isPipelineCommand() const
 {
-    return m_isPipeline;
+    return m_data->m_isPipeline;
 }
 
 void RedisClient::Command::setPipelineCommand(const bool enable)
 {
-    m_isPipeline = enable;
+    m_data->m_isPipeline = enable;
 }
 
 int RedisClient::Command::getDbIndex() const
 {
     if (isSelectCommand()) {
-        return m_commandWithArguments.at(1).toInt();
+        return m_data->m_commandWithArguments.at(1).toInt();
     }
-    return m_dbIndex;
+    return m_data->m_dbIndex;
+}
+
+QObject *RedisClient::Command::getOwner() const { return m_data->m_owner; }
+
+QThread *RedisClient::Command::getOwnerThread() const {
+  return m_data->m_ownerThread;
 }
 
-QObject *RedisClient::Command::getOwner() const { return m_owner; }
+bool RedisClient::Command::isOwnerAlive() const {
+  return !m_data->m_ownerGuard.isNull();
+}
+
+void RedisClient::Command::setOwner(QObject *context) {
+  m_data->m_owner = context;
+  m_data->m_ownerGuard = context;
+  m_data->m_ownerThread = context ? context->thread() : nullptr;
+}
 
 QByteArray RedisClient::Command::getRawString(int limit) const {
   if (isAuthCommand()) return QByteArray("AUTH *******");
 
-  return (limit > 0) ? m_commandWithArguments.join(' ').left(limit)
-                     : m_commandWithArguments.join(' ');
+  return (limit > 0) ? m_data->m_commandWithArguments.join(' ').left(limit)
+                     : m_data->m_commandWithArguments.join(' ');
 }
 
-QList<QByteArray> RedisClient::Command::getSplitedRepresentattion() const {
-  return m_commandWithArguments;
+const QList<QByteArray> &RedisClient::Command::getSplitedRepresentattion()
+    const {
+  return m_data->m_commandWithArguments;
 }
 
 QString RedisClient::Command::getPartAsString(int i) const {
-  if (m_commandWithArguments.size() <= i) return QString();
+  if (m_data->m_commandWithArguments.size() <= i) return QString();
 
-  return QString::fromUtf8(m_commandWithArguments.at(i));
+  return QString::fromUtf8(m_data->m_commandWithArguments.at(i));
 }
 
 bool RedisClient::Command::isEmpty() const {
-  if (!m_isPipeline)
-    return m_commandWithArguments.isEmpty();
+  if (!m_data->m_isPipeline)
+    return m_data->m_commandWithArguments.isEmpty();
   else
-    return m_pipelineCommands.isEmpty();
+    return m_data->m_pipelineCommands.isEmpty();
 }
 
 QByteArray RedisClient::Command::getByteRepresentation() const
 {
-    if (!m_isPipeline)
-        return serializeToRESP(m_commandWithArguments);
-    else
-    {
-        QByteArray result = serializeToRESP({"MULTI"});
-        QList<QByteArray> pipelineCmd;
-        foreach (pipelineCmd, m_pipelineCommands)
-            result.append(serializeToRESP(pipelineCmd));
-        result.append(serializeToRESP({"EXEC"}));
-        return result;
+    if (!m_data->m_isPipeline)
+        return serializeToRESP(m_data->m_commandWithArguments);
+
+    static const QList<QByteArray> multi{"MULTI"};
+    static const QList<QByteArray> exec{"EXEC"};
+
+    int size = respSize(multi) + respSize(exec);
+    for (const QList<QByteArray>& pipelineCmd : m_data->m_pipelineCommands)
+        size += respSize(pipelineCmd);
+
+    QByteArray result(size, Qt::Uninitialized);
+    char* out = writeRESP(result.data(), multi);
+    for (const QList<QByteArray>& pipelineCmd : m_data->m_pipelineCommands)
+        out = writeRESP(out, pipelineCmd);
+    out = writeRESP(out, exec);
+
+    Q_ASSERT(out == result.constData() + size);
+    return result;
+}
+
+QList<QByteArray> RedisClient::Command::getByteRepresentationChunks(
+    int inlineLimit) const
+{
+    if (m_data->m_isPipeline) return {getByteRepresentation()};
+
+    QList<QByteArray> chunks;
+    QByteArray current;
+    current.reserve(respSize(m_data->m_commandWithArguments, inlineLimit));
+
+    appendHeader(current, '*', m_data->m_commandWithArguments.size());
+
+    for (const QByteArray& part : m_data->m_commandWithArguments) {
+        appendHeader(current, '$', part.size());
+
+        if (part.size() < inlineLimit) {
+            current.append(part);
+            current.append("\r\n", 2);
+            continue;
+        }
+
+        // Large argument: reference it directly instead of copying
+        chunks.append(current);
+        chunks.append(part);
+        current = QByteArray("\r\n", 2);
     }
+
+    chunks.append(current);
+    return chunks;
 }
 
 void RedisClient::Command::markAsHiPriorityCommand()
 {
-    m_hiPriorityCommand = true;
+    m_data->m_priority = static_cast<int>(Priority::High);
 }
 
 bool RedisClient::Command::isValid() const
@@ -211,18 +495,39 @@ bool RedisClient::Command::isValid() const
     return !isEmpty();
 }
 
-QByteArray RedisClient::Command::serializeToRESP(QList<QByteArray> args) const
+QByteArray RedisClient::Command::serializeToRESP(
+    const QList<QByteArray>& args) const
 {
-    QByteArray result;
-    result.append(QString("*%1\r\n").arg(args.length()));
+    QByteArray result(respSize(args), Qt::Uninitialized);
+    writeRESP(result.data(), args);
+    return result;
+}
 
-  for (QByteArray partArray : args) {
-    result.append("$");
-    result.append(QString::number(partArray.size()));
-    result.append("\r\n");
-    result.append(partArray);
-    result.append("\r\n");
-  }
+int RedisClient::Command::respSize(const QList<QByteArray>& args,
+                                   int inlineLimit)
+{
+    // "*<n>\r\n" + "$<len>\r\n<data>\r\n" for each argument
+    int size = 3 + decimalLength(args.size());
+
+    for (const QByteArray& part : args) {
+        size += 5 + decimalLength(part.size());
+        if (inlineLimit < 0 || part.size() < inlineLimit) size += part.size();
+    }
+
+    return size;
+}
+
+char* RedisClient::Command::writeRESP(char* out, const QList<QByteArray>& args)
+{
+    out = writeHeader(out, '*', args.size());
+
+    for (const QByteArray& part : args) {
+        out = writeHeader(out, '$', part.size());
+        memcpy(out, part.constData(), part.size());
+        out += part.size();
+        *out++ = '\r';
+        *out++ = '\n';
+    }
 
-  return result;
+    return out;
 }
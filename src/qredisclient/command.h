@@ -3,10 +3,17 @@
 #include <QByteArray>
 #include <QList>
 #include <QObject>
+#include <QPointer>
+#include <QSharedData>
+#include <QSharedDataPointer>
 #include <QString>
+#include <QVector>
 #include <functional>
+#include "commandinfo.h"
 #include "response.h"
 
+class QThread;
+
 namespace RedisClient {
 
 /**
@@ -18,6 +25,19 @@ namespace RedisClient {
 class Command {
  public:
   typedef std::function<void(Response, QString)> Callback;
+  typedef std::function<void(const Response&)> StreamCallback;
+  typedef std::function<void(const QVector<Response>&)> MessageBatchCallback;
+
+  /**
+   * @brief Priority classes of commands.
+   * High - added to the beginning of the queue (connection handshake etc.)
+   * Normal - interactive commands
+   * Bulk - commands with large replies or long execution time,
+   * executed over separate connection if bulk lane is enabled
+   * (see ConnectionConfig::useBulkLane())
+   */
+  enum class Priority { High = 0, Normal = 1, Bulk = 2 };
+  static const int PRIORITY_CLASSES = 3;
 
 public:
     /**
@@ -42,6 +62,16 @@ public:
   Command(const QList<QByteArray>& cmd, QObject* context, Callback callback,
           int db = -1);
 
+  /**
+   * @brief Command is implicitly shared:
+   * copies are cheap and share arguments, callbacks and future
+   * until one of them is modified.
+   */
+  Command(const Command&) = default;
+  Command(Command&&) = default;
+  Command& operator=(const Command&) = default;
+  Command& operator=(Command&&) = default;
+
   /**
    * @brief ~Command
    */
@@ -67,12 +97,35 @@ public:
      */
     int length() const;
 
+    /**
+     * @brief payloadSize
+     * @return Total size of arguments in bytes, including all commands
+     * of pipeline
+     */
+    qint64 payloadSize() const;
+
     /**
      * @brief Get command in RESP or Pipeline format
      * @return QByteArray
      */
     QByteArray  getByteRepresentation() const;
 
+    /**
+     * @brief Get command in RESP format as scatter/gather list.
+     * Arguments larger than inlineLimit are returned as separate chunks
+     * which share data with the original argument instead of being copied.
+     * @param inlineLimit - size in bytes
+     * @return List of buffers which should be written sequentially
+     */
+    QList<QByteArray> getByteRepresentationChunks(
+        int inlineLimit = SCATTER_GATHER_THRESHOLD) const;
+
+    /**
+     * @brief Arguments of this size or larger are not copied
+     * into serialization buffer by transporters.
+     */
+    static const int SCATTER_GATHER_THRESHOLD = 64 * 1024;
+
   /**
    * @brief Get source command as single string
    * @return
@@ -83,7 +136,7 @@ public:
    * @brief Get source command as list of args
    * @return
    */
-  QList<QByteArray> getSplitedRepresentattion() const;
+  const QList<QByteArray>& getSplitedRepresentattion() const;
 
   /**
    * @brief Get specific argument/part of the command
@@ -110,6 +163,17 @@ public:
    */
   QObject* getOwner() const;
 
+  /**
+   * @brief Thread where callback context lived when it was set
+   */
+  QThread* getOwnerThread() const;
+
+  /**
+   * @brief Check if callback context is not destroyed.
+   * Result is reliable only in owner thread.
+   */
+  bool isOwnerAlive() const;
+
   /**
    * @brief Set context and callback
    * @param context
@@ -121,7 +185,7 @@ public:
    * @brief getCallBack
    * @return
    */
-  Callback getCallBack() const;
+  const Callback& getCallBack() const;
 
   /**
    * @brief hasCallback
@@ -129,6 +193,60 @@ public:
    */
   bool hasCallback() const;
 
+  /**
+   * @brief Set handler called when command is completed or failed,
+   * before callback is delivered to owner. Unlike callback it is called
+   * directly in thread which completes command (usually transporter
+   * thread), so it doesn't depend on event loop of any thread.
+   * Handler should be thread-safe and return quickly.
+   * @param handler
+   */
+  void setCompletionHandler(Callback handler);
+
+  /**
+   * @brief getCompletionHandler
+   * @return
+   */
+  const Callback& getCompletionHandler() const;
+
+  /**
+   * @brief Enable streaming mode.
+   * Bulk string replies are delivered to callback in chunks as they arrive,
+   * elements of array replies are delivered one by one, so the whole reply
+   * is never kept in memory. Regular callback and future receive
+   * number of streamed bytes/elements when reply is fully received.
+   * NOTE: callback is called in transporter thread.
+   * @param callback
+   */
+  void setStreamCallback(StreamCallback callback);
+
+  /**
+   * @brief getStreamCallback
+   * @return
+   */
+  const StreamCallback& getStreamCallback() const;
+
+  /**
+   * @brief isStreamingCommand
+   * @return
+   */
+  bool isStreamingCommand() const;
+
+  /**
+   * @brief Deliver pub/sub messages of subscription in batches.
+   * Messages are buffered while owner thread is busy and passed to
+   * callback in a single call. Regular callback still receives
+   * subscription confirmation.
+   * @param callback
+   */
+  void setMessageBatchCallback(MessageBatchCallback callback);
+
+  /**
+   * @brief getMessageBatchCallback
+   * @return
+   */
+  const MessageBatchCallback& getMessageBatchCallback() const;
+
   /**
    * @brief getFuture
    * @return
@@ -148,6 +266,37 @@ public:
    */
   bool isHiPriorityCommand() const;
 
+  /**
+   * @brief Set priority class explicitly
+   * @param priority
+   */
+  void setPriority(Priority priority);
+
+  /**
+   * @brief Priority class set by caller or detected from command type
+   * (KEYS, HGETALL, SMEMBERS etc. are Bulk)
+   * @return
+   */
+  Priority priority() const;
+
+  /**
+   * @brief Fail command with "Execution timeout" error if reply is not
+   * received in time. Only this command fails, its late reply is discarded.
+   * Server-side timeout of blocking commands (BLPOP, XREAD BLOCK, WAIT etc.)
+   * is lowered to the time left when command is sent.
+   * @param msecs - counted from the moment command is queued, 0 - no timeout
+   */
+  void setTimeout(uint msecs);
+  uint timeout() const;
+
+  /**
+   * @brief Lower server-side timeout of blocking command
+   * @param msecs - time left until deadline
+   * @param fractionalSeconds - server accepts timeouts like 0.5 (redis >= 6.0)
+   * @return false if command doesn't block or blocks for a shorter time
+   */
+  bool limitBlockingTimeout(qint64 msecs, bool fractionalSeconds);
+
     /**
      * @brief Enable/disable pipeline mode. Default is off.
      * @param enable
@@ -171,12 +320,49 @@ public:
     bool isAuthCommand() const;
     bool isPipelineCommand() const;
 
+    /**
+     * @brief Command doesn't modify data and can be executed on replica
+     * (GET, HGETALL, ZRANGE, SCAN etc.)
+     */
+    bool isReadOnlyCommand() const;
+
+    /**
+     * @brief Command blocks connection until server-side timeout
+     * (BLPOP, XREAD BLOCK, WAIT etc.)
+     */
+    bool isBlockingCommand() const;
+
+    /**
+     * @brief Metadata of command detected once by command name
+     * (unknown commands have no flags)
+     */
+    const CommandInfo& info() const;
+
+    /**
+     * @brief Keys of command according to CommandInfo key positions
+     */
+    QList<QByteArray> keys() const;
+
 protected:
     /**
      * @brief Serialize command to RESP format
      * @return
      */
-    QByteArray serializeToRESP(QList<QByteArray> args) const;
+    QByteArray serializeToRESP(const QList<QByteArray>& args) const;
+
+    /**
+     * @brief Exact size of RESP representation of args.
+     * Arguments larger than inlineLimit are excluded from payload size.
+     */
+    static int respSize(const QList<QByteArray>& args, int inlineLimit = -1);
+
+    /**
+     * @brief Write RESP representation of args into pre-sized buffer
+     * @return Pointer to the first byte after written data
+     */
+    static char* writeRESP(char* out, const QList<QByteArray>& args);
+
+    void setOwner(QObject* context);
 
 public:
   /**
@@ -187,13 +373,29 @@ public:
   static QList<QByteArray> splitCommandString(const QString&);
 
 protected:
-    QObject * m_owner;
-    QList<QByteArray> m_commandWithArguments;
-    QList<QList<QByteArray>> m_pipelineCommands;
-    int m_dbIndex;
-    bool m_hiPriorityCommand;
-    bool m_isPipeline;
-    Callback m_callback;
-    AsyncFuture::Deferred<Response> m_deferred;
+    struct Data : public QSharedData {
+      Data()
+          : m_owner(nullptr), m_ownerThread(nullptr), m_dbIndex(-1),
+            m_priority(-1), m_isPipeline(false), m_timeout(0),
+            m_info(&CommandInfo::lookup(QByteArray())) {}
+
+      QObject * m_owner;
+      QPointer<QObject> m_ownerGuard;
+      QThread * m_ownerThread;
+      QList<QByteArray> m_commandWithArguments;
+      QList<QList<QByteArray>> m_pipelineCommands;
+      int m_dbIndex;
+      int m_priority;  // -1 - detected from command type
+      bool m_isPipeline;
+      uint m_timeout;
+      Callback m_callback;
+      Callback m_completionHandler;
+      StreamCallback m_streamCallback;
+      MessageBatchCallback m_messageBatchCallback;
+      AsyncFuture::Deferred<Response> m_deferred;
+      const CommandInfo* m_info;  // classified once by command name
+    };
+
+    QSharedDataPointer<Data> m_data;
 };
 }  // namespace RedisClient
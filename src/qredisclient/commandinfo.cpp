@@ -0,0 +1,351 @@
+#include "commandinfo.h"
+#include <QVector>
+#include <cstring>
+
+namespace {
+
+typedef RedisClient::CommandInfo C;
+
+const uint RO = C::ReadOnly;
+const uint CACHE = C::ReadOnly | C::Cacheable;
+const uint BULK_RO = C::ReadOnly | C::Bulk;
+const uint KEYLESS = C::Keyless;
+
+// clang-format off
+const C COMMANDS[] = {
+    // Keyless commands
+    {"acl", KEYLESS, 0, 0, 0},
+    {"asking", KEYLESS, 0, 0, 0},
+    {"auth", KEYLESS | C::Auth, 0, 0, 0},
+    {"bgrewriteaof", KEYLESS, 0, 0, 0},
+    {"bgsave", KEYLESS, 0, 0, 0},
+    {"client", KEYLESS, 0, 0, 0},
+    {"cluster", KEYLESS, 0, 0, 0},
+    {"command", KEYLESS, 0, 0, 0},
+    {"config", KEYLESS, 0, 0, 0},
+    {"dbsize", KEYLESS, 0, 0, 0},
+    {"debug", KEYLESS | C::Bulk, 0, 0, 0},
+    {"discard", KEYLESS | C::Exec, 0, 0, 0},
+    {"echo", KEYLESS, 0, 0, 0},
+    {"exec", KEYLESS | C::Exec, 0, 0, 0},
+    {"flushall", KEYLESS | C::Bulk, 0, 0, 0},
+    {"flushdb", KEYLESS | C::Bulk, 0, 0, 0},
+    {"hello", KEYLESS, 0, 0, 0},
+    {"info", KEYLESS, 0, 0, 0},
+    {"keys", KEYLESS | BULK_RO, 0, 0, 0},
+    {"lastsave", KEYLESS, 0, 0, 0},
+    {"latency", KEYLESS, 0, 0, 0},
+    {"lolwut", KEYLESS, 0, 0, 0},
+    {"module", KEYLESS, 0, 0, 0},
+    {"monitor", KEYLESS | C::Monitor, 0, 0, 0},
+    {"multi", KEYLESS | C::Multi, 0, 0, 0},
+    {"ping", KEYLESS, 0, 0, 0},
+    {"psubscribe", KEYLESS | C::Subscribe | C::PatternChannel, 0, 0, 0},
+    {"publish", KEYLESS, 0, 0, 0},
+    {"pubsub", KEYLESS, 0, 0, 0},
+    {"punsubscribe", KEYLESS | C::Unsubscribe | C::PatternChannel, 0, 0, 0},
+    {"quit", KEYLESS, 0, 0, 0},
+    {"randomkey", KEYLESS | RO, 0, 0, 0},
+    {"readonly", KEYLESS, 0, 0, 0},
+    {"readwrite", KEYLESS, 0, 0, 0},
+    {"role", KEYLESS, 0, 0, 0},
+    {"save", KEYLESS, 0, 0, 0},
+    {"scan", KEYLESS | RO | C::KeyScan, 0, 0, 0},
+    // aliyun cloud provides iscan command for scanning clusters
+    {"iscan", KEYLESS | C::KeyScan, 0, 0, 0},
+    {"script", KEYLESS, 0, 0, 0},
+    {"select", KEYLESS | C::Select, 0, 0, 0},
+    {"sentinel", KEYLESS, 0, 0, 0},
+    {"shutdown", KEYLESS, 0, 0, 0},
+    {"slowlog", KEYLESS, 0, 0, 0},
+    {"subscribe", KEYLESS | C::Subscribe, 0, 0, 0},
+    {"swapdb", KEYLESS, 0, 0, 0},
+    {"time", KEYLESS, 0, 0, 0},
+    {"unsubscribe", KEYLESS | C::Unsubscribe, 0, 0, 0},
+    {"unwatch", KEYLESS | C::Unwatch, 0, 0, 0},
+    {"wait", KEYLESS | C::Blocking, 0, 0, 0},
+
+    // Sharded pub/sub channels are hashed like keys
+    {"ssubscribe", C::Subscribe | C::ShardChannel, 1, -1, 1},
+    {"sunsubscribe", C::Unsubscribe | C::ShardChannel, 1, -1, 1},
+
+    // Key is the subcommand argument: MEMORY USAGE key, OBJECT ENCODING key
+    {"memory", C::ReadOnlySubcommands, 2, 2, 1},
+    {"object", C::ReadOnlySubcommands, 2, 2, 1},
+
+    // MIGRATE host port key|"" db timeout [... KEYS key [key ...]]
+    {"migrate", C::Bulk, 3, 3, 1},
+
+    // XREAD [...] STREAMS key [key ...] id [id ...]
+    {"xread", RO | C::Blocking | C::Streams, 0, 0, 0},
+    {"xreadgroup", C::Blocking | C::Streams, 0, 0, 0},
+
+    // Scripts
+    {"eval", C::Script | C::NumKeys, 2, 0, 0},
+    {"evalsha", C::Script | C::NumKeys, 2, 0, 0},
+    {"eval_ro", C::Script | C::NumKeys | RO, 2, 0, 0},
+    {"evalsha_ro", C::Script | C::NumKeys | RO, 2, 0, 0},
+
+    // Blocking commands, timeout is the last argument
+    {"blpop", C::Blocking, 1, -2, 1},
+    {"brpop", C::Blocking, 1, -2, 1},
+    {"brpoplpush", C::Blocking, 1, 2, 1},
+    {"blmove", C::Blocking, 1, 2, 1},
+    {"bzpopmin", C::Blocking, 1, -2, 1},
+    {"bzpopmax", C::Blocking, 1, -2, 1},
+    {"blmpop", C::Blocking | C::NumKeys, 2, 0, 0},
+    {"bzmpop", C::Blocking | C::NumKeys, 2, 0, 0},
+
+    // Read-only commands
+    {"bitcount", RO, 1, 1, 1},
+    {"bitfield_ro", RO, 1, 1, 1},
+    {"bitpos", RO, 1, 1, 1},
+    {"dump", BULK_RO, 1, 1, 1},
+    {"exists", CACHE, 1, -1, 1},
+    {"geodist", RO, 1, 1, 1},
+    {"geohash", RO, 1, 1, 1},
+    {"geopos", RO, 1, 1, 1},
+    {"georadius_ro", RO, 1, 1, 1},
+    {"georadiusbymember_ro", RO, 1, 1, 1},
+    {"geosearch", RO, 1, 1, 1},
+    {"get", CACHE, 1, 1, 1},
+    {"getbit", RO, 1, 1, 1},
+    {"getrange", CACHE, 1, 1, 1},
+    {"hexists", CACHE, 1, 1, 1},
+    {"hget", CACHE, 1, 1, 1},
+    {"hgetall", CACHE | C::Bulk, 1, 1, 1},
+    {"hkeys", CACHE | C::Bulk, 1, 1, 1},
+    {"hlen", CACHE, 1, 1, 1},
+    {"hmget", CACHE, 1, 1, 1},
+    {"hrandfield", RO, 1, 1, 1},
+    {"hscan", RO | C::ValueScan, 1, 1, 1},
+    {"hstrlen", CACHE, 1, 1, 1},
+    {"hvals", CACHE | C::Bulk, 1, 1, 1},
+    {"lindex", CACHE, 1, 1, 1},
+    {"llen", CACHE, 1, 1, 1},
+    {"lpos", RO, 1, 1, 1},
+    {"lrange", CACHE, 1, 1, 1},
+    {"mget", CACHE, 1, -1, 1},
+    {"pfcount", RO, 1, -1, 1},
+    {"pttl", RO, 1, 1, 1},
+    {"scard", CACHE, 1, 1, 1},
+    {"sdiff", BULK_RO, 1, -1, 1},
+    {"sinter", BULK_RO, 1, -1, 1},
+    {"sintercard", RO | C::NumKeys, 1, 0, 0},
+    {"sismember", CACHE, 1, 1, 1},
+    {"smembers", CACHE | C::Bulk, 1, 1, 1},
+    {"smismember", RO, 1, 1, 1},
+    {"srandmember", RO, 1, 1, 1},
+    {"sscan", RO | C::ValueScan, 1, 1, 1},
+    {"strlen", CACHE, 1, 1, 1},
+    {"substr", RO, 1, 1, 1},
+    {"sunion", BULK_RO, 1, -1, 1},
+    {"ttl", RO, 1, 1, 1},
+    {"type", CACHE, 1, 1, 1},
+    {"xlen", RO, 1, 1, 1},
+    {"xpending", RO, 1, 1, 1},
+    {"xrange", RO, 1, 1, 1},
+    {"xrevrange", RO, 1, 1, 1},
+    {"zcard", CACHE, 1, 1, 1},
+    {"zcount", CACHE, 1, 1, 1},
+    {"zdiff", RO | C::NumKeys, 1, 0, 0},
+    {"zinter", RO | C::NumKeys, 1, 0, 0},
+    {"zintercard", RO | C::NumKeys, 1, 0, 0},
+    {"zlexcount", RO, 1, 1, 1},
+    {"zmscore", RO, 1, 1, 1},
+    {"zrandmember", RO, 1, 1, 1},
+    {"zrange", CACHE, 1, 1, 1},
+    {"zrangebylex", RO, 1, 1, 1},
+    {"zrangebyscore", CACHE, 1, 1, 1},
+    {"zrank", CACHE, 1, 1, 1},
+    {"zrevrange", CACHE, 1, 1, 1},
+    {"zrevrangebylex", RO, 1, 1, 1},
+    {"zrevrangebyscore", RO, 1, 1, 1},
+    {"zrevrank", RO, 1, 1, 1},
+    {"zscan", RO | C::ValueScan, 1, 1, 1},
+    {"zscore", CACHE, 1, 1, 1},
+    {"zunion", RO | C::NumKeys, 1, 0, 0},
+
+    // Write commands with several keys or long execution time
+    {"del", 0, 1, -1, 1},
+    {"unlink", 0, 1, -1, 1},
+    {"touch", 0, 1, -1, 1},
+    {"mset", 0, 1, -1, 2},
+    {"msetnx", 0, 1, -1, 2},
+    {"watch", C::Watch, 1, -1, 1},
+    {"lmpop", C::NumKeys, 1, 0, 0},
+    {"zmpop", C::NumKeys, 1, 0, 0},
+    {"restore", C::Bulk, 1, 1, 1},
+    {"sinterstore", C::Bulk, 1, -1, 1},
+    {"sunionstore", C::Bulk, 1, -1, 1},
+    {"sdiffstore", C::Bulk, 1, -1, 1},
+    {"zunionstore", C::Bulk, 1, 1, 1},
+    {"zinterstore", C::Bulk, 1, 1, 1},
+    {"sort", C::Bulk, 1, 1, 1},
+};
+// clang-format on
+
+const C UNKNOWN_COMMAND = {"", 0, 1, 1, 1};
+
+inline char toLowerAscii(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+// FNV-1a over lower-cased name
+inline uint nameHash(const char* name, int size) {
+  uint hash = 2166136261u;
+
+  for (int i = 0; i < size; ++i) {
+    hash ^= static_cast<uchar>(toLowerAscii(name[i]));
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+/*
+ * Open addressing table with 4x more slots than commands, so most
+ * lookups are resolved by the first probe.
+ */
+class CommandTable {
+ public:
+  CommandTable() {
+    int count = static_cast<int>(sizeof(COMMANDS) / sizeof(COMMANDS[0]));
+    int size = 1;
+
+    while (size < count * 4) size <<= 1;
+
+    m_mask = static_cast<uint>(size - 1);
+    m_slots.fill(-1, size);
+
+    for (int i = 0; i < count; ++i) {
+      int length = static_cast<int>(strlen(COMMANDS[i].name));
+      uint slot = nameHash(COMMANDS[i].name, length) & m_mask;
+
+      while (m_slots.at(slot) >= 0) slot = (slot + 1) & m_mask;
+
+      m_slots[slot] = i;
+    }
+  }
+
+  const C& find(const QByteArray& name) const {
+    // Longest known command name is shorter than 32 bytes
+    if (name.isEmpty() || name.size() > 32) return UNKNOWN_COMMAND;
+
+    uint slot = nameHash(name.constData(), name.size()) & m_mask;
+
+    while (m_slots.at(slot) >= 0) {
+      const C& info = COMMANDS[m_slots.at(slot)];
+
+      if (C::nameEquals(name, info.name)) return info;
+
+      slot = (slot + 1) & m_mask;
+    }
+
+    return UNKNOWN_COMMAND;
+  }
+
+ private:
+  QVector<int> m_slots;
+  uint m_mask;
+};
+
+// Position of the first argument after given option, -1 if not found
+int indexAfter(const QList<QByteArray>& args, int from,
+               const char* lowerCaseOption) {
+  for (int i = from; i < args.size() - 1; ++i) {
+    if (C::nameEquals(args.at(i), lowerCaseOption)) return i + 1;
+  }
+
+  return -1;
+}
+
+int streamKeysIndex(const C& info, const QList<QByteArray>& args) {
+  // Group and consumer names of XREADGROUP can look like STREAMS option
+  int from = strcmp(info.name, "xreadgroup") == 0 ? 4 : 1;
+  return indexAfter(args, from, "streams");
+}
+
+}  // namespace
+
+QList<QByteArray> RedisClient::CommandInfo::keys(
+    const QList<QByteArray>& args) const {
+  QList<QByteArray> result;
+
+  if (is(Streams)) {
+    // STREAMS key [key ...] id [id ...]
+    int first = streamKeysIndex(*this, args);
+
+    if (first < 0) return result;
+
+    int count = (args.size() - first) / 2;
+
+    for (int i = first; i < first + count; ++i) result.append(args.at(i));
+
+    return result;
+  }
+
+  if (is(NumKeys)) {
+    // numkeys key [key ...]
+    int count = firstKey < args.size() ? args.at(firstKey).toInt() : 0;
+    int last = qMin(firstKey + count, args.size() - 1);
+
+    for (int i = firstKey + 1; i <= last; ++i) result.append(args.at(i));
+
+    return result;
+  }
+
+  if (firstKey <= 0 || keyStep <= 0) return result;
+
+  int last = lastKey < 0 ? args.size() + lastKey : lastKey;
+  last = qMin(last, args.size() - 1);
+
+  for (int i = firstKey; i <= last; i += keyStep) result.append(args.at(i));
+
+  return result;
+}
+
+int RedisClient::CommandInfo::firstKeyIndex(
+    const QList<QByteArray>& args) const {
+  if (is(Keyless)) return -1;
+
+  if (is(NumKeys)) {
+    int first = firstKey + 1;
+
+    if (first >= args.size() || args.at(firstKey).toInt() < 1) return -1;
+
+    return first;
+  }
+
+  if (is(Streams)) {
+    int first = streamKeysIndex(*this, args);
+    return first >= 0 && args.size() - first >= 2 ? first : -1;
+  }
+
+  if (firstKey <= 0 || firstKey >= args.size()) return -1;
+
+  // Empty key argument of MIGRATE - keys are listed after KEYS option
+  if (strcmp(name, "migrate") == 0 && args.at(firstKey).isEmpty())
+    return indexAfter(args, firstKey + 1, "keys");
+
+  return firstKey;
+}
+
+const RedisClient::CommandInfo& RedisClient::CommandInfo::lookup(
+    const QByteArray& name) {
+  static const CommandTable table;
+  return table.find(name);
+}
+
+bool RedisClient::CommandInfo::nameEquals(const QByteArray& arg,
+                                          const char* lowerCaseName) {
+  int size = arg.size();
+  const char* data = arg.constData();
+
+  for (int i = 0; i < size; ++i) {
+    if (lowerCaseName[i] == '\0' || toLowerAscii(data[i]) != lowerCaseName[i])
+      return false;
+  }
+
+  return lowerCaseName[size] == '\0';
+}
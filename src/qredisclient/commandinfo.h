@@ -0,0 +1,81 @@
+#pragma once
+#include <QByteArray>
+#include <QList>
+
+namespace RedisClient {
+
+/**
+ * @brief The CommandInfo struct
+ * Static metadata of known redis commands used by routing, replica reads,
+ * client-side cache and transporter. Command name is classified once when
+ * command is constructed: lookup is case-insensitive and doesn't allocate.
+ * Unknown commands have no flags and a single key at position 1.
+ */
+struct CommandInfo {
+  enum Flag {
+    ReadOnly = 1 << 0,   // can be executed on replicas
+    Bulk = 1 << 1,       // large reply or long execution time
+    Cacheable = 1 << 2,  // reply can be stored in client-side cache
+    Keyless = 1 << 3,    // executed on the node connection was created for
+    Blocking = 1 << 4,   // has server-side timeout
+    Subscribe = 1 << 5,
+    Unsubscribe = 1 << 6,
+    PatternChannel = 1 << 7,  // PSUBSCRIBE, PUNSUBSCRIBE
+    ShardChannel = 1 << 8,    // SSUBSCRIBE, SUNSUBSCRIBE
+    Select = 1 << 9,
+    Auth = 1 << 10,
+    KeyScan = 1 << 11,    // SCAN, ISCAN
+    ValueScan = 1 << 12,  // HSCAN, SSCAN, ZSCAN
+    Script = 1 << 13,     // runs Lua script (EVAL, EVALSHA)
+
+    // Only some subcommands are read-only (MEMORY USAGE, OBJECT ENCODING)
+    ReadOnlySubcommands = 1 << 14,
+    Streams = 1 << 15,  // keys follow STREAMS argument (XREAD)
+
+    // Connection state: transaction, watched keys, monitor mode
+    Multi = 1 << 16,
+    Exec = 1 << 17,  // EXEC, DISCARD - end transaction and unwatch keys
+    Watch = 1 << 18,
+    Unwatch = 1 << 19,
+    Monitor = 1 << 20,
+
+    // Keys follow numkeys argument, firstKey is position of numkeys
+    NumKeys = 1 << 21
+  };
+
+  const char* name;  // lower-case, empty for unknown commands
+  uint flags;
+
+  // Key positions: first key, last key (negative - counted from the end)
+  // and step between keys. firstKey == 0 - command has no keys.
+  int firstKey;
+  int lastKey;
+  int keyStep;
+
+  bool is(Flag flag) const { return (flags & flag) != 0; }
+  bool isKnown() const { return name[0] != '\0'; }
+
+  /**
+   * @brief Keys of command with given arguments
+   */
+  QList<QByteArray> keys(const QList<QByteArray>& args) const;
+
+  /**
+   * @brief Position of the first key in given arguments
+   * @return -1 if command has no keys
+   */
+  int firstKeyIndex(const QList<QByteArray>& args) const;
+
+  /**
+   * @brief Metadata of command, never fails
+   * @param name - command name in any case
+   */
+  static const CommandInfo& lookup(const QByteArray& name);
+
+  /**
+   * @brief Case-insensitive name comparison without allocation
+   */
+  static bool nameEquals(const QByteArray& arg, const char* lowerCaseName);
+};
+
+}  // namespace RedisClient
@@ -0,0 +1,518 @@
+#include "compactkeylist.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+// Max size of QByteArray in Qt5, leaves space for header of allocation
+const qint64 MAX_DATA_SIZE = std::numeric_limits<int>::max() - 64;
+
+// Max size of encoded shared prefix length
+const int MAX_VARINT_SIZE = 5;
+
+// Same order as QByteArray::operator<
+int compareKeys(const char *a, int aSize, const char *b, int bSize) {
+  int common = qMin(aSize, bSize);
+  int result = common > 0 ? memcmp(a, b, static_cast<size_t>(common)) : 0;
+
+  if (result != 0) return result;
+
+  return aSize < bSize ? -1 : (aSize > bSize ? 1 : 0);
+}
+
+int sharedPrefix(const char *a, int aSize, const char *b, int bSize) {
+  int limit = qMin(aSize, bSize);
+  int i = 0;
+
+  while (i < limit && a[i] == b[i]) ++i;
+
+  return i;
+}
+
+bool startsWith(const char *key, int size, const QByteArray &prefix) {
+  return size >= prefix.size() &&
+         (prefix.isEmpty() ||
+          memcmp(key, prefix.constData(),
+                 static_cast<size_t>(prefix.size())) == 0);
+}
+
+// Reuses allocated buffer of target
+void assignKey(QByteArray &target, int keep, const char *suffix, int size) {
+  target.resize(keep + size);
+
+  if (size > 0) memcpy(target.data() + keep, suffix, static_cast<size_t>(size));
+}
+
+void appendVarint(QByteArray &data, quint32 value) {
+  while (value >= 0x80) {
+    data.append(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+
+  data.append(static_cast<char>(value));
+}
+
+quint32 readVarint(const char *&p) {
+  quint32 result = 0;
+  int shift = 0;
+
+  while (true) {
+    quint8 byte = static_cast<quint8>(*p++);
+    result |= static_cast<quint32>(byte & 0x7f) << shift;
+
+    if (!(byte & 0x80)) return result;
+
+    shift += 7;
+  }
+}
+
+// Smallest key greater than all keys starting with prefix,
+// empty if there is no such key
+QByteArray prefixSuccessor(const QByteArray &prefix) {
+  QByteArray result = prefix;
+
+  while (!result.isEmpty() &&
+         static_cast<quint8>(result.at(result.size() - 1)) == 0xff)
+    result.chop(1);
+
+  if (!result.isEmpty()) {
+    int last = result.size() - 1;
+    result[last] = static_cast<char>(static_cast<quint8>(result.at(last)) + 1);
+  }
+
+  return result;
+}
+}  // namespace
+
+const int RedisClient::CompactKeyList::RESTART_INTERVAL;
+
+RedisClient::CompactKeyList::const_iterator::const_iterator(
+    const CompactKeyList *list, int index)
+    : m_list(list), m_index(index) {
+  load(false);
+}
+
+RedisClient::CompactKeyList::const_iterator &
+RedisClient::CompactKeyList::const_iterator::operator++() {
+  ++m_index;
+  load(true);
+  return *this;
+}
+
+RedisClient::CompactKeyList::const_iterator
+RedisClient::CompactKeyList::const_iterator::operator++(int) {
+  const_iterator result = *this;
+  ++(*this);
+  return result;
+}
+
+void RedisClient::CompactKeyList::const_iterator::load(bool incremental) {
+  if (m_index >= m_list->size()) {
+    m_key.clear();
+    return;
+  }
+
+  int size = 0;
+
+  if (!m_list->m_compressed) {
+    const char *key = m_list->plainKey(m_index, &size);
+    m_key.setRawData(key, static_cast<uint>(size));
+    return;
+  }
+
+  if (!incremental && m_index % RESTART_INTERVAL != 0) {
+    m_key = m_list->decode(m_index);
+    return;
+  }
+
+  // Previous key is decoded, only suffix is replaced
+  int shared = 0;
+  const char *suffix = m_list->suffix(m_index, &shared, &size);
+  assignKey(m_key, shared, suffix, size);
+}
+
+RedisClient::CompactKeyList::CompactKeyList()
+    : m_sorted(true), m_compressed(false) {}
+
+void RedisClient::CompactKeyList::append(const QByteArray &key) {
+  appendKey(key.constData(), key.size());
+}
+
+void RedisClient::CompactKeyList::append(const QList<QByteArray> &keys) {
+  for (const QByteArray &key : keys) appendKey(key.constData(), key.size());
+}
+
+void RedisClient::CompactKeyList::append(const CompactKeyList &other) {
+  if (&other == this) return append(CompactKeyList(other));
+
+  if (m_compressed || other.m_compressed) {
+    for (const QByteArray &key : other) appendKey(key.constData(), key.size());
+    return;
+  }
+
+  if (other.isEmpty()) return;
+
+  checkCapacity(other.m_data.size());
+
+  // Plain lists are merged without copying keys one by one
+  bool sorted = m_sorted && other.m_sorted;
+
+  if (sorted && !isEmpty()) {
+    int lastSize = 0, firstSize = 0;
+    const char *last = plainKey(size() - 1, &lastSize);
+    const char *first = other.plainKey(0, &firstSize);
+    sorted = compareKeys(first, firstSize, last, lastSize) >= 0;
+  }
+
+  quint32 shift = static_cast<quint32>(m_data.size());
+
+  for (quint32 offset : other.m_offsets) m_offsets.append(shift + offset);
+
+  m_data.append(other.m_data.constData(), other.m_data.size());
+  m_sorted = sorted;
+}
+
+void RedisClient::CompactKeyList::reserve(int keys, int bytes) {
+  m_offsets.reserve(keys);
+  m_data.reserve(bytes);
+}
+
+void RedisClient::CompactKeyList::squeeze() {
+  m_offsets.squeeze();
+  m_data.squeeze();
+  m_lastKey.squeeze();
+}
+
+void RedisClient::CompactKeyList::clear() {
+  m_offsets.clear();
+  m_data.clear();
+  m_lastKey.clear();
+  m_sorted = true;
+  m_compressed = false;
+}
+
+QByteArray RedisClient::CompactKeyList::at(int i) const {
+  Q_ASSERT(i >= 0 && i < size());
+
+  if (m_compressed) return decode(i);
+
+  int size = 0;
+  const char *key = plainKey(i, &size);
+  return QByteArray(key, size);
+}
+
+RedisClient::CompactKeyList::const_iterator
+RedisClient::CompactKeyList::begin() const {
+  return const_iterator(this, 0);
+}
+
+RedisClient::CompactKeyList::const_iterator RedisClient::CompactKeyList::end()
+    const {
+  return const_iterator(this, size());
+}
+
+void RedisClient::CompactKeyList::arrange(Layout layout) {
+  switch (layout) {
+    case Layout::Unsorted:
+      return decompress();
+    case Layout::Sorted:
+      decompress();
+      return sort();
+    case Layout::SortedCompressed:
+      return compress();
+  }
+}
+
+void RedisClient::CompactKeyList::sort() {
+  // Compressed lists are always sorted
+  if (m_sorted) return;
+
+  QVector<int> order(size());
+
+  for (int i = 0; i < order.size(); ++i) order[i] = i;
+
+  std::sort(order.begin(), order.end(), [this](int a, int b) -> bool {
+    int aSize = 0, bSize = 0;
+    const char *aKey = plainKey(a, &aSize);
+    const char *bKey = plainKey(b, &bSize);
+    return compareKeys(aKey, aSize, bKey, bSize) < 0;
+  });
+
+  QByteArray data;
+  data.reserve(m_data.size());
+  QVector<quint32> offsets;
+  offsets.reserve(size());
+
+  for (int i : order) {
+    int keySize = 0;
+    const char *key = plainKey(i, &keySize);
+    offsets.append(static_cast<quint32>(data.size()));
+    data.append(key, keySize);
+  }
+
+  m_data.swap(data);
+  m_offsets.swap(offsets);
+  m_sorted = true;
+}
+
+void RedisClient::CompactKeyList::compress() {
+  if (m_compressed) return;
+
+  sort();
+
+  QByteArray data;
+  data.reserve(static_cast<int>(
+      qMin(static_cast<qint64>(m_data.size()) + size(), MAX_DATA_SIZE)));
+  QVector<quint32> offsets;
+  offsets.reserve(size());
+
+  const char *previous = nullptr;
+  int previousSize = 0;
+
+  for (int i = 0; i < size(); ++i) {
+    int keySize = 0;
+    const char *key = plainKey(i, &keySize);
+    int shared = i % RESTART_INTERVAL == 0
+                     ? 0
+                     : sharedPrefix(previous, previousSize, key, keySize);
+
+    if (data.size() + static_cast<qint64>(keySize - shared) +
+            MAX_VARINT_SIZE >
+        MAX_DATA_SIZE)
+      throw Exception("Key list is full");
+
+    offsets.append(static_cast<quint32>(data.size()));
+    appendVarint(data, static_cast<quint32>(shared));
+    data.append(key + shared, keySize - shared);
+
+    previous = key;
+    previousSize = keySize;
+  }
+
+  assignKey(m_lastKey, 0, previous, previousSize);
+  m_data.swap(data);
+  m_offsets.swap(offsets);
+  m_compressed = true;
+}
+
+void RedisClient::CompactKeyList::decompress() {
+  if (!m_compressed) return;
+
+  QByteArray data;
+  data.reserve(m_data.size());
+  QVector<quint32> offsets;
+  offsets.reserve(size());
+
+  for (const QByteArray &key : *this) {
+    if (data.size() + static_cast<qint64>(key.size()) > MAX_DATA_SIZE)
+      throw Exception("Key list is full");
+
+    offsets.append(static_cast<quint32>(data.size()));
+    data.append(key.constData(), key.size());
+  }
+
+  m_data.swap(data);
+  m_offsets.swap(offsets);
+  m_lastKey.clear();
+  m_compressed = false;
+}
+
+int RedisClient::CompactKeyList::lowerBound(const QByteArray &key) const {
+  requireSorted();
+
+  int first = 0;
+  int count = m_compressed
+                  ? (size() + RESTART_INTERVAL - 1) / RESTART_INTERVAL
+                  : size();
+
+  // Plain keys are searched directly, compressed lists are searched by
+  // whole restart keys first
+  while (count > 0) {
+    int step = count / 2;
+    int middle = first + step;
+    int keySize = 0, shared = 0;
+    const char *middleKey =
+        m_compressed ? suffix(middle * RESTART_INTERVAL, &shared, &keySize)
+                     : plainKey(middle, &keySize);
+
+    if (compareKeys(middleKey, keySize, key.constData(), key.size()) < 0) {
+      first = middle + 1;
+      count -= step + 1;
+    } else {
+      count = step;
+    }
+  }
+
+  if (!m_compressed || first == 0) return first;
+
+  // Key is in the previous block or it is restart key of found block
+  int blockBegin = (first - 1) * RESTART_INTERVAL;
+  int blockEnd = qMin(first * RESTART_INTERVAL, size());
+
+  for (const_iterator it(this, blockBegin); it.index() < blockEnd; ++it) {
+    if (compareKeys(it->constData(), it->size(), key.constData(),
+                    key.size()) >= 0)
+      return it.index();
+  }
+
+  return blockEnd;
+}
+
+QPair<int, int> RedisClient::CompactKeyList::prefixRange(
+    const QByteArray &prefix) const {
+  int first = lowerBound(prefix);
+  QByteArray successor = prefixSuccessor(prefix);
+  int last = successor.isEmpty() ? size() : lowerBound(successor);
+
+  return qMakePair(first, last);
+}
+
+RedisClient::CompactKeyList RedisClient::CompactKeyList::keysWithPrefix(
+    const QByteArray &prefix) const {
+  CompactKeyList result;
+
+  if (!m_sorted) {
+    for (int i = 0; i < size(); ++i) {
+      int keySize = 0;
+      const char *key = plainKey(i, &keySize);
+
+      if (startsWith(key, keySize, prefix)) result.appendKey(key, keySize);
+    }
+    return result;
+  }
+
+  QPair<int, int> range = prefixRange(prefix);
+
+  if (range.first == range.second) return result;
+
+  if (!m_compressed) {
+    // Keys of range are contiguous in plain lists
+    int begin = static_cast<int>(m_offsets.at(range.first));
+    int end = entryEnd(range.second - 1);
+
+    result.m_data = QByteArray(m_data.constData() + begin, end - begin);
+    result.m_offsets.reserve(range.second - range.first);
+
+    for (int i = range.first; i < range.second; ++i)
+      result.m_offsets.append(m_offsets.at(i) - static_cast<quint32>(begin));
+
+    return result;
+  }
+
+  // Keys are appended in order, so result stays compressed
+  result.m_compressed = true;
+
+  for (const_iterator it(this, range.first); it.index() < range.second; ++it)
+    result.appendKey(it->constData(), it->size());
+
+  return result;
+}
+
+bool RedisClient::CompactKeyList::contains(const QByteArray &key) const {
+  if (!m_sorted) {
+    for (int i = 0; i < size(); ++i) {
+      int keySize = 0;
+      const char *k = plainKey(i, &keySize);
+
+      if (compareKeys(k, keySize, key.constData(), key.size()) == 0)
+        return true;
+    }
+    return false;
+  }
+
+  int i = lowerBound(key);
+
+  return i < size() && at(i) == key;
+}
+
+qint64 RedisClient::CompactKeyList::memoryUsage() const {
+  return static_cast<qint64>(sizeof(CompactKeyList)) + m_data.capacity() +
+         static_cast<qint64>(m_offsets.capacity()) *
+             static_cast<qint64>(sizeof(quint32)) +
+         m_lastKey.capacity();
+}
+
+QList<QByteArray> RedisClient::CompactKeyList::toList() const {
+  QList<QByteArray> result;
+  result.reserve(size());
+
+  for (const QByteArray &key : *this)
+    result.append(QByteArray(key.constData(), key.size()));
+
+  return result;
+}
+
+int RedisClient::CompactKeyList::entryEnd(int i) const {
+  return i + 1 < m_offsets.size() ? static_cast<int>(m_offsets.at(i + 1))
+                                  : m_data.size();
+}
+
+const char *RedisClient::CompactKeyList::plainKey(int i, int *size) const {
+  int begin = static_cast<int>(m_offsets.at(i));
+  *size = entryEnd(i) - begin;
+  return m_data.constData() + begin;
+}
+
+const char *RedisClient::CompactKeyList::suffix(int i, int *shared,
+                                                int *size) const {
+  const char *p = m_data.constData() + m_offsets.at(i);
+  *shared = static_cast<int>(readVarint(p));
+  *size = static_cast<int>(m_data.constData() + entryEnd(i) - p);
+  return p;
+}
+
+QByteArray RedisClient::CompactKeyList::decode(int i) const {
+  QByteArray result;
+
+  for (int j = i - i % RESTART_INTERVAL; j <= i; ++j) {
+    int shared = 0, size = 0;
+    const char *s = suffix(j, &shared, &size);
+    assignKey(result, shared, s, size);
+  }
+
+  return result;
+}
+
+void RedisClient::CompactKeyList::checkCapacity(qint64 bytes) const {
+  if (m_data.size() + bytes > MAX_DATA_SIZE)
+    throw Exception("Key list is full");
+}
+
+void RedisClient::CompactKeyList::appendKey(const char *key, int size) {
+  if (m_compressed) {
+    if (compareKeys(key, size, m_lastKey.constData(), m_lastKey.size()) >=
+        0) {
+      int shared =
+          this->size() % RESTART_INTERVAL == 0
+              ? 0
+              : sharedPrefix(m_lastKey.constData(), m_lastKey.size(), key,
+                             size);
+
+      checkCapacity(size - shared + MAX_VARINT_SIZE);
+      m_offsets.append(static_cast<quint32>(m_data.size()));
+      appendVarint(m_data, static_cast<quint32>(shared));
+      m_data.append(key + shared, size - shared);
+      assignKey(m_lastKey, shared, key + shared, size - shared);
+      return;
+    }
+
+    // Only sorted lists are compressed
+    decompress();
+  }
+
+  checkCapacity(size);
+
+  if (m_sorted && !isEmpty()) {
+    int lastSize = 0;
+    const char *last = plainKey(this->size() - 1, &lastSize);
+
+    if (compareKeys(key, size, last, lastSize) < 0) m_sorted = false;
+  }
+
+  m_offsets.append(static_cast<quint32>(m_data.size()));
+  m_data.append(key, size);
+}
+
+void RedisClient::CompactKeyList::requireSorted() const {
+  if (!m_sorted) throw Exception("Key list is not sorted");
+}
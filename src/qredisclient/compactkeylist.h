@@ -0,0 +1,154 @@
+#pragma once
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <iterator>
+#include "exception.h"
+
+namespace RedisClient {
+
+/**
+ * @brief The CompactKeyList class
+ * Contiguous list of keys for huge keyspaces. Keys are concatenated into
+ * a single byte blob indexed by quint32 offsets, so each key costs its
+ * size and 4 bytes instead of a separately allocated QByteArray.
+ *
+ * Sorted lists support binary search and prefix ranges. Sorted lists can
+ * be prefix-compressed: each key stores only the suffix after the prefix
+ * shared with previous key and every RESTART_INTERVAL-th key is stored
+ * whole, so random access decodes at most RESTART_INTERVAL keys.
+ *
+ * Total size of keys is limited by QByteArray (about 2 GB in Qt5).
+ */
+class CompactKeyList {
+  ADD_EXCEPTION
+
+ public:
+  enum class Layout { Unsorted, Sorted, SortedCompressed };
+
+  static const int RESTART_INTERVAL = 16;
+
+  /**
+   * @brief Forward iterator. Keys of plain lists share memory with the
+   * list, compressed keys are decoded one by one. Keys are valid until
+   * the iterator is incremented or the list is modified, copy key data
+   * to keep it longer.
+   */
+  class const_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef QByteArray value_type;
+    typedef int difference_type;
+    typedef const QByteArray *pointer;
+    typedef const QByteArray &reference;
+
+    const_iterator() : m_list(nullptr), m_index(0) {}
+
+    reference operator*() const { return m_key; }
+    pointer operator->() const { return &m_key; }
+
+    const_iterator &operator++();
+    const_iterator operator++(int);
+
+    bool operator==(const const_iterator &other) const {
+      return m_list == other.m_list && m_index == other.m_index;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+
+    int index() const { return m_index; }
+
+   private:
+    friend class CompactKeyList;
+    const_iterator(const CompactKeyList *list, int index);
+    void load(bool incremental);
+
+    const CompactKeyList *m_list;
+    int m_index;
+    QByteArray m_key;
+  };
+
+ public:
+  CompactKeyList();
+
+  /**
+   * @throws CompactKeyList::Exception if key data exceeds size limit
+   */
+  void append(const QByteArray &key);
+  void append(const QList<QByteArray> &keys);
+  void append(const CompactKeyList &other);
+
+  void reserve(int keys, int bytes);
+  void squeeze();
+  void clear();
+
+  int size() const { return m_offsets.size(); }
+  bool isEmpty() const { return m_offsets.isEmpty(); }
+
+  /**
+   * @brief Copy of i-th key
+   */
+  QByteArray at(int i) const;
+
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  /**
+   * @brief Keys appended in order keep list sorted, compressed lists
+   * are decompressed on first out of order key
+   */
+  bool isSorted() const { return m_sorted; }
+  bool isCompressed() const { return m_compressed; }
+
+  void arrange(Layout layout);
+  void sort();
+  void compress();
+  void decompress();
+
+  /**
+   * @brief Index of the first key not less than given key
+   * @throws CompactKeyList::Exception if list is not sorted
+   */
+  int lowerBound(const QByteArray &key) const;
+
+  /**
+   * @brief Indexes [first, last) of keys starting with prefix
+   * @throws CompactKeyList::Exception if list is not sorted
+   */
+  QPair<int, int> prefixRange(const QByteArray &prefix) const;
+
+  /**
+   * @brief Keys starting with prefix in list order. Sorted lists are
+   * searched with prefixRange(), unsorted are scanned.
+   */
+  CompactKeyList keysWithPrefix(const QByteArray &prefix) const;
+
+  bool contains(const QByteArray &key) const;
+
+  /**
+   * @brief Allocated bytes including reserved capacity
+   */
+  qint64 memoryUsage() const;
+
+  QList<QByteArray> toList() const;
+
+ private:
+  int entryEnd(int i) const;
+  const char *plainKey(int i, int *size) const;
+  const char *suffix(int i, int *shared, int *size) const;
+  QByteArray decode(int i) const;
+  void checkCapacity(qint64 bytes) const;
+  void appendKey(const char *key, int size);
+  void requireSorted() const;
+
+ private:
+  QByteArray m_data;
+  QVector<quint32> m_offsets;
+  bool m_sorted;
+  bool m_compressed;
+  QByteArray m_lastKey;  // decoded last key of compressed list
+};
+
+}  // namespace RedisClient
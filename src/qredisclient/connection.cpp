@@ -1,13 +1,24 @@
 #include "connection.h"
+#include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QJsonDocument>
-#include <QRegularExpression>
+#include <QMetaMethod>
+#include <QMutexLocker>
+#include <QPointer>
 #include <QThread>
 
 #include "command.h"
+#include "keyiterator.h"
+#include "namespacetree.h"
+#include "private/responsedispatcher.h"
+#include "responseparser.h"
 #include "scancommand.h"
 #include "transporters/defaulttransporter.h"
+#include "transporters/tcptransporter.h"
+#include "transporters/unixsockettransporter.h"
+#include "transporterthreadpool.h"
 #include "utils/compat.h"
 #include "utils/sync.h"
 
@@ -19,13 +30,183 @@ inline void initResources() { Q_INIT_RESOURCE(lua); }
 
 const QString END_OF_COLLECTION = "end_of_collection";
 
+// Limit redirects to avoid endless loops during resharding
+const int MAX_CLUSTER_REDIRECTS = 5;
+
+// Min interval between partial namespace tree updates in ms
+const qint64 NAMESPACE_UPDATE_INTERVAL = 100;
+
+const QByteArray NAMESPACE_SCAN_SCRIPT = "qredisclient:namespace_scan";
+
+// Resource is read once per process
+static QByteArray namespaceScanScript() {
+  static const QByteArray body = []() -> QByteArray {
+    QFile script("://scan.lua");
+    return script.open(QIODevice::ReadOnly) ? script.readAll() : QByteArray();
+  }();
+
+  return body;
+}
+
+static QString nodeId(const QPair<QString, int> &node) {
+  return QString("%1:%2").arg(node.first).arg(node.second);
+}
+
+// Sentinel addresses local nodes as they are seen from sentinel host
+static QString reachableHost(const QString &host,
+                            const RedisClient::ConnectionConfig &sentinel) {
+  if (!sentinel.useSshTunnel() && (host == "127.0.0.1" || host == "localhost"))
+    return sentinel.host();
+
+  return host;
+}
+
+// SENTINEL masters and SENTINEL replicas replies are lists of flat
+// field-value lists
+static QHash<QString, QString> sentinelFields(const QVariant &item) {
+  QStringList fields = item.toStringList();
+  QHash<QString, QString> info;
+
+  for (int i = 0; i + 1 < fields.size(); i += 2)
+    info.insert(fields.at(i), fields.at(i + 1));
+
+  return info;
+}
+
+// Reply of SENTINEL get-master-addr-by-name if name is set or
+// SENTINEL masters otherwise. Name of found master is set to name.
+static QPair<QString, int> sentinelMasterAddress(
+    const RedisClient::Response &r, QString &name) {
+  if (!r.isArray()) return QPair<QString, int>();
+
+  QVariantList result = r.value().toList();
+
+  if (!name.isEmpty()) {
+    if (result.size() < 2) return QPair<QString, int>();
+
+    return qMakePair(result.at(0).toString(), result.at(1).toInt());
+  }
+
+  for (const QVariant &master : result) {
+    QHash<QString, QString> info = sentinelFields(master);
+
+    if (info.value("ip").isEmpty()) continue;
+
+    name = info.value("name");
+    return qMakePair(info.value("ip"), info.value("port").toInt());
+  }
+
+  return QPair<QString, int>();
+}
+
+static QList<QPair<QString, int>> healthySentinelReplicas(
+    const RedisClient::Response &r) {
+  QList<QPair<QString, int>> result;
+
+  if (!r.isArray()) return result;
+
+  for (const QVariant &replica : r.value().toList()) {
+    QHash<QString, QString> info = sentinelFields(replica);
+    QString flags = info.value("flags");
+
+    if (info.value("ip").isEmpty() || flags.contains("s_down") ||
+        flags.contains("o_down") || flags.contains("disconnected"))
+      continue;
+
+    result.append(qMakePair(info.value("ip"), info.value("port").toInt()));
+  }
+
+  return result;
+}
+
+// Appends pages to a single list, list is passed to callback once
+struct CompactKeysCollector {
+  CompactKeysCollector(RedisClient::Connection::CompactKeysListCallback c,
+                       RedisClient::CompactKeyList::Layout l)
+      : callback(c), layout(l), finished(false) {}
+
+  void addPage(const RedisClient::Connection::RawKeysList &page,
+               const QString &err, bool final) {
+    if (finished) return;
+
+    if (!err.isEmpty()) return finish(err);
+
+    try {
+      keys.append(page);
+
+      if (!final) return;
+
+      keys.arrange(layout);
+      keys.squeeze();
+    } catch (const RedisClient::CompactKeyList::Exception &e) {
+      return finish(QString("Cannot load keys: %1").arg(e.what()));
+    }
+
+    finish(QString());
+  }
+
+  void finish(const QString &err) {
+    finished = true;
+    callback(err.isEmpty() ? keys : RedisClient::CompactKeyList(), err);
+    keys.clear();
+  }
+
+  RedisClient::Connection::CompactKeysListCallback callback;
+  RedisClient::CompactKeyList::Layout layout;
+  RedisClient::CompactKeyList keys;
+  bool finished;
+};
+
+static RedisClient::KeyIterator::Options databaseKeysOptions(
+    const QString &pattern, int dbIndex, long scanLimit) {
+  RedisClient::KeyIterator::Options options;
+  options.pattern = pattern.toUtf8();
+  options.dbIndex = dbIndex;
+  options.count = static_cast<uint>(qMax(1L, scanLimit));
+  options.maxCount = qMax(options.maxCount, options.count);
+  return options;
+}
+
+// Requests pages one by one until the last page or error
+static void streamKeys(RedisClient::KeyIterator iterator,
+                       RedisClient::KeyIterator::PageCallback callback) {
+  iterator.next([iterator, callback](const RedisClient::KeyIterator::Page &keys,
+                                     const QString &err, bool final) {
+    callback(keys, err, final);
+
+    if (final || !err.isEmpty()) return;
+
+    try {
+      streamKeys(iterator, callback);
+    } catch (const RedisClient::Connection::Exception &e) {
+      callback(RedisClient::KeyIterator::Page(),
+               QString("Cannot load keys: %1").arg(e.what()), true);
+    }
+  });
+}
+
 RedisClient::Connection::Connection(const ConnectionConfig &c, bool autoConnect)
-    : m_config(c),
+    : Connection(ConnectionSettings::create(c), autoConnect) {}
+
+RedisClient::Connection::Connection(
+    QSharedPointer<const ConnectionSettings> settings, bool autoConnect)
+    : m_settings(settings),
       m_dbNumber(0),
-      m_currentMode(Mode::Normal),
+      m_currentMode(static_cast<int>(Mode::Normal)),
+      m_protocolVersion(2),
+      m_fractionalTimeouts(0),
       m_autoConnect(autoConnect),
-      m_stoppingTransporter(false) {
+      m_stoppingTransporter(false),
+      m_sharedTransporterThread(false),
+      m_fullServerInfoLoaded(0),
+      m_scripts(new ScriptCache()),
+      m_metrics(new ConnectionMetrics()),
+      m_isClusterNode(false),
+      m_readOnlyNode(false),
+      m_isSentinelNode(false),
+      m_readCounter(0) {
   initResources();
+  m_routingClock.start();
 }
 
 RedisClient::Connection::~Connection() {
@@ -35,24 +216,41 @@ RedisClient::Connection::~Connection() {
 bool RedisClient::Connection::connect(bool wait) {
   if (isConnected()) return true;
 
-  if (m_config.isValid() == false) throw Exception("Invalid config detected");
+  auto settings = sharedSettings();
+
+  if (settings->isValid == false) throw Exception("Invalid config detected");
 
   if (m_transporter.isNull()) createTransporter();
 
   // Create & run transporter
-  m_transporterThread = QSharedPointer<QThread>(new QThread);
-  m_transporterThread->setObjectName("qredisclient::transporter_thread");
-  m_transporter->moveToThread(m_transporterThread.data());
+  m_sharedTransporterThread = settings->useSharedTransporterThread;
 
-  QObject::connect(m_transporterThread.data(), &QThread::started,
-                   m_transporter.data(), &AbstractTransporter::init);
-  QObject::connect(m_transporterThread.data(), &QThread::finished,
-                   m_transporter.data(),
-                   &AbstractTransporter::disconnectFromHost);
+  if (m_sharedTransporterThread) {
+    m_transporterThread = TransporterThreadPool::instance().acquire();
+  } else {
+    m_transporterThread = QSharedPointer<QThread>(new QThread);
+    m_transporterThread->setObjectName("qredisclient::transporter_thread");
+
+    QObject::connect(m_transporterThread.data(), &QThread::started,
+                     m_transporter.data(), &AbstractTransporter::init);
+    QObject::connect(m_transporterThread.data(), &QThread::finished,
+                     m_transporter.data(),
+                     &AbstractTransporter::disconnectFromHost);
+  }
+
+  m_transporter->moveToThread(m_transporterThread.data());
   QObject::connect(this, &Connection::shutdownStart, m_transporter.data(),
                    &AbstractTransporter::disconnectFromHost);
+  // Handshake runs in transporter thread, so it doesn't depend on event
+  // loop of connection thread which can be blocked by connect(true)
   QObject::connect(m_transporter.data(), &AbstractTransporter::connected, this,
-                   &Connection::auth);
+                   &Connection::auth, Qt::DirectConnection);
+  QObject::connect(m_transporter.data(),
+                   &AbstractTransporter::pushMessageReceived, this,
+                   &Connection::pushMessageReceived);
+  QObject::connect(m_transporter.data(),
+                   &AbstractTransporter::queuePressureChanged, this,
+                   &Connection::commandQueuePressure);
   QObject::connect(m_transporter.data(), &AbstractTransporter::errorOccurred,
                    this, [this](const QString &err) {
                      disconnect();
@@ -62,16 +260,17 @@ bool RedisClient::Connection::connect(bool wait) {
                    [this](const QString &) { disconnect(); });
 
   if (wait) {
-    SignalWaiter waiter(m_config.connectionTimeout());
+    SignalWaiter waiter(settings->connectionTimeout);
     waiter.addAbortSignal(this, &Connection::shutdownStart);
     waiter.addAbortSignal(m_transporter.data(),
                           &AbstractTransporter::errorOccurred);
     waiter.addAbortSignal(this, &Connection::authError);
     waiter.addSuccessSignal(this, &Connection::authOk);
-    m_transporterThread->start();
+
+    startTransporter();
     return waiter.wait();
   } else {
-    m_transporterThread->start();
+    startTransporter();
     return true;
   }
 }
@@ -84,13 +283,45 @@ void RedisClient::Connection::disconnect() {
   emit shutdownStart();
   if (isTransporterRunning()) {
     m_stoppingTransporter = true;
-    m_transporterThread->quit();
-    m_transporterThread->wait();
+    stopTransporter();
     m_transporter.clear();
     m_transporterThread.clear();
     m_stoppingTransporter = false;
   }
-  m_dbNumber = 0;
+  m_dbNumber.storeRelease(0);
+  m_protocolVersion.storeRelease(2);
+
+  // Invalidations are not received without connection
+  m_cacheEnabled.storeRelease(0);
+  if (m_cache) m_cache->clear();
+
+  QHash<QString, QSharedPointer<Connection>> clusterNodes;
+  QHash<QString, QSharedPointer<Connection>> replicaNodes;
+
+  {
+    QMutexLocker lock(&m_routingLock);
+    clusterNodes.swap(m_clusterNodes);
+    replicaNodes.swap(m_replicaNodes);
+    m_nodeLatency.clear();
+  }
+
+  for (auto node : clusterNodes) node->disconnect();
+  m_slotMap.clear();
+
+  for (auto node : replicaNodes) node->disconnect();
+
+  QHash<QString, QSharedPointer<Connection>> sentinels;
+
+  {
+    QMutexLocker lock(&m_routingLock);
+    sentinels.swap(m_sentinels);
+  }
+
+  for (auto sentinel : sentinels) sentinel->disconnect();
+
+  QSharedPointer<Connection> bulkLane = sharedBulkLane();
+
+  if (bulkLane) bulkLane->disconnect();
 }
 
 QFuture<RedisClient::Response> RedisClient::Connection::command(
@@ -125,6 +356,28 @@ QFuture<RedisClient::Response> RedisClient::Connection::command(
   }
 }
 
+QFuture<QByteArray> RedisClient::Connection::getTyped(const QByteArray &key,
+                                                      int db) {
+  return commandTyped<QByteArray>(Command({"GET", key}, db));
+}
+
+QFuture<QHash<QByteArray, QByteArray>> RedisClient::Connection::hgetallTyped(
+    const QByteArray &key, int db) {
+  return commandTyped<QHash<QByteArray, QByteArray>>(
+      Command({"HGETALL", key}, db));
+}
+
+QFuture<QVector<QByteArray>> RedisClient::Connection::mgetTyped(
+    const QList<QByteArray> &keys, int db) {
+  return commandTyped<QVector<QByteArray>>(
+      Command(QList<QByteArray>({"MGET"}) + keys, db));
+}
+
+QFuture<qint64> RedisClient::Connection::incrTyped(const QByteArray &key,
+                                                   int db) {
+  return commandTyped<qint64>(Command({"INCR", key}, db));
+}
+
 RedisClient::Response RedisClient::Connection::commandSync(
     QList<QByteArray> rawCmd, int db) {
   Command cmd(rawCmd, db);
@@ -133,9 +386,32 @@ RedisClient::Response RedisClient::Connection::commandSync(
 
 RedisClient::Response RedisClient::Connection::commandSync(
     const Command &command) {
-  auto future = runCommand(command);
+  // Otherwise reply would depend on handshake callbacks of this thread
+  if (!isConnected() && m_autoConnect && !connect(true))
+    return RedisClient::Response();
+
+  SignalWaiter waiter(command.timeout() > 0
+                          ? command.timeout()
+                          : sharedSettings()->executeTimeout);
+
+  // Transporter or forwarding handler of node connection wakes up
+  // waiting thread directly, no events of this thread are delivered
+  std::function<void()> wakeUp = waiter.successTrigger();
+  Command::Callback handler = command.getCompletionHandler();
+
+  Command cmd = command;
+  cmd.setCompletionHandler([wakeUp, handler](Response r, QString err) {
+    if (handler) handler(r, err);
+    wakeUp();
+  });
+
+  auto future = runCommand(cmd);
 
-  if (future.isCanceled()) return RedisClient::Response();
+  if (!future.isFinished()) waiter.wait();
+
+  if (!future.isFinished() || future.isCanceled() ||
+      future.resultCount() == 0)
+    return RedisClient::Response();
 
   return future.result();
 }
@@ -146,39 +422,140 @@ QFuture<RedisClient::Response> RedisClient::Connection::runCommand(
 
   if (!isConnected()) {
     if (m_autoConnect) {
-      auto d = QSharedPointer<AsyncFuture::Deferred<RedisClient::Response>>(
-          new AsyncFuture::Deferred<RedisClient::Response>());
-
-      callAfterConnect([this, cmd, d](const QString &err) {
+      // Command completes own deferred, so waiting for it doesn't
+      // depend on future watchers of this thread
+      callAfterConnect([this, cmd](const QString &err) {
         if (err.isEmpty()) {
-          d->complete(runCommand(cmd));
+          runCommand(cmd);
         } else {
-          d->cancel();
+          cmd.getDeferred().cancel();
+
+          if (ResponseDispatcher::canDispatch(cmd))
+            ResponseDispatcher::dispatch(cmd, Response(), err);
         }
       });
 
       connect(false);
 
-      return d->future();
+      return cmd.getDeferred().future();
     } else {
       throw Exception("Try run command in not connected state");
     }
   }
 
-  if (cmd.getOwner() && cmd.getOwner() != this)
-    QObject::connect(cmd.getOwner(), SIGNAL(destroyed(QObject *)),
-                     m_transporter.data(), SLOT(cancelCommands(QObject *)),
-                     static_cast<Qt::ConnectionType>(Qt::QueuedConnection |
-                                                     Qt::UniqueConnection));
+  trackCommandOwner(cmd.getOwner());
+
+  if (m_cacheEnabled.loadAcquire() && ClientSideCache::isCacheable(cmd)) {
+    Response cached;
+    int db = cmd.hasDbIndex() ? cmd.getDbIndex() : dbIndex();
+
+    if (m_cache->lookup(cmd, db, cached)) {
+      auto deferred = cmd.getDeferred();
+      deferred.complete(cached);
+      return deferred.future();
+    }
+  }
+
+  if (isBulkLaneCommand(cmd)) {
+    runBulkLaneCommand(cmd);
+    return cmd.getDeferred().future();
+  }
+
+  if (mode() == Mode::Cluster && !m_slotMap.isEmpty()) {
+    int slot = ClusterSlotMap::commandSlot(cmd);
+    Host node = m_slotMap.nodeForSlot(slot);
+
+    if (!node.first.isEmpty()) {
+      Host readNode = node;
+
+      if (isReplicaReadCommand(cmd) &&
+          !selectReadNode(node, m_slotMap.replicasForSlot(slot), readNode)) {
+        emit log("Cannot run read-only command: no replicas available");
+        cmd.getDeferred().cancel();
+        return cmd.getDeferred().future();
+      }
+
+      routeClusterCommand(cmd, slot, readNode, false);
+      return cmd.getDeferred().future();
+    }
+  }
+
+  bool masterRead = false;
+  Host sentinelMaster;
+
+  if (mode() == Mode::Sentinel && isReplicaReadCommand(cmd)) {
+    HostList replicas;
+    Host readNode;
+
+    {
+      QMutexLocker lock(&m_routingLock);
+      sentinelMaster = m_sentinelMaster;
+      replicas = m_sentinelReplicas;
+    }
+
+    if (!selectReadNode(sentinelMaster, replicas, readNode)) {
+      emit log("Cannot run read-only command: no replicas available");
+      cmd.getDeferred().cancel();
+      return cmd.getDeferred().future();
+    }
+
+    if (readNode != sentinelMaster) {
+      runReplicaCommand(cmd, readNode);
+      return cmd.getDeferred().future();
+    }
+
+    masterRead = true;
+  }
 
   auto deferred = cmd.getDeferred();
 
-  emit addCommandToWorker(cmd);
+  m_transporter->submitCommand(cmd);
+
+  if (masterRead) trackNodeLatency(sentinelMaster, deferred.future());
 
   return deferred.future();
 }
 
+void RedisClient::Connection::runCommands(const QList<Command> &commands) {
+  for (const Command &cmd : commands) {
+    if (!cmd.isValid()) throw Exception("Command is not valid");
+  }
+
+  if (commands.isEmpty()) return;
+
+  if (!isConnected()) {
+    if (m_autoConnect) {
+      callAfterConnect([this, commands](const QString &err) {
+        if (err.isEmpty()) return runCommands(commands);
+
+        for (const Command &cmd : commands) {
+          cmd.getDeferred().cancel();
+
+          if (ResponseDispatcher::canDispatch(cmd))
+            ResponseDispatcher::dispatch(cmd, Response(), err);
+        }
+      });
+
+      connect(false);
+      return;
+    } else {
+      throw Exception("Try run command in not connected state");
+    }
+  }
+
+  for (const Command &cmd : commands) trackCommandOwner(cmd.getOwner());
+
+  m_transporter->submitCommands(commands);
+}
+
+RedisClient::Pipeline RedisClient::Connection::pipeline() {
+  return Pipeline(this);
+}
+
 bool RedisClient::Connection::waitForIdle(uint timeout) {
+  if (m_transporter.isNull()) return false;
+
+  // Signal is emitted in transporter thread
   SignalWaiter waiter(timeout);
   waiter.addSuccessSignal(m_transporter.data(),
                           &AbstractTransporter::queueIsEmpty);
@@ -187,7 +564,7 @@ bool RedisClient::Connection::waitForIdle(uint timeout) {
 
 QSharedPointer<RedisClient::Connection> RedisClient::Connection::clone() const {
   return QSharedPointer<RedisClient::Connection>(
-      new RedisClient::Connection(getConfig()));
+      new RedisClient::Connection(sharedSettings()));
 }
 
 void RedisClient::Connection::retrieveCollection(
@@ -217,113 +594,194 @@ void RedisClient::Connection::retrieveCollectionIncrementally(
 }
 
 RedisClient::ConnectionConfig RedisClient::Connection::getConfig() const {
-  return m_config;
+  return sharedSettings()->config;
+}
+
+QSharedPointer<const RedisClient::ConnectionSettings>
+RedisClient::Connection::sharedSettings() const {
+  QMutexLocker lock(&m_settingsLock);
+  return m_settings;
 }
 
 void RedisClient::Connection::setConnectionConfig(
     const RedisClient::ConnectionConfig &c) {
-  m_config = c;
+  QSharedPointer<const ConnectionSettings> settings =
+      ConnectionSettings::create(c);
+
+  // Previous settings are released outside of lock
+  QMutexLocker lock(&m_settingsLock);
+  m_settings.swap(settings);
 }
 
 RedisClient::Connection::Mode RedisClient::Connection::mode() const {
-  return m_currentMode;
+  return static_cast<Mode>(m_currentMode.loadAcquire());
+}
+
+int RedisClient::Connection::dbIndex() const {
+  return m_dbNumber.loadAcquire();
+}
+
+int RedisClient::Connection::protocolVersion() const {
+  return m_protocolVersion.loadAcquire();
+}
+
+RedisClient::ClientSideCache::Stats
+RedisClient::Connection::clientSideCacheStats() const {
+  if (!m_cache) return ClientSideCache::Stats{0, 0, 0, 0, 0, 0};
+
+  return m_cache->stats();
+}
+
+RedisClient::ConnectionMetrics::Snapshot RedisClient::Connection::metrics()
+    const {
+  return m_metrics->snapshot();
+}
+
+QByteArray RedisClient::Connection::prometheusMetrics() const {
+  return m_metrics->snapshot().toPrometheus(sharedSettings()->name);
 }
 
-int RedisClient::Connection::dbIndex() const { return m_dbNumber; }
+void RedisClient::Connection::resetMetrics() { m_metrics->reset(); }
+
+bool RedisClient::Connection::isLogEnabled() const {
+  static const QMetaMethod logSignal = QMetaMethod::fromSignal(&Connection::log);
+  return isSignalConnected(logSignal);
+}
 
 double RedisClient::Connection::getServerVersion() {
-  return m_serverInfo.version;
+  return serverInfo().version;
 }
 
 RedisClient::DatabaseList RedisClient::Connection::getKeyspaceInfo() {
-  return m_serverInfo.databases;
+  return serverInfo().databases;
+}
+
+RedisClient::ServerInfo::ParsedServerInfo
+RedisClient::Connection::getParsedServerInfo() {
+  if (!m_fullServerInfoLoaded.loadAcquire()) refreshServerInfo();
+
+  return serverInfo().parsed;
 }
 
 void RedisClient::Connection::refreshServerInfo() {
   Response infoResult = internalCommandSync({"INFO", "ALL"});
-  m_serverInfo = ServerInfo::fromString(infoResult.value().toString());
+  setServerInfo(ServerInfo::fromBytes(infoResult.toByteArray()));
+  m_fullServerInfoLoaded.storeRelease(1);
+}
+
+RedisClient::ServerInfo RedisClient::Connection::serverInfo() const {
+  QMutexLocker lock(&m_serverInfoLock);
+  return m_serverInfo;
+}
+
+void RedisClient::Connection::setServerInfo(const ServerInfo &info) {
+  QMutexLocker lock(&m_serverInfoLock);
+  m_serverInfo = info;
+  m_fractionalTimeouts.storeRelease(info.version >= 6.0);
 }
 
 void RedisClient::Connection::getClusterKeys(RawKeysListCallback callback,
                                              const QString &pattern) {
-  if (mode() != Mode::Cluster) {
-    throw Exception("Connection is not in cluster mode");
-  }
-
   QSharedPointer<RawKeysList> result(new RawKeysList());
-  m_notVisitedMasterNodes =
-      QSharedPointer<HostList>(new HostList(getMasterNodes()));
 
-  auto onConnect = [this, callback, pattern, result](const QString &err) {
-    if (!err.isEmpty()) {
-      return callback(*result,
-                      QObject::tr("Cannot connect to cluster node %1:%2")
-                          .arg(m_config.host())
-                          .arg(m_config.port()));
-    }
+  getClusterKeysIncrementally(
+      [result, callback](const RawKeysList &keys, const QString &err,
+                         bool final) {
+        if (!final) return result->append(keys);
 
-    getDatabaseKeys(m_collectClusterNodeKeys, pattern);
-  };
+        if (!err.isEmpty()) return callback(RawKeysList(), err);
 
-  m_collectClusterNodeKeys = [this, result, callback, onConnect](
-                                 const RawKeysList &res, const QString &err) {
-    if (!err.isEmpty()) {
-      return callback(RawKeysList(), err);
-    }
+        callback(*result, QString());
+      },
+      pattern);
+}
 
-    result->append(res);
+void RedisClient::Connection::getClusterKeysCompact(
+    CompactKeysListCallback callback, const QString &pattern,
+    CompactKeyList::Layout layout) {
+  QSharedPointer<CompactKeysCollector> collector(
+      new CompactKeysCollector(callback, layout));
 
-    if (!hasNotVisitedClusterNodes()) return callback(*result, QString());
+  getClusterKeysIncrementally(
+      [collector](const RawKeysList &keys, const QString &err, bool final) {
+        collector->addPage(keys, err, final);
+      },
+      pattern);
+}
 
-    clusterConnectToNextMasterNode(onConnect);
-  };
+void RedisClient::Connection::getClusterKeysIncrementally(
+    IncrementalRawKeysListCallback callback, const QString &pattern) {
+  KeyIterator::Options options;
+  options.pattern = pattern.toUtf8();
+
+  // Nodes are scanned in parallel, pages are passed to callback as soon as
+  // they are received from any node
+  forEachMaster(
+      [callback, options](QSharedPointer<Connection> node,
+                          std::function<void(const QString &)> done) {
+        streamKeys(KeyIterator(node.data(), options),
+                   [node, callback, done](const RawKeysList &keys,
+                                          const QString &err, bool final) {
+                     if (!err.isEmpty()) return done(err);
 
-  clusterConnectToNextMasterNode(onConnect);
+                     if (!keys.isEmpty()) callback(keys, QString(), false);
+
+                     if (final) done(QString());
+                   });
+      },
+      [callback](const QString &err) { callback(RawKeysList(), err, true); });
 }
 
-void RedisClient::Connection::flushDbKeys(
-    int dbIndex, std::function<void(const QString &)> callback) {
-  if (mode() == Mode::Cluster) {
-    m_notVisitedMasterNodes =
-        QSharedPointer<HostList>(new HostList(getMasterNodes()));
-
-    auto onConnect = [this, callback](const QString &err) {
-      if (!err.isEmpty()) {
-        return callback(QObject::tr("Cannot connect to cluster node %1:%2")
-                            .arg(m_config.host())
-                            .arg(m_config.port()));
-      }
+void RedisClient::Connection::analyzeKeyspace(
+    KeyspaceReportCallback callback, const KeyspaceAnalyzer::Options &options) {
+  KeyspaceAnalyzer analyzer(options);
+  analyzer.setProgressCallback(
+      [callback](const KeyspaceAnalyzer::Report &report) {
+        callback(report, QString(), false);
+      });
 
-      command({"FLUSHDB"}, this, m_cmdCallback);
-    };
+  auto onFinished = [analyzer, callback](const QString &err) {
+    callback(analyzer.report(), err, true);
+  };
 
-    m_cmdCallback = [this, callback, dbIndex, onConnect](
-                        const RedisClient::Response &, const QString &error) {
-      if (!error.isEmpty()) {
-        callback(QString(QObject::tr("Cannot flush db (%1): %2"))
-                     .arg(dbIndex)
-                     .arg(error));
-        return;
-      }
+  if (mode() != Mode::Cluster) return analyzer.analyze(this, onFinished);
 
-      if (!hasNotVisitedClusterNodes()) return callback(QString());
+  // Nodes share analyzer, so report contains keys of all nodes
+  forEachMaster(
+      [analyzer](QSharedPointer<Connection> node,
+                 std::function<void(const QString &)> done) mutable {
+        analyzer.analyze(node.data(),
+                         [node, done](const QString &err) { done(err); });
+      },
+      onFinished);
+}
 
-      clusterConnectToNextMasterNode(onConnect);
-    };
+void RedisClient::Connection::flushDbKeys(
+    int dbIndex, std::function<void(const QString &)> callback) {
+  auto onFlushed = [dbIndex, callback](const QString &error) {
+    if (!error.isEmpty()) {
+      callback(QString(QObject::tr("Cannot flush db (%1): %2"))
+                   .arg(dbIndex)
+                   .arg(error));
+    } else {
+      callback(QString());
+    }
+  };
 
-    clusterConnectToNextMasterNode(onConnect);
+  if (mode() == Mode::Cluster) {
+    forEachMaster(
+        [](QSharedPointer<Connection> node,
+           std::function<void(const QString &)> done) {
+          node->command({"FLUSHDB"}, node.data(),
+                        [done](const RedisClient::Response &,
+                               const QString &error) { done(error); });
+        },
+        onFlushed);
   } else {
     command(
         {"FLUSHDB"}, this,
-        [dbIndex, callback](const RedisClient::Response &,
-                            const QString &error) {
-          if (!error.isEmpty()) {
-            callback(QString(QObject::tr("Cannot flush db (%1): %2"))
-                         .arg(dbIndex)
-                         .arg(error));
-          } else {
-            callback(QString());
-          }
+        [onFlushed](const RedisClient::Response &, const QString &error) {
+          onFlushed(error);
         },
         dbIndex);
   }
@@ -332,38 +790,98 @@ void RedisClient::Connection::flushDbKeys(
 void RedisClient::Connection::getDatabaseKeys(RawKeysListCallback callback,
                                               const QString &pattern,
                                               int dbIndex, long scanLimit) {
-  QList<QByteArray> rawCmd{"scan",  "0",
-                           "MATCH", pattern.toUtf8(),
-                           "COUNT", QString::number(scanLimit).toLatin1()};
-  ScanCommand keyCmd(rawCmd, dbIndex);
+  KeyIterator::Options options =
+      databaseKeysOptions(pattern, dbIndex, scanLimit);
+
+  // Pages are converted to QByteArray lists as soon as they are received,
+  // so only keys themselves are kept in memory
+  QSharedPointer<RawKeysList> result(new RawKeysList());
+
+  streamKeys(KeyIterator(this, options),
+             [result, callback](const RawKeysList &keys, const QString &err,
+                                bool final) {
+               if (!err.isEmpty()) return callback(RawKeysList(), err);
 
-  retrieveCollection(keyCmd, [callback](QVariant r, QString err) {
-    if (!err.isEmpty())
-      return callback(RawKeysList(), QString("Cannot load keys: %1").arg(err));
+               result->append(keys);
 
-    auto keysList = convertQVariantList(r.toList());
+               if (final) callback(*result, QString());
+             });
+}
+
+void RedisClient::Connection::getDatabaseKeysCompact(
+    CompactKeysListCallback callback, const QString &pattern, int dbIndex,
+    long scanLimit, CompactKeyList::Layout layout) {
+  QSharedPointer<CompactKeysCollector> collector(
+      new CompactKeysCollector(callback, layout));
 
-    return callback(keysList, QString());
+  // Keys are copied out of each page, so reply buffers are released
+  // right after the page is processed
+  KeyIterator iterator(this, databaseKeysOptions(pattern, dbIndex, scanLimit));
+
+  streamKeys(iterator, [collector](const RawKeysList &keys, const QString &err,
+                                   bool final) {
+    collector->addPage(keys, err, final);
   });
 }
 
 void RedisClient::Connection::getNamespaceItems(
     RedisClient::Connection::NamespaceItemsCallback callback,
     const QString &nsSeparator, const QString &filter, int dbIndex) {
-  QFile script("://scan.lua");
-  if (!script.open(QIODevice::ReadOnly)) {
-    qWarning() << "Cannot open LUA resource";
-    return;
-  }
+  if (sharedSettings()->serverSideNamespaceScan)
+    return getNamespaceItemsWithScript(callback, nsSeparator, filter, dbIndex);
+
+  getNamespaceItemsIncrementally(
+      [callback](const NamespaceItems &items, const QString &err, bool final) {
+        if (final) callback(items, err);
+      },
+      nsSeparator, filter, dbIndex);
+}
 
-  QByteArray LUA_SCRIPT = script.readAll();
+void RedisClient::Connection::getNamespaceItemsIncrementally(
+    IncrementalNamespaceItemsCallback callback, const QString &nsSeparator,
+    const QString &filter, int dbIndex) {
+  KeyIterator::Options options;
+  options.pattern = filter.toUtf8() + "*";
+  options.dbIndex = dbIndex;
 
-  QList<QByteArray> rawCmd{"eval", LUA_SCRIPT, "0", nsSeparator.toUtf8(),
-                           filter.toUtf8()};
+  QSharedPointer<NamespaceTree> tree(
+      new NamespaceTree(nsSeparator.toUtf8(), filter.toUtf8()));
+  QSharedPointer<QElapsedTimer> lastUpdate(new QElapsedTimer());
 
-  Command evalCmd(rawCmd, dbIndex);
+  streamKeys(KeyIterator(this, options), [tree, lastUpdate, callback](
+                                             const RawKeysList &keys,
+                                             const QString &err, bool final) {
+    if (!err.isEmpty()) return callback(NamespaceItems(), err, true);
 
-  evalCmd.setCallBack(this, [callback](RedisClient::Response r, QString error) {
+    tree->addKeys(keys);
+
+    if (final) return callback(tree->rootItems(), QString(), true);
+
+    // First page is passed immediately, next updates are throttled
+    if (keys.isEmpty() || (lastUpdate->isValid() &&
+                           lastUpdate->elapsed() < NAMESPACE_UPDATE_INTERVAL))
+      return;
+
+    lastUpdate->start();
+    callback(tree->rootItems(), QString(), false);
+  });
+}
+
+void RedisClient::Connection::getNamespaceItemsWithScript(
+    RedisClient::Connection::NamespaceItemsCallback callback,
+    const QString &nsSeparator, const QString &filter, int dbIndex) {
+  if (!m_scripts->script(NAMESPACE_SCAN_SCRIPT).isValid()) {
+    QByteArray body = namespaceScanScript();
+
+    if (body.isEmpty()) {
+      qWarning() << "Cannot open LUA resource";
+      return;
+    }
+
+    registerScript(NAMESPACE_SCAN_SCRIPT, body);
+  }
+
+  auto processResult = [callback](RedisClient::Response r, QString error) {
     if (!error.isEmpty()) {
       return callback(NamespaceItems(), error);
     }
@@ -403,24 +921,61 @@ void RedisClient::Connection::getNamespaceItems(
     foreach (QString key, rootKeys) { keys.append(key.toUtf8()); }
 
     callback(NamespaceItems(rootNs, keys), QString());
-  });
+  };
 
-  runCommand(evalCmd);
+  runScript(NAMESPACE_SCAN_SCRIPT, QList<QByteArray>(),
+            QList<QByteArray>{nsSeparator.toUtf8(), filter.toUtf8()}, this,
+            processResult, dbIndex);
 }
 
 void RedisClient::Connection::createTransporter() {
-  // todo : implement unix socket transporter
-  if (m_config.useSshTunnel()) {
+  auto settings = sharedSettings();
+
+  if (settings->useUnixSocket) {
+    m_transporter =
+        QSharedPointer<AbstractTransporter>(new UnixSocketTransporter(this));
+  } else if (settings->useSshTunnel) {
 #ifdef SSH_SUPPORT
     m_transporter =
         QSharedPointer<AbstractTransporter>(new SshTransporter(this));
 #else
     throw SSHSupportException("QRedisClient compiled without ssh support.");
 #endif
-  } else {
+  } else if (settings->useSsl) {
     m_transporter =
         QSharedPointer<AbstractTransporter>(new DefaultTransporter(this));
+  } else {
+    m_transporter =
+        QSharedPointer<AbstractTransporter>(new TcpTransporter(this));
+  }
+}
+
+void RedisClient::Connection::startTransporter() {
+  if (!m_sharedTransporterThread) return m_transporterThread->start();
+
+  // Shared thread is already running
+  QMetaObject::invokeMethod(m_transporter.data(), "init",
+                            Qt::QueuedConnection);
+}
+
+void RedisClient::Connection::stopTransporter() {
+  if (!m_sharedTransporterThread) {
+    m_transporterThread->quit();
+    m_transporterThread->wait();
+    return;
   }
+
+  // Transporter should be destroyed in this thread
+  // because shared thread keeps running
+  Qt::ConnectionType type =
+      m_transporterThread.data() == QThread::currentThread()
+          ? Qt::DirectConnection
+          : Qt::BlockingQueuedConnection;
+
+  QMetaObject::invokeMethod(m_transporter.data(), "detachToThread", type,
+                            Q_ARG(QThread *, QThread::currentThread()));
+
+  TransporterThreadPool::instance().release(m_transporterThread);
 }
 
 bool RedisClient::Connection::isTransporterRunning() {
@@ -450,7 +1005,8 @@ void RedisClient::Connection::processScanCommand(
           /*
            * aliyun cloud provides iscan command for scanning clusters
            */
-          if (cmd.getPartAsString(0).toLower() == "scan" &&
+          if (CommandInfo::nameEquals(cmd.getSplitedRepresentattion().first(),
+                                      "scan") &&
               r.isDisabledCommandErrorMessage()) {
             auto rawCmd = cmd.getSplitedRepresentattion();
             rawCmd.replace(0, "iscan");
@@ -491,56 +1047,467 @@ void RedisClient::Connection::processScanCommand(
         auto newCmd = cmd;
         newCmd.setCursor(r.getCursor());
 
-        processScanCommand(newCmd, callback, result);
+        processScanCommand(newCmd, callback, result, incrementalProcessing);
       });
 
   runCommand(cmdWithCallback);
 }
 
 void RedisClient::Connection::changeCurrentDbNumber(int db) {
-  if (m_dbNumberMutex.tryLock(5000)) {
-    m_dbNumber = db;
-    m_dbNumberMutex.unlock();
-  } else {
-    qWarning() << "Cannot lock db number mutex!";
-  }
+  m_dbNumber.storeRelease(db);
 }
 
-void RedisClient::Connection::clusterConnectToNextMasterNode(
-    std::function<void(const QString &err)> callback) {
-  if (!hasNotVisitedClusterNodes()) {
+void RedisClient::Connection::enableClientSideCache(
+    const Response &trackingResult) {
+  if (protocolVersion() < 3) {
+    emit log("Client-side cache requires RESP3. Cache is disabled");
     return;
   }
 
-  Host h = m_notVisitedMasterNodes->first();
-  m_notVisitedMasterNodes->removeFirst();
+  if (!trackingResult.isOkMessage()) {
+    emit log(QString("Cannot enable client tracking: %1. Cache is disabled")
+                 .arg(QString::fromUtf8(trackingResult.asBytes())));
+    return;
+  }
 
-  callAfterConnect(callback);
+  if (!m_cache)
+    m_cache = QSharedPointer<ClientSideCache>(
+        new ClientSideCache(sharedSettings()->clientSideCacheMaxMemory));
 
-  if (m_config.overrideClusterHost()) {
-    reconnectTo(h.first, h.second);
-  } else {
-    reconnectTo(m_config.host(), h.second);
-  }
+  m_cacheEnabled.storeRelease(1);
+  emit log("Client-side cache enabled");
 }
 
-bool RedisClient::Connection::hasNotVisitedClusterNodes() const {
-  return m_notVisitedMasterNodes && m_notVisitedMasterNodes->size() > 0;
+void RedisClient::Connection::routeClusterCommand(const Command &cmd, int slot,
+                                                  const Host &node,
+                                                  bool asking,
+                                                  int redirectsCount) {
+  QSharedPointer<Connection> nodeConnection = clusterNodeConnection(node);
+  qint64 sentAt = m_routingClock.nsecsElapsed();
+
+  Command nodeCmd = forwardedCommand(
+      cmd, -1,
+      [this, cmd, slot, node, redirectsCount, sentAt](const Response &r,
+                                                      const QString &err) {
+        if (err.isEmpty()) addLatencySample(node, sentAt);
+
+        if (err.isEmpty() && (r.isMovedRedirect() || r.isAskRedirect()) &&
+            redirectsCount < MAX_CLUSTER_REDIRECTS) {
+          Host target{QString::fromUtf8(r.getRedirectionHost()),
+                      static_cast<int>(r.getRedirectionPort())};
+
+          // MOVED means that slot is served by another node permanently
+          if (r.isMovedRedirect()) m_slotMap.setNodeForSlot(slot, target);
+
+          return routeClusterCommand(cmd, slot, target, r.isAskRedirect(),
+                                     redirectsCount + 1);
+        }
+
+        completeForwardedCommand(cmd, r, err);
+      });
+
+  try {
+    // ASKING and command are submitted as one batch, so commands of
+    // other threads can't get between them
+    if (asking)
+      nodeConnection->runCommands({Command({"ASKING"}), nodeCmd});
+    else
+      nodeConnection->runCommand(nodeCmd);
+  } catch (const Exception &e) {
+    emit log(QString("Cannot run command on cluster node %1:%2: %3")
+                 .arg(node.first)
+                 .arg(node.second)
+                 .arg(e.what()));
+    completeForwardedCommand(cmd, Response(), e.what());
+  }
 }
 
-void RedisClient::Connection::callAfterConnect(
-    std::function<void(const QString &err)> callback) {
-  auto context = new QObject();
+RedisClient::Command RedisClient::Connection::forwardedCommand(
+    const Command &cmd, int db, Command::Callback callback) {
+  Command forwarded(cmd.getSplitedRepresentattion(), db);
+  forwarded.setTimeout(cmd.timeout());
 
-  QObject::connect(this, &Connection::authOk, context, [callback, context]() {
-    callback(QString());
-    context->deleteLater();
+  // Pub/sub messages are delivered by event loop of this connection,
+  // replies are forwarded directly in transporter thread of node, so
+  // waiting for them doesn't depend on event loop of any thread
+  if (cmd.isSubscriptionCommand() || cmd.isUnSubscriptionCommand())
+    forwarded.setCallBack(this, callback);
+  else
+    forwarded.setCompletionHandler(callback);
+
+  if (cmd.isStreamingCommand())
+    forwarded.setStreamCallback(cmd.getStreamCallback());
+
+  return forwarded;
+}
+
+void RedisClient::Connection::completeForwardedCommand(const Command &cmd,
+                                                       const Response &r,
+                                                       const QString &err) {
+  // Command was canceled by owner destruction
+  if (!err.isEmpty() || (cmd.getOwner() && !cmd.isOwnerAlive()))
+    cmd.getDeferred().cancel();
+  else
+    cmd.getDeferred().complete(r);
+
+  // Deliver response in owner's thread as transporter does
+  if (cmd.getOwner() || !cmd.getCallBack())
+    return ResponseDispatcher::dispatch(cmd, r, err);
+
+  Command ownedCmd = cmd;
+  ownedCmd.setCallBack(this, cmd.getCallBack());
+  ResponseDispatcher::dispatch(ownedCmd, r, err);
+}
+
+QSharedPointer<RedisClient::Connection>
+RedisClient::Connection::clusterNodeConnection(const Host &node) {
+  auto settings = sharedSettings();
+  QString host = settings->overrideClusterHost ? node.first : settings->host;
+  QString id = QString("%1:%2").arg(host).arg(node.second);
+
+  // Node connections are created by runCommand() of any thread
+  QMutexLocker lock(&m_routingLock);
+
+  if (m_clusterNodes.contains(id)) return m_clusterNodes[id];
+
+  ConnectionConfig config = settings->config;
+  config.setHost(host);
+  config.setPort(node.second);
+
+  QSharedPointer<Connection> nodeConnection(new Connection(config, true));
+  nodeConnection->m_isClusterNode = true;
+
+  // Queued slots of node connection need event loop of this connection
+  // thread, caller thread may not have one
+  nodeConnection->moveToThread(thread());
+
+  // Replicas serve reads only after READONLY, masters ignore it
+  nodeConnection->m_readOnlyNode =
+      settings->readFrom != ConnectionConfig::ReadFrom::Master;
+
+  QObject::connect(nodeConnection.data(), &Connection::log, this,
+                   &Connection::log);
+  QObject::connect(nodeConnection.data(), &Connection::error, this,
+                   [this, id](const QString &err) {
+                     emit log(QString("Cluster node %1: %2").arg(id).arg(err));
+                   });
+
+  m_clusterNodes.insert(id, nodeConnection);
+  return nodeConnection;
+}
+
+bool RedisClient::Connection::isReplicaReadCommand(const Command &cmd) const {
+  // Stream callbacks are not passed to forwarded commands
+  return sharedSettings()->readFrom != ConnectionConfig::ReadFrom::Master &&
+         !cmd.isStreamingCommand() && cmd.isReadOnlyCommand();
+}
+
+bool RedisClient::Connection::selectReadNode(const Host &master,
+                                              const HostList &replicas,
+                                              Host &result) {
+  ConnectionConfig::ReadFrom policy = sharedSettings()->readFrom;
+
+  if (replicas.isEmpty()) {
+    result = master;
+    return policy != ConnectionConfig::ReadFrom::Replica;
+  }
+
+  // Called from any thread, counter and latencies are shared
+  QMutexLocker lock(&m_routingLock);
+
+  // Reads are spread across replicas in round-robin order
+  uint offset = m_readCounter++;
+
+  if (policy != ConnectionConfig::ReadFrom::Nearest) {
+    result = replicas.at(static_cast<int>(offset % replicas.size()));
+    return true;
+  }
+
+  HostList candidates = replicas;
+
+  if (!master.first.isEmpty()) candidates.prepend(master);
+
+  // Nodes without latency samples are tried first
+  qint64 lowest = -1;
+
+  for (int i = 0; i < candidates.size(); ++i) {
+    const Host &node =
+        candidates.at(static_cast<int>((offset + i) % candidates.size()));
+    qint64 latency = m_nodeLatency.value(nodeId(node), 0);
+
+    if (lowest < 0 || latency < lowest) {
+      lowest = latency;
+      result = node;
+    }
+  }
+
+  return true;
+}
+
+void RedisClient::Connection::runReplicaCommand(const Command &cmd,
+                                                const Host &node) {
+  QSharedPointer<Connection> replica = replicaConnection(node);
+  qint64 sentAt = m_routingClock.nsecsElapsed();
+
+  Command replicaCmd = forwardedCommand(
+      cmd, cmd.hasDbIndex() ? cmd.getDbIndex() : dbIndex(),
+      [this, cmd, node, sentAt](const Response &r, const QString &err) {
+        if (err.isEmpty()) addLatencySample(node, sentAt);
+
+        completeForwardedCommand(cmd, r, err);
+      });
+
+  try {
+    replica->runCommand(replicaCmd);
+  } catch (const Exception &e) {
+    emit log(QString("Cannot run command on replica %1: %2")
+                 .arg(nodeId(node))
+                 .arg(e.what()));
+    completeForwardedCommand(cmd, Response(), e.what());
+  }
+}
+
+QSharedPointer<RedisClient::Connection>
+RedisClient::Connection::replicaConnection(const Host &node) {
+  QString id = nodeId(node);
+
+  QMutexLocker lock(&m_routingLock);
+
+  if (m_replicaNodes.contains(id)) return m_replicaNodes[id];
+
+  ConnectionConfig config = sharedSettings()->config;
+  config.setHost(node.first);
+  config.setPort(node.second);
+  config.setBulkLane(false);
+  config.setClientSideCache(0);
+
+  QSharedPointer<Connection> replica(new Connection(config, true));
+  replica->moveToThread(thread());
+
+  QObject::connect(replica.data(), &Connection::log, this, &Connection::log);
+  QObject::connect(replica.data(), &Connection::error, this,
+                   [this, id](const QString &err) {
+                     emit log(QString("Replica %1: %2").arg(id).arg(err));
+                   });
+
+  m_replicaNodes.insert(id, replica);
+  return replica;
+}
+
+void RedisClient::Connection::trackNodeLatency(const Host &node,
+                                               QFuture<Response> result) {
+  if (sharedSettings()->readFrom != ConnectionConfig::ReadFrom::Nearest) return;
+
+  QPointer<Connection> self(this);
+  qint64 sentAt = m_routingClock.nsecsElapsed();
+
+  AsyncFuture::observe(result).subscribe([self, node, sentAt](Response) {
+    if (self) self->addLatencySample(node, sentAt);
   });
-  QObject::connect(this, &Connection::error, context,
-                   [callback, context](const QString &err) {
-                     callback(err);
-                     context->deleteLater();
+}
+
+void RedisClient::Connection::addLatencySample(const Host &node,
+                                               qint64 sentAt) {
+  if (sharedSettings()->readFrom != ConnectionConfig::ReadFrom::Nearest) return;
+
+  qint64 sample =
+      qMax<qint64>(1, (m_routingClock.nsecsElapsed() - sentAt) / 1000);
+
+  QMutexLocker lock(&m_routingLock);
+  qint64 &latency = m_nodeLatency[nodeId(node)];
+
+  latency = latency == 0 ? sample : (latency * 7 + sample) / 8;
+}
+
+bool RedisClient::Connection::isBulkLaneCommand(const Command &cmd) const {
+  // Lane is a single extra connection, cluster commands are routed by slot.
+  // Writes stay on main connection to keep their order with other writes.
+  return sharedSettings()->useBulkLane && mode() == Mode::Normal &&
+         !cmd.isSubscriptionCommand() && cmd.isReadOnlyCommand() &&
+         cmd.priority() == Command::Priority::Bulk;
+}
+
+void RedisClient::Connection::runBulkLaneCommand(const Command &cmd) {
+  QSharedPointer<Connection> lane = bulkLaneConnection();
+
+  Command laneCmd = forwardedCommand(
+      cmd, cmd.hasDbIndex() ? cmd.getDbIndex() : dbIndex(),
+      [this, cmd](const Response &r, const QString &err) {
+        completeForwardedCommand(cmd, r, err);
+      });
+
+  try {
+    lane->runCommand(laneCmd);
+  } catch (const Exception &e) {
+    emit log(QString("Cannot run command on bulk lane: %1").arg(e.what()));
+    completeForwardedCommand(cmd, Response(), e.what());
+  }
+}
+
+QSharedPointer<RedisClient::Connection>
+RedisClient::Connection::bulkLaneConnection() {
+  QMutexLocker lock(&m_bulkLaneLock);
+
+  if (m_bulkLane) return m_bulkLane;
+
+  ConnectionConfig config = sharedSettings()->config;
+  config.setBulkLane(false);
+  config.setClientSideCache(0);
+
+  m_bulkLane = QSharedPointer<Connection>(new Connection(config, true));
+  m_bulkLane->moveToThread(thread());
+
+  QObject::connect(m_bulkLane.data(), &Connection::log, this,
+                   &Connection::log);
+  QObject::connect(m_bulkLane.data(), &Connection::error, this,
+                   [this](const QString &err) {
+                     emit log(QString("Bulk lane: %1").arg(err));
                    });
+
+  return m_bulkLane;
+}
+
+QSharedPointer<RedisClient::Connection>
+RedisClient::Connection::sharedBulkLane() const {
+  QMutexLocker lock(&m_bulkLaneLock);
+  return m_bulkLane;
+}
+
+struct RedisClient::Connection::MasterNodesFanOut {
+  HostList notVisited;
+  MasterNodeOperation operation;
+  std::function<void(const QString &)> callback;
+  int running;
+  bool finished;
+};
+
+void RedisClient::Connection::forEachMaster(
+    MasterNodeOperation operation,
+    std::function<void(const QString &)> callback, int concurrency) {
+  if (mode() != Mode::Cluster) {
+    throw Exception("Connection is not in cluster mode");
+  }
+
+  HostList masters = getMasterNodes();
+
+  if (masters.isEmpty()) {
+    return callback(QObject::tr("Cannot retrieve cluster master nodes"));
+  }
+
+  if (concurrency <= 0)
+    concurrency = static_cast<int>(sharedSettings()->clusterFanOutConcurrency);
+
+  QSharedPointer<MasterNodesFanOut> fanOut(
+      new MasterNodesFanOut{masters, operation, callback, 0, false});
+
+  for (int i = 0; i < qMax(1, concurrency) && i < masters.size(); ++i) {
+    processNextMasterNode(fanOut);
+  }
+}
+
+void RedisClient::Connection::processNextMasterNode(
+    QSharedPointer<MasterNodesFanOut> fanOut) {
+  if (fanOut->finished) return;
+
+  if (fanOut->notVisited.isEmpty()) {
+    if (fanOut->running > 0) return;
+
+    fanOut->finished = true;
+    return fanOut->callback(QString());
+  }
+
+  Host h = fanOut->notVisited.takeFirst();
+  QSharedPointer<Connection> node = clusterNodeConnection(h);
+  fanOut->running++;
+
+  QPointer<Connection> self(this);
+
+  auto done = [self, fanOut](const QString &err) {
+    fanOut->running--;
+
+    if (!self || fanOut->finished) return;
+
+    if (!err.isEmpty()) {
+      fanOut->finished = true;
+      return fanOut->callback(err);
+    }
+
+    self->processNextMasterNode(fanOut);
+  };
+
+  if (node->isConnected()) return fanOut->operation(node, done);
+
+  QWeakPointer<Connection> weakNode = node;
+
+  node->callAfterConnect([fanOut, weakNode, h, done](const QString &err) {
+    QSharedPointer<Connection> node = weakNode.toStrongRef();
+
+    if (!err.isEmpty() || !node) {
+      return done(QObject::tr("Cannot connect to cluster node %1:%2")
+                      .arg(h.first)
+                      .arg(h.second));
+    }
+
+    fanOut->operation(node, done);
+  }, this);
+
+  node->connect(false);
+}
+
+void RedisClient::Connection::trackCommandOwner(QObject *owner) {
+  if (!owner || owner == this) return;
+
+  // Commands are run from any thread
+  QMutexLocker lock(&m_trackedOwnersLock);
+
+  if (m_trackedOwners.contains(owner)) return;
+
+  m_trackedOwners.insert(owner);
+
+  // Single registration per owner instead of connect() per command
+  QObject::connect(owner, &QObject::destroyed, this, [this](QObject *obj) {
+    {
+      QMutexLocker lock(&m_trackedOwnersLock);
+      m_trackedOwners.remove(obj);
+    }
+
+    if (m_transporter)
+      QMetaObject::invokeMethod(m_transporter.data(), "cancelCommands",
+                                Qt::QueuedConnection, Q_ARG(QObject *, obj));
+  });
+}
+
+void RedisClient::Connection::callAfterConnect(
+    std::function<void(const QString &err)> callback, QObject *context) {
+  struct Subscription {
+    QMetaObject::Connection authOk;
+    QMetaObject::Connection error;
+    QAtomicInt done;
+  };
+
+  QSharedPointer<Subscription> subscription(new Subscription());
+
+  auto finish = [subscription, callback](const QString &err) {
+    // Both signals can be emitted, queued calls can be already posted
+    if (!subscription->done.testAndSetOrdered(0, 1)) return;
+
+    QObject::disconnect(subscription->authOk);
+    QObject::disconnect(subscription->error);
+    callback(err);
+  };
+
+  // Handshake signals are emitted by transporter thread, direct call
+  // doesn't depend on event loop of thread which waits for connection
+  Qt::ConnectionType type =
+      context ? Qt::AutoConnection : Qt::DirectConnection;
+
+  if (!context) context = this;
+
+  subscription->authOk = QObject::connect(
+      this, &Connection::authOk, context, [finish]() { finish(QString()); },
+      type);
+  subscription->error =
+      QObject::connect(this, &Connection::error, context, finish, type);
 }
 
 RedisClient::Connection::HostList RedisClient::Connection::getMasterNodes() {
@@ -559,19 +1526,14 @@ RedisClient::Connection::HostList RedisClient::Connection::getMasterNodes() {
     return result;
   }
 
-  QVariantList slotsList = r.value().toList();
-
-  foreach (QVariant clusterSlot, slotsList) {
-    QVariantList details = clusterSlot.toList();
+  ClusterSlotMap slots;
 
-    if (details.size() < 3) continue;
+  if (!slots.load(r)) return result;
 
-    QVariantList masterDetails = details[2].toList();
-
-    result.append({masterDetails[0].toString(), masterDetails[1].toInt()});
-  }
+  // Keep routing table up to date
+  if (sharedSettings()->clusterSlotRouting) m_slotMap.load(r);
 
-  return result;
+  return slots.masters();
 }
 
 QFuture<bool> RedisClient::Connection::isCommandSupported(
@@ -591,172 +1553,564 @@ QFuture<bool> RedisClient::Connection::isCommandSupported(
   return d->future();
 }
 
+struct RedisClient::Connection::Handshake {
+  Handshake() : helloSent(false), trackingSent(false), pending(0) {}
+
+  Response hello;
+  Response setName;
+  Response tracking;
+  Response ping;
+  Response infoServer;
+  Response infoKeyspace;
+  bool helloSent;
+  bool trackingSent;
+  QString error;
+  int pending;
+};
+
 void RedisClient::Connection::auth() {
   emit log("AUTH");
 
-  try {
-    if (m_config.useAuth()) {
-      internalCommandSync({"AUTH", m_config.auth().toUtf8()});
+  // Tracking state is lost on reconnect
+  m_cacheEnabled.storeRelease(0);
+  if (m_cache) m_cache->clear();
+  m_fullServerInfoLoaded.storeRelease(0);
+
+  // Script cache of new server can be empty after failover
+  m_scripts->resetLoaded();
+
+  QSharedPointer<Handshake> handshake(new Handshake());
+  QList<Command> commands;
+
+  // All handshake commands are sent in one write and processed
+  // when reply to the last of them is received
+  auto addStep = [this, handshake, &commands](QList<QByteArray> rawCmd,
+                                              Response *result) {
+    Command cmd(rawCmd);
+    cmd.markAsHiPriorityCommand();
+    // Replies are processed in transporter thread one by one
+    cmd.setCompletionHandler([this, handshake, result](Response r,
+                                                       QString err) {
+      if (result) *result = r;
+
+      if (!err.isEmpty() && handshake->error.isEmpty()) handshake->error = err;
+
+      if (--handshake->pending == 0) processHandshake(handshake);
+    });
+    commands.append(cmd);
+  };
+
+  auto settings = sharedSettings();
+
+  if (settings->useAuth) {
+    addStep({"AUTH", settings->auth.toUtf8()}, nullptr);
+  }
+
+  if (settings->protocolVersion >= 3) {
+    if (ResponseParser::isResp3Supported()) {
+      handshake->helloSent = true;
+      addStep({"HELLO", "3"}, &handshake->hello);
+    } else {
+      emit log("RESP3 is not supported by hiredis. Fallback to RESP2");
     }
+  }
 
-    Response testResult = internalCommandSync({"PING"});
+  if (!settings->clientName.isEmpty()) {
+    addStep({"CLIENT", "SETNAME", settings->clientName.toUtf8()},
+            &handshake->setName);
+  }
 
-    if (testResult.value().toByteArray() != QByteArray("PONG")) {
-      emit authError("Redis server requires password or password is not valid");
-      emit error("AUTH ERROR");
-      return;
+  if (m_readOnlyNode) addStep({"READONLY"}, nullptr);
+
+  if (settings->clientSideCacheMaxMemory > 0) {
+    if (handshake->helloSent) {
+      QList<QByteArray> trackingCmd = {"CLIENT", "TRACKING", "ON"};
+
+      if (settings->clientSideCacheBroadcastMode) trackingCmd.append("BCAST");
+
+      handshake->trackingSent = true;
+      addStep(trackingCmd, &handshake->tracking);
+    } else {
+      emit log("Client-side cache requires RESP3. Cache is disabled");
     }
+  }
 
-    refreshServerInfo();
+  addStep({"PING"}, &handshake->ping);
+  addStep({"INFO", "server"}, &handshake->infoServer);
+  addStep({"INFO", "keyspace"}, &handshake->infoKeyspace);
 
-    // TODO(u_glide): add option to disable automatic mode switching
-    if (m_serverInfo.clusterMode) {
-      m_currentMode = Mode::Cluster;
-      emit log("Cluster detected");
-    } else if (m_serverInfo.sentinelMode) {
-      m_currentMode = Mode::Sentinel;
-      emit log("Sentinel detected. Requesting master node...");
+  handshake->pending = commands.size();
 
-      Response mastersResult = internalCommandSync({"SENTINEL", "masters"});
+  m_transporter->submitCommands(commands);
+}
 
-      if (!mastersResult.isArray()) {
-        emit error(QString(
-            "Connection error: cannot retrive master node from sentinel"));
-        return;
-      }
+void RedisClient::Connection::processHandshake(
+    QSharedPointer<Handshake> handshake) {
+  if (!handshake->error.isEmpty()) {
+    emit error(QString("Connection error on AUTH: %1").arg(handshake->error));
+    emit authError("Connection error on AUTH");
+    return;
+  }
 
-      QVariantList result = mastersResult.value().toList();
+  if (handshake->helloSent) {
+    if (handshake->hello.isErrorMessage()) {
+      emit log("Server doesn't support RESP3. Fallback to RESP2");
+    } else {
+      m_protocolVersion.storeRelease(3);
+      emit log("RESP3 enabled");
+    }
+  }
 
-      if (result.size() == 0) {
-        emit error(QString("Connection error: invalid response from sentinel"));
-        return;
-      }
+  if (!sharedSettings()->clientName.isEmpty() &&
+      !handshake->setName.isOkMessage()) {
+    emit log(QString("Cannot set client name: %1")
+                 .arg(QString::fromUtf8(handshake->setName.asBytes())));
+  }
 
-      QStringList masterInfo = result.at(0).toStringList();
+  if (handshake->trackingSent) enableClientSideCache(handshake->tracking);
 
-      if (masterInfo.size() < 6) {
-        emit error(QString("Connection error: invalid response from sentinel"));
-        return;
-      }
+  if (handshake->ping.value().toByteArray() != QByteArray("PONG")) {
+    emit authError("Redis server requires password or password is not valid");
+    emit error("AUTH ERROR");
+    return;
+  }
 
-      QString host = masterInfo[3];
+  // Full INFO is requested on demand by getParsedServerInfo()
+  setServerInfo(ServerInfo::fromBytes(handshake->infoServer.asBytes() +
+                                      "\r\n" +
+                                      handshake->infoKeyspace.asBytes()));
 
-      if (!m_config.useSshTunnel() &&
-          (host == "127.0.0.1" || host == "localhost"))
-        host = m_config.host();
+  detectServerMode();
+}
 
-      emit reconnectTo(host, masterInfo[5].toInt());
-      return;
+void RedisClient::Connection::detectServerMode() {
+  ServerInfo info = serverInfo();
+
+  // TODO(u_glide): add option to disable automatic mode switching
+  if (m_isClusterNode) {
+    // Redirects are processed by parent connection
+  } else if (info.clusterMode) {
+    m_currentMode.storeRelease(static_cast<int>(Mode::Cluster));
+    emit log("Cluster detected");
+
+    if (sharedSettings()->clusterSlotRouting) {
+      return handshakeCommand({"CLUSTER", "SLOTS"}, [this](const Response &r) {
+        m_slotMap.load(r);
+        emit log(QString("Cluster slots loaded: %1 master nodes")
+                     .arg(m_slotMap.masters().size()));
+        handshakeCompleted();
+      });
     }
+  } else if (m_isSentinelNode) {
+    // Sentinel is used only for discovery and failover events
+  } else if (info.sentinelMode) {
+    m_currentMode.storeRelease(static_cast<int>(Mode::Sentinel));
+    emit log("Sentinel detected. Requesting master node...");
 
-    emit log("Connected");
-    emit authOk();
-    emit connected();
-  } catch (const Exception &e) {
-    emit error(QString("Connection error on AUTH: %1").arg(e.what()));
-    emit authError("Connection error on AUTH");
+    return discoverSentinelMaster();
   }
+
+  handshakeCompleted();
 }
 
-void RedisClient::Connection::setTransporter(
-    QSharedPointer<RedisClient::AbstractTransporter> transporter) {
-  if (transporter.isNull()) return;
+struct RedisClient::Connection::SentinelDiscovery {
+  SentinelDiscovery() : found(false), pending(0) {}
 
-  m_transporter = transporter;
-}
+  // Replies of sentinels are processed in their transporter threads
+  QMutex lock;
+  QString masterName;
+  bool found;
+  int pending;
+};
 
-QSharedPointer<RedisClient::AbstractTransporter>
-RedisClient::Connection::getTransporter() const {
-  return m_transporter;
-}
+void RedisClient::Connection::discoverSentinelMaster() {
+  auto settings = sharedSettings();
+  QSharedPointer<SentinelDiscovery> discovery(new SentinelDiscovery());
+  discovery->masterName = settings->sentinelMasterName;
 
-RedisClient::ServerInfo::ServerInfo()
-    : version(0.0), clusterMode(false), sentinelMode(false) {}
+  QList<QByteArray> rawCmd =
+      discovery->masterName.isEmpty()
+          ? QList<QByteArray>{"SENTINEL", "masters"}
+          : QList<QByteArray>{"SENTINEL", "get-master-addr-by-name",
+                              discovery->masterName.toUtf8()};
 
-RedisClient::ServerInfo RedisClient::ServerInfo::fromString(
-    const QString &info) {
-  QStringList lines = info.split("\r\n");
+  HostList sentinels{
+      Host{settings->host, static_cast<int>(settings->port)}};
 
-  ParsedServerInfo parsed;
-  QString currentSection{"unknown"};
-  int posOfSeparator = -1;
+  for (const QString &address : settings->sentinels) {
+    int separator = address.lastIndexOf(':');
 
-  foreach (QString line, lines) {
-    if (line.startsWith("#")) {
-      currentSection = line.mid(2).toLower();
-      continue;
+    if (separator > 0)
+      sentinels.append(Host{address.left(separator),
+                            address.mid(separator + 1).toInt()});
+  }
+
+  // Main connection asks sentinel it is connected to, others are asked
+  // in parallel over connections which then receive failover events
+  ConnectionConfig mainSentinel = settings->config;
+  discovery->pending = 1;
+
+  // Sentinel connections are created before any reply is processed
+  QHash<QString, QSharedPointer<Connection>> knownSentinels;
+
+  {
+    QMutexLocker lock(&m_routingLock);
+    knownSentinels = m_sentinels;
+  }
+
+  QList<QSharedPointer<Connection>> newSentinels;
+  QList<QSharedPointer<Connection>> askedSentinels;
+
+  for (int i = 0; i < sentinels.size(); ++i) {
+    // Subscribed connections can't run other commands in RESP2
+    if (knownSentinels.contains(nodeId(sentinels.at(i)))) continue;
+
+    QSharedPointer<Connection> sentinel = sentinelConnection(sentinels.at(i));
+    newSentinels.append(sentinel);
+
+    if (i > 0) askedSentinels.append(sentinel);
+  }
+
+  discovery->pending += askedSentinels.size();
+
+  handshakeCommand(rawCmd, [this, discovery, mainSentinel](const Response &r) {
+    processSentinelMaster(discovery, r, mainSentinel);
+  });
+
+  for (QSharedPointer<Connection> sentinel : askedSentinels) {
+    ConnectionConfig config = sentinel->getConfig();
+
+    // Reply is processed in transporter thread of sentinel, so discovery
+    // doesn't depend on event loop of this connection
+    Command cmd(rawCmd);
+    cmd.setCompletionHandler(
+        [this, discovery, config](Response r, QString err) {
+          processSentinelMaster(discovery, err.isEmpty() ? r : Response(),
+                                config);
+        });
+
+    try {
+      sentinel->runCommand(cmd);
+    } catch (const Exception &e) {
+      emit log(QString("Sentinel %1:%2: %3")
+                   .arg(config.host())
+                   .arg(config.port())
+                   .arg(e.what()));
+      processSentinelMaster(discovery, Response(), config);
     }
+  }
+
+  for (QSharedPointer<Connection> sentinel : newSentinels)
+    subscribeToSwitchMaster(sentinel);
+}
 
-    posOfSeparator = line.indexOf(':');
+void RedisClient::Connection::processSentinelMaster(
+    QSharedPointer<SentinelDiscovery> discovery, const Response &r,
+    const ConnectionConfig &sentinel) {
+  QString name;
+  Host master;
+  bool failed = false;
 
-    if (posOfSeparator == -1) continue;
+  {
+    QMutexLocker lock(&discovery->lock);
 
-    parsed[currentSection][line.mid(0, posOfSeparator)] =
-        line.mid(posOfSeparator + 1);
+    // First valid reply wins
+    if (discovery->found) return;
+
+    name = discovery->masterName;
+    master = sentinelMasterAddress(r, name);
+
+    if (master.first.isEmpty())
+      failed = --discovery->pending == 0;
+    else
+      discovery->found = true;
   }
 
-  QRegExp versionRegex("redis_version:([0-9]+\\.[0-9]+)", Qt::CaseInsensitive,
-                       QRegExp::RegExp2);
-  QRegExp modeRegex("redis_mode:([a-z]+)", Qt::CaseInsensitive,
-                    QRegExp::RegExp2);
+  if (master.first.isEmpty()) {
+    if (failed)
+      emit error(
+          QString("Connection error: cannot retrive master node from sentinel"));
+    return;
+  }
 
-  RedisClient::ServerInfo result;
-  result.parsed = parsed;
-  result.version =
-      (versionRegex.indexIn(info) == -1) ? 0.0 : versionRegex.cap(1).toDouble();
+  Host address{reachableHost(master.first, sentinel), master.second};
 
-  if (modeRegex.indexIn(info) != -1) {
-    if (modeRegex.cap(1) == "cluster") result.clusterMode = true;
-    if (modeRegex.cap(1) == "sentinel") result.sentinelMode = true;
+  {
+    QMutexLocker lock(&m_routingLock);
+    m_sentinelMasterName = name;
+    m_sentinelMaster = address;
   }
 
-  if (result.clusterMode) {
-    result.databases.insert(0, 0);
-    return result;
-  } else if (result.sentinelMode) {
-    return result;
+  emit log(QString("Sentinel master %1: %2").arg(name).arg(nodeId(address)));
+
+  if (sharedSettings()->readFrom == ConnectionConfig::ReadFrom::Master) {
+    emit reconnectTo(address.first, address.second);
+    return;
+  }
+
+  handshakeCommand({"SENTINEL", "replicas", name.toUtf8()},
+                   [this, sentinel](const Response &replicasResult) {
+                     updateSentinelReplicas(replicasResult, sentinel);
+
+                     // Master could be switched while replicas were loaded
+                     Host master;
+
+                     {
+                       QMutexLocker lock(&m_routingLock);
+                       master = m_sentinelMaster;
+                     }
+
+                     emit reconnectTo(master.first, master.second);
+                   });
+}
+
+void RedisClient::Connection::processSwitchMaster(
+    const QByteArray &event, const ConnectionConfig &sentinel) {
+  // <master name> <old ip> <old port> <new ip> <new port>
+  QList<QByteArray> parts = event.split(' ');
+
+  if (parts.size() < 5) return;
+
+  {
+    QMutexLocker lock(&m_routingLock);
+
+    if (m_sentinelMasterName.isEmpty() ||
+        QString::fromUtf8(parts.at(0)) != m_sentinelMasterName)
+      return;
   }
 
-  // Parse keyspace info
-  QRegularExpression getDbAndKeysCount("^db(\\d+):keys=(\\d+).*");
-  getDbAndKeysCount.setPatternOptions(QRegularExpression::MultilineOption);
-  QRegularExpressionMatchIterator iter = getDbAndKeysCount.globalMatch(info);
-  while (iter.hasNext()) {
-    QRegularExpressionMatch match = iter.next();
-    int dbIndex = match.captured(1).toInt();
-    result.databases.insert(dbIndex, match.captured(2).toInt());
+  Host master{reachableHost(QString::fromUtf8(parts.at(3)), sentinel),
+              parts.at(4).toInt()};
+
+  Host previous;
+
+  {
+    QMutexLocker lock(&m_routingLock);
+
+    // Event is published by every sentinel
+    if (master == m_sentinelMaster) return;
+
+    previous = m_sentinelMaster;
+    m_sentinelMaster = master;
+
+    // Promoted replica doesn't serve replica reads anymore, old master
+    // is usually unreachable at this point
+    m_sentinelReplicas.removeAll(master);
   }
 
-  if (result.databases.size() == 0) return result;
+  emit log(QString("Sentinel failover: %1 -> %2")
+               .arg(nodeId(previous))
+               .arg(nodeId(master)));
 
-  int lastKnownDbIndex = result.databases.lastKey();
-  for (int dbIndex = 0; dbIndex < lastKnownDbIndex; ++dbIndex) {
-    if (!result.databases.contains(dbIndex)) {
-      result.databases.insert(dbIndex, 0);
-    }
+  // Commands are held in queue while transporter reconnects, interrupted
+  // writes are failed unless replay policy allows to send them again
+  emit reconnectTo(master.first, master.second);
+}
+
+void RedisClient::Connection::updateSentinelReplicas(
+    const Response &r, const ConnectionConfig &sentinel) {
+  HostList replicas;
+
+  for (const Host &replica : healthySentinelReplicas(r))
+    replicas.append(
+        Host{reachableHost(replica.first, sentinel), replica.second});
+
+  {
+    QMutexLocker lock(&m_routingLock);
+    m_sentinelReplicas = replicas;
   }
 
-  return result;
+  emit log(QString("Sentinel replicas: %1").arg(replicas.size()));
+}
+
+QSharedPointer<RedisClient::Connection>
+RedisClient::Connection::sentinelConnection(const Host &node) {
+  QString id = nodeId(node);
+
+  {
+    QMutexLocker lock(&m_routingLock);
+    if (m_sentinels.contains(id)) return m_sentinels[id];
+  }
+
+  ConnectionConfig config = sharedSettings()->config;
+  config.setHost(node.first);
+  config.setPort(node.second);
+  config.setBulkLane(false);
+  config.setClientSideCache(0);
+
+  QSharedPointer<Connection> sentinel(new Connection(config, true));
+  sentinel->m_isSentinelNode = true;
+
+  // Discovery runs in transporter thread, sentinel belongs to this one
+  sentinel->moveToThread(thread());
+
+  QObject::connect(sentinel.data(), &Connection::error, this,
+                   [this, id](const QString &err) {
+                     emit log(QString("Sentinel %1: %2").arg(id).arg(err));
+                   });
+
+  QMutexLocker lock(&m_routingLock);
+  m_sentinels.insert(id, sentinel);
+  return sentinel;
+}
+
+void RedisClient::Connection::subscribeToSwitchMaster(
+    QSharedPointer<Connection> sentinel) {
+  QPointer<Connection> self(this);
+  ConnectionConfig config = sentinel->getConfig();
+
+  // Subscription lives as long as sentinel connection
+  Command subscription({"SUBSCRIBE", "+switch-master"}, this,
+                       [self, config](Response r, QString err) {
+                         if (!self || !err.isEmpty() || !r.isMessage()) return;
+
+                         self->processSwitchMaster(r.getPayload(), config);
+                       });
+
+  try {
+    sentinel->runCommand(subscription);
+  } catch (const Exception &e) {
+    emit log(QString("Cannot subscribe to sentinel %1:%2: %3")
+                 .arg(config.host())
+                 .arg(config.port())
+                 .arg(e.what()));
+  }
+}
+
+void RedisClient::Connection::handshakeCommand(
+    QList<QByteArray> rawCmd, std::function<void(const Response &)> callback) {
+  Command cmd(rawCmd);
+  cmd.markAsHiPriorityCommand();
+  cmd.setCompletionHandler([this, callback](Response r, QString err) {
+    if (!err.isEmpty()) {
+      emit error(QString("Connection error on AUTH: %1").arg(err));
+      emit authError("Connection error on AUTH");
+      return;
+    }
+
+    callback(r);
+  });
+
+  m_transporter->submitCommand(cmd);
 }
 
-QVariantMap RedisClient::ServerInfo::ParsedServerInfo::toVariantMap() {
-  QVariantMap categories;
-  QHashIterator<QString, QHash<QString, QString>> catIterator(*this);
+void RedisClient::Connection::handshakeCompleted() {
+  emit log("Connected");
+  emit authOk();
+  emit connected();
 
-  while (catIterator.hasNext()) {
-    catIterator.next();
-    QHashIterator<QString, QString> propIterator(catIterator.value());
-    QVariantMap properties;
+  loadScripts();
+}
+
+QByteArray RedisClient::Connection::registerScript(const QByteArray &name,
+                                                   const QByteArray &body) {
+  return m_scripts->add(name, body);
+}
 
-    while (propIterator.hasNext()) {
-      propIterator.next();
-      properties.insert(propIterator.key(), propIterator.value());
+void RedisClient::Connection::runScript(const QByteArray &name,
+                                        const QList<QByteArray> &keys,
+                                        const QList<QByteArray> &args,
+                                        QObject *owner,
+                                        RedisClient::Command::Callback callback,
+                                        int db) {
+  ScriptCache::Script script = m_scripts->script(name);
+
+  if (!script.isValid())
+    throw Exception(
+        QString("Script %1 is not registered").arg(QString::fromUtf8(name)));
+
+  QList<QByteArray> scriptArgs;
+  scriptArgs.append(QByteArray::number(keys.size()));
+  scriptArgs.append(keys);
+  scriptArgs.append(args);
+
+  // SCRIPT LOAD is pipelined with first EVALSHA
+  if (!m_scripts->isLoaded(script.sha1)) loadScript(script);
+
+  QPointer<Connection> self(this);
+  QSharedPointer<ScriptCache> scripts = m_scripts;
+
+  Command evalShaCmd(QList<QByteArray>{"EVALSHA", script.sha1} + scriptArgs,
+                     db);
+  evalShaCmd.setCallBack(owner, [self, scripts, script, scriptArgs, owner,
+                                 callback, db](Response r, QString err) {
+    if (!err.isEmpty() || !r.isNoScriptErrorMessage() || !self)
+      return callback(r, err);
+
+    // Script is executed with EVAL and stays in script cache of server
+    scripts->setLoaded(script.sha1, false);
+
+    Command evalCmd(QList<QByteArray>{"EVAL", script.body} + scriptArgs, db);
+    evalCmd.setCallBack(owner, [scripts, script, callback](Response r,
+                                                           QString err) {
+      if (err.isEmpty() && !r.isErrorMessage())
+        scripts->setLoaded(script.sha1);
+
+      callback(r, err);
+    });
+
+    try {
+      self->runCommand(evalCmd);
+    } catch (const Connection::Exception &e) {
+      callback(Response(), QString(e.what()));
     }
+  });
+
+  runCommand(evalShaCmd);
+}
+
+void RedisClient::Connection::loadScript(const ScriptCache::Script &script) {
+  QSharedPointer<ScriptCache> scripts = m_scripts;
+  QByteArray sha1 = script.sha1;
+
+  // Marked in advance to avoid duplicate SCRIPT LOAD for pipelined EVALSHA
+  scripts->setLoaded(sha1);
+
+  Command cmd(QList<QByteArray>{"SCRIPT", "LOAD", script.body});
+  cmd.setCallBack(this, [this, scripts, sha1](Response r, QString err) {
+    if (err.isEmpty() && !r.isErrorMessage()) return;
+
+    scripts->setLoaded(sha1, false);
+    emit log(QString("Cannot load script: %1")
+                 .arg(err.isEmpty() ? QString::fromUtf8(r.asBytes()) : err));
+  });
+
+  runCommand(cmd);
+}
 
-    categories.insert(catIterator.key(), properties);
+void RedisClient::Connection::loadScripts() {
+  // Mode stays Sentinel after connection is switched to discovered
+  // master, so scripts are skipped only while socket points at sentinel
+  if (m_isSentinelNode || serverInfo().sentinelMode) return;
+
+  for (const ScriptCache::Script &script : m_scripts->scripts()) {
+    try {
+      loadScript(script);
+    } catch (const Connection::Exception &e) {
+      emit log(QString("Cannot load script: %1").arg(e.what()));
+    }
   }
+}
+
+void RedisClient::Connection::setTransporter(
+    QSharedPointer<RedisClient::AbstractTransporter> transporter) {
+  if (transporter.isNull()) return;
+
+  m_transporter = transporter;
+}
+
+QSharedPointer<RedisClient::AbstractTransporter>
+RedisClient::Connection::getTransporter() const {
+  return m_transporter;
+}
+
+QSharedPointer<RedisClient::AbstractTransporter>
+RedisClient::Connection::getBulkLaneTransporter() const {
+  QSharedPointer<Connection> bulkLane = sharedBulkLane();
+
+  if (!bulkLane) return QSharedPointer<AbstractTransporter>();
 
-  return categories;
+  return bulkLane->getTransporter();
 }
 
 RedisClient::Connection::SSHSupportException::SSHSupportException(
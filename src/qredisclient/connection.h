@@ -1,48 +1,36 @@
 #pragma once
+#include <QAtomicInt>
 #include <QByteArray>
+#include <QElapsedTimer>
 #include <QEventLoop>
 #include <QList>
 #include <QMap>
 #include <QMutex>
 #include <QObject>
+#include <QSet>
 #include <QSharedPointer>
 #include <QTimer>
 #include <QVariantList>
 #include <functional>
+#include "clientsidecache.h"
+#include "clusterslotmap.h"
 #include "command.h"
+#include "compactkeylist.h"
 #include "connectionconfig.h"
+#include "connectionmetrics.h"
 #include "exception.h"
+#include "keyspaceanalyzer.h"
+#include "pipeline.h"
 #include "response.h"
+#include "responsedecoder.h"
 #include "scancommand.h"
+#include "scriptcache.h"
+#include "serverinfo.h"
 
 namespace RedisClient {
 
 class AbstractTransporter;
 
-typedef QMap<int, int> DatabaseList;
-
-/**
- * @brief The ServerInfo struct
- * Represents redis-server information parsed from INFO command.
- */
-struct ServerInfo {
-  ServerInfo();
-
-  double version;
-  bool clusterMode;
-  bool sentinelMode;
-  DatabaseList databases;
-
-  class ParsedServerInfo : public QHash<QString, QHash<QString, QString>> {
-   public:
-    QVariantMap toVariantMap();
-  };
-
-  ParsedServerInfo parsed;
-
-  static ServerInfo fromString(const QString &info);
-};
-
 /**
  * @brief The Connection class
  * Main client class.
@@ -71,6 +59,13 @@ class Connection : public QObject {
    */
   Connection(const ConnectionConfig &c, bool autoConnect = true);
 
+  /**
+   * @brief Constructs connection which shares settings with other
+   * connections, e.g. clones and pooled connections
+   */
+  Connection(QSharedPointer<const ConnectionSettings> settings,
+             bool autoConnect = true);
+
   /**
    * @brief ~Connection
    * If connection established internally call disconnect()
@@ -79,7 +74,10 @@ class Connection : public QObject {
 
   /**
    * @brief connects to redis-server
-   * @param wait -  true = sync mode, false = async mode
+   * @param wait -  true = sync mode, false = async mode.
+   * In sync mode events of calling thread are not processed while it
+   * waits: handshake runs in transporter thread, so authOk(), connected()
+   * and handshake errors are emitted from transporter thread.
    * @return true - on success
    * @throws Connection::Exception if config is invalid or something went wrong.
    */
@@ -103,7 +101,18 @@ class Connection : public QObject {
   ConnectionConfig getConfig() const;
 
   /**
-   * @brief setConnectionConfig
+   * @brief Typed settings resolved from config, use on hot paths
+   * instead of getConfig(). Returned snapshot stays valid if settings
+   * are replaced, keep it while settings are read.
+   * Thread-safe, can be called from any thread
+   */
+  QSharedPointer<const ConnectionSettings> sharedSettings() const;
+
+  /**
+   * @brief setConnectionConfig - replace settings, connections which
+   * shared previous settings keep them. Pointer is swapped under lock
+   * and all readers go through sharedSettings(), so it can be called
+   * from transporter thread.
    */
   void setConnectionConfig(const ConnectionConfig &);
 
@@ -119,6 +128,36 @@ class Connection : public QObject {
    */
   int dbIndex() const;
 
+  /**
+   * @brief RESP version negotiated with redis-server
+   * @return 2 or 3
+   */
+  int protocolVersion() const;
+
+  /**
+   * @brief Hit/miss counters of client-side cache
+   * @return Zero stats if cache is disabled
+   */
+  ClientSideCache::Stats clientSideCacheStats() const;
+
+  /**
+   * @brief Latency histograms (queue wait, send, server + network)
+   * per command name and traffic counters.
+   * Thread-safe, can be called from any thread
+   */
+  ConnectionMetrics::Snapshot metrics() const;
+
+  /**
+   * @brief Metrics in Prometheus text format labeled with connection name
+   */
+  QByteArray prometheusMetrics() const;
+  void resetMetrics();
+
+  /**
+   * @brief Log messages are formatted only if log() has listeners
+   */
+  bool isLogEnabled() const;
+
   /**
    * @brief Get redis-server version
    * @return
@@ -131,6 +170,13 @@ class Connection : public QObject {
    */
   virtual DatabaseList getKeyspaceInfo();
 
+  /**
+   * @brief Get all sections of INFO command.
+   * Only "server" and "keyspace" sections are loaded on connect,
+   * so first call requests full INFO from redis-server.
+   */
+  virtual ServerInfo::ParsedServerInfo getParsedServerInfo();
+
   /**
    * @brief update internal structure for methods getServerVersion() and
    * getKeyspaceInfo()
@@ -148,26 +194,60 @@ class Connection : public QObject {
       RawKeysListCallback;
 
   /**
-   * @brief getDatabaseKeys - async keys loading
+   * @brief getDatabaseKeys - async keys loading.
+   * Use KeyIterator to process keys page by page without loading
+   * all of them into memory.
    * @param callback
    * @param pattern
    * @param dbIndex
+   * @param scanLimit - initial SCAN COUNT, adjusted to page latency
    */
   virtual void getDatabaseKeys(RawKeysListCallback callback,
                                const QString &pattern = QString("*"),
                                int dbIndex = 0, long scanLimit = 10000);
 
+  typedef std::function<void(const CompactKeyList &, const QString &)>
+      CompactKeysListCallback;
+
+  /**
+   * @brief getDatabaseKeysCompact - async keys loading into a single
+   * contiguous CompactKeyList, uses less memory than RawKeysList for
+   * huge keyspaces
+   * @param layout - list layout applied once all keys are loaded
+   */
+  virtual void getDatabaseKeysCompact(
+      CompactKeysListCallback callback, const QString &pattern = QString("*"),
+      int dbIndex = 0, long scanLimit = 10000,
+      CompactKeyList::Layout layout = CompactKeyList::Layout::Unsorted);
+
   typedef QList<QPair<QByteArray, ulong>> RootNamespaces;
   typedef QList<QByteArray> RootKeys;
   typedef QPair<RootNamespaces, RootKeys> NamespaceItems;
   typedef std::function<void(const NamespaceItems &, const QString &)>
       NamespaceItemsCallback;
 
+  /**
+   * @brief getNamespaceItems - async loading of root namespaces and keys.
+   * Namespace tree is built on client side from SCAN pages unless
+   * ConnectionConfig::serverSideNamespaceScan() is enabled.
+   */
   virtual void getNamespaceItems(NamespaceItemsCallback callback,
                                  const QString &nsSeparator,
                                  const QString &pattern = QString("*"),
                                  int dbIndex = 0);
 
+  typedef std::function<void(const NamespaceItems &, const QString &,
+                             bool final)>
+      IncrementalNamespaceItemsCallback;
+
+  /**
+   * @brief getNamespaceItemsIncrementally - callback is called with partial
+   * namespace tree while keys are loaded and finally with final=true
+   */
+  virtual void getNamespaceItemsIncrementally(
+      IncrementalNamespaceItemsCallback callback, const QString &nsSeparator,
+      const QString &pattern = QString("*"), int dbIndex = 0);
+
   /**
    * @brief getClusterKeys - async keys loading from all cluster nodes
    * @param callback
@@ -176,6 +256,28 @@ class Connection : public QObject {
   virtual void getClusterKeys(RawKeysListCallback callback,
                               const QString &pattern);
 
+  /**
+   * @brief getClusterKeysCompact - async keys loading from all cluster
+   * nodes into a single CompactKeyList
+   * @param layout - list layout applied once all keys are loaded
+   */
+  virtual void getClusterKeysCompact(
+      CompactKeysListCallback callback, const QString &pattern,
+      CompactKeyList::Layout layout = CompactKeyList::Layout::Unsorted);
+
+  typedef std::function<void(const RawKeysList &, const QString &, bool final)>
+      IncrementalRawKeysListCallback;
+
+  /**
+   * @brief getClusterKeysIncrementally - async keys loading from all cluster
+   * nodes. Nodes are scanned in parallel and callback is called for each
+   * page of keys and finally with final=true
+   * @param callback
+   * @param pattern
+   */
+  virtual void getClusterKeysIncrementally(
+      IncrementalRawKeysListCallback callback, const QString &pattern);
+
   /**
    * @brief flushDbKeys - Remove keys on all master nodes
    */
@@ -191,6 +293,37 @@ class Connection : public QObject {
    */
   HostList getMasterNodes();
 
+  typedef std::function<void(QSharedPointer<Connection> node,
+                             std::function<void(const QString &err)> done)>
+      MasterNodeOperation;
+
+  /**
+   * @brief forEachMaster - run async operation on all master nodes of cluster.
+   * Each node is processed over separate connection.
+   * @param operation - called for each connected node, should call done()
+   * once node is processed
+   * @param callback - called once all nodes are processed or on first error
+   * @param concurrency - max number of nodes processed in parallel,
+   * ConnectionConfig::clusterFanOutConcurrency() is used if <= 0
+   */
+  virtual void forEachMaster(MasterNodeOperation operation,
+                             std::function<void(const QString &)> callback,
+                             int concurrency = 0);
+
+  typedef std::function<void(const KeyspaceAnalyzer::Report &,
+                             const QString &, bool final)>
+      KeyspaceReportCallback;
+
+  /**
+   * @brief analyzeKeyspace - collect memory, type and TTL statistics of
+   * database. In cluster mode all master nodes are analyzed in parallel.
+   * Callback is called with partial report at most once per
+   * KeyspaceAnalyzer::Options::progressInterval and finally with final=true
+   */
+  virtual void analyzeKeyspace(KeyspaceReportCallback callback,
+                               const KeyspaceAnalyzer::Options &options =
+                                   KeyspaceAnalyzer::Options());
+
   /**
    * @brief isCommandSupported
    * @param rawCmd
@@ -254,9 +387,55 @@ class Connection : public QObject {
   }
 
   /**
-   * @brief commandSync
+   * @brief Execute command and decode reply into T without building
+   * QVariant tree, see ResponseDecoder for supported types.
+   * Future is canceled on error reply or if reply doesn't match T.
+   */
+  template <typename T>
+  QFuture<T> commandTyped(const Command &cmd) {
+    auto d = QSharedPointer<AsyncFuture::Deferred<T>>(
+        new AsyncFuture::Deferred<T>());
+
+    AsyncFuture::observe(command(cmd))
+        .subscribe(
+            [d](Response r) {
+              T value;
+
+              if (r.isErrorMessage() || !decode(r.view(), value))
+                return d->cancel();
+
+              d->complete(value);
+            },
+            [d]() { d->cancel(); });
+
+    return d->future();
+  }
+
+  /*
+   * Typed wrappers of common commands
+   */
+  QFuture<QByteArray> getTyped(const QByteArray &key, int db = -1);
+  QFuture<QHash<QByteArray, QByteArray>> hgetallTyped(const QByteArray &key,
+                                                      int db = -1);
+  QFuture<QVector<QByteArray>> mgetTyped(const QList<QByteArray> &keys,
+                                         int db = -1);
+  QFuture<qint64> incrTyped(const QByteArray &key, int db = -1);
+
+  /**
+   * @brief Create builder for non-transactional pipeline
+   * @return Pipeline
+   */
+  Pipeline pipeline();
+
+  /**
+   * @brief Execute command and block calling thread until reply is
+   * received. Connection is established with connect(true) first.
+   * Waiting is limited by command timeout or by execution timeout of
+   * connection config if command has no timeout.
+   * Waiting thread is woken up by completion handler of command, events
+   * of this thread are not processed while it waits.
    * @param cmd
-   * @return
+   * @return empty response if command was canceled or timed out
    */
   Response commandSync(const Command &cmd);
 
@@ -302,8 +481,43 @@ class Connection : public QObject {
    */
   virtual QFuture<Response> runCommand(const Command &cmd);
 
+  /**
+   * @brief Pass batch of commands to transporter at once.
+   * Commands are pipelined: written to the socket without waiting
+   * for responses of previous commands.
+   * @param commands
+   */
+  virtual void runCommands(const QList<Command> &commands);
+
+  /**
+   * @brief registerScript - add lua script to script registry of connection.
+   * Registered scripts are loaded with SCRIPT LOAD after each connect,
+   * scripts registered later are loaded on first use.
+   * @param name
+   * @param body
+   * @return SHA1 digest of script
+   */
+  QByteArray registerScript(const QByteArray &name, const QByteArray &body);
+
+  /**
+   * @brief runScript - execute registered script with EVALSHA.
+   * If redis-server lost script cache (restart, failover, SCRIPT FLUSH)
+   * script is executed with EVAL and loaded again.
+   * @param name - name of registered script
+   * @param keys
+   * @param args
+   * @param owner
+   * @param callback
+   * @param db
+   * @throws Connection::Exception if script is not registered
+   */
+  virtual void runScript(const QByteArray &name, const QList<QByteArray> &keys,
+                         const QList<QByteArray> &args, QObject *owner,
+                         RedisClient::Command::Callback callback, int db = -1);
+
   /**
    * @brief waitForIdle - Wait until all commands in queue will be processed
+   * Calling thread is blocked, events of other objects are not processed.
    * @param timeout - in milliseconds
    */
   bool waitForIdle(uint timeout);
@@ -321,8 +535,13 @@ class Connection : public QObject {
   void setTransporter(QSharedPointer<AbstractTransporter>);
   QSharedPointer<AbstractTransporter> getTransporter() const;
 
+  /**
+   * @brief Transporter of bulk lane connection
+   * @return nullptr if bulk lane is disabled or wasn't used yet
+   */
+  QSharedPointer<AbstractTransporter> getBulkLaneTransporter() const;
+
  signals:
-  void addCommandToWorker(const Command &);
   void error(const QString &);
   void log(const QString &);
   void connected();
@@ -331,15 +550,27 @@ class Connection : public QObject {
   void authOk();
   void authError(const QString &);
 
+  // RESP3 push frames which are not pub/sub messages
+  void pushMessageReceived(const RedisClient::Response &);
+
+  // Command queue is full, producers should throttle until false
+  void commandQueuePressure(bool underPressure);
+
   // Cluster & Sentinel
   void reconnectTo(const QString &host, int port);
 
  protected:
   void createTransporter();
   bool isTransporterRunning();
+  void startTransporter();
+  void stopTransporter();
 
   Response internalCommandSync(QList<QByteArray> rawCmd);
 
+  // Server info is written by handshake in transporter thread
+  ServerInfo serverInfo() const;
+  void setServerInfo(const ServerInfo &info);
+
   void processScanCommand(
       const ScanCommand &cmd, CollectionCallback callback,
       QSharedPointer<QVariantList> result = QSharedPointer<QVariantList>(),
@@ -347,28 +578,157 @@ class Connection : public QObject {
 
   void changeCurrentDbNumber(int db);
 
-  void clusterConnectToNextMasterNode(std::function<void(const QString& err)> callback);
+  /**
+   * @brief Namespace scan with lua script which blocks redis-server
+   * until whole keyspace is scanned
+   */
+  void getNamespaceItemsWithScript(NamespaceItemsCallback callback,
+                                   const QString &nsSeparator,
+                                   const QString &filter, int dbIndex);
+
+  struct MasterNodesFanOut;
+  void processNextMasterNode(QSharedPointer<MasterNodesFanOut> fanOut);
+
+  void enableClientSideCache(const Response &trackingResult);
+
+  /*
+   * Asynchronous connection handshake
+   */
+  struct Handshake;
+  void processHandshake(QSharedPointer<Handshake> handshake);
+  void detectServerMode();
+  void handshakeCommand(QList<QByteArray> rawCmd,
+                        std::function<void(const Response &)> callback);
+  void handshakeCompleted();
+
+  /*
+   * Script registry
+   */
+  void loadScript(const ScriptCache::Script &script);
+  void loadScripts();
+
+  /*
+   * Slot-aware cluster routing
+   */
+  void routeClusterCommand(const Command &cmd, int slot, const Host &node,
+                           bool asking, int redirectsCount = 0);
+  Command forwardedCommand(const Command &cmd, int db,
+                           Command::Callback callback);
+  void completeForwardedCommand(const Command &cmd, const Response &r,
+                                const QString &err);
+  QSharedPointer<Connection> clusterNodeConnection(const Host &node);
+
+  /*
+   * Read-from-replica routing
+   */
+  bool isReplicaReadCommand(const Command &cmd) const;
+
+  /**
+   * @brief Node for read-only command according to ReadFrom policy
+   * @return false if policy requires replica and there are no replicas
+   */
+  bool selectReadNode(const Host &master, const HostList &replicas,
+                      Host &result);
+  void runReplicaCommand(const Command &cmd, const Host &node);
+  QSharedPointer<Connection> replicaConnection(const Host &node);
+  void trackNodeLatency(const Host &node, QFuture<Response> result);
+  void addLatencySample(const Host &node, qint64 sentAt);
 
-  bool hasNotVisitedClusterNodes() const;
+  /*
+   * Sentinel discovery and failover
+   */
+  struct SentinelDiscovery;
+  void discoverSentinelMaster();
+  void processSentinelMaster(QSharedPointer<SentinelDiscovery> discovery,
+                             const Response &r,
+                             const ConnectionConfig &sentinel);
+  void processSwitchMaster(const QByteArray &event,
+                           const ConnectionConfig &sentinel);
+  void updateSentinelReplicas(const Response &r,
+                              const ConnectionConfig &sentinel);
+  QSharedPointer<Connection> sentinelConnection(const Host &sentinel);
+  void subscribeToSwitchMaster(QSharedPointer<Connection> sentinel);
 
-  void callAfterConnect(std::function<void(const QString& err)> callback);
+  /*
+   * Bulk lane
+   */
+  bool isBulkLaneCommand(const Command &cmd) const;
+  void runBulkLaneCommand(const Command &cmd);
+  QSharedPointer<Connection> bulkLaneConnection();
+
+  /**
+   * @return null if lane wasn't created yet
+   */
+  QSharedPointer<Connection> sharedBulkLane() const;
+
+  /**
+   * @brief Callback is called once after handshake or error. It is called
+   * directly in transporter thread, or in thread of context if it's given
+   */
+  void callAfterConnect(std::function<void(const QString& err)> callback,
+                        QObject *context = nullptr);
+  void trackCommandOwner(QObject *owner);
 
  protected slots:
   void auth();
 
  protected:
-  ConnectionConfig m_config;
+  // Read only through sharedSettings(), replaced from transporter thread
+  QSharedPointer<const ConnectionSettings> m_settings;
+  mutable QMutex m_settingsLock;
   QSharedPointer<QThread> m_transporterThread;
   QSharedPointer<AbstractTransporter> m_transporter;
 
-  int m_dbNumber;
-  ServerInfo m_serverInfo;
-  Mode m_currentMode;
-  QMutex m_dbNumberMutex;
+  // Updated from transporter thread
+  QAtomicInt m_dbNumber;
+  ServerInfo m_serverInfo;  // guarded by m_serverInfoLock
+  mutable QMutex m_serverInfoLock;
+  QAtomicInt m_currentMode;  // Mode, read by runCommand() from any thread
+  QAtomicInt m_protocolVersion;
+
+  // Server accepts timeouts like 0.5 (redis >= 6.0), snapshot of
+  // m_serverInfo for transporter thread
+  QAtomicInt m_fractionalTimeouts;
+
+  // Cache object is created once and never replaced, so
+  // transporter can access it after checking m_cacheEnabled
+  QSharedPointer<ClientSideCache> m_cache;
+  QAtomicInt m_cacheEnabled;
+  QSharedPointer<ScriptCache> m_scripts;
+
+  // Updated from transporter thread
+  QSharedPointer<ConnectionMetrics> m_metrics;
   bool m_autoConnect;
   bool m_stoppingTransporter;
-  RawKeysListCallback m_collectClusterNodeKeys;
-  RedisClient::Command::Callback m_cmdCallback;
-  QSharedPointer<HostList> m_notVisitedMasterNodes;
+  bool m_sharedTransporterThread;
+  QAtomicInt m_fullServerInfoLoaded;
+  QMutex m_trackedOwnersLock;
+  QSet<QObject *> m_trackedOwners;  // guarded by m_trackedOwnersLock
+
+  // Cluster routing. Slot map has own lock, node map is guarded by
+  // m_routingLock because runCommand() can be called from any thread.
+  QMutex m_routingLock;
+  ClusterSlotMap m_slotMap;
+  QHash<QString, QSharedPointer<Connection>> m_clusterNodes;
+  bool m_isClusterNode;
+  bool m_readOnlyNode;  // READONLY is sent on connect
+
+  // Sentinel discovery and failover, master name and sentinels are
+  // guarded by m_routingLock
+  bool m_isSentinelNode;
+  QString m_sentinelMasterName;
+  QHash<QString, QSharedPointer<Connection>> m_sentinels;
+
+  // Read-from-replica routing, guarded by m_routingLock
+  Host m_sentinelMaster;
+  HostList m_sentinelReplicas;
+  QHash<QString, QSharedPointer<Connection>> m_replicaNodes;
+  QHash<QString, qint64> m_nodeLatency;  // smoothed, in microseconds
+  QElapsedTimer m_routingClock;
+  uint m_readCounter;
+
+  // Lane is created on demand by runCommand() of any thread
+  mutable QMutex m_bulkLaneLock;
+  QSharedPointer<Connection> m_bulkLane;
 };
 }  // namespace RedisClient
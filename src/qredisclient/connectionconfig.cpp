@@ -167,6 +167,87 @@ uint RedisClient::ConnectionConfig::sshPort() const
     return param<uint>("ssh_port", DEFAULT_SSH_PORT);
 }
 
+uint RedisClient::ConnectionConfig::protocolVersion() const
+{
+    return param<uint>("protocol_version", 2);
+}
+
+void RedisClient::ConnectionConfig::setProtocolVersion(uint version)
+{
+    setParam<uint>("protocol_version", version);
+}
+
+QString RedisClient::ConnectionConfig::clientName() const
+{
+    return param<QString>("client_name");
+}
+
+void RedisClient::ConnectionConfig::setClientName(const QString &name)
+{
+    setParam<QString>("client_name", name);
+}
+
+uint RedisClient::ConnectionConfig::clientSideCacheMaxMemory() const
+{
+    return param<uint>("client_cache_max_memory", 0);
+}
+
+bool RedisClient::ConnectionConfig::clientSideCacheBroadcastMode() const
+{
+    return param<bool>("client_cache_bcast", false);
+}
+
+void RedisClient::ConnectionConfig::setClientSideCache(uint maxMemoryInBytes, bool broadcastMode)
+{
+    setParam<uint>("client_cache_max_memory", maxMemoryInBytes);
+    setParam<bool>("client_cache_bcast", broadcastMode);
+}
+
+uint RedisClient::ConnectionConfig::writeBatchMaxBytes() const
+{
+    return param<uint>("write_batch_max_bytes", DEFAULT_WRITE_BATCH_MAX_BYTES);
+}
+
+uint RedisClient::ConnectionConfig::writeBatchMaxCommands() const
+{
+    return param<uint>("write_batch_max_commands", DEFAULT_WRITE_BATCH_MAX_COMMANDS);
+}
+
+uint RedisClient::ConnectionConfig::writeBatchMaxDelay() const
+{
+    return param<uint>("write_batch_max_delay_us", DEFAULT_WRITE_BATCH_MAX_DELAY_IN_US);
+}
+
+void RedisClient::ConnectionConfig::setWriteBatchLimits(uint maxBytes, uint maxCommands, uint maxDelayInUs)
+{
+    setParam<uint>("write_batch_max_bytes", qMax(1u, maxBytes));
+    setParam<uint>("write_batch_max_commands", qMax(1u, maxCommands));
+    setParam<uint>("write_batch_max_delay_us", maxDelayInUs);
+}
+
+uint RedisClient::ConnectionConfig::subscriberQueueLimit() const
+{
+    return param<uint>("subscriber_queue_limit", DEFAULT_SUBSCRIBER_QUEUE_LIMIT);
+}
+
+RedisClient::ConnectionConfig::SubscriberOverflowPolicy
+RedisClient::ConnectionConfig::subscriberOverflowPolicy() const
+{
+    uint policy = param<uint>("subscriber_overflow_policy",
+                              static_cast<uint>(SubscriberOverflowPolicy::DropOldest));
+
+    if (policy > static_cast<uint>(SubscriberOverflowPolicy::PauseReading))
+        return SubscriberOverflowPolicy::DropOldest;
+
+    return static_cast<SubscriberOverflowPolicy>(policy);
+}
+
+void RedisClient::ConnectionConfig::setSubscriberQueue(uint limit, SubscriberOverflowPolicy policy)
+{
+    setParam<uint>("subscriber_queue_limit", qMax(1u, limit));
+    setParam<uint>("subscriber_overflow_policy", static_cast<uint>(policy));
+}
+
 QVariantHash RedisClient::ConnectionConfig::getInternalParameters() const
 {
     return m_parameters;
@@ -182,8 +263,229 @@ void RedisClient::ConnectionConfig::setClusterHostOverride(bool v)
     m_parameters.insert("cluster_host_override", v);
 }
 
+bool RedisClient::ConnectionConfig::clusterSlotRouting() const
+{
+    return param<bool>("cluster_slot_routing", true);
+}
+
+void RedisClient::ConnectionConfig::setClusterSlotRouting(bool v)
+{
+    m_parameters.insert("cluster_slot_routing", v);
+}
+
+uint RedisClient::ConnectionConfig::clusterFanOutConcurrency() const
+{
+    return param<uint>("cluster_fanout_concurrency", DEFAULT_CLUSTER_FANOUT_CONCURRENCY);
+}
+
+void RedisClient::ConnectionConfig::setClusterFanOutConcurrency(uint v)
+{
+    m_parameters.insert("cluster_fanout_concurrency", v);
+}
+
+bool RedisClient::ConnectionConfig::useSharedTransporterThread() const
+{
+    return param<bool>("shared_transporter_thread", false);
+}
+
+void RedisClient::ConnectionConfig::setSharedTransporterThread(bool v)
+{
+    m_parameters.insert("shared_transporter_thread", v);
+}
+
+bool RedisClient::ConnectionConfig::serverSideNamespaceScan() const
+{
+    return param<bool>("server_side_namespace_scan", false);
+}
+
+void RedisClient::ConnectionConfig::setServerSideNamespaceScan(bool v)
+{
+    m_parameters.insert("server_side_namespace_scan", v);
+}
+
+bool RedisClient::ConnectionConfig::useBulkLane() const
+{
+    return param<bool>("bulk_lane", false);
+}
+
+void RedisClient::ConnectionConfig::setBulkLane(bool v)
+{
+    m_parameters.insert("bulk_lane", v);
+}
+
+RedisClient::ConnectionConfig::ReadFrom
+RedisClient::ConnectionConfig::readFrom() const
+{
+    uint policy = param<uint>("read_from", static_cast<uint>(ReadFrom::Master));
+
+    if (policy > static_cast<uint>(ReadFrom::Nearest))
+        return ReadFrom::Master;
+
+    return static_cast<ReadFrom>(policy);
+}
+
+void RedisClient::ConnectionConfig::setReadFrom(ReadFrom policy)
+{
+    setParam<uint>("read_from", static_cast<uint>(policy));
+}
+
+QString RedisClient::ConnectionConfig::sentinelMasterName() const
+{
+    return param<QString>("sentinel_master");
+}
+
+QStringList RedisClient::ConnectionConfig::sentinels() const
+{
+    return param<QStringList>("sentinels");
+}
+
+void RedisClient::ConnectionConfig::setSentinelMasterName(const QString &name)
+{
+    m_parameters.insert("sentinel_master", name);
+}
+
+void RedisClient::ConnectionConfig::setSentinels(const QStringList &hosts)
+{
+    m_parameters.insert("sentinels", hosts);
+}
+
+QString RedisClient::ConnectionConfig::unixSocketPath() const
+{
+    return param<QString>("unix_socket");
+}
+
+bool RedisClient::ConnectionConfig::useUnixSocket() const
+{
+    return !unixSocketPath().isEmpty();
+}
+
+void RedisClient::ConnectionConfig::setUnixSocketPath(const QString &path)
+{
+    m_parameters.insert("unix_socket", path);
+}
+
+uint RedisClient::ConnectionConfig::socketReceiveBufferSize() const
+{
+    return param<uint>("socket_receive_buffer", 0);
+}
+
+uint RedisClient::ConnectionConfig::socketSendBufferSize() const
+{
+    return param<uint>("socket_send_buffer", 0);
+}
+
+void RedisClient::ConnectionConfig::setSocketBufferSizes(uint receiveBufferSize,
+                                                         uint sendBufferSize)
+{
+    m_parameters.insert("socket_receive_buffer", receiveBufferSize);
+    m_parameters.insert("socket_send_buffer", sendBufferSize);
+}
+
+uint RedisClient::ConnectionConfig::maxReplyBufferSize() const
+{
+    return param<uint>("max_reply_buffer", 0);
+}
+
+void RedisClient::ConnectionConfig::setMaxReplyBufferSize(uint bytes)
+{
+    m_parameters.insert("max_reply_buffer", bytes);
+}
+
+uint RedisClient::ConnectionConfig::reconnectMinDelay() const
+{
+    return param<uint>("reconnect_min_delay", DEFAULT_RECONNECT_MIN_DELAY_IN_MS);
+}
+
+uint RedisClient::ConnectionConfig::reconnectMaxDelay() const
+{
+    return qMax(reconnectMinDelay(),
+                param<uint>("reconnect_max_delay", DEFAULT_RECONNECT_MAX_DELAY_IN_MS));
+}
+
+uint RedisClient::ConnectionConfig::reconnectMaxAttempts() const
+{
+    return param<uint>("reconnect_max_attempts", DEFAULT_RECONNECT_MAX_ATTEMPTS);
+}
+
+RedisClient::ConnectionConfig::ReplayPolicy
+RedisClient::ConnectionConfig::replayPolicy() const
+{
+    uint policy = param<uint>("replay_policy", static_cast<uint>(ReplayPolicy::All));
+
+    if (policy > static_cast<uint>(ReplayPolicy::None))
+        return ReplayPolicy::All;
+
+    return static_cast<ReplayPolicy>(policy);
+}
+
+bool RedisClient::ConnectionConfig::useStandbyConnection() const
+{
+    return param<bool>("standby_connection", false);
+}
+
+void RedisClient::ConnectionConfig::setReconnectBackoff(uint minDelayInMs,
+                                                        uint maxDelayInMs,
+                                                        uint maxAttempts)
+{
+    m_parameters.insert("reconnect_min_delay", minDelayInMs);
+    m_parameters.insert("reconnect_max_delay", maxDelayInMs);
+    m_parameters.insert("reconnect_max_attempts", maxAttempts);
+}
+
+void RedisClient::ConnectionConfig::setReplayPolicy(ReplayPolicy policy)
+{
+    setParam<uint>("replay_policy", static_cast<uint>(policy));
+}
+
+void RedisClient::ConnectionConfig::setStandbyConnection(bool v)
+{
+    m_parameters.insert("standby_connection", v);
+}
+
+uint RedisClient::ConnectionConfig::commandQueueMaxCommands() const
+{
+    return param<uint>("command_queue_max_commands", 0);
+}
+
+uint RedisClient::ConnectionConfig::commandQueueMaxBytes() const
+{
+    return param<uint>("command_queue_max_bytes", 0);
+}
+
+RedisClient::ConnectionConfig::QueueOverflowPolicy
+RedisClient::ConnectionConfig::commandQueueOverflowPolicy() const
+{
+    uint policy = param<uint>("command_queue_overflow_policy",
+                              static_cast<uint>(QueueOverflowPolicy::Fail));
+
+    if (policy > static_cast<uint>(QueueOverflowPolicy::ShedLowestPriority))
+        return QueueOverflowPolicy::Fail;
+
+    return static_cast<QueueOverflowPolicy>(policy);
+}
+
+uint RedisClient::ConnectionConfig::commandQueueBlockTimeout() const
+{
+    return param<uint>("command_queue_block_timeout",
+                       DEFAULT_COMMAND_QUEUE_BLOCK_TIMEOUT_IN_MS);
+}
+
+void RedisClient::ConnectionConfig::setCommandQueueLimits(uint maxCommands,
+                                                          uint maxBytes,
+                                                          QueueOverflowPolicy policy,
+                                                          uint blockTimeoutInMs)
+{
+    m_parameters.insert("command_queue_max_commands", maxCommands);
+    m_parameters.insert("command_queue_max_bytes", maxBytes);
+    setParam<uint>("command_queue_overflow_policy", static_cast<uint>(policy));
+    m_parameters.insert("command_queue_block_timeout", blockTimeoutInMs);
+}
+
 bool RedisClient::ConnectionConfig::isNull() const
 {
+    if (useUnixSocket())
+        return false;
+
     return param<QString>("host").isEmpty()
             || param<uint>("port") <= 0;
 }
@@ -276,6 +578,61 @@ QJsonObject RedisClient::ConnectionConfig::toJsonObject()
     return QJsonObjectFromVariantHash(m_parameters);
 }
 
+RedisClient::ConnectionSettings::ConnectionSettings(const ConnectionConfig &c)
+    : config(c),
+      name(c.name()),
+      host(c.host()),
+      port(c.port()),
+      auth(c.auth()),
+      useAuth(c.useAuth()),
+      isValid(c.isValid()),
+      executeTimeout(c.executeTimeout()),
+      connectionTimeout(c.connectionTimeout()),
+      protocolVersion(c.protocolVersion()),
+      clientName(c.clientName()),
+      clientSideCacheMaxMemory(c.clientSideCacheMaxMemory()),
+      clientSideCacheBroadcastMode(c.clientSideCacheBroadcastMode()),
+      writeBatchMaxBytes(c.writeBatchMaxBytes()),
+      writeBatchMaxCommands(c.writeBatchMaxCommands()),
+      writeBatchMaxDelay(c.writeBatchMaxDelay()),
+      subscriberQueueLimit(c.subscriberQueueLimit()),
+      subscriberOverflowPolicy(c.subscriberOverflowPolicy()),
+      unixSocketPath(c.unixSocketPath()),
+      useUnixSocket(c.useUnixSocket()),
+      socketReceiveBufferSize(c.socketReceiveBufferSize()),
+      socketSendBufferSize(c.socketSendBufferSize()),
+      maxReplyBufferSize(c.maxReplyBufferSize()),
+      reconnectMinDelay(c.reconnectMinDelay()),
+      reconnectMaxDelay(c.reconnectMaxDelay()),
+      reconnectMaxAttempts(c.reconnectMaxAttempts()),
+      replayPolicy(c.replayPolicy()),
+      useStandbyConnection(c.useStandbyConnection()),
+      commandQueueMaxCommands(c.commandQueueMaxCommands()),
+      commandQueueMaxBytes(c.commandQueueMaxBytes()),
+      commandQueueOverflowPolicy(c.commandQueueOverflowPolicy()),
+      commandQueueBlockTimeout(c.commandQueueBlockTimeout()),
+      useSsl(c.useSsl()),
+      useSshTunnel(c.useSshTunnel()),
+      ignoreAllSslErrors(c.ignoreAllSslErrors()),
+      overrideClusterHost(c.overrideClusterHost()),
+      clusterSlotRouting(c.clusterSlotRouting()),
+      clusterFanOutConcurrency(c.clusterFanOutConcurrency()),
+      useSharedTransporterThread(c.useSharedTransporterThread()),
+      serverSideNamespaceScan(c.serverSideNamespaceScan()),
+      useBulkLane(c.useBulkLane()),
+      readFrom(c.readFrom()),
+      sentinelMasterName(c.sentinelMasterName()),
+      sentinels(c.sentinels())
+{
+}
+
+QSharedPointer<const RedisClient::ConnectionSettings>
+RedisClient::ConnectionSettings::create(const ConnectionConfig &config)
+{
+    return QSharedPointer<const ConnectionSettings>(
+        new ConnectionSettings(config));
+}
+
 QString RedisClient::ConnectionConfig::getValidPathFromParameter(const QString &name) const
 {
     QString path = param<QString>(name);
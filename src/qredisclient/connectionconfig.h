@@ -1,8 +1,10 @@
 #pragma once
 #include <QJsonObject>
 #include <QList>
+#include <QSharedPointer>
 #include <QSslCertificate>
 #include <QString>
+#include <QStringList>
 #include <QVariantHash>
 
 namespace RedisClient {
@@ -18,6 +20,54 @@ class ConnectionConfig {
   static const uint DEFAULT_REDIS_PORT = 6379;
   static const uint DEFAULT_SSH_PORT = 22;
   static const uint DEFAULT_TIMEOUT_IN_MS = 60000;
+  static const uint DEFAULT_WRITE_BATCH_MAX_BYTES = 64 * 1024;
+  static const uint DEFAULT_WRITE_BATCH_MAX_COMMANDS = 1000;
+  static const uint DEFAULT_WRITE_BATCH_MAX_DELAY_IN_US = 0;
+  static const uint DEFAULT_CLUSTER_FANOUT_CONCURRENCY = 8;
+  static const uint DEFAULT_SUBSCRIBER_QUEUE_LIMIT = 10000;
+  static const uint DEFAULT_RECONNECT_MIN_DELAY_IN_MS = 100;
+  static const uint DEFAULT_RECONNECT_MAX_DELAY_IN_MS = 10000;
+  static const uint DEFAULT_RECONNECT_MAX_ATTEMPTS = 10;
+  static const uint DEFAULT_COMMAND_QUEUE_BLOCK_TIMEOUT_IN_MS = 1000;
+
+  /**
+   * @brief Action taken when pub/sub messages of subscription exceed
+   * subscriber queue limit
+   */
+  enum class SubscriberOverflowPolicy {
+    DropOldest = 0,
+    DropNewest = 1,
+    PauseReading = 2  // stop reading socket until consumer catches up
+  };
+
+  /**
+   * @brief Nodes used for read-only commands in cluster and sentinel modes
+   */
+  enum class ReadFrom {
+    Master = 0,
+    PreferReplica = 1,  // master is used if there are no replicas
+    Replica = 2,        // command fails if there are no replicas
+    Nearest = 3         // node with lowest observed latency
+  };
+
+  /**
+   * @brief Commands sent before connection was lost which are sent
+   * again after reconnect. Other commands fail.
+   */
+  /**
+   * @brief Action taken when command queue is full
+   */
+  enum class QueueOverflowPolicy {
+    Fail = 0,               // new command fails immediately
+    Block = 1,              // caller waits for space up to block timeout
+    ShedLowestPriority = 2  // queued command of lowest priority fails
+  };
+
+  enum class ReplayPolicy {
+    All = 0,
+    ReadOnly = 1,  // write commands may have been applied by server
+    None = 2
+  };
 
  public:
   /**
@@ -58,6 +108,118 @@ class ConnectionConfig {
   void setConnectionTimeout(uint timeout);
   void setTimeouts(uint connectionTimeout, uint commandExecutionTimeout);
 
+  /*
+   * Protocol settings
+   * RESP3 is negotiated with HELLO 3 on connect. Connection falls back to
+   * RESP2 if server or hiredis doesn't support it.
+   */
+  uint protocolVersion() const;
+  void setProtocolVersion(uint version);
+
+  /**
+   * @brief Name set with CLIENT SETNAME during handshake.
+   * Empty name keeps connection anonymous.
+   */
+  QString clientName() const;
+  void setClientName(const QString& name);
+
+  /*
+   * Client-side cache settings
+   * Cache requires RESP3 and redis-server >= 6.0 (CLIENT TRACKING).
+   * Zero memory limit disables cache.
+   */
+  uint clientSideCacheMaxMemory() const;
+  bool clientSideCacheBroadcastMode() const;
+
+  void setClientSideCache(uint maxMemoryInBytes, bool broadcastMode = false);
+
+  /*
+   * Write coalescing settings
+   * Commands queued within one event loop turn (or within max delay)
+   * are written to socket as a single batch. Batch is flushed as soon
+   * as one of the limits is reached. Zero delay means "flush at the
+   * end of current event loop turn".
+   */
+  uint writeBatchMaxBytes() const;
+  uint writeBatchMaxCommands() const;
+  uint writeBatchMaxDelay() const;
+
+  void setWriteBatchLimits(uint maxBytes, uint maxCommands,
+                           uint maxDelayInUs = DEFAULT_WRITE_BATCH_MAX_DELAY_IN_US);
+
+  /*
+   * Pub/Sub delivery settings
+   * Messages for subscribers in other threads are buffered and
+   * delivered in batches. Limit is a number of messages per subscription.
+   */
+  uint subscriberQueueLimit() const;
+  SubscriberOverflowPolicy subscriberOverflowPolicy() const;
+
+  void setSubscriberQueue(uint limit, SubscriberOverflowPolicy policy =
+                                          SubscriberOverflowPolicy::DropOldest);
+
+  /*
+   * Unix domain socket settings
+   * Connection to local redis-server through unix socket skips TCP stack.
+   * Host and port are ignored, SSL and SSH tunnel are not used.
+   */
+  QString unixSocketPath() const;
+  bool useUnixSocket() const;
+
+  void setUnixSocketPath(const QString& path);
+
+  /*
+   * Socket settings
+   * Sizes of kernel buffers (SO_RCVBUF / SO_SNDBUF) in bytes.
+   * Zero keeps OS defaults.
+   * Max reply buffer limits amount of received but not yet parsed data,
+   * connection is closed on runaway reply. Zero - unlimited.
+   */
+  uint socketReceiveBufferSize() const;
+  uint socketSendBufferSize() const;
+  uint maxReplyBufferSize() const;
+
+  void setSocketBufferSizes(uint receiveBufferSize, uint sendBufferSize);
+  void setMaxReplyBufferSize(uint bytes);
+
+  /*
+   * Reconnect settings
+   * Lost connection is restored in background. Delay between attempts
+   * grows exponentially from min to max delay and is randomized, so
+   * clients don't reconnect at the same moment. Connection is closed
+   * with error after max attempts, 0 - unlimited.
+   * Standby connection is opened to the same server in advance, so
+   * reconnect skips TCP handshake (plain TCP only).
+   */
+  uint reconnectMinDelay() const;
+  uint reconnectMaxDelay() const;
+  uint reconnectMaxAttempts() const;
+  ReplayPolicy replayPolicy() const;
+  bool useStandbyConnection() const;
+
+  void setReconnectBackoff(
+      uint minDelayInMs, uint maxDelayInMs,
+      uint maxAttempts = DEFAULT_RECONNECT_MAX_ATTEMPTS);
+  void setReplayPolicy(ReplayPolicy policy);
+  void setStandbyConnection(bool v);
+
+  /*
+   * Command queue settings
+   * Limits of commands which are waiting to be written to socket,
+   * zero - unlimited. Size is a total size of command arguments.
+   * High priority commands (e.g. handshake) are always accepted.
+   * Caller is never blocked in transporter thread, command fails instead.
+   */
+  uint commandQueueMaxCommands() const;
+  uint commandQueueMaxBytes() const;
+  QueueOverflowPolicy commandQueueOverflowPolicy() const;
+  uint commandQueueBlockTimeout() const;
+
+  void setCommandQueueLimits(
+      uint maxCommands, uint maxBytes,
+      QueueOverflowPolicy policy = QueueOverflowPolicy::Fail,
+      uint blockTimeoutInMs = DEFAULT_COMMAND_QUEUE_BLOCK_TIMEOUT_IN_MS);
+
   /*
    * SSL settings
    */
@@ -108,6 +270,65 @@ class ConnectionConfig {
   bool overrideClusterHost() const;
   void setClusterHostOverride(bool v);
 
+  /**
+   * @brief Route commands directly to master node which owns key slot
+   * instead of following redirects on a single connection
+   */
+  bool clusterSlotRouting() const;
+  void setClusterSlotRouting(bool v);
+
+  /**
+   * @brief Max number of master nodes processed in parallel by
+   * Connection::forEachMaster()
+   */
+  uint clusterFanOutConcurrency() const;
+  void setClusterFanOutConcurrency(uint v);
+
+  /**
+   * @brief Run transporter in shared I/O thread from TransporterThreadPool
+   * instead of dedicated thread
+   */
+  bool useSharedTransporterThread() const;
+  void setSharedTransporterThread(bool v);
+
+  /**
+   * @brief Build namespace tree with lua script on redis-server instead
+   * of client side. Script blocks server until whole keyspace is scanned.
+   */
+  bool serverSideNamespaceScan() const;
+  void setServerSideNamespaceScan(bool v);
+
+  /**
+   * @brief Execute read-only Bulk priority commands over separate
+   * connection, so they don't block interactive commands. Bulk writes
+   * stay on main connection.
+   * NOTE: order of commands on different connections is not preserved,
+   * use Pipeline for MULTI/EXEC transactions.
+   */
+  bool useBulkLane() const;
+  void setBulkLane(bool v);
+
+  /**
+   * @brief Route read-only commands to replicas returned by CLUSTER SLOTS
+   * or SENTINEL replicas. Load is spread across replicas.
+   */
+  ReadFrom readFrom() const;
+  void setReadFrom(ReadFrom policy);
+
+  /*
+   * Sentinel settings
+   * Master is looked up by name on all sentinels in parallel, first
+   * valid reply wins. Without name first master of SENTINEL masters is
+   * used. Connection switches to new master on +switch-master event.
+   * Other sentinels are set as "host:port" in addition to host/port
+   * of this config.
+   */
+  QString sentinelMasterName() const;
+  QStringList sentinels() const;
+
+  void setSentinelMasterName(const QString& name);
+  void setSentinels(const QStringList& hosts);
+
   /*
    * Convert config to JSON
    */
@@ -145,4 +366,81 @@ class ConnectionConfig {
   QWeakPointer<Connection> m_owner;
   QVariantHash m_parameters;
 };
+
+/**
+ * @brief The ConnectionSettings struct
+ * Typed snapshot of ConnectionConfig which is used by Connection and
+ * transporters. Parameters are resolved once when config is set, so
+ * hot paths read plain fields instead of QVariantHash lookups.
+ * Settings are shared as QSharedPointer<const ConnectionSettings> by
+ * connection clones and pooled connections and never modified.
+ */
+struct ConnectionSettings {
+  typedef ConnectionConfig::SubscriberOverflowPolicy SubscriberOverflowPolicy;
+  typedef ConnectionConfig::ReadFrom ReadFrom;
+  typedef ConnectionConfig::QueueOverflowPolicy QueueOverflowPolicy;
+  typedef ConnectionConfig::ReplayPolicy ReplayPolicy;
+
+  explicit ConnectionSettings(
+      const ConnectionConfig& config = ConnectionConfig());
+
+  static QSharedPointer<const ConnectionSettings> create(
+      const ConnectionConfig& config);
+
+  ConnectionConfig config;  // source config, e.g. for SSL and SSH settings
+
+  QString name;
+  QString host;
+  uint port;
+  QString auth;
+  bool useAuth;
+  bool isValid;
+
+  uint executeTimeout;
+  uint connectionTimeout;
+  uint protocolVersion;
+  QString clientName;
+
+  uint clientSideCacheMaxMemory;
+  bool clientSideCacheBroadcastMode;
+
+  uint writeBatchMaxBytes;
+  uint writeBatchMaxCommands;
+  uint writeBatchMaxDelay;
+
+  uint subscriberQueueLimit;
+  SubscriberOverflowPolicy subscriberOverflowPolicy;
+
+  QString unixSocketPath;
+  bool useUnixSocket;
+  uint socketReceiveBufferSize;
+  uint socketSendBufferSize;
+  uint maxReplyBufferSize;
+
+  uint reconnectMinDelay;
+  uint reconnectMaxDelay;
+  uint reconnectMaxAttempts;
+  ReplayPolicy replayPolicy;
+  bool useStandbyConnection;
+
+  uint commandQueueMaxCommands;
+  uint commandQueueMaxBytes;
+  QueueOverflowPolicy commandQueueOverflowPolicy;
+  uint commandQueueBlockTimeout;
+
+  bool useSsl;
+  bool useSshTunnel;
+  bool ignoreAllSslErrors;
+
+  bool overrideClusterHost;
+  bool clusterSlotRouting;
+  uint clusterFanOutConcurrency;
+  bool useSharedTransporterThread;
+  bool serverSideNamespaceScan;
+  bool useBulkLane;
+  ReadFrom readFrom;
+
+  QString sentinelMasterName;
+  QStringList sentinels;
+};
 }  // namespace RedisClient
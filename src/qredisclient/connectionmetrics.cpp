@@ -0,0 +1,269 @@
+#include "connectionmetrics.h"
+#include <QMutexLocker>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+const char* PHASE_NAMES[] = {"queue_wait", "send", "server"};
+
+QByteArray escapeLabel(const QByteArray& value) {
+  QByteArray result = value;
+  result.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+  return result;
+}
+
+QByteArray seconds(quint64 usecs) {
+  return QByteArray::number(usecs / 1000000.0, 'g', 9);
+}
+}  // namespace
+
+RedisClient::LatencyHistogram::LatencyHistogram()
+    : m_count(0), m_sum(0), m_min(0), m_max(0) {}
+
+void RedisClient::LatencyHistogram::record(quint64 usecs) {
+  if (m_counts.isEmpty()) m_counts.fill(0, BUCKETS);
+
+  m_counts[bucketIndex(usecs)]++;
+
+  if (m_count == 0 || usecs < m_min) m_min = usecs;
+  if (usecs > m_max) m_max = usecs;
+
+  m_count++;
+  m_sum += usecs;
+}
+
+void RedisClient::LatencyHistogram::clear() {
+  m_counts.clear();
+  m_count = 0;
+  m_sum = 0;
+  m_min = 0;
+  m_max = 0;
+}
+
+quint64 RedisClient::LatencyHistogram::count() const { return m_count; }
+
+quint64 RedisClient::LatencyHistogram::sum() const { return m_sum; }
+
+quint64 RedisClient::LatencyHistogram::min() const { return m_min; }
+
+quint64 RedisClient::LatencyHistogram::max() const { return m_max; }
+
+double RedisClient::LatencyHistogram::mean() const {
+  return m_count > 0 ? double(m_sum) / m_count : 0.0;
+}
+
+quint64 RedisClient::LatencyHistogram::percentile(double percentile) const {
+  if (m_count == 0) return 0;
+
+  quint64 target = static_cast<quint64>(
+      std::ceil(qBound(0.0, percentile, 100.0) / 100.0 * m_count));
+  target = qMax(Q_UINT64_C(1), target);
+
+  quint64 seen = 0;
+
+  for (int i = 0; i < m_counts.size(); ++i) {
+    seen += m_counts.at(i);
+
+    if (seen >= target) return qMin(bucketUpperBound(i), m_max);
+  }
+
+  return m_max;
+}
+
+int RedisClient::LatencyHistogram::bucketIndex(quint64 usecs) {
+  const quint64 limit = (Q_UINT64_C(1) << MAX_BITS) - 1;
+
+  if (usecs > limit) usecs = limit;
+
+  if (usecs < static_cast<quint64>(SUB_BUCKETS)) return static_cast<int>(usecs);
+
+  int msb = 63 - static_cast<int>(qCountLeadingZeroBits(usecs));
+  int shift = msb - SUB_BUCKET_BITS;
+
+  return (shift + 1) * SUB_BUCKETS + static_cast<int>(usecs >> shift) -
+         SUB_BUCKETS;
+}
+
+quint64 RedisClient::LatencyHistogram::bucketUpperBound(int index) {
+  if (index < SUB_BUCKETS) return index;
+
+  int shift = index / SUB_BUCKETS - 1;
+  quint64 lowest = static_cast<quint64>(SUB_BUCKETS + index % SUB_BUCKETS)
+                   << shift;
+
+  return lowest + (Q_UINT64_C(1) << shift) - 1;
+}
+
+RedisClient::ConnectionMetrics::ConnectionMetrics() { reset(); }
+
+void RedisClient::ConnectionMetrics::recordCommand(const QByteArray& name,
+                                                   quint64 queueWait,
+                                                   quint64 send,
+                                                   quint64 server) {
+  // Lower-case lookup key is built without allocation for usual names
+  char buffer[32];
+  QByteArray key;
+
+  if (name.size() <= static_cast<int>(sizeof(buffer))) {
+    for (int i = 0; i < name.size(); ++i) {
+      char c = name.at(i);
+      buffer[i] = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+    key = QByteArray::fromRawData(buffer, name.size());
+  } else {
+    key = name.toLower();
+  }
+
+  QMutexLocker lock(&m_lock);
+
+  auto stats = m_commands.find(key);
+
+  if (stats == m_commands.end())
+    stats = m_commands.insert(QByteArray(key.constData(), key.size()),
+                              CommandStats());
+
+  stats->phases[QueueWait].record(queueWait);
+  stats->phases[Send].record(send);
+  stats->phases[Server].record(server);
+}
+
+void RedisClient::ConnectionMetrics::addBytesIn(quint64 bytes) {
+  m_bytesIn.fetchAndAddRelaxed(bytes);
+}
+
+void RedisClient::ConnectionMetrics::addBytesOut(quint64 bytes) {
+  m_bytesOut.fetchAndAddRelaxed(bytes);
+}
+
+void RedisClient::ConnectionMetrics::addReplies(quint64 replies,
+                                                quint64 allocations) {
+  m_replies.fetchAndAddRelaxed(replies);
+  m_replyAllocations.fetchAndAddRelaxed(allocations);
+}
+
+void RedisClient::ConnectionMetrics::addReconnect() {
+  m_reconnects.fetchAndAddRelaxed(1);
+}
+
+void RedisClient::ConnectionMetrics::addRejectedCommands(quint64 commands) {
+  m_rejectedCommands.fetchAndAddRelaxed(commands);
+}
+
+void RedisClient::ConnectionMetrics::addShedCommands(quint64 commands) {
+  m_shedCommands.fetchAndAddRelaxed(commands);
+}
+
+void RedisClient::ConnectionMetrics::setInFlight(int commands) {
+  m_inFlight.storeRelease(commands);
+
+  // Updated only from transporter thread
+  if (commands > m_maxInFlight.loadAcquire())
+    m_maxInFlight.storeRelease(commands);
+}
+
+RedisClient::ConnectionMetrics::Snapshot
+RedisClient::ConnectionMetrics::snapshot() const {
+  Snapshot s;
+
+  {
+    QMutexLocker lock(&m_lock);
+    s.commands = m_commands;
+  }
+
+  s.bytesIn = m_bytesIn.loadAcquire();
+  s.bytesOut = m_bytesOut.loadAcquire();
+  s.replies = m_replies.loadAcquire();
+  s.replyAllocations = m_replyAllocations.loadAcquire();
+  s.reconnects = m_reconnects.loadAcquire();
+  s.rejectedCommands = m_rejectedCommands.loadAcquire();
+  s.shedCommands = m_shedCommands.loadAcquire();
+  s.inFlight = m_inFlight.loadAcquire();
+  s.maxInFlight = m_maxInFlight.loadAcquire();
+  return s;
+}
+
+void RedisClient::ConnectionMetrics::reset() {
+  {
+    QMutexLocker lock(&m_lock);
+    m_commands.clear();
+  }
+
+  m_bytesIn.storeRelease(0);
+  m_bytesOut.storeRelease(0);
+  m_replies.storeRelease(0);
+  m_replyAllocations.storeRelease(0);
+  m_reconnects.storeRelease(0);
+  m_rejectedCommands.storeRelease(0);
+  m_shedCommands.storeRelease(0);
+  m_inFlight.storeRelease(0);
+  m_maxInFlight.storeRelease(0);
+}
+
+QByteArray RedisClient::ConnectionMetrics::Snapshot::toPrometheus(
+    const QString& connection) const {
+  QByteArray labels;
+
+  if (!connection.isEmpty())
+    labels = "connection=\"" + escapeLabel(connection.toUtf8()) + "\"";
+
+  auto withLabels = [&labels](const QByteArray& extra) -> QByteArray {
+    if (labels.isEmpty() && extra.isEmpty()) return QByteArray();
+    if (labels.isEmpty()) return "{" + extra + "}";
+    if (extra.isEmpty()) return "{" + labels + "}";
+    return "{" + labels + "," + extra + "}";
+  };
+
+  auto metric = [&withLabels](QByteArray& out, const char* name,
+                              const char* type, quint64 value) {
+    out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+    out.append(name).append(withLabels(QByteArray())).append(" ");
+    out.append(QByteArray::number(value)).append("\n");
+  };
+
+  QByteArray out;
+  metric(out, "qredisclient_bytes_received_total", "counter", bytesIn);
+  metric(out, "qredisclient_bytes_sent_total", "counter", bytesOut);
+  metric(out, "qredisclient_replies_total", "counter", replies);
+  metric(out, "qredisclient_reply_allocations_total", "counter",
+         replyAllocations);
+  metric(out, "qredisclient_reconnects_total", "counter", reconnects);
+  metric(out, "qredisclient_rejected_commands_total", "counter",
+         rejectedCommands);
+  metric(out, "qredisclient_shed_commands_total", "counter", shedCommands);
+  metric(out, "qredisclient_in_flight_commands", "gauge", inFlight);
+  metric(out, "qredisclient_in_flight_commands_max", "gauge", maxInFlight);
+
+  const char* duration = "qredisclient_command_duration_seconds";
+  out.append("# TYPE ").append(duration).append(" summary\n");
+
+  QList<QByteArray> names = commands.keys();
+  std::sort(names.begin(), names.end());
+
+  for (const QByteArray& name : names) {
+    const CommandStats stats = commands.value(name);
+
+    for (int phase = 0; phase < PHASES_COUNT; ++phase) {
+      const LatencyHistogram& h = stats.phases[phase];
+      QByteArray series = "command=\"" + escapeLabel(name) + "\",phase=\"" +
+                          PHASE_NAMES[phase] + "\"";
+
+      for (double q : QUANTILES) {
+        out.append(duration)
+            .append(withLabels(series + ",quantile=\"" +
+                               QByteArray::number(q) + "\""))
+            .append(" ")
+            .append(seconds(h.percentile(q * 100)))
+            .append("\n");
+      }
+
+      out.append(duration).append("_sum").append(withLabels(series));
+      out.append(" ").append(seconds(h.sum())).append("\n");
+      out.append(duration).append("_count").append(withLabels(series));
+      out.append(" ").append(QByteArray::number(h.count())).append("\n");
+    }
+  }
+
+  return out;
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+namespace RedisClient {
+
+/**
+ * @brief The LatencyHistogram class
+ * HDR-style histogram of durations in microseconds. Each power of two
+ * range is split into SUB_BUCKETS linear buckets, so relative error of
+ * percentiles is below 1 / SUB_BUCKETS on the whole range.
+ */
+class LatencyHistogram {
+ public:
+  static const int SUB_BUCKET_BITS = 4;
+  static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+  // Durations are clamped to 2^MAX_BITS microseconds (~12 days)
+  static const int MAX_BITS = 40;
+  static const int BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+ public:
+  LatencyHistogram();
+
+  void record(quint64 usecs);
+  void clear();
+
+  quint64 count() const;
+  quint64 sum() const;
+  quint64 min() const;
+  quint64 max() const;
+  double mean() const;
+
+  /**
+   * @brief Highest value of bucket which contains percentile
+   * @param percentile - 0..100
+   */
+  quint64 percentile(double percentile) const;
+
+  static int bucketIndex(quint64 usecs);
+  static quint64 bucketUpperBound(int index);
+
+ private:
+  QVector<quint64> m_counts;  // allocated on first record
+  quint64 m_count;
+  quint64 m_sum;
+  quint64 m_min;
+  quint64 m_max;
+};
+
+/**
+ * @brief The ConnectionMetrics class
+ * Low-overhead counters of a connection. Latencies are recorded by
+ * transporter once per reply, snapshot can be taken from any thread.
+ */
+class ConnectionMetrics {
+ public:
+  /*
+   * Phases of command execution:
+   * QueueWait - from submission until command is taken from queue,
+   * Send - until write batch with command is written to socket,
+   * Server - until reply is parsed (redis-server + network)
+   */
+  enum Phase { QueueWait = 0, Send = 1, Server = 2, PHASES_COUNT = 3 };
+
+  struct CommandStats {
+    LatencyHistogram phases[PHASES_COUNT];
+
+    quint64 calls() const { return phases[Server].count(); }
+  };
+
+  struct Snapshot {
+    QHash<QByteArray, CommandStats> commands;  // by lower-case name
+    quint64 bytesIn;
+    quint64 bytesOut;
+    quint64 replies;
+    quint64 replyAllocations;
+    quint64 reconnects;
+    quint64 rejectedCommands;  // command queue was full
+    quint64 shedCommands;
+    int inFlight;
+    int maxInFlight;
+
+    double allocationsPerReply() const {
+      return replies > 0 ? double(replyAllocations) / replies : 0.0;
+    }
+
+    /**
+     * @brief Prometheus text exposition format
+     * @param connection - value of "connection" label, omitted if empty
+     */
+    QByteArray toPrometheus(const QString& connection = QString()) const;
+  };
+
+ public:
+  ConnectionMetrics();
+
+  /**
+   * @brief Record latencies of completed command
+   * @param name - command name as sent to redis-server
+   */
+  void recordCommand(const QByteArray& name, quint64 queueWait, quint64 send,
+                     quint64 server);
+
+  void addBytesIn(quint64 bytes);
+  void addBytesOut(quint64 bytes);
+  void addReplies(quint64 replies, quint64 allocations);
+  void addReconnect();
+  void addRejectedCommands(quint64 commands);
+  void addShedCommands(quint64 commands);
+  void setInFlight(int commands);
+
+  Snapshot snapshot() const;
+  void reset();
+
+ private:
+  mutable QMutex m_lock;
+  QHash<QByteArray, CommandStats> m_commands;
+
+  QAtomicInteger<quint64> m_bytesIn;
+  QAtomicInteger<quint64> m_bytesOut;
+  QAtomicInteger<quint64> m_replies;
+  QAtomicInteger<quint64> m_replyAllocations;
+  QAtomicInteger<quint64> m_reconnects;
+  QAtomicInteger<quint64> m_rejectedCommands;
+  QAtomicInteger<quint64> m_shedCommands;
+  QAtomicInt m_inFlight;
+  QAtomicInt m_maxInFlight;
+};
+
+}  // namespace RedisClient
@@ -0,0 +1,410 @@
+#include "connectionpool.h"
+#include <QPointer>
+#include <QSet>
+#include <QThread>
+
+namespace {
+// Commands which change connection state
+const uint STATEFUL_FLAGS =
+    RedisClient::CommandInfo::Select | RedisClient::CommandInfo::Multi |
+    RedisClient::CommandInfo::Exec | RedisClient::CommandInfo::Watch |
+    RedisClient::CommandInfo::Unwatch | RedisClient::CommandInfo::Subscribe |
+    RedisClient::CommandInfo::Unsubscribe | RedisClient::CommandInfo::Monitor;
+
+// Channels follow command name
+void updateSubscriptions(QSet<QByteArray> &subscriptions,
+                         const QList<QByteArray> &args, bool subscribe) {
+  if (!subscribe && args.size() < 2) return subscriptions.clear();
+
+  for (int i = 1; i < args.size(); ++i) {
+    if (subscribe)
+      subscriptions.insert(args.at(i));
+    else
+      subscriptions.remove(args.at(i));
+  }
+}
+}  // namespace
+
+RedisClient::ConnectionPool::ConnectionPool(const ConnectionConfig &c,
+                                            int size, Dispatch dispatch)
+    : m_settings(ConnectionSettings::create(c)),
+      m_dispatch(dispatch),
+      m_nextIndex(0) {
+  if (size <= 0) size = qMax(1, QThread::idealThreadCount());
+
+  m_nodes.reserve(size);
+
+  // Settings are resolved once and shared by all connections
+  for (int i = 0; i < size; ++i) {
+    QSharedPointer<Connection> connection(new Connection(m_settings, true));
+
+    QObject::connect(connection.data(), &Connection::log, this,
+                     &ConnectionPool::log);
+    QObject::connect(connection.data(), &Connection::error, this,
+                     [this, i](const QString &err) {
+                       setHealthy(i, false);
+                       emit error(err);
+                     });
+    QObject::connect(connection.data(), &Connection::authOk, this,
+                     [this, i]() { setHealthy(i, true); });
+
+    m_nodes.append(PoolNode{connection, 0, 0, false});
+  }
+
+  m_healthCheckTimer.setInterval(DEFAULT_HEALTH_CHECK_INTERVAL_IN_MS);
+  QObject::connect(&m_healthCheckTimer, &QTimer::timeout, this,
+                   &ConnectionPool::checkHealth);
+}
+
+RedisClient::ConnectionPool::~ConnectionPool() {
+  m_healthCheckTimer.stop();
+  disconnect();
+}
+
+int RedisClient::ConnectionPool::size() const { return m_nodes.size(); }
+
+RedisClient::ConnectionConfig RedisClient::ConnectionPool::getConfig() const {
+  return m_settings->config;
+}
+
+QSharedPointer<RedisClient::Connection>
+RedisClient::ConnectionPool::connectionAt(int index) const {
+  if (index < 0 || index >= m_nodes.size()) return QSharedPointer<Connection>();
+
+  return m_nodes.at(index).connection;
+}
+
+bool RedisClient::ConnectionPool::connect(bool wait) {
+  bool connected = false;
+
+  for (int i = 0; i < m_nodes.size(); ++i) {
+    try {
+      bool result = m_nodes[i].connection->connect(wait);
+      if (wait) setHealthy(i, result);
+      connected |= result;
+    } catch (const Connection::Exception &e) {
+      setHealthy(i, false);
+      emit error(QString("Cannot connect pool connection %1: %2")
+                     .arg(i)
+                     .arg(e.what()));
+    }
+  }
+
+  if (m_healthCheckTimer.interval() > 0) m_healthCheckTimer.start();
+
+  return connected;
+}
+
+void RedisClient::ConnectionPool::disconnect() {
+  m_healthCheckTimer.stop();
+
+  for (int i = 0; i < m_nodes.size(); ++i) {
+    m_nodes[i].connection->disconnect();
+    m_nodes[i].healthy = false;
+  }
+}
+
+bool RedisClient::ConnectionPool::isConnected() const {
+  for (const PoolNode &node : m_nodes) {
+    if (node.healthy && node.connection->isConnected()) return true;
+  }
+  return false;
+}
+
+QFuture<RedisClient::Response> RedisClient::ConnectionPool::runCommand(
+    const Command &cmd) {
+  int index = connectionIndexFor(cmd);
+
+  QFuture<Response> result;
+
+  try {
+    result = m_nodes[index].connection->runCommand(cmd);
+  } catch (const Connection::Exception &) {
+    commandFinished(cmd);
+    throw;
+  }
+
+  trackOutstanding(index, result);
+
+  if (cmd.isBlockingCommand()) {
+    QPointer<ConnectionPool> self(this);
+
+    auto onFinished = [self, cmd]() {
+      if (self) self->commandFinished(cmd);
+    };
+
+    AsyncFuture::observe(result).subscribe(
+        [onFinished](Response) { onFinished(); }, onFinished);
+  }
+
+  return result;
+}
+
+QFuture<RedisClient::Response> RedisClient::ConnectionPool::command(
+    QList<QByteArray> rawCmd, int db) {
+  return runCommand(Command(rawCmd, db));
+}
+
+QFuture<RedisClient::Response> RedisClient::ConnectionPool::command(
+    QList<QByteArray> rawCmd, QObject *owner,
+    RedisClient::Command::Callback callback, int db) {
+  return runCommand(Command(rawCmd, owner, callback, db));
+}
+
+RedisClient::Response RedisClient::ConnectionPool::commandSync(
+    const Command &cmd) {
+  int index = connectionIndexFor(cmd);
+  QSharedPointer<Connection> connection = m_nodes[index].connection;
+
+  m_nodes[index].outstanding++;
+
+  try {
+    Response r = connection->commandSync(cmd);
+    m_nodes[index].outstanding--;
+    commandFinished(cmd);
+    return r;
+  } catch (...) {
+    m_nodes[index].outstanding--;
+    commandFinished(cmd);
+    throw;
+  }
+}
+
+QSharedPointer<RedisClient::Connection> RedisClient::ConnectionPool::lease() {
+  int index = dispatchIndex();
+  m_nodes[index].leases++;
+  return m_nodes[index].connection;
+}
+
+void RedisClient::ConnectionPool::release(
+    QSharedPointer<Connection> connection) {
+  for (PoolNode &node : m_nodes) {
+    if (node.connection == connection && node.leases > 0) {
+      node.leases--;
+      return;
+    }
+  }
+}
+
+int RedisClient::ConnectionPool::outstandingCommands(int index) const {
+  if (index < 0 || index >= m_nodes.size()) return 0;
+
+  return m_nodes.at(index).outstanding;
+}
+
+bool RedisClient::ConnectionPool::isHealthy(int index) const {
+  if (index < 0 || index >= m_nodes.size()) return false;
+
+  return m_nodes.at(index).healthy;
+}
+
+void RedisClient::ConnectionPool::setHealthCheckInterval(int ms) {
+  m_healthCheckTimer.stop();
+
+  if (ms <= 0) return;
+
+  m_healthCheckTimer.setInterval(ms);
+
+  if (isConnected()) m_healthCheckTimer.start();
+}
+
+bool RedisClient::ConnectionPool::isStatefulCommand(const Command &cmd) {
+  if (cmd.isPipelineCommand() || cmd.length() == 0) return false;
+
+  return (cmd.info().flags & STATEFUL_FLAGS) != 0 || cmd.isBlockingCommand();
+}
+
+bool RedisClient::ConnectionPool::OwnerPin::isReleased() const {
+  return state == 0 && blocking == 0 && channels.isEmpty() &&
+         patterns.isEmpty() && shardChannels.isEmpty();
+}
+
+int RedisClient::ConnectionPool::dispatchIndex() {
+  int size = m_nodes.size();
+  int start = m_nextIndex;
+  m_nextIndex = (m_nextIndex + 1) % size;
+
+  // Leased connections are never used, prefer healthy connections,
+  // then any connection (auto-reconnect)
+  for (int pass = 0; pass < 2; ++pass) {
+    int selected = -1;
+
+    for (int i = 0; i < size; ++i) {
+      int index = (start + i) % size;
+      const PoolNode &node = m_nodes.at(index);
+
+      if (node.leases > 0) continue;
+      if (pass < 1 && !node.healthy) continue;
+
+      if (m_dispatch == Dispatch::RoundRobin) return index;
+
+      if (selected == -1 ||
+          node.outstanding < m_nodes.at(selected).outstanding)
+        selected = index;
+    }
+
+    if (selected >= 0) return selected;
+  }
+
+  throw Connection::Exception("All pool connections are leased");
+}
+
+int RedisClient::ConnectionPool::connectionIndexFor(const Command &cmd) {
+  QObject *owner = cmd.getOwner();
+  bool pinned = owner && m_pinnedOwners.contains(owner);
+
+  if (!isStatefulCommand(cmd))
+    return pinned ? m_pinnedOwners[owner].index : dispatchIndex();
+
+  // State of shared connection would leak into commands of other callers
+  if (!owner)
+    throw Connection::Exception(
+        "Stateful command without owner, use lease() to run it");
+
+  if (!pinned) pinOwner(owner, dispatchIndex());
+
+  OwnerPin &pin = m_pinnedOwners[owner];
+  int index = pin.index;
+
+  // Commands which follow release are queued after it on the same
+  // connection, so connection can be returned to dispatching right away
+  updateState(pin, cmd);
+
+  if (pin.isReleased()) unpinOwner(owner);
+
+  return index;
+}
+
+void RedisClient::ConnectionPool::commandFinished(const Command &cmd) {
+  QObject *owner = cmd.getOwner();
+
+  if (!cmd.isBlockingCommand() || !owner || !m_pinnedOwners.contains(owner))
+    return;
+
+  OwnerPin &pin = m_pinnedOwners[owner];
+
+  if (pin.blocking > 0) pin.blocking--;
+
+  if (pin.isReleased()) unpinOwner(owner);
+}
+
+void RedisClient::ConnectionPool::pinOwner(QObject *owner, int index) {
+  OwnerPin pin;
+  pin.index = index;
+  pin.destroyed = QObject::connect(owner, &QObject::destroyed, this,
+                                   [this, owner]() { unpinOwner(owner); });
+
+  m_pinnedOwners.insert(owner, pin);
+  m_nodes[index].leases++;
+}
+
+void RedisClient::ConnectionPool::unpinOwner(QObject *owner) {
+  if (!m_pinnedOwners.contains(owner)) return;
+
+  OwnerPin pin = m_pinnedOwners.take(owner);
+  QObject::disconnect(pin.destroyed);
+
+  if (m_nodes[pin.index].leases > 0) m_nodes[pin.index].leases--;
+}
+
+void RedisClient::ConnectionPool::updateState(OwnerPin &pin,
+                                              const Command &cmd) {
+  const QList<QByteArray> &args = cmd.getSplitedRepresentattion();
+  const CommandInfo &info = cmd.info();
+
+  if (info.is(CommandInfo::Multi)) {
+    pin.state |= OwnerPin::Transaction;
+  } else if (info.is(CommandInfo::Exec)) {
+    pin.state &= ~(OwnerPin::Transaction | OwnerPin::Watch);
+  } else if (info.is(CommandInfo::Watch)) {
+    pin.state |= OwnerPin::Watch;
+  } else if (info.is(CommandInfo::Unwatch)) {
+    pin.state &= ~OwnerPin::Watch;
+  } else if (info.is(CommandInfo::Select)) {
+    // Transporter selects db 0 after reconnect
+    if (args.value(1) == "0")
+      pin.state &= ~OwnerPin::Select;
+    else
+      pin.state |= OwnerPin::Select;
+  } else if (info.is(CommandInfo::Monitor)) {
+    pin.state |= OwnerPin::Monitor;
+  } else if (info.is(CommandInfo::Subscribe) ||
+             info.is(CommandInfo::Unsubscribe)) {
+    QSet<QByteArray> &subscriptions =
+        info.is(CommandInfo::PatternChannel)
+            ? pin.patterns
+            : info.is(CommandInfo::ShardChannel) ? pin.shardChannels
+                                                 : pin.channels;
+
+    updateSubscriptions(subscriptions, args, info.is(CommandInfo::Subscribe));
+  } else if (cmd.isBlockingCommand()) {
+    pin.blocking++;
+  }
+}
+
+void RedisClient::ConnectionPool::trackOutstanding(
+    int index, const QFuture<Response> &result) {
+  m_nodes[index].outstanding++;
+
+  QPointer<ConnectionPool> self(this);
+
+  auto onFinished = [self, index]() {
+    if (!self || self->m_nodes[index].outstanding <= 0) return;
+
+    self->m_nodes[index].outstanding--;
+  };
+
+  AsyncFuture::observe(result).subscribe(
+      [onFinished](Response) { onFinished(); }, onFinished);
+}
+
+void RedisClient::ConnectionPool::checkHealth() {
+  QPointer<ConnectionPool> self(this);
+
+  for (int i = 0; i < m_nodes.size(); ++i) {
+    QSharedPointer<Connection> connection = m_nodes[i].connection;
+
+    if (!connection->isConnected()) {
+      setHealthy(i, false);
+
+      try {
+        connection->connect(false);
+      } catch (const Connection::Exception &e) {
+        emit error(QString("Cannot reconnect pool connection %1: %2")
+                       .arg(i)
+                       .arg(e.what()));
+      }
+      continue;
+    }
+
+    Command ping({"PING"});
+    ping.markAsHiPriorityCommand();
+
+    QFuture<Response> result;
+
+    try {
+      result = connection->runCommand(ping);
+    } catch (const Connection::Exception &) {
+      setHealthy(i, false);
+      continue;
+    }
+
+    AsyncFuture::observe(result).subscribe(
+        [self, i](Response r) {
+          if (self) self->setHealthy(i, !r.isErrorMessage());
+        },
+        [self, i]() {
+          if (self) self->setHealthy(i, false);
+        });
+  }
+}
+
+void RedisClient::ConnectionPool::setHealthy(int index, bool healthy) {
+  if (m_nodes[index].healthy == healthy) return;
+
+  m_nodes[index].healthy = healthy;
+
+  emit log(QString("Pool connection %1 is %2")
+               .arg(index)
+               .arg(healthy ? "healthy" : "unhealthy"));
+}
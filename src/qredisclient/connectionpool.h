@@ -0,0 +1,156 @@
+#pragma once
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVector>
+#include "command.h"
+#include "connection.h"
+#include "connectionconfig.h"
+#include "response.h"
+
+namespace RedisClient {
+
+/**
+ * @brief The ConnectionPool class
+ * Distributes commands across several connections with the same config.
+ * Each connection has own transporter thread and socket.
+ *
+ * Stateful commands (SELECT, MULTI/EXEC, WATCH, blocking pops, subscriptions)
+ * pin command owner to one connection so following commands of the same owner
+ * are executed on it. Pinned connection is excluded from dispatching until
+ * the state is released: EXEC/DISCARD, UNWATCH, SELECT 0, reply of blocking
+ * command, unsubscribe from all channels or destruction of owner.
+ * Stateful commands without owner are rejected, use lease() to run them.
+ *
+ * NOTE: Pool methods should be called from the thread where pool was created.
+ */
+class ConnectionPool : public QObject {
+  Q_OBJECT
+
+ public:
+  enum class Dispatch { RoundRobin, LeastOutstanding };
+
+  static const int DEFAULT_HEALTH_CHECK_INTERVAL_IN_MS = 5000;
+
+ public:
+  /**
+   * @brief ConnectionPool
+   * @param c - config shared by all connections
+   * @param size - number of connections, QThread::idealThreadCount() if <= 0
+   * @param dispatch - how commands are distributed between connections
+   */
+  ConnectionPool(const ConnectionConfig& c, int size = 0,
+                 Dispatch dispatch = Dispatch::LeastOutstanding);
+
+  ~ConnectionPool();
+
+  int size() const;
+  ConnectionConfig getConfig() const;
+  QSharedPointer<Connection> connectionAt(int index) const;
+
+  /**
+   * @brief Connect all connections of pool
+   * @param wait - true = sync mode, false = async mode
+   * @return true if at least one connection is established
+   */
+  bool connect(bool wait = true);
+  void disconnect();
+
+  /**
+   * @brief isConnected
+   * @return true if pool has at least one healthy connection
+   */
+  bool isConnected() const;
+
+  /*
+   * Command execution API
+   * @throws Connection::Exception if stateful command doesn't have owner
+   * or all connections are leased
+   */
+  QFuture<Response> runCommand(const Command& cmd);
+  QFuture<Response> command(QList<QByteArray> rawCmd, int db = -1);
+  QFuture<Response> command(QList<QByteArray> rawCmd, QObject* owner,
+                            RedisClient::Command::Callback callback,
+                            int db = -1);
+  Response commandSync(const Command& cmd);
+
+  /**
+   * @brief Reserve connection for exclusive use (e.g. MULTI/EXEC
+   * without owner). Leased connection is excluded from dispatching
+   * until release() is called.
+   */
+  QSharedPointer<Connection> lease();
+  void release(QSharedPointer<Connection> connection);
+
+  int outstandingCommands(int index) const;
+  bool isHealthy(int index) const;
+
+  /**
+   * @brief Interval of PING health checks, 0 disables checks
+   */
+  void setHealthCheckInterval(int ms);
+
+  /**
+   * @brief Check if command changes connection state or blocks it
+   */
+  static bool isStatefulCommand(const Command& cmd);
+
+ signals:
+  void error(const QString& err);
+  void log(const QString& msg);
+
+ protected:
+  struct OwnerPin;
+
+  int dispatchIndex();
+  int connectionIndexFor(const Command& cmd);
+  void commandFinished(const Command& cmd);
+  void pinOwner(QObject* owner, int index);
+  void unpinOwner(QObject* owner);
+  static void updateState(OwnerPin& pin, const Command& cmd);
+  void trackOutstanding(int index, const QFuture<Response>& result);
+  void checkHealth();
+  void setHealthy(int index, bool healthy);
+
+ protected:
+  struct PoolNode {
+    QSharedPointer<Connection> connection;
+    int outstanding;
+    int leases;
+    bool healthy;
+  };
+
+  // Connection state changed by commands of owner
+  struct OwnerPin {
+    enum State {
+      Transaction = 1,
+      Watch = 2,
+      Select = 4,
+      Monitor = 8,
+    };
+
+    OwnerPin() : index(-1), state(0), blocking(0) {}
+
+    bool isReleased() const;
+
+    int index;
+    int state;     // State flags
+    int blocking;  // blocking commands waiting for reply
+    QSet<QByteArray> channels;
+    QSet<QByteArray> patterns;
+    QSet<QByteArray> shardChannels;
+    QMetaObject::Connection destroyed;
+  };
+
+  QSharedPointer<const ConnectionSettings> m_settings;
+  Dispatch m_dispatch;
+  QVector<PoolNode> m_nodes;
+  QHash<QObject*, OwnerPin> m_pinnedOwners;
+  int m_nextIndex;
+  QTimer m_healthCheckTimer;
+};
+
+}  // namespace RedisClient
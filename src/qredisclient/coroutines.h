@@ -0,0 +1,246 @@
+#pragma once
+/*
+ * C++20 coroutine API.
+ * Header is available only if compiler supports coroutines, the rest of
+ * the library doesn't depend on it and is still built as C++11.
+ *
+ * Awaitables are resumed in the thread of context object by the same
+ * event that delivers command callbacks, no QFutureWatcher or
+ * intermediate futures are created. Without context object awaitables
+ * are resumed in the thread that awaits them, so this thread should
+ * run an event loop.
+ * Commands dropped on disconnect resume awaitables with an error.
+ * NOTE: Like callbacks, awaitables are not resumed if context object
+ * is destroyed.
+ *
+ * Usage:
+ *    Response r = co_await RedisClient::coro::exec(conn, {"GET", "foo"});
+ *
+ *    RedisClient::coro::ScanCursor cursor(conn, {"SCAN", "0"});
+ *    while (!cursor.atEnd()) {
+ *      QVariantList keys = co_await cursor.next();
+ *    }
+ */
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <QByteArray>
+#include <QList>
+#include <QVariantList>
+#include <QVector>
+#include <QObject>
+#include <coroutine>
+#include <memory>
+#include "command.h"
+#include "connection.h"
+#include "response.h"
+#include "scancommand.h"
+
+#define QREDISCLIENT_HAS_COROUTINES 1
+
+namespace RedisClient {
+namespace coro {
+
+/**
+ * Context object created in awaiting thread is owned by awaiter,
+ * so callbacks of destroyed awaiters are not called.
+ */
+inline QObject* callbackContext(QObject* context,
+                                std::unique_ptr<QObject>& ownContext) {
+  if (context) return context;
+
+  if (!ownContext) ownContext.reset(new QObject);
+
+  return ownContext.get();
+}
+
+/**
+ * @brief Awaitable command execution
+ * co_await returns Response (including error replies),
+ * transport errors are thrown as Connection::Exception
+ */
+class CommandAwaiter {
+ public:
+  CommandAwaiter(Connection& connection, const QList<QByteArray>& rawCmd,
+                 int db = -1, QObject* context = nullptr)
+      : m_connection(connection),
+        m_rawCmd(rawCmd),
+        m_db(db),
+        m_context(context) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    Command cmd(m_rawCmd, callbackContext(m_context, m_ownContext),
+                [this, handle](Response r, QString err) {
+                  m_result = r;
+                  m_error = err;
+                  handle.resume();
+                },
+                m_db);
+
+    m_connection.runCommand(cmd);
+  }
+
+  Response await_resume() {
+    if (!m_error.isEmpty()) throw Connection::Exception(m_error);
+
+    return m_result;
+  }
+
+ private:
+  Connection& m_connection;
+  QList<QByteArray> m_rawCmd;
+  int m_db;
+  QObject* m_context;
+  std::unique_ptr<QObject> m_ownContext;
+  Response m_result;
+  QString m_error;
+};
+
+/**
+ * @brief Awaitable non-transactional pipeline.
+ * co_await returns responses in order of commands.
+ */
+class PipelineAwaiter {
+ public:
+  PipelineAwaiter(Connection& connection,
+                  const QList<QList<QByteArray>>& rawCommands, int db = -1,
+                  QObject* context = nullptr)
+      : m_connection(connection),
+        m_rawCommands(rawCommands),
+        m_db(db),
+        m_context(context),
+        m_remaining(0) {}
+
+  bool await_ready() const noexcept { return m_rawCommands.isEmpty(); }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    m_results.resize(m_rawCommands.size());
+    m_remaining = m_rawCommands.size();
+
+    QList<Command> commands;
+    commands.reserve(m_rawCommands.size());
+    QObject* context = callbackContext(m_context, m_ownContext);
+
+    // Callbacks are called in context thread one by one
+    for (int i = 0; i < m_rawCommands.size(); ++i) {
+      commands.append(Command(m_rawCommands.at(i), context,
+                              [this, handle, i](Response r, QString err) {
+                                m_results[i] = r;
+                                if (m_error.isEmpty()) m_error = err;
+                                if (--m_remaining == 0) handle.resume();
+                              },
+                              m_db));
+    }
+
+    m_connection.runCommands(commands);
+  }
+
+  QVector<Response> await_resume() {
+    if (!m_error.isEmpty()) throw Connection::Exception(m_error);
+
+    return m_results;
+  }
+
+ private:
+  Connection& m_connection;
+  QList<QList<QByteArray>> m_rawCommands;
+  int m_db;
+  QObject* m_context;
+  std::unique_ptr<QObject> m_ownContext;
+  QVector<Response> m_results;
+  int m_remaining;
+  QString m_error;
+};
+
+inline CommandAwaiter exec(Connection& connection,
+                           const QList<QByteArray>& rawCmd, int db = -1,
+                           QObject* context = nullptr) {
+  return CommandAwaiter(connection, rawCmd, db, context);
+}
+
+inline PipelineAwaiter pipeline(Connection& connection,
+                                const QList<QList<QByteArray>>& rawCommands,
+                                int db = -1, QObject* context = nullptr) {
+  return PipelineAwaiter(connection, rawCommands, db, context);
+}
+
+/**
+ * @brief Async generator over SCAN-family cursor.
+ * Each co_await next() loads one page and returns its items.
+ */
+class ScanCursor {
+ public:
+  ScanCursor(Connection& connection, const QList<QByteArray>& rawCmd,
+             int db = -1, QObject* context = nullptr)
+      : m_connection(connection),
+        m_cmd(rawCmd, db),
+        m_context(context),
+        m_atEnd(!m_cmd.isValidScanCommand()) {}
+
+  bool atEnd() const { return m_atEnd; }
+
+  class PageAwaiter {
+   public:
+    explicit PageAwaiter(ScanCursor& cursor)
+        : m_cursor(cursor),
+          m_awaiter(cursor.m_connection,
+                    cursor.m_cmd.getSplitedRepresentattion(),
+                    cursor.m_cmd.getDbIndex(), cursor.m_context) {}
+
+    bool await_ready() const noexcept { return m_cursor.m_atEnd; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+      m_awaiter.await_suspend(handle);
+    }
+
+    QVariantList await_resume() {
+      if (m_cursor.m_atEnd) return QVariantList();
+
+      Response r;
+
+      try {
+        r = m_awaiter.await_resume();
+      } catch (...) {
+        m_cursor.m_atEnd = true;
+        throw;
+      }
+
+      if (r.isErrorMessage()) {
+        m_cursor.m_atEnd = true;
+        throw Connection::Exception(r.value().toString());
+      }
+
+      if (!r.isValidScanResponse()) {
+        m_cursor.m_atEnd = true;
+        return QVariantList();
+      }
+
+      long long cursor = r.getCursor();
+
+      if (cursor <= 0)
+        m_cursor.m_atEnd = true;
+      else
+        m_cursor.m_cmd.setCursor(cursor);
+
+      return r.getCollection();
+    }
+
+   private:
+    ScanCursor& m_cursor;
+    CommandAwaiter m_awaiter;
+  };
+
+  PageAwaiter next() { return PageAwaiter(*this); }
+
+ private:
+  Connection& m_connection;
+  ScanCommand m_cmd;
+  QObject* m_context;
+  bool m_atEnd;
+};
+
+}  // namespace coro
+}  // namespace RedisClient
+
+#endif
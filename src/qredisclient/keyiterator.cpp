@@ -0,0 +1,59 @@
+#include "keyiterator.h"
+#include "connection.h"
+
+RedisClient::KeyIterator::Options::Options()
+    : pattern("*"),
+      dbIndex(0),
+      prefetch(1),
+      targetPageLatency(50),
+      count(1000),
+      minCount(100),
+      maxCount(100000) {}
+
+RedisClient::KeyIterator::KeyIterator(Connection *connection,
+                                      const Options &options)
+    : m_connection(connection),
+      m_options(options),
+      m_iterator(connection, scanCommand(options), scanOptions(options)) {}
+
+void RedisClient::KeyIterator::next(PageCallback callback) {
+  if (!m_options.type.isEmpty() && m_connection &&
+      m_connection->getServerVersion() < 6.0) {
+    return callback(
+        Page(), QString("Cannot load keys: SCAN TYPE requires redis >= 6.0"),
+        true);
+  }
+
+  m_iterator.next(callback);
+}
+
+bool RedisClient::KeyIterator::hasNext() const { return m_iterator.hasNext(); }
+
+bool RedisClient::KeyIterator::isPending() const {
+  return m_iterator.isPending();
+}
+
+void RedisClient::KeyIterator::reset() { m_iterator.reset(); }
+
+uint RedisClient::KeyIterator::count() const { return m_iterator.count(); }
+
+RedisClient::ScanCommand RedisClient::KeyIterator::scanCommand(
+    const Options &options) {
+  QList<QByteArray> rawCmd{"SCAN",  "0",
+                           "MATCH", options.pattern,
+                           "COUNT", QByteArray::number(options.count)};
+
+  if (!options.type.isEmpty()) rawCmd << "TYPE" << options.type;
+
+  return ScanCommand(rawCmd, options.dbIndex);
+}
+
+RedisClient::ScanIterator::Options RedisClient::KeyIterator::scanOptions(
+    const Options &options) {
+  ScanIterator::Options result;
+  result.prefetch = options.prefetch;
+  result.targetPageLatency = options.targetPageLatency;
+  result.minCount = options.minCount;
+  result.maxCount = options.maxCount;
+  return result;
+}
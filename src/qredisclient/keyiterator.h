@@ -0,0 +1,73 @@
+#pragma once
+#include <QByteArray>
+#include <QList>
+#include <QPointer>
+#include <functional>
+#include "scaniterator.h"
+
+namespace RedisClient {
+
+class Connection;
+
+/**
+ * @brief The KeyIterator class
+ * Streams keys of a database page by page with SCAN.
+ * Only Options::prefetch pages are loaded ahead of consumer, so memory
+ * usage is bounded by a few pages. COUNT is adjusted after each page to keep
+ * SCAN latency close to Options::targetPageLatency.
+ * Copies of iterator share cursor.
+ */
+class KeyIterator {
+ public:
+  typedef ScanIterator::Exception Exception;
+  typedef ScanIterator::Page Page;
+  typedef ScanIterator::PageCallback PageCallback;
+
+  struct Options {
+    Options();
+
+    QByteArray pattern;
+    QByteArray type;  // SCAN ... TYPE, requires redis-server >= 6.0
+    int dbIndex;
+
+    uint prefetch;           // pages loaded ahead, 0 - load on demand only
+    uint targetPageLatency;  // in ms, 0 disables adaptive COUNT
+    uint count;              // initial COUNT
+    uint minCount;
+    uint maxCount;
+  };
+
+ public:
+  KeyIterator(Connection *connection, const Options &options = Options());
+
+  /**
+   * @brief Request next page. Only one page can be requested at a time.
+   * Callback is called in the thread of connection or immediately if
+   * page is already loaded.
+   */
+  void next(PageCallback callback);
+
+  bool hasNext() const;
+  bool isPending() const;
+
+  /**
+   * @brief Start iteration from the first page
+   */
+  void reset();
+
+  /**
+   * @brief COUNT which will be used for next page
+   */
+  uint count() const;
+
+ private:
+  static ScanCommand scanCommand(const Options &options);
+  static ScanIterator::Options scanOptions(const Options &options);
+
+ private:
+  QPointer<Connection> m_connection;
+  Options m_options;
+  ScanIterator m_iterator;
+};
+
+}  // namespace RedisClient
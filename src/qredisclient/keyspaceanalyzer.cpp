@@ -0,0 +1,345 @@
+#include "keyspaceanalyzer.h"
+#include <QElapsedTimer>
+#include <QPointer>
+#include <algorithm>
+#include <limits>
+#include "connection.h"
+#include "keyiterator.h"
+#include "namespacetree.h"
+
+namespace {
+enum ReplyField { TypeField, MemoryField, TtlField, FieldsCount };
+
+const qint64 TTL_BUCKET_LIMITS[] = {60 * 1000, 60 * 60 * 1000,
+                                    24 * 60 * 60 * 1000,
+                                    7 * 24 * 60 * 60 * 1000};
+
+// Min-heap by size, smallest of top keys is replaced first
+bool biggerKey(const RedisClient::KeyspaceAnalyzer::BigKey &a,
+               const RedisClient::KeyspaceAnalyzer::BigKey &b) {
+  return a.bytes > b.bytes;
+}
+
+void addStats(RedisClient::KeyspaceAnalyzer::Stats &stats, qint64 bytes) {
+  stats.keys++;
+  stats.bytes += bytes;
+}
+}  // namespace
+
+struct RedisClient::KeyspaceAnalyzer::State {
+  State(const Options &o)
+      : options(o),
+        tree(o.separator, o.pattern),
+        sampleThreshold(std::numeric_limits<uint>::max()) {
+    if (options.sampleRate < 1.0) {
+      sampleThreshold = static_cast<uint>(
+          qMax(0.0, options.sampleRate) * std::numeric_limits<uint>::max());
+    }
+
+    report.ttl.fill(0, TtlBucketsCount);
+  }
+
+  bool isSampled(const QByteArray &key) const {
+    return sampleThreshold == std::numeric_limits<uint>::max() ||
+           qHash(key) < sampleThreshold;
+  }
+
+  void addKey(const QByteArray &key, const QByteArray &type, qint64 bytes,
+              qint64 pttl);
+  Report currentReport() const;
+
+  Options options;
+  NamespaceTree tree;  // separator logic only, keys are not added
+  uint sampleThreshold;
+
+  Report report;
+  QVector<BigKey> bigKeys;  // heap
+  ProgressCallback progress;
+  QElapsedTimer lastProgress;
+};
+
+struct RedisClient::KeyspaceAnalyzer::NodeScan {
+  NodeScan(QSharedPointer<State> s, Connection *c,
+           const KeyIterator::Options &o)
+      : state(s),
+        connection(c),
+        iterator(c, o),
+        pending(0),
+        final(false),
+        finished(false) {}
+
+  QSharedPointer<State> state;
+  QPointer<Connection> connection;
+  KeyIterator iterator;
+  DoneCallback done;
+
+  // Sampled keys of current page
+  QList<QByteArray> keys;
+  QVector<QByteArray> types;
+  QVector<qint64> bytes;
+  QVector<qint64> ttls;
+  int pending;
+  bool final;
+  bool finished;
+
+  void finish(const QString &err) {
+    if (finished) return;
+
+    finished = true;
+    done(err);
+  }
+};
+
+void RedisClient::KeyspaceAnalyzer::State::addKey(const QByteArray &key,
+                                                  const QByteArray &type,
+                                                  qint64 bytes, qint64 pttl) {
+  bytes = qMax(Q_INT64_C(0), bytes);
+
+  report.sampledKeys++;
+  addStats(report.total, bytes);
+  addStats(report.types[type], bytes);
+  report.ttl[ttlBucket(pttl)]++;
+
+  QByteArray ns = tree.namespaceOf(key, options.namespaceDepth);
+  auto nsStats = report.namespaces.find(ns);
+
+  if (nsStats != report.namespaces.end())
+    addStats(*nsStats, bytes);
+  else if (static_cast<uint>(report.namespaces.size()) < options.maxNamespaces)
+    addStats(report.namespaces[ns], bytes);
+  else
+    addStats(report.otherNamespaces, bytes);
+
+  if (options.topKeys == 0) return;
+
+  if (static_cast<uint>(bigKeys.size()) == options.topKeys) {
+    if (bytes <= bigKeys.first().bytes) return;
+
+    std::pop_heap(bigKeys.begin(), bigKeys.end(), biggerKey);
+    bigKeys.removeLast();
+  }
+
+  BigKey bigKey;
+  bigKey.key = key;
+  bigKey.type = type;
+  bigKey.bytes = bytes;
+  bigKey.ttl = pttl;
+
+  bigKeys.append(bigKey);
+  std::push_heap(bigKeys.begin(), bigKeys.end(), biggerKey);
+}
+
+RedisClient::KeyspaceAnalyzer::Report
+RedisClient::KeyspaceAnalyzer::State::currentReport() const {
+  Report result = report;
+  result.bigKeys = bigKeys;
+  std::sort(result.bigKeys.begin(), result.bigKeys.end(), biggerKey);
+  return result;
+}
+
+RedisClient::KeyspaceAnalyzer::Options::Options()
+    : pattern("*"),
+      dbIndex(0),
+      separator(":"),
+      namespaceDepth(1),
+      sampleRate(1.0),
+      count(500),
+      memorySamples(5),
+      topKeys(100),
+      maxNamespaces(1000),
+      progressInterval(500) {}
+
+RedisClient::KeyspaceAnalyzer::Report::Report()
+    : scannedKeys(0), sampledKeys(0), missingKeys(0), errors(0) {}
+
+double RedisClient::KeyspaceAnalyzer::Report::scale() const {
+  return sampledKeys > 0 ? static_cast<double>(scannedKeys) / sampledKeys
+                         : 0.0;
+}
+
+RedisClient::KeyspaceAnalyzer::KeyspaceAnalyzer(const Options &options)
+    : m_state(new State(options)) {}
+
+void RedisClient::KeyspaceAnalyzer::analyze(Connection *connection,
+                                            DoneCallback done) {
+  KeyIterator::Options options;
+  options.pattern = m_state->options.pattern;
+  options.dbIndex = m_state->options.dbIndex;
+  options.maxCount = qMax(1u, m_state->options.count);
+  options.count = options.maxCount;
+  options.minCount = qMin(options.minCount, options.count);
+
+  QSharedPointer<NodeScan> scan(new NodeScan(m_state, connection, options));
+  scan->done = done;
+
+  if (!m_state->lastProgress.isValid()) m_state->lastProgress.start();
+
+  requestPage(scan);
+}
+
+void RedisClient::KeyspaceAnalyzer::setProgressCallback(
+    ProgressCallback callback) {
+  m_state->progress = callback;
+}
+
+void RedisClient::KeyspaceAnalyzer::addKey(const QByteArray &key,
+                                           const QByteArray &type,
+                                           qint64 bytes, qint64 pttl) {
+  m_state->addKey(key, type, bytes, pttl);
+}
+
+bool RedisClient::KeyspaceAnalyzer::isSampled(const QByteArray &key) const {
+  return m_state->isSampled(key);
+}
+
+RedisClient::KeyspaceAnalyzer::Report RedisClient::KeyspaceAnalyzer::report()
+    const {
+  return m_state->currentReport();
+}
+
+RedisClient::KeyspaceAnalyzer::TtlBucket
+RedisClient::KeyspaceAnalyzer::ttlBucket(qint64 pttl) {
+  if (pttl < 0) return NoTtl;
+
+  for (int i = 0; i < MoreThanWeek - LessThanMinute; ++i) {
+    if (pttl < TTL_BUCKET_LIMITS[i])
+      return static_cast<TtlBucket>(LessThanMinute + i);
+  }
+
+  return MoreThanWeek;
+}
+
+void RedisClient::KeyspaceAnalyzer::requestPage(
+    QSharedPointer<NodeScan> scan) {
+  if (!scan->connection)
+    return scan->finish(
+        QString("Cannot analyze keyspace: connection was removed"));
+
+  try {
+    scan->iterator.next([scan](const KeyIterator::Page &keys,
+                               const QString &err, bool final) {
+      processPage(scan, keys, err, final);
+    });
+  } catch (const Connection::Exception &e) {
+    scan->finish(QString("Cannot analyze keyspace: %1").arg(e.what()));
+  }
+}
+
+void RedisClient::KeyspaceAnalyzer::processPage(
+    QSharedPointer<NodeScan> scan, const QList<QByteArray> &keys,
+    const QString &err, bool final) {
+  if (!err.isEmpty()) return scan->finish(err);
+
+  scan->state->report.scannedKeys += keys.size();
+  scan->final = final;
+  scan->keys.clear();
+
+  for (const QByteArray &key : keys) {
+    if (scan->state->isSampled(key)) scan->keys.append(key);
+  }
+
+  if (scan->keys.isEmpty()) return processResults(scan);
+
+  if (!scan->connection)
+    return scan->finish(
+        QString("Cannot analyze keyspace: connection was removed"));
+
+  int size = scan->keys.size();
+  scan->types.fill(QByteArray(), size);
+  scan->bytes.fill(0, size);
+  scan->ttls.fill(-1, size);
+  scan->pending = size * FieldsCount;
+
+  const Options &options = scan->state->options;
+  QByteArray samples = QByteArray::number(options.memorySamples);
+  QList<Command> commands;
+  commands.reserve(scan->pending);
+
+  auto replyCommand = [scan, &options](const QList<QByteArray> &args, int i,
+                                       int field) -> Command {
+    Command cmd(args, options.dbIndex);
+    cmd.setCallBack(scan->connection.data(),
+                    [scan, i, field](Response r, QString err) {
+                      processReply(scan, i, field, r, err);
+                    });
+    return cmd;
+  };
+
+  for (int i = 0; i < size; ++i) {
+    const QByteArray &key = scan->keys.at(i);
+
+    commands.append(replyCommand({"TYPE", key}, i, TypeField));
+    commands.append(replyCommand(
+        {"MEMORY", "USAGE", key, "SAMPLES", samples}, i, MemoryField));
+    commands.append(replyCommand({"PTTL", key}, i, TtlField));
+  }
+
+  try {
+    scan->connection->runCommands(commands);
+  } catch (const Connection::Exception &e) {
+    scan->finish(QString("Cannot analyze keyspace: %1").arg(e.what()));
+  }
+}
+
+void RedisClient::KeyspaceAnalyzer::processReply(QSharedPointer<NodeScan> scan,
+                                                 int index, int field,
+                                                 const Response &r,
+                                                 const QString &err) {
+  if (scan->finished) return;
+
+  Report &report = scan->state->report;
+
+  // MEMORY USAGE is not available before redis-server 4.0
+  if (!err.isEmpty() || r.isErrorMessage()) {
+    report.errors++;
+    report.lastError = err.isEmpty() ? QString::fromUtf8(r.asBytes()) : err;
+  } else if (field == TypeField) {
+    scan->types[index] = r.view().toByteArray();
+  } else if (field == MemoryField) {
+    scan->bytes[index] = r.view().toInteger();
+  } else {
+    scan->ttls[index] = r.view().toInteger();
+  }
+
+  if (--scan->pending == 0) processResults(scan);
+}
+
+void RedisClient::KeyspaceAnalyzer::processResults(
+    QSharedPointer<NodeScan> scan) {
+  for (int i = 0; i < scan->types.size(); ++i) {
+    const QByteArray &type = scan->types.at(i);
+
+    if (type.isEmpty()) continue;
+
+    // Key was removed after SCAN
+    if (type == "none" || scan->ttls.at(i) == -2) {
+      scan->state->report.missingKeys++;
+      continue;
+    }
+
+    scan->state->addKey(scan->keys.at(i), type, scan->bytes.at(i),
+                        scan->ttls.at(i));
+  }
+
+  scan->keys.clear();
+  scan->types.clear();
+  scan->bytes.clear();
+  scan->ttls.clear();
+
+  if (scan->final) return scan->finish(QString());
+
+  reportProgress(scan->state, false);
+  requestPage(scan);
+}
+
+void RedisClient::KeyspaceAnalyzer::reportProgress(QSharedPointer<State> state,
+                                                   bool force) {
+  if (!state->progress) return;
+
+  if (!force && state->lastProgress.isValid() &&
+      state->lastProgress.elapsed() < state->options.progressInterval)
+    return;
+
+  state->lastProgress.start();
+  state->progress(state->currentReport());
+}
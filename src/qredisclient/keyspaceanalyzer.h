@@ -0,0 +1,145 @@
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+namespace RedisClient {
+
+class Connection;
+class Response;
+
+/**
+ * @brief The KeyspaceAnalyzer class
+ * Collects memory, type and TTL statistics of a keyspace. Keys are
+ * streamed with SCAN, TYPE, MEMORY USAGE and PTTL of sampled keys are
+ * pipelined page by page. Results are aggregated in bounded containers:
+ * Options::maxNamespaces namespaces, Options::topKeys biggest keys and
+ * fixed TTL buckets, so memory usage doesn't depend on keyspace size.
+ *
+ * analyze() can run on several nodes at the same time (e.g. cluster
+ * masters), results of all nodes are merged. Copies of analyzer share
+ * results.
+ */
+class KeyspaceAnalyzer {
+ public:
+  struct Options {
+    Options();
+
+    QByteArray pattern;
+    int dbIndex;
+    QByteArray separator;   // empty separator disables namespaces
+    int namespaceDepth;     // namespace levels below the root level
+    double sampleRate;      // share of scanned keys analyzed, (0, 1]
+    uint count;             // SCAN COUNT, sampled keys of page are pipelined
+    uint memorySamples;     // MEMORY USAGE ... SAMPLES, 0 - whole value
+    uint topKeys;
+    uint maxNamespaces;     // other namespaces are merged into one bucket
+    uint progressInterval;  // in ms
+  };
+
+  enum TtlBucket {
+    NoTtl,
+    LessThanMinute,
+    LessThanHour,
+    LessThanDay,
+    LessThanWeek,
+    MoreThanWeek,
+    TtlBucketsCount
+  };
+
+  struct Stats {
+    Stats() : keys(0), bytes(0) {}
+
+    quint64 keys;
+    qint64 bytes;
+  };
+
+  struct BigKey {
+    BigKey() : bytes(0), ttl(-1) {}
+
+    QByteArray key;
+    QByteArray type;
+    qint64 bytes;
+    qint64 ttl;  // in ms, -1 - no TTL
+  };
+
+  /**
+   * @brief Statistics of sampled keys. Use scale() to estimate values
+   * of the whole keyspace.
+   */
+  struct Report {
+    Report();
+
+    quint64 scannedKeys;
+    quint64 sampledKeys;
+    quint64 missingKeys;  // removed after SCAN
+    quint64 errors;
+    QString lastError;
+
+    Stats total;
+    QHash<QByteArray, Stats> types;
+    QHash<QByteArray, Stats> namespaces;  // "" - keys without namespace
+    Stats otherNamespaces;                // over Options::maxNamespaces
+    QVector<BigKey> bigKeys;              // sorted by size, biggest first
+    QVector<quint64> ttl;                 // keys in each TtlBucket
+
+    /**
+     * @brief Ratio of scanned and sampled keys
+     */
+    double scale() const;
+  };
+
+  typedef std::function<void(const Report &report)> ProgressCallback;
+  typedef std::function<void(const QString &err)> DoneCallback;
+
+ public:
+  KeyspaceAnalyzer(const Options &options = Options());
+
+  /**
+   * @brief Scan keyspace of connection, results are added to report()
+   * @param done - called once all keys are processed or on first error
+   */
+  void analyze(Connection *connection, DoneCallback done);
+
+  /**
+   * @brief Called with current report while keys are analyzed,
+   * at most once per Options::progressInterval
+   */
+  void setProgressCallback(ProgressCallback callback);
+
+  /**
+   * @brief Add analyzed key to report
+   */
+  void addKey(const QByteArray &key, const QByteArray &type, qint64 bytes,
+              qint64 pttl);
+
+  /**
+   * @brief Sampling is deterministic, so results of repeated runs
+   * can be compared
+   */
+  bool isSampled(const QByteArray &key) const;
+
+  Report report() const;
+
+  static TtlBucket ttlBucket(qint64 pttl);
+
+ private:
+  struct State;
+  struct NodeScan;
+  static void requestPage(QSharedPointer<NodeScan> scan);
+  static void processPage(QSharedPointer<NodeScan> scan,
+                          const QList<QByteArray> &keys, const QString &err,
+                          bool final);
+  static void processReply(QSharedPointer<NodeScan> scan, int index,
+                           int field, const Response &r, const QString &err);
+  static void processResults(QSharedPointer<NodeScan> scan);
+  static void reportProgress(QSharedPointer<State> state, bool force);
+
+ private:
+  QSharedPointer<State> m_state;
+};
+
+}  // namespace RedisClient
@@ -0,0 +1,154 @@
+#include "namespacetree.h"
+#include <algorithm>
+#include <cstring>
+
+RedisClient::NamespaceTree::NamespaceTree(const QByteArray &separator,
+                                          const QByteArray &filter)
+    : m_separator(separator),
+      m_separatorMatcher(separator),
+      m_rootPartIndex(0),
+      m_keysCount(0) {
+  int lastSeparator = separator.isEmpty() ? -1 : filter.lastIndexOf(separator);
+
+  if (lastSeparator >= 0) m_rootPartIndex = lastSeparator + separator.size();
+
+  clear();
+}
+
+void RedisClient::NamespaceTree::addKey(const QByteArray &key) {
+  m_keysCount++;
+
+  const char *data = key.constData();
+  int pos = qMin(m_rootPartIndex, key.size());
+  int node = 0;
+  int separator = indexOfSeparator(key, pos);
+
+  if (separator < 0) {
+    m_rootKeys.append(key);
+    return;
+  }
+
+  while (separator >= 0) {
+    // Lookup doesn't copy segment bytes
+    QByteArray segment = QByteArray::fromRawData(data + pos, separator - pos);
+    auto child = m_nodes.at(node).children.constFind(segment);
+    int childIndex;
+
+    if (child == m_nodes.at(node).children.constEnd()) {
+      childIndex = m_nodes.size();
+
+      Node n;
+      n.fullName = key.left(separator);
+      m_nodes.append(n);
+      m_nodes[node].children.insert(QByteArray(data + pos, separator - pos),
+                                    childIndex);
+    } else {
+      childIndex = child.value();
+    }
+
+    m_nodes[childIndex].keys++;
+
+    node = childIndex;
+    pos = separator + m_separator.size();
+    separator = indexOfSeparator(key, pos);
+  }
+}
+
+void RedisClient::NamespaceTree::addKeys(const QList<QByteArray> &keys) {
+  for (const QByteArray &key : keys) addKey(key);
+}
+
+void RedisClient::NamespaceTree::clear() {
+  m_nodes.clear();
+  m_nodes.append(Node());
+  m_rootKeys.clear();
+  m_keysCount = 0;
+}
+
+RedisClient::NamespaceTree::Items RedisClient::NamespaceTree::rootItems()
+    const {
+  Keys keys = m_rootKeys;
+  std::sort(keys.begin(), keys.end());
+
+  return Items(namespacesOf(m_nodes.first()), keys);
+}
+
+RedisClient::NamespaceTree::Namespaces
+RedisClient::NamespaceTree::childNamespaces(const QByteArray &ns) const {
+  int node = findNode(ns);
+
+  if (node < 0) return Namespaces();
+
+  return namespacesOf(m_nodes.at(node));
+}
+
+ulong RedisClient::NamespaceTree::keysCount() const { return m_keysCount; }
+
+QByteArray RedisClient::NamespaceTree::namespaceOf(const QByteArray &key,
+                                                   int depth) const {
+  int pos = qMin(m_rootPartIndex, key.size());
+  int end = -1;
+
+  for (int level = 0; level < depth; ++level) {
+    int separator = indexOfSeparator(key, pos);
+
+    if (separator < 0) break;
+
+    end = separator;
+    pos = separator + m_separator.size();
+  }
+
+  return end < 0 ? QByteArray() : key.left(end);
+}
+
+int RedisClient::NamespaceTree::indexOfSeparator(const QByteArray &data,
+                                                 int from) const {
+  if (m_separator.isEmpty() || from >= data.size()) return -1;
+
+  if (m_separator.size() == 1) {
+    const char *found = static_cast<const char *>(
+        memchr(data.constData() + from, m_separator.at(0), data.size() - from));
+
+    return found ? static_cast<int>(found - data.constData()) : -1;
+  }
+
+  return m_separatorMatcher.indexIn(data, from);
+}
+
+int RedisClient::NamespaceTree::findNode(const QByteArray &ns) const {
+  int pos = qMin(m_rootPartIndex, ns.size());
+  int node = 0;
+
+  while (true) {
+    int separator = indexOfSeparator(ns, pos);
+    int end = separator < 0 ? ns.size() : separator;
+
+    auto child = m_nodes.at(node).children.constFind(
+        QByteArray::fromRawData(ns.constData() + pos, end - pos));
+
+    if (child == m_nodes.at(node).children.constEnd()) return -1;
+
+    if (separator < 0) return child.value();
+
+    node = child.value();
+    pos = separator + m_separator.size();
+  }
+}
+
+RedisClient::NamespaceTree::Namespaces
+RedisClient::NamespaceTree::namespacesOf(const Node &node) const {
+  Namespaces result;
+  result.reserve(node.children.size());
+
+  for (auto it = node.children.constBegin(); it != node.children.constEnd();
+       ++it) {
+    const Node &child = m_nodes.at(it.value());
+    result.append(qMakePair(child.fullName, child.keys));
+  }
+
+  std::sort(result.begin(), result.end(),
+            [](const QPair<QByteArray, ulong> &a,
+               const QPair<QByteArray, ulong> &b) { return a.first < b.first; });
+
+  return result;
+}
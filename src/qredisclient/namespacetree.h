@@ -0,0 +1,80 @@
+#pragma once
+#include <QByteArray>
+#include <QByteArrayMatcher>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVector>
+
+namespace RedisClient {
+
+/**
+ * @brief The NamespaceTree class
+ * Prefix trie of key namespaces with number of keys in each namespace.
+ * Keys are added page by page while SCAN is running, so partial results
+ * are available at any moment. Only keys without namespace on the root
+ * level are stored.
+ */
+class NamespaceTree {
+ public:
+  typedef QList<QPair<QByteArray, ulong>> Namespaces;
+  typedef QList<QByteArray> Keys;
+  typedef QPair<Namespaces, Keys> Items;
+
+ public:
+  /**
+   * @brief NamespaceTree
+   * @param separator - namespace separator, e.g. ":"
+   * @param filter - SCAN filter. Root level starts after last separator
+   * in filter.
+   */
+  NamespaceTree(const QByteArray& separator,
+                const QByteArray& filter = QByteArray("*"));
+
+  void addKey(const QByteArray& key);
+  void addKeys(const QList<QByteArray>& keys);
+  void clear();
+
+  /**
+   * @brief Namespaces and keys of the root level sorted by name
+   */
+  Items rootItems() const;
+
+  /**
+   * @brief Nested namespaces of the namespace sorted by name
+   * @param ns - full namespace name, e.g. "user:1"
+   */
+  Namespaces childNamespaces(const QByteArray& ns) const;
+
+  ulong keysCount() const;
+
+  /**
+   * @brief Namespace of key limited to depth levels below the root level,
+   * e.g. "user:1" for "user:1:name" and depth 2. Tree is not modified.
+   * @return empty array if key has no namespace
+   */
+  QByteArray namespaceOf(const QByteArray& key, int depth = 1) const;
+
+ private:
+  struct Node {
+    Node() : keys(0) {}
+
+    ulong keys;
+    QByteArray fullName;
+    QHash<QByteArray, int> children;  // segment -> index in m_nodes
+  };
+
+  int indexOfSeparator(const QByteArray& data, int from) const;
+  int findNode(const QByteArray& ns) const;
+  Namespaces namespacesOf(const Node& node) const;
+
+ private:
+  QByteArray m_separator;
+  QByteArrayMatcher m_separatorMatcher;
+  int m_rootPartIndex;
+  QVector<Node> m_nodes;  // root node at index 0
+  Keys m_rootKeys;
+  ulong m_keysCount;
+};
+
+}  // namespace RedisClient
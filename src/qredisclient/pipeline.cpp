@@ -0,0 +1,55 @@
+#include "pipeline.h"
+#include "connection.h"
+
+namespace {
+struct PipelineState {
+  QVector<RedisClient::Response> responses;
+  int remaining;
+  AsyncFuture::Deferred<QVector<RedisClient::Response>> deferred;
+};
+}  // namespace
+
+RedisClient::Pipeline::Pipeline(RedisClient::Connection* connection)
+    : m_connection(connection) {}
+
+RedisClient::Pipeline& RedisClient::Pipeline::add(const QList<QByteArray>& cmd,
+                                                  int db) {
+  m_commands.append(Command(cmd, db));
+  return *this;
+}
+
+int RedisClient::Pipeline::size() const { return m_commands.size(); }
+
+bool RedisClient::Pipeline::isEmpty() const { return m_commands.isEmpty(); }
+
+QFuture<QVector<RedisClient::Response>> RedisClient::Pipeline::exec() {
+  QSharedPointer<PipelineState> state(new PipelineState());
+  state->remaining = m_commands.size();
+  state->responses.resize(m_commands.size());
+
+  if (m_commands.isEmpty()) {
+    state->deferred.complete(state->responses);
+    return state->deferred.future();
+  }
+
+  QList<Command> commands;
+  commands.reserve(m_commands.size());
+
+  for (int i = 0; i < m_commands.size(); ++i) {
+    Command cmd = m_commands.at(i);
+
+    // Callbacks are delivered in connection thread one by one
+    cmd.setCallBack(m_connection, [state, i](Response r, QString err) {
+      state->responses[i] =
+          err.isEmpty() ? r : Response(Response::Error, err.toUtf8());
+
+      if (--state->remaining == 0) state->deferred.complete(state->responses);
+    });
+
+    commands.append(cmd);
+  }
+
+  m_connection->runCommands(commands);
+
+  return state->deferred.future();
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <asyncfuture.h>
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include "command.h"
+#include "response.h"
+
+namespace RedisClient {
+
+class Connection;
+
+/**
+ * @brief The Pipeline class
+ * Builder for non-transactional pipelines. All commands are passed to the
+ * transporter at once, written to the socket in one batch without
+ * MULTI/EXEC and responses are returned in the same order.
+ *
+ * Use Command::addToPipeline() if you need MULTI/EXEC transaction.
+ */
+class Pipeline {
+ public:
+  /**
+   * @brief Constructs empty pipeline
+   * @param connection
+   */
+  Pipeline(Connection* connection);
+
+  /**
+   * @brief Add command to pipeline
+   * @param cmd - Command parts
+   * @param db - Database index where this command should be executed.
+   * Commands with different db indexes may be sent out of order
+   * to minimize the number of SELECT commands.
+   * @return Reference to current object
+   */
+  Pipeline& add(const QList<QByteArray>& cmd, int db = -1);
+
+  /**
+   * @brief Number of commands in pipeline
+   * @return
+   */
+  int size() const;
+
+  bool isEmpty() const;
+
+  /**
+   * @brief Send all commands to redis-server.
+   * Errors don't interrupt pipeline execution, failed commands are
+   * represented by error responses.
+   * @return Future with responses in order of added commands
+   */
+  QFuture<QVector<Response>> exec();
+
+ private:
+  Connection* m_connection;
+  QList<Command> m_commands;
+};
+
+}  // namespace RedisClient
@@ -0,0 +1,69 @@
+#pragma once
+#include <QByteArray>
+#include <QtEndian>
+#include <cstring>
+
+namespace RedisClient {
+
+/*
+ * Binary file written by BulkExport and read by BulkImport:
+ * header (DUMP_FILE_MAGIC) followed by records
+ * [u32 key size][key][i64 pttl][u32 value size][DUMP payload],
+ * integers are little-endian. pttl is 0 for keys without TTL.
+ */
+namespace DumpFile {
+
+const char MAGIC[] = "QRDUMP\x01\n";
+const int MAGIC_SIZE = 8;
+const int RECORD_HEADER_SIZE = 4 + 8 + 4;
+
+inline bool hasMagic(const QByteArray& data) {
+  return data.size() >= MAGIC_SIZE &&
+         memcmp(data.constData(), MAGIC, MAGIC_SIZE) == 0;
+}
+
+inline void appendRecord(QByteArray& out, const QByteArray& key, qint64 pttl,
+                         const QByteArray& dump) {
+  int pos = out.size();
+  out.resize(pos + RECORD_HEADER_SIZE + key.size() + dump.size());
+
+  uchar* data = reinterpret_cast<uchar*>(out.data()) + pos;
+
+  qToLittleEndian<quint32>(key.size(), data);
+  memcpy(data + 4, key.constData(), key.size());
+  data += 4 + key.size();
+
+  qToLittleEndian<qint64>(pttl, data);
+  qToLittleEndian<quint32>(dump.size(), data + 8);
+  memcpy(data + 12, dump.constData(), dump.size());
+}
+
+/*
+ * Returns size of parsed record, 0 if buffer doesn't contain the whole
+ * record yet.
+ */
+inline int readRecord(const QByteArray& buffer, int pos, QByteArray& key,
+                      qint64& pttl, QByteArray& dump) {
+  const uchar* data = reinterpret_cast<const uchar*>(buffer.constData()) + pos;
+  qint64 available = buffer.size() - pos;
+
+  if (available < RECORD_HEADER_SIZE) return 0;
+
+  qint64 keySize = qFromLittleEndian<quint32>(data);
+
+  if (available < RECORD_HEADER_SIZE + keySize) return 0;
+
+  qint64 dumpSize = qFromLittleEndian<quint32>(data + 4 + keySize + 8);
+  qint64 size = RECORD_HEADER_SIZE + keySize + dumpSize;
+
+  if (available < size) return 0;
+
+  key = buffer.mid(pos + 4, keySize);
+  pttl = qFromLittleEndian<qint64>(data + 4 + keySize);
+  dump = buffer.mid(pos + RECORD_HEADER_SIZE + keySize, dumpSize);
+
+  return static_cast<int>(size);
+}
+
+}  // namespace DumpFile
+}  // namespace RedisClient
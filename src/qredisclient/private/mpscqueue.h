@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+namespace RedisClient {
+
+/**
+ * @brief The MpscQueue class
+ * Unbounded lock-free multi-producer/single-consumer queue
+ * (intrusive linked list by D. Vyukov).
+ * push() can be called from any thread, pop() only from consumer thread.
+ * THIS IS IMPLEMENTATION CLASS AND SHOULDN'T BE USED DIRECTLY.
+ */
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : m_head(new Node()), m_tail(m_head.load()) {}
+
+  ~MpscQueue() {
+    T value;
+    while (pop(value)) {
+    }
+    delete m_tail;
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  /**
+   * @brief Wait-free push, safe to call from any thread
+   */
+  void push(T&& value) { enqueue(new Node(std::move(value))); }
+  void push(const T& value) { enqueue(new Node(value)); }
+
+  /**
+   * @brief Pop value in consumer thread
+   * @return false if queue is empty or producer didn't finish push() yet
+   */
+  bool pop(T& value) {
+    Node* tail = m_tail;
+    Node* next = tail->next.load(std::memory_order_acquire);
+
+    if (!next) return false;
+
+    value = std::move(next->value);
+    m_tail = next;
+    delete tail;
+    return true;
+  }
+
+  /**
+   * @brief Check if queue has pushed values, including values which are not
+   * visible to pop() yet. Should be called only from consumer thread.
+   */
+  bool isEmpty() const {
+    return m_head.load(std::memory_order_acquire) == m_tail;
+  }
+
+ private:
+  struct Node {
+    Node() : next(nullptr) {}
+    explicit Node(T&& v) : next(nullptr), value(std::move(v)) {}
+    explicit Node(const T& v) : next(nullptr), value(v) {}
+
+    std::atomic<Node*> next;
+    T value;
+  };
+
+  void enqueue(Node* node) {
+    Node* prev = m_head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+ private:
+  std::atomic<Node*> m_head;  // last pushed node
+  Node* m_tail;               // stub node, touched only by consumer
+};
+
+}  // namespace RedisClient
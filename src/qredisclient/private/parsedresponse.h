@@ -1,24 +1,31 @@
 #pragma once
-#include <QMetaType>
-#include <QVariant>
-#include <QVector>
+#include <cstddef>
 #include "qredisclient/response.h"
 
 namespace RedisClient {
-struct ParsingResult;
 
+/**
+ * @brief The ParsingResult struct
+ * Reply node allocated in ParsingArena by hiredis callbacks.
+ * Nodes are trivially destructible and released together with arena.
+ * THIS IS IMPLEMENTATION CLASS AND SHOULDN'T BE USED DIRECTLY.
+ */
 struct ParsingResult {
-  ParsingResult(int t, QVariant v) : type(t), val(v) {}
+  ParsingResult(int t)
+      : type(t), integer(0), str(nullptr), len(0), array(nullptr),
+        elements(0) {}
 
-  ParsingResult(int s) : type(2) { array.resize(s); }
-
-  Response toResponse();
+  /**
+   * @brief Flatten node tree into compact ReplyData
+   */
+  Response toResponse() const;
 
   int type;
-  QVariant val;
-  QVector<ParsingResult *> array;
+  long long integer;  // integers and booleans
+  const char *str;
+  size_t len;
+  ParsingResult **array;
+  int elements;
 };
 
 }  // namespace RedisClient
-
-Q_DECLARE_METATYPE(QVector<RedisClient::ParsingResult *>)
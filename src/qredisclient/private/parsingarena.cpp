@@ -0,0 +1,67 @@
+#include "parsingarena.h"
+#include <cstring>
+
+RedisClient::ParsingArena::ParsingArena(size_t blockSize)
+    : m_blockSize(blockSize), m_offset(0), m_blocksAllocated(0) {}
+
+RedisClient::ParsingArena::~ParsingArena() {
+  for (const Block &b : m_blocks) delete[] b.data;
+}
+
+void *RedisClient::ParsingArena::allocate(size_t size, size_t align) {
+  if (!m_blocks.isEmpty()) {
+    const Block &current = m_blocks.last();
+    size_t aligned = (m_offset + align - 1) & ~(align - 1);
+
+    if (aligned + size <= current.size) {
+      m_offset = aligned + size;
+      return current.data + aligned;
+    }
+  }
+
+  addBlock(size + align);
+
+  size_t aligned =
+      (reinterpret_cast<size_t>(m_blocks.last().data) + align - 1) &
+      ~(align - 1);
+  m_offset = aligned - reinterpret_cast<size_t>(m_blocks.last().data) + size;
+  return reinterpret_cast<void *>(aligned);
+}
+
+char *RedisClient::ParsingArena::copyString(const char *str, size_t len) {
+  // Non-null pointer keeps empty bulk strings distinguishable from nil
+  static char empty[1] = {'\0'};
+  if (len == 0) return empty;
+
+  char *result = static_cast<char *>(allocate(len, 1));
+  memcpy(result, str, len);
+  return result;
+}
+
+void RedisClient::ParsingArena::reset() {
+  m_offset = 0;
+
+  if (m_blocks.size() <= 1) return;
+
+  // Keep only first block to avoid holding memory after huge replies
+  for (int i = 1; i < m_blocks.size(); ++i) delete[] m_blocks[i].data;
+
+  m_blocks.resize(1);
+
+  if (m_blocks.first().size > m_blockSize) {
+    delete[] m_blocks.first().data;
+    m_blocks.clear();
+  }
+}
+
+uint RedisClient::ParsingArena::blocksAllocated() const {
+  return m_blocksAllocated;
+}
+
+void RedisClient::ParsingArena::addBlock(size_t minSize) {
+  Block b;
+  b.size = qMax(minSize, m_blockSize);
+  b.data = new char[b.size];
+  m_blocks.append(b);
+  m_blocksAllocated++;
+}
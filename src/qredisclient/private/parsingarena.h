@@ -0,0 +1,62 @@
+#pragma once
+#include <QVector>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace RedisClient {
+
+/**
+ * @brief The ParsingArena class
+ * Bump allocator for reply nodes created by hiredis callbacks.
+ * All memory allocated from arena is released at once by reset().
+ * THIS IS IMPLEMENTATION CLASS AND SHOULDN'T BE USED DIRECTLY.
+ */
+class ParsingArena {
+ public:
+  static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+  explicit ParsingArena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+  ~ParsingArena();
+
+  void *allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+  char *copyString(const char *str, size_t len);
+
+  /**
+   * @brief Construct trivially destructible object in arena
+   */
+  template <typename T, typename... Args>
+  T *create(Args &&... args) {
+    return new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Release all allocated objects.
+   * First block is kept for next parsing cycle.
+   */
+  void reset();
+
+  /**
+   * @brief Number of heap allocations made by arena since creation
+   */
+  uint blocksAllocated() const;
+
+ private:
+  Q_DISABLE_COPY(ParsingArena)
+
+  struct Block {
+    char *data;
+    size_t size;
+  };
+
+  void addBlock(size_t minSize);
+
+  QVector<Block> m_blocks;
+  size_t m_blockSize;
+  size_t m_offset;
+  uint m_blocksAllocated;
+};
+
+}  // namespace RedisClient
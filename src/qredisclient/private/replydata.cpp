@@ -0,0 +1,197 @@
+#include "replydata.h"
+#include <QMutexLocker>
+#include <cstring>
+#include "parsedresponse.h"
+#include "qredisclient/response.h"
+
+QVariant RedisClient::ReplyData::variant() const {
+  if (m_cached.loadAcquire()) return m_cache;
+
+  QMutexLocker lock(&m_cacheLock);
+
+  if (!m_cached.load()) {
+    m_cache = nodes.isEmpty() ? QVariant() : toVariant(0);
+    m_cached.storeRelease(1);
+  }
+
+  return m_cache;
+}
+
+QVariant RedisClient::ReplyData::toVariant(int index) const {
+  if (index < 0 || index >= nodes.size()) return QVariant();
+
+  const ReplyNode &node = nodes.at(index);
+
+  if (isAggregate(node.type)) {
+    QVariantList result;
+    result.reserve(node.size);
+
+    for (int i = 0; i < node.size; ++i) {
+      int child = children.at(static_cast<int>(node.value) + i);
+
+      // Empty nested arrays are represented as null values
+      if (child >= 0 && nodes.at(child).type == Response::Array &&
+          nodes.at(child).size == 0) {
+        result.append(QVariant());
+      } else {
+        result.append(toVariant(child));
+      }
+    }
+    return QVariant(result);
+  }
+
+  switch (node.type) {
+    case Response::Integer:
+      return QVariant(static_cast<long long>(node.value));
+    case Response::Boolean:
+      return QVariant(node.value != 0);
+    case Response::Double:
+      return QVariant(
+          QByteArray::fromRawData(payload.constData() + node.value, node.size)
+              .toDouble());
+    case Response::Nil:
+      return QVariant();
+    default:
+      return QVariant(QByteArray(payload.constData() + node.value, node.size));
+  }
+}
+
+QSharedPointer<RedisClient::ReplyData>
+RedisClient::ReplyData::fromParsingResult(const ParsingResult *r) {
+  QSharedPointer<ReplyData> data(new ReplyData());
+
+  int nodesCount = 0, childrenCount = 0, payloadSize = 0;
+  data->count(r, nodesCount, childrenCount, payloadSize);
+
+  data->nodes.reserve(nodesCount);
+  data->children.reserve(childrenCount);
+  data->payload.reserve(payloadSize);
+
+  data->append(r);
+  return data;
+}
+
+QSharedPointer<RedisClient::ReplyData> RedisClient::ReplyData::fromVariant(
+    int type, const QVariant &v) {
+  QSharedPointer<ReplyData> data(new ReplyData());
+  data->append(type, v);
+
+  // Keep original value to return it as is
+  data->m_cache = v;
+  data->m_cached.storeRelease(1);
+  return data;
+}
+
+bool RedisClient::ReplyData::isAggregate(int type) {
+  return type == Response::Array || type == Response::Set ||
+         type == Response::Map || type == Response::Push ||
+         type == Response::Attribute;
+}
+
+int RedisClient::ReplyData::allocations() const {
+  // ReplyData object and control block of shared pointer
+  int result = 2;
+
+  if (payload.capacity() > 0) result++;
+  if (nodes.capacity() > 0) result++;
+  if (children.capacity() > 0) result++;
+
+  return result;
+}
+
+void RedisClient::ReplyData::count(const ParsingResult *r, int &nodesCount,
+                                   int &childrenCount,
+                                   int &payloadSize) const {
+  nodesCount++;
+
+  if (isAggregate(r->type)) {
+    childrenCount += r->elements;
+    for (int i = 0; i < r->elements; ++i) {
+      if (r->array[i]) count(r->array[i], nodesCount, childrenCount,
+                             payloadSize);
+    }
+  } else if (r->str) {
+    payloadSize += static_cast<int>(r->len);
+  }
+}
+
+int RedisClient::ReplyData::append(const ParsingResult *r) {
+  int index = nodes.size();
+  ReplyNode node{r->type, 0, 0};
+
+  if (isAggregate(r->type)) {
+    node.size = r->elements;
+    node.value = children.size();
+    nodes.append(node);
+    children.resize(children.size() + r->elements);
+
+    for (int i = 0; i < r->elements; ++i) {
+      int child = r->array[i] ? append(r->array[i]) : -1;
+      children[static_cast<int>(node.value) + i] = child;
+    }
+    return index;
+  }
+
+  if (r->type == Response::Integer || r->type == Response::Boolean) {
+    node.value = r->integer;
+  } else if (r->str) {
+    const char *str = r->str;
+    int len = static_cast<int>(r->len);
+
+    // Skip format prefix of verbatim strings, e.g. "txt:"
+    if (r->type == Response::Verbatim && len >= 4 && str[3] == ':') {
+      str += 4;
+      len -= 4;
+    }
+
+    node.value = payload.size();
+    node.size = len;
+    payload.append(str, len);
+  }
+
+  nodes.append(node);
+  return index;
+}
+
+int RedisClient::ReplyData::append(int type, const QVariant &v) {
+  int index = nodes.size();
+  ReplyNode node{type, 0, 0};
+
+  if (v.type() == QVariant::List || v.type() == QVariant::StringList) {
+    QVariantList list = v.toList();
+    node.type = isAggregate(type) ? type : Response::Array;
+    node.size = list.size();
+    node.value = children.size();
+    nodes.append(node);
+    children.resize(children.size() + list.size());
+
+    for (int i = 0; i < list.size(); ++i) {
+      int child = append(Response::String, list.at(i));
+      children[static_cast<int>(node.value) + i] = child;
+    }
+    return index;
+  }
+
+  if (v.isNull()) {
+    node.type = Response::Nil;
+  } else if (type == Response::Boolean) {
+    node.value = v.toBool() ? 1 : 0;
+  } else if (v.type() == QVariant::Int || v.type() == QVariant::LongLong ||
+             v.type() == QVariant::UInt || v.type() == QVariant::ULongLong) {
+    node.type = (type == Response::String) ? Response::Integer : type;
+    node.value = v.toLongLong();
+  } else {
+    QByteArray bytes = v.toByteArray();
+    node.value = payload.size();
+    node.size = bytes.size();
+
+    // Share data for single-value replies instead of copying it
+    if (payload.isEmpty())
+      payload = bytes;
+    else
+      payload.append(bytes);
+  }
+
+  nodes.append(node);
+  return index;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QVariant>
+#include <QVector>
+
+namespace RedisClient {
+
+struct ParsingResult;
+
+/**
+ * @brief The ReplyNode struct
+ * Element of flattened reply tree.
+ * - strings, doubles and big numbers: value = offset in payload,
+ *   size = length in bytes
+ * - integers and booleans: value = integer
+ * - aggregates (arrays, sets, maps, pushes): value = index of first child
+ *   in ReplyData::children, size = number of children. Maps are stored
+ *   as flat list of keys and values.
+ */
+struct ReplyNode {
+  int type;
+  int size;
+  qint64 value;
+};
+
+/**
+ * @brief The ReplyData struct
+ * Immutable storage of a single reply: all bulk strings are stored in one
+ * payload buffer and the reply structure is stored in an offsets index.
+ * THIS IS IMPLEMENTATION CLASS AND SHOULDN'T BE USED DIRECTLY.
+ */
+struct ReplyData {
+  QByteArray payload;
+  QVector<ReplyNode> nodes;
+  QVector<int> children;
+
+  /**
+   * @brief QVariant representation of the whole reply.
+   * Built on first call and cached.
+   */
+  QVariant variant() const;
+
+  QVariant toVariant(int node) const;
+
+  static QSharedPointer<ReplyData> fromParsingResult(const ParsingResult *r);
+  static QSharedPointer<ReplyData> fromVariant(int type, const QVariant &v);
+
+  static bool isAggregate(int type);
+
+  /**
+   * @brief Number of heap allocations used by reply storage
+   */
+  int allocations() const;
+
+ private:
+  void count(const ParsingResult *r, int &nodesCount, int &childrenCount,
+             int &payloadSize) const;
+  int append(const ParsingResult *r);
+  int append(int type, const QVariant &v);
+
+  mutable QMutex m_cacheLock;
+  mutable QAtomicInt m_cached;
+  mutable QVariant m_cache;
+};
+
+}  // namespace RedisClient
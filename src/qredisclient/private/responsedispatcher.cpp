@@ -0,0 +1,186 @@
+#include "responsedispatcher.h"
+#include <QCoreApplication>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+#include "subscriberqueue.h"
+
+namespace {
+
+const QEvent::Type CALLBACK_EVENT_TYPE =
+    static_cast<QEvent::Type>(QEvent::registerEventType());
+
+class CallbackEvent : public QEvent {
+ public:
+  CallbackEvent(const RedisClient::Command& cmd,
+                const RedisClient::Response& r, const QString& err)
+      : QEvent(CALLBACK_EVENT_TYPE), cmd(cmd), response(r), error(err) {}
+
+  RedisClient::Command cmd;
+  RedisClient::Response response;
+  QString error;
+};
+
+const QEvent::Type MESSAGES_EVENT_TYPE =
+    static_cast<QEvent::Type>(QEvent::registerEventType());
+
+class MessagesEvent : public QEvent {
+ public:
+  MessagesEvent(const RedisClient::Command& cmd,
+                QSharedPointer<RedisClient::SubscriberQueue> queue)
+      : QEvent(MESSAGES_EVENT_TYPE), cmd(cmd), queue(queue) {}
+
+  RedisClient::Command cmd;
+  QSharedPointer<RedisClient::SubscriberQueue> queue;
+};
+
+QMutex& dispatchersLock() {
+  static QMutex lock;
+  return lock;
+}
+
+QHash<QThread*, RedisClient::ResponseDispatcher*>& dispatchers() {
+  static QHash<QThread*, RedisClient::ResponseDispatcher*> map;
+  return map;
+}
+
+// Threads with connected finished/destroyed signals
+QSet<QThread*>& watchedThreads() {
+  static QSet<QThread*> threads;
+  return threads;
+}
+
+}  // namespace
+
+RedisClient::ResponseDispatcher::ResponseDispatcher() : QObject() {}
+
+bool RedisClient::ResponseDispatcher::canDispatch(const Command& cmd) {
+  return (cmd.getOwner() && cmd.getCallBack()) || cmd.getCompletionHandler();
+}
+
+void RedisClient::ResponseDispatcher::dispatch(const Command& cmd,
+                                               const Response& r,
+                                               const QString& err) {
+  if (cmd.getCompletionHandler()) cmd.getCompletionHandler()(r, err);
+
+  if (!cmd.getOwner() || !cmd.getCallBack()) return;
+
+  QThread* ownerThread = cmd.getOwnerThread();
+
+  if (ownerThread == QThread::currentThread()) {
+    if (cmd.isOwnerAlive()) cmd.getCallBack()(r, err);
+    return;
+  }
+
+  // Owner is checked again in own thread before callback is invoked
+  if (!cmd.isOwnerAlive()) return;
+
+  post(ownerThread, new CallbackEvent(cmd, r, err));
+}
+
+void RedisClient::ResponseDispatcher::dispatchMessages(
+    const Command& cmd, QSharedPointer<SubscriberQueue> queue) {
+  QThread* ownerThread = cmd.getOwnerThread();
+
+  if (ownerThread == QThread::currentThread())
+    return deliverMessages(cmd, queue);
+
+  // Messages are dropped to resume paused transporter
+  if (!cmd.isOwnerAlive() ||
+      !post(ownerThread, new MessagesEvent(cmd, queue)))
+    queue->clear();
+}
+
+void RedisClient::ResponseDispatcher::deliverMessages(
+    const Command& cmd, QSharedPointer<SubscriberQueue> queue) {
+  QVector<Response> batch = queue->takeBatch();
+
+  if (batch.isEmpty() || !cmd.isOwnerAlive()) return;
+
+  if (cmd.getMessageBatchCallback())
+    return cmd.getMessageBatchCallback()(batch);
+
+  if (!cmd.getCallBack()) return;
+
+  for (const Response& r : batch) {
+    if (!cmd.isOwnerAlive()) return;
+
+    cmd.getCallBack()(r, QString());
+  }
+}
+
+bool RedisClient::ResponseDispatcher::event(QEvent* e) {
+  if (e->type() == MESSAGES_EVENT_TYPE) {
+    auto messagesEvent = static_cast<MessagesEvent*>(e);
+    deliverMessages(messagesEvent->cmd, messagesEvent->queue);
+    return true;
+  }
+
+  if (e->type() != CALLBACK_EVENT_TYPE) return QObject::event(e);
+
+  auto callbackEvent = static_cast<CallbackEvent*>(e);
+
+  if (callbackEvent->cmd.isOwnerAlive())
+    callbackEvent->cmd.getCallBack()(callbackEvent->response,
+                                     callbackEvent->error);
+
+  return true;
+}
+
+bool RedisClient::ResponseDispatcher::post(QThread* thread, QEvent* e) {
+  // Event is posted under lock, so forgetThread() can't delete
+  // dispatcher in between
+  QMutexLocker lock(&dispatchersLock());
+
+  ResponseDispatcher* dispatcher = forThread(thread);
+
+  if (!dispatcher) {
+    delete e;
+    return false;
+  }
+
+  QCoreApplication::postEvent(dispatcher, e);
+  return true;
+}
+
+RedisClient::ResponseDispatcher* RedisClient::ResponseDispatcher::forThread(
+    QThread* thread) {
+  if (!thread) return nullptr;
+
+  ResponseDispatcher* dispatcher = dispatchers().value(thread, nullptr);
+
+  if (dispatcher) return dispatcher;
+
+  // Events of finished thread are never delivered
+  if (thread->isFinished()) return nullptr;
+
+  dispatcher = new ResponseDispatcher();
+  dispatcher->moveToThread(thread);
+  dispatchers().insert(thread, dispatcher);
+
+  if (watchedThreads().contains(thread)) return dispatcher;
+
+  watchedThreads().insert(thread);
+
+  // Dispatcher is deleted in own thread when thread finishes
+  // or when QThread object is destroyed without running.
+  // Restarted thread gets new dispatcher, signals are connected once.
+  QObject::connect(thread, &QThread::finished,
+                   [thread]() { forgetThread(thread, false); });
+  QObject::connect(thread, &QObject::destroyed,
+                   [thread]() { forgetThread(thread, true); });
+
+  return dispatcher;
+}
+
+void RedisClient::ResponseDispatcher::forgetThread(QThread* thread,
+                                                   bool destroyed) {
+  QMutexLocker lock(&dispatchersLock());
+
+  if (destroyed) watchedThreads().remove(thread);
+
+  // Pending events are discarded with dispatcher
+  delete dispatchers().take(thread);
+}
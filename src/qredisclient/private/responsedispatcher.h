@@ -0,0 +1,60 @@
+#pragma once
+#include <QEvent>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include "qredisclient/command.h"
+#include "qredisclient/response.h"
+
+namespace RedisClient {
+
+class SubscriberQueue;
+
+/**
+ * @brief The ResponseDispatcher class
+ * Delivers responses to command callbacks in the thread of command owner.
+ * Callback is invoked directly if owner lives in current thread, otherwise
+ * single event is posted to dispatcher object of owner thread.
+ * Callback is skipped if owner was destroyed. Completion handler of
+ * command is always invoked directly in current thread.
+ * THIS IS IMPLEMENTATION CLASS AND SHOULDN'T BE USED DIRECTLY.
+ */
+class ResponseDispatcher : public QObject {
+ public:
+  /**
+   * @brief Check if command has completion handler or owner and callback
+   */
+  static bool canDispatch(const Command& cmd);
+
+  static void dispatch(const Command& cmd, const Response& r,
+                       const QString& err = QString());
+
+  /**
+   * @brief Deliver buffered pub/sub messages of subscription.
+   * Queue is drained immediately if owner lives in current thread,
+   * otherwise single event drains all messages buffered until
+   * it is processed.
+   */
+  static void dispatchMessages(const Command& cmd,
+                               QSharedPointer<SubscriberQueue> queue);
+
+ protected:
+  bool event(QEvent* e) override;
+
+ private:
+  ResponseDispatcher();
+
+  static void deliverMessages(const Command& cmd,
+                              QSharedPointer<SubscriberQueue> queue);
+  /**
+   * @brief Post event to dispatcher of thread, takes ownership of event
+   * @return false if event cannot be delivered to thread
+   */
+  static bool post(QThread* thread, QEvent* e);
+
+  // Caller should hold dispatchers lock
+  static ResponseDispatcher* forThread(QThread* thread);
+  static void forgetThread(QThread* thread, bool destroyed);
+};
+
+}  // namespace RedisClient
@@ -0,0 +1,122 @@
+#include "sslcontextcache.h"
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSslKey>
+#include <QStringList>
+#include "qredisclient/connectionconfig.h"
+
+namespace {
+QString fileVersion(const QString& path) {
+  if (path.isEmpty()) return QString();
+
+  QFileInfo info(path);
+  return QString("%1@%2").arg(path).arg(
+      info.lastModified().toMSecsSinceEpoch());
+}
+
+QByteArray readFile(const QString& path) {
+  QFile file(path);
+
+  if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+
+  return file.readAll();
+}
+}  // namespace
+
+RedisClient::SslContextCache& RedisClient::SslContextCache::instance() {
+  static SslContextCache cache;
+  return cache;
+}
+
+QSslConfiguration RedisClient::SslContextCache::configuration(
+    const ConnectionConfig& config) {
+  QString key = filesKey(config);
+  QString session = sessionKey(config);
+
+  QSslConfiguration result;
+
+  {
+    QMutexLocker lock(&m_lock);
+    auto cached = m_configurations.constFind(key);
+
+    if (cached != m_configurations.constEnd()) {
+      result = cached.value();
+      result.setSessionTicket(m_sessionTickets.value(session));
+      return result;
+    }
+  }
+
+  // Files are parsed without lock, concurrent miss only parses them twice
+  result = load(config);
+
+  QMutexLocker lock(&m_lock);
+  m_configurations.insert(key, result);
+  result.setSessionTicket(m_sessionTickets.value(session));
+  return result;
+}
+
+void RedisClient::SslContextCache::storeSession(
+    const ConnectionConfig& config, const QSslConfiguration& configuration) {
+  QByteArray ticket = configuration.sessionTicket();
+
+  if (ticket.isEmpty()) return;
+
+  QString session = sessionKey(config);
+
+  QMutexLocker lock(&m_lock);
+  m_sessionTickets.insert(session, ticket);
+}
+
+void RedisClient::SslContextCache::clear() {
+  QMutexLocker lock(&m_lock);
+  m_configurations.clear();
+  m_sessionTickets.clear();
+}
+
+QString RedisClient::SslContextCache::filesKey(const ConnectionConfig& config) {
+  return QStringList({fileVersion(config.sslCaCertPath()),
+                      fileVersion(config.sslLocalCertPath()),
+                      fileVersion(config.sslPrivateKeyPath())})
+      .join('|');
+}
+
+QString RedisClient::SslContextCache::sessionKey(
+    const ConnectionConfig& config) {
+  // Session of one client identity isn't resumed with another one
+  return QString("%1:%2|%3")
+      .arg(config.host())
+      .arg(config.port())
+      .arg(filesKey(config));
+}
+
+QSslConfiguration RedisClient::SslContextCache::load(
+    const ConnectionConfig& config) {
+  QSslConfiguration result = QSslConfiguration::defaultConfiguration();
+
+  // Session tickets are available only with session persistence
+  result.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+  result.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+
+  QList<QSslCertificate> trustedCas = config.sslCaCertificates();
+
+  if (!trustedCas.isEmpty())
+    result.setCaCertificates(result.caCertificates() + trustedCas);
+
+  QString privateKey = config.sslPrivateKeyPath();
+
+  if (!privateKey.isEmpty())
+    result.setPrivateKey(QSslKey(readFile(privateKey), QSsl::Rsa));
+
+  QString localCert = config.sslLocalCertPath();
+
+  if (!localCert.isEmpty()) {
+    QList<QSslCertificate> certs =
+        QSslCertificate::fromData(readFile(localCert));
+
+    if (!certs.isEmpty()) result.setLocalCertificate(certs.first());
+  }
+
+  return result;
+}
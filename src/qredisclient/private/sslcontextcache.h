@@ -0,0 +1,53 @@
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QSslConfiguration>
+#include <QString>
+
+namespace RedisClient {
+
+class ConnectionConfig;
+
+/**
+ * @brief The SslContextCache class
+ * Process-wide cache of SSL settings shared by all connections.
+ * CA certificates, local certificate and private key are parsed once per
+ * file (files are re-read only when modified). TLS session tickets are
+ * stored per host and certificate files, so reconnects and other
+ * connections to the same host with the same identity resume session
+ * instead of doing full handshake.
+ * Thread-safe.
+ * THIS IS IMPLEMENTATION CLASS AND SHOULDN'T BE USED DIRECTLY.
+ */
+class SslContextCache {
+ public:
+  static SslContextCache& instance();
+
+  /**
+   * @brief SSL configuration for connection with session ticket
+   * of the last session with the same host and certificate files
+   */
+  QSslConfiguration configuration(const ConnectionConfig& config);
+
+  /**
+   * @brief Store session ticket of encrypted socket
+   */
+  void storeSession(const ConnectionConfig& config,
+                    const QSslConfiguration& configuration);
+  void clear();
+
+ private:
+  SslContextCache() {}
+
+  static QString filesKey(const ConnectionConfig& config);
+  static QString sessionKey(const ConnectionConfig& config);
+  static QSslConfiguration load(const ConnectionConfig& config);
+
+ private:
+  QMutex m_lock;
+  QHash<QString, QSslConfiguration> m_configurations;  // by files key
+  QHash<QString, QByteArray> m_sessionTickets;         // by session key
+};
+
+}  // namespace RedisClient
@@ -0,0 +1,196 @@
+#include "streamingreplyreader.h"
+
+RedisClient::StreamingReplyReader::StreamingReplyReader()
+    : m_state(State::Idle), m_remaining(0), m_streamed(0) {}
+
+void RedisClient::StreamingReplyReader::start(
+    Command::StreamCallback callback) {
+  m_callback = callback;
+  m_state = State::Header;
+  m_header.clear();
+  m_remaining = 0;
+  m_streamed = 0;
+  m_response = Response();
+  m_elementsParser.reset();
+}
+
+bool RedisClient::StreamingReplyReader::isActive() const {
+  return m_state != State::Idle && m_state != State::Finished;
+}
+
+void RedisClient::StreamingReplyReader::reset() {
+  m_callback = nullptr;
+  m_state = State::Idle;
+  m_header.clear();
+  m_response = Response();
+  m_elementsParser.reset();
+}
+
+bool RedisClient::StreamingReplyReader::isFinished() const {
+  return m_state == State::Finished;
+}
+
+RedisClient::Response RedisClient::StreamingReplyReader::takeResponse() {
+  Response r = m_response;
+  m_response = Response();
+  m_callback = nullptr;
+  m_state = State::Idle;
+  return r;
+}
+
+QByteArray RedisClient::StreamingReplyReader::feed(const QByteArray& data) {
+  QByteArray rest = data;
+
+  while (!rest.isEmpty() && isActive()) {
+    switch (m_state) {
+      case State::Header:
+        rest = processHeader(rest);
+        break;
+      case State::Bulk:
+      case State::BulkTrailer:
+        rest = processBulk(rest);
+        break;
+      case State::Array:
+        rest = processArray(rest);
+        break;
+      default:
+        return rest;
+    }
+  }
+
+  return rest;
+}
+
+QByteArray RedisClient::StreamingReplyReader::processHeader(
+    const QByteArray& data) {
+  QByteArray rest;
+
+  if (m_header.endsWith('\r') && data.startsWith('\n')) {
+    // CR and LF were split between reads
+    m_header.chop(1);
+    rest = data.mid(1);
+  } else {
+    int lineEnd = data.indexOf("\r\n");
+
+    if (lineEnd == -1) {
+      m_header.append(data);
+      return QByteArray();
+    }
+
+    m_header.append(data.constData(), lineEnd);
+    rest = data.mid(lineEnd + 2);
+  }
+
+  if (m_header.isEmpty()) {
+    finish(Response(Response::Error, QByteArray("Invalid reply header")));
+    return rest;
+  }
+
+  char prefix = m_header.at(0);
+  QByteArray line = m_header.mid(1);
+  m_header.clear();
+
+  switch (prefix) {
+    case '$':
+    case '=':  // RESP3 verbatim string
+      m_remaining = line.toLongLong();
+      if (m_remaining < 0) {
+        finish(Response(Response::Nil, QVariant()));
+      } else {
+        m_state = State::Bulk;
+      }
+      break;
+    case '*':
+    case '~':  // RESP3 set
+    case '%':  // RESP3 map, keys and values are streamed as elements
+      m_remaining = line.toLongLong();
+      if (prefix == '%') m_remaining *= 2;
+
+      if (m_remaining < 0) {
+        finish(Response(Response::Nil, QVariant()));
+      } else if (m_remaining == 0) {
+        finish(Response(Response::Integer, QVariant(0LL)));
+      } else {
+        m_state = State::Array;
+      }
+      break;
+    case '+':
+      finish(Response(Response::Status, line));
+      break;
+    case '-':
+      finish(Response(Response::Error, line));
+      break;
+    case ':':
+      finish(Response(Response::Integer, QVariant(line.toLongLong())));
+      break;
+    case '_':
+      finish(Response(Response::Nil, QVariant()));
+      break;
+    default:
+      finish(Response(Response::Error, QByteArray("Invalid reply header")));
+  }
+
+  return rest;
+}
+
+QByteArray RedisClient::StreamingReplyReader::processBulk(
+    const QByteArray& data) {
+  if (m_state == State::Bulk) {
+    qint64 chunkSize = qMin<qint64>(m_remaining, data.size());
+
+    if (chunkSize > 0) {
+      QByteArray chunk =
+          (chunkSize == data.size()) ? data : data.left(chunkSize);
+      m_remaining -= chunkSize;
+      m_streamed += chunkSize;
+
+      if (m_callback) m_callback(Response(Response::String, chunk));
+    }
+
+    if (m_remaining > 0) return QByteArray();
+
+    m_state = State::BulkTrailer;
+    m_remaining = 2;
+    return data.mid(chunkSize);
+  }
+
+  // Skip trailing CRLF
+  int skip = qMin<qint64>(m_remaining, data.size());
+  m_remaining -= skip;
+
+  if (m_remaining == 0)
+    finish(Response(Response::Integer, QVariant(m_streamed)));
+
+  return data.mid(skip);
+}
+
+QByteArray RedisClient::StreamingReplyReader::processArray(
+    const QByteArray& data) {
+  if (!m_elementsParser.feedBuffer(data)) {
+    finish(Response(Response::Error, QByteArray("Cannot parse reply")));
+    return QByteArray();
+  }
+
+  while (m_remaining > 0) {
+    Response element = m_elementsParser.getNextResponse();
+
+    if (!element.isValid()) break;
+
+    m_remaining--;
+    m_streamed++;
+
+    if (m_callback) m_callback(element);
+  }
+
+  if (m_remaining > 0) return QByteArray();
+
+  QByteArray rest = m_elementsParser.unusedBuffer();
+  m_elementsParser.reset();
+  finish(Response(Response::Integer, QVariant(m_streamed)));
+  return rest;
+}
+
+void RedisClient::StreamingReplyReader::finish(const Response& r) {
+  m_response = r;
+  m_state = State::Finished;
+}
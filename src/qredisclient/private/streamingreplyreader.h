@@ -0,0 +1,61 @@
+#pragma once
+#include <QByteArray>
+#include "qredisclient/command.h"
+#include "qredisclient/response.h"
+#include "qredisclient/responseparser.h"
+
+namespace RedisClient {
+
+/**
+ * @brief The StreamingReplyReader class
+ * Incremental reader for top-level reply of streaming commands.
+ * Bulk strings are delivered in chunks as they arrive from socket,
+ * elements of array replies are delivered one by one.
+ * THIS IS IMPLEMENTATION CLASS AND SHOULDN'T BE USED DIRECTLY.
+ */
+class StreamingReplyReader {
+ public:
+  StreamingReplyReader();
+
+  void start(Command::StreamCallback callback);
+
+  bool isActive() const;
+
+  void reset();
+
+  /**
+   * @brief Process incoming data
+   * @return Bytes which don't belong to current reply
+   */
+  QByteArray feed(const QByteArray& data);
+
+  /**
+   * @brief Check if reply was fully received
+   */
+  bool isFinished() const;
+
+  /**
+   * @brief Final response. For bulk strings contains number of streamed
+   * bytes, for arrays number of streamed elements, other replies are
+   * returned as is.
+   */
+  Response takeResponse();
+
+ private:
+  enum class State { Idle, Header, Bulk, BulkTrailer, Array, Finished };
+
+  QByteArray processHeader(const QByteArray& data);
+  QByteArray processBulk(const QByteArray& data);
+  QByteArray processArray(const QByteArray& data);
+  void finish(const Response& r);
+
+  State m_state;
+  Command::StreamCallback m_callback;
+  QByteArray m_header;
+  qint64 m_remaining;
+  qint64 m_streamed;
+  ResponseParser m_elementsParser;
+  Response m_response;
+};
+
+}  // namespace RedisClient
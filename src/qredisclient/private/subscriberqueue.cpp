@@ -0,0 +1,102 @@
+#include "subscriberqueue.h"
+#include <QMutexLocker>
+
+RedisClient::SubscriberQueue::SubscriberQueue(uint limit,
+                                              OverflowPolicy policy,
+                                              QSharedPointer<Counters> counters,
+                                              PauseHandler pauseHandler)
+    : m_limit(qMax(1u, limit)),
+      m_policy(policy),
+      m_counters(counters ? counters : QSharedPointer<Counters>(new Counters())),
+      m_pauseHandler(pauseHandler),
+      m_dropped(0),
+      m_deliveryScheduled(false),
+      m_paused(false) {}
+
+RedisClient::SubscriberQueue::~SubscriberQueue() { clear(); }
+
+bool RedisClient::SubscriberQueue::push(const Response &r) {
+  QMutexLocker lock(&m_lock);
+
+  if (static_cast<uint>(m_messages.size()) >= m_limit) {
+    if (m_policy == OverflowPolicy::DropNewest) {
+      m_dropped++;
+      m_counters->dropped.fetchAndAddRelaxed(1);
+      return false;
+    }
+
+    if (m_policy == OverflowPolicy::DropOldest) {
+      m_messages.dequeue();
+      m_dropped++;
+      m_counters->dropped.fetchAndAddRelaxed(1);
+      m_counters->depth.fetchAndAddRelaxed(-1);
+    }
+  }
+
+  m_messages.enqueue(r);
+  m_counters->depth.fetchAndAddRelaxed(1);
+
+  bool pause = m_policy == OverflowPolicy::PauseReading && !m_paused &&
+               static_cast<uint>(m_messages.size()) >= m_limit;
+
+  if (pause) m_paused = true;
+
+  bool scheduleDelivery = !m_deliveryScheduled;
+  m_deliveryScheduled = true;
+
+  lock.unlock();
+
+  if (pause && m_pauseHandler) m_pauseHandler(true);
+
+  return scheduleDelivery;
+}
+
+QVector<RedisClient::Response> RedisClient::SubscriberQueue::takeBatch() {
+  QMutexLocker lock(&m_lock);
+
+  QVector<Response> batch;
+  batch.reserve(m_messages.size());
+
+  while (!m_messages.isEmpty()) batch.append(m_messages.dequeue());
+
+  m_deliveryScheduled = false;
+  m_counters->depth.fetchAndAddRelaxed(-batch.size());
+  m_counters->delivered.fetchAndAddRelaxed(batch.size());
+
+  resume(lock);
+
+  return batch;
+}
+
+void RedisClient::SubscriberQueue::clear() {
+  QMutexLocker lock(&m_lock);
+
+  m_counters->depth.fetchAndAddRelaxed(-m_messages.size());
+  m_messages.clear();
+
+  resume(lock);
+}
+
+int RedisClient::SubscriberQueue::size() const {
+  QMutexLocker lock(&m_lock);
+  return m_messages.size();
+}
+
+quint64 RedisClient::SubscriberQueue::dropped() const {
+  QMutexLocker lock(&m_lock);
+  return m_dropped;
+}
+
+bool RedisClient::SubscriberQueue::isPaused() const {
+  QMutexLocker lock(&m_lock);
+  return m_paused;
+}
+
+void RedisClient::SubscriberQueue::resume(QMutexLocker &lock) {
+  if (!m_paused) return;
+
+  m_paused = false;
+  lock.unlock();
+
+  if (m_pauseHandler) m_pauseHandler(false);
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QVector>
+#include <functional>
+#include "qredisclient/connectionconfig.h"
+#include "qredisclient/response.h"
+
+namespace RedisClient {
+
+/**
+ * @brief The SubscriberQueue class
+ * Bounded queue of pub/sub messages of a single subscription.
+ * Messages are pushed from transporter thread and taken in batches
+ * from owner thread, so only one delivery event is queued at a time.
+ * THIS IS IMPLEMENTATION CLASS AND SHOULDN'T BE USED DIRECTLY.
+ */
+class SubscriberQueue {
+ public:
+  typedef ConnectionConfig::SubscriberOverflowPolicy OverflowPolicy;
+
+  /**
+   * @brief Counters shared by all queues of transporter
+   */
+  struct Counters {
+    QAtomicInteger<qint64> depth;
+    QAtomicInteger<quint64> delivered;
+    QAtomicInteger<quint64> dropped;
+  };
+
+  /**
+   * @brief Called with true in transporter thread when queue reaches
+   * the limit with PauseReading policy and with false in owner thread
+   * when queue is drained
+   */
+  typedef std::function<void(bool paused)> PauseHandler;
+
+ public:
+  SubscriberQueue(uint limit, OverflowPolicy policy,
+                  QSharedPointer<Counters> counters = QSharedPointer<Counters>(),
+                  PauseHandler pauseHandler = nullptr);
+  ~SubscriberQueue();
+
+  /**
+   * @brief Add message
+   * @return true if delivery of the queue should be scheduled
+   */
+  bool push(const Response& r);
+
+  /**
+   * @brief Take all buffered messages
+   */
+  QVector<Response> takeBatch();
+
+  /**
+   * @brief Drop buffered messages and resume reading if paused
+   */
+  void clear();
+
+  int size() const;
+  quint64 dropped() const;
+  bool isPaused() const;
+
+ private:
+  void resume(QMutexLocker& lock);
+
+ private:
+  mutable QMutex m_lock;
+  QQueue<Response> m_messages;
+  uint m_limit;
+  OverflowPolicy m_policy;
+  QSharedPointer<Counters> m_counters;
+  PauseHandler m_pauseHandler;
+  quint64 m_dropped;
+  bool m_deliveryScheduled;
+  bool m_paused;
+};
+
+}  // namespace RedisClient
@@ -0,0 +1,137 @@
+#include "subscriptionindex.h"
+#include "responsedispatcher.h"
+
+RedisClient::SubscriptionIndex::SubscriptionIndex()
+    : m_queueLimit(ConnectionConfig::DEFAULT_SUBSCRIBER_QUEUE_LIMIT),
+      m_overflowPolicy(SubscriberQueue::OverflowPolicy::DropOldest),
+      m_counters(new SubscriberQueue::Counters()) {}
+
+void RedisClient::SubscriptionIndex::setQueuePolicy(
+    uint limit, SubscriberQueue::OverflowPolicy policy,
+    QSharedPointer<SubscriberQueue::Counters> counters,
+    SubscriberQueue::PauseHandler pauseHandler) {
+  m_queueLimit = limit;
+  m_overflowPolicy = policy;
+  m_counters = counters;
+  m_pauseHandler = pauseHandler;
+}
+
+void RedisClient::SubscriptionIndex::subscribe(const Command &cmd) {
+  int kind = commandKind(cmd);
+
+  if (kind < 0) return;
+
+  Subscription subscription;
+  subscription.cmd = cmd;
+  subscription.queue = QSharedPointer<SubscriberQueue>(new SubscriberQueue(
+      m_queueLimit, m_overflowPolicy, m_counters, m_pauseHandler));
+
+  const QList<QByteArray> &parts = cmd.getSplitedRepresentattion();
+
+  for (int i = 1; i < parts.size(); ++i)
+    m_index[kind].insert(parts.at(i), subscription);
+}
+
+void RedisClient::SubscriptionIndex::unsubscribe(const Command &cmd) {
+  int kind = commandKind(cmd);
+
+  if (kind < 0) return;
+
+  const QList<QByteArray> &parts = cmd.getSplitedRepresentattion();
+
+  for (int i = 1; i < parts.size(); ++i) m_index[kind].remove(parts.at(i));
+}
+
+QList<RedisClient::Command> RedisClient::SubscriptionIndex::removeOwner(
+    QObject *owner) {
+  static const QByteArray unsubscribe[KindsCount] = {
+      "UNSUBSCRIBE", "PUNSUBSCRIBE", "SUNSUBSCRIBE"};
+
+  QList<Command> removed;
+
+  for (int kind = 0; kind < KindsCount; ++kind) {
+    auto i = m_index[kind].begin();
+
+    while (i != m_index[kind].end()) {
+      if (i.value().cmd.getOwner() == owner) {
+        // One channel per command, so each reply matches one command
+        removed.append(Command({unsubscribe[kind], i.key()}));
+        i = m_index[kind].erase(i);
+      } else {
+        ++i;
+      }
+    }
+  }
+
+  return removed;
+}
+
+bool RedisClient::SubscriptionIndex::isEmpty() const { return size() == 0; }
+
+int RedisClient::SubscriptionIndex::size() const {
+  return m_index[Channel].size() + m_index[Pattern].size() +
+         m_index[ShardChannel].size();
+}
+
+void RedisClient::SubscriptionIndex::clear() {
+  for (int kind = 0; kind < KindsCount; ++kind) m_index[kind].clear();
+}
+
+bool RedisClient::SubscriptionIndex::dispatch(const Response &r) const {
+  int kind = messageKind(r);
+
+  if (kind < 0) return false;
+
+  // pmessage is matched by pattern, other messages by channel.
+  // asBytes() points to reply memory, so lookup doesn't copy the name.
+  auto subscription = m_index[kind].constFind(r.at(1).asBytes());
+
+  if (subscription == m_index[kind].constEnd()) return true;
+
+  const Command &cmd = subscription.value().cmd;
+
+  if (!cmd.getOwner() || !(cmd.getCallBack() || cmd.getMessageBatchCallback()))
+    return true;
+
+  // Only first message of a batch posts delivery event
+  if (subscription.value().queue->push(r))
+    ResponseDispatcher::dispatchMessages(cmd, subscription.value().queue);
+
+  return true;
+}
+
+int RedisClient::SubscriptionIndex::messageKind(const Response &r) {
+  if (!r.isArray() || r.arraySize() < 3) return -1;
+
+  QByteArray type = r.at(0).asBytes();
+
+  if (type == "message") return Channel;
+  if (type == "smessage") return ShardChannel;
+  if (type == "pmessage" && r.arraySize() >= 4) return Pattern;
+
+  return -1;
+}
+
+int RedisClient::SubscriptionIndex::confirmationKind(const Response &r) {
+  if (!r.isArray() || r.arraySize() != 3) return -1;
+
+  QByteArray type = r.at(0).asBytes().toLower();
+
+  if (type == "subscribe" || type == "unsubscribe") return Channel;
+  if (type == "psubscribe" || type == "punsubscribe") return Pattern;
+  if (type == "ssubscribe" || type == "sunsubscribe") return ShardChannel;
+
+  return -1;
+}
+
+int RedisClient::SubscriptionIndex::commandKind(const Command &cmd) {
+  const CommandInfo &info = cmd.info();
+
+  if (!info.is(CommandInfo::Subscribe) && !info.is(CommandInfo::Unsubscribe))
+    return -1;
+
+  if (info.is(CommandInfo::PatternChannel)) return Pattern;
+  if (info.is(CommandInfo::ShardChannel)) return ShardChannel;
+
+  return Channel;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include "qredisclient/command.h"
+#include "qredisclient/response.h"
+#include "subscriberqueue.h"
+
+namespace RedisClient {
+
+/**
+ * @brief The SubscriptionIndex class
+ * Pub/Sub subscriptions of transporter indexed separately by channel,
+ * pattern and shard channel, so message, pmessage and smessage frames
+ * are matched with a single hash lookup without copying channel name.
+ * Each subscription buffers messages in bounded SubscriberQueue.
+ * THIS IS IMPLEMENTATION CLASS AND SHOULDN'T BE USED DIRECTLY.
+ */
+class SubscriptionIndex {
+ public:
+  enum Kind { Channel = 0, Pattern, ShardChannel, KindsCount };
+
+ public:
+  SubscriptionIndex();
+
+  /**
+   * @brief Queue settings of subscriptions added after this call
+   */
+  void setQueuePolicy(uint limit, SubscriberQueue::OverflowPolicy policy,
+                      QSharedPointer<SubscriberQueue::Counters> counters,
+                      SubscriberQueue::PauseHandler pauseHandler);
+
+  /**
+   * @brief Add channels of SUBSCRIBE, PSUBSCRIBE or SSUBSCRIBE command
+   */
+  void subscribe(const Command& cmd);
+
+  /**
+   * @brief Remove channels of UNSUBSCRIBE, PUNSUBSCRIBE or SUNSUBSCRIBE
+   */
+  void unsubscribe(const Command& cmd);
+
+  /**
+   * @brief Remove subscriptions of owner
+   * @return UNSUBSCRIBE, PUNSUBSCRIBE or SUNSUBSCRIBE command for each
+   * removed channel, server stays subscribed until they are sent
+   */
+  QList<Command> removeOwner(QObject* owner);
+
+  bool isEmpty() const;
+  int size() const;
+  void clear();
+
+  /**
+   * @brief Deliver pub/sub message to subscriber.
+   * Messages without subscriber are dropped.
+   * @return false if response is not a pub/sub message
+   */
+  bool dispatch(const Response& r) const;
+
+  /**
+   * @brief Kind of message, pmessage or smessage frame
+   * @return -1 if response is not a pub/sub message
+   */
+  static int messageKind(const Response& r);
+
+  /**
+   * @brief Kind of subscribe or unsubscribe confirmation frame
+   * @return -1 if response is not a confirmation
+   */
+  static int confirmationKind(const Response& r);
+
+ private:
+  static int commandKind(const Command& cmd);
+
+ private:
+  struct Subscription {
+    Command cmd;
+    QSharedPointer<SubscriberQueue> queue;  // shared by command channels
+  };
+
+  QHash<QByteArray, Subscription> m_index[KindsCount];
+
+  uint m_queueLimit;
+  SubscriberQueue::OverflowPolicy m_overflowPolicy;
+  QSharedPointer<SubscriberQueue::Counters> m_counters;
+  SubscriberQueue::PauseHandler m_pauseHandler;
+};
+
+}  // namespace RedisClient
@@ -1,9 +1,21 @@
 #pragma once
 
+#include "bulkexport.h"
+#include "bulkimport.h"
 #include "command.h"
+#include "compactkeylist.h"
 #include "connection.h"
 #include "connectionconfig.h"
+#include "connectionmetrics.h"
+#include "connectionpool.h"
+#include "coroutines.h"
+#include "keyiterator.h"
+#include "keyspaceanalyzer.h"
+#include "pipeline.h"
 #include "response.h"
+#include "scaniterator.h"
+#include "streamconsumer.h"
+#include "valuereader.h"
 #include <QObject>
 #include <QVector>
 #include <QByteArray>
@@ -12,8 +24,17 @@ inline void initRedisClient()
 {
     qRegisterMetaType<RedisClient::Command>("Command");
     qRegisterMetaType<RedisClient::Command>("RedisClient::Command");
+    qRegisterMetaType<QList<RedisClient::Command>>("QList<Command>");
+    qRegisterMetaType<QList<RedisClient::Command>>(
+        "QList<RedisClient::Command>");
     qRegisterMetaType<RedisClient::Response>("Response");
     qRegisterMetaType<RedisClient::Response>("RedisClient::Response");
     qRegisterMetaType<QVector<QVariant*>>("QVector<QVariant*>");
     qRegisterMetaType<QVariant*>("QVariant*");    
+    qRegisterMetaType<RedisClient::BulkImport::Progress>(
+        "RedisClient::BulkImport::Progress");
+    qRegisterMetaType<RedisClient::BulkExport::Progress>(
+        "RedisClient::BulkExport::Progress");
+    qRegisterMetaType<RedisClient::StreamConsumer::Batch>(
+        "RedisClient::StreamConsumer::Batch");
 }
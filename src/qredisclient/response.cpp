@@ -4,76 +4,220 @@
 #include <QObject>
 #include <QVariantList>
 #include <QVector>
+#include "qredisclient/private/replydata.h"
 #include "qredisclient/utils/compat.h"
 #include "qredisclient/utils/text.h"
 
+/*
+ * ResponseView
+ */
+RedisClient::ResponseView::ResponseView() : m_node(-1) {}
+
+RedisClient::ResponseView::ResponseView(QSharedPointer<const ReplyData> data,
+                                        int node)
+    : m_data(data), m_node(node) {}
+
+bool RedisClient::ResponseView::isValid() const {
+  return m_data && m_node >= 0 && m_node < m_data->nodes.size();
+}
+
+int RedisClient::ResponseView::type() const {
+  if (!isValid()) return Response::Unknown;
+
+  return m_data->nodes.at(m_node).type;
+}
+
+bool RedisClient::ResponseView::isNil() const {
+  return !isValid() || type() == Response::Nil;
+}
+
+bool RedisClient::ResponseView::isArray() const {
+  int t = type();
+  return t == Response::Array || t == Response::Set || t == Response::Push;
+}
+
+bool RedisClient::ResponseView::isMap() const {
+  return type() == Response::Map;
+}
+
+bool RedisClient::ResponseView::isAggregate() const {
+  return ReplyData::isAggregate(type());
+}
+
+int RedisClient::ResponseView::arraySize() const {
+  if (!isAggregate()) return 0;
+
+  return m_data->nodes.at(m_node).size;
+}
+
+RedisClient::ResponseView RedisClient::ResponseView::at(int i) const {
+  if (i < 0 || i >= arraySize()) return ResponseView();
+
+  const ReplyNode& node = m_data->nodes.at(m_node);
+  return ResponseView(m_data,
+                      m_data->children.at(static_cast<int>(node.value) + i));
+}
+
+QByteArray RedisClient::ResponseView::asBytes() const {
+  if (!isValid()) return QByteArray();
+
+  const ReplyNode& node = m_data->nodes.at(m_node);
+
+  if (ReplyData::isAggregate(node.type)) return QByteArray();
+
+  switch (node.type) {
+    case Response::Nil:
+      return QByteArray();
+    case Response::Integer:
+    case Response::Boolean:
+      return QByteArray::number(node.value);
+    default:
+      return QByteArray::fromRawData(m_data->payload.constData() + node.value,
+                                     node.size);
+  }
+}
+
+QByteArray RedisClient::ResponseView::toByteArray() const {
+  QByteArray bytes = asBytes();
+  bytes.detach();
+  return bytes;
+}
+
+qint64 RedisClient::ResponseView::toInteger() const {
+  if (!isValid()) return 0;
+
+  const ReplyNode& node = m_data->nodes.at(m_node);
+
+  if (node.type == Response::Integer || node.type == Response::Boolean)
+    return node.value;
+
+  if (node.type == Response::Double) return static_cast<qint64>(toDouble());
+
+  return asBytes().toLongLong();
+}
+
+double RedisClient::ResponseView::toDouble() const {
+  if (!isValid()) return 0.0;
+
+  const ReplyNode& node = m_data->nodes.at(m_node);
+
+  if (node.type == Response::Integer || node.type == Response::Boolean)
+    return static_cast<double>(node.value);
+
+  return asBytes().toDouble();
+}
+
+bool RedisClient::ResponseView::toBool() const { return toInteger() != 0; }
+
+QVariant RedisClient::ResponseView::toVariant() const {
+  if (!isValid()) return QVariant();
+
+  if (m_node == 0) return m_data->variant();
+
+  return m_data->toVariant(m_node);
+}
+
+/*
+ * Response
+ */
 RedisClient::Response::Response() : m_type(RedisClient::Response::Unknown) {}
 
 RedisClient::Response::Response(Type t, const QVariant& result)
-    : m_type(t), m_result(result) {}
+    : m_type(t), m_data(ReplyData::fromVariant(t, result)) {}
+
+RedisClient::Response::Response(QSharedPointer<const ReplyData> data)
+    : m_type(Unknown), m_data(data) {
+  if (m_data && !m_data->nodes.isEmpty())
+    m_type = static_cast<Type>(m_data->nodes.first().type);
+}
 
 RedisClient::Response::~Response(void) {}
 
-bool RedisClient::Response::isEmpty() const { return m_result.isNull(); }
+bool RedisClient::Response::isEmpty() const { return view().isNil(); }
 
-QVariant RedisClient::Response::value() const { return m_result; }
+QVariant RedisClient::Response::value() const {
+  if (!m_data) return QVariant();
+
+  return m_data->variant();
+}
 
 RedisClient::Response::Type RedisClient::Response::type() const {
   return m_type;
 }
 
+RedisClient::ResponseView RedisClient::Response::view() const {
+  return ResponseView(m_data, 0);
+}
+
+int RedisClient::Response::arraySize() const { return view().arraySize(); }
+
+RedisClient::ResponseView RedisClient::Response::at(int i) const {
+  return view().at(i);
+}
+
+QByteArray RedisClient::Response::asBytes() const { return view().asBytes(); }
+
+qint64 RedisClient::Response::approximateSize() const {
+  if (!m_data) return sizeof(Response);
+
+  return sizeof(Response) + sizeof(ReplyData) + m_data->payload.size() +
+         m_data->nodes.size() * sizeof(ReplyNode) +
+         m_data->children.size() * sizeof(int);
+}
+
 bool RedisClient::Response::isValid() { return m_type != Type::Unknown; }
 
 bool RedisClient::Response::isMessage() const {
-  if (!isArray()) return false;
+  if (m_type != Type::Array && m_type != Type::Push) return false;
 
-  QVariantList result = m_result.toList();
+  if (arraySize() < 3) return false;
 
-  return result.size() >= 3 &&
-         (result[0] == "message" || result[0] == "pmessage");
-}
+  QByteArray type = at(0).asBytes();
 
-bool RedisClient::Response::isArray() const {
-  return m_result.isValid() && m_result.canConvert(QMetaType::QVariantList);
+  return type == "message" || type == "smessage" ||
+         (type == "pmessage" && arraySize() >= 4);
 }
 
+bool RedisClient::Response::isArray() const { return view().isArray(); }
+
+bool RedisClient::Response::isMap() const { return m_type == Type::Map; }
+
+bool RedisClient::Response::isPush() const { return m_type == Type::Push; }
+
 bool RedisClient::Response::isValidScanResponse() const {
-  if (!isArray()) return false;
+  if (arraySize() != 2) return false;
 
-  QVariantList result = m_result.toList();
+  ResponseView cursor = at(0);
+  ResponseView collection = at(1);
 
-  return result.size() == 2 && result.at(0).canConvert(QMetaType::QString) &&
-         (result.at(1).canConvert(QMetaType::QVariantList) || result.at(1).isNull());
+  return !cursor.isNil() && !cursor.isArray() &&
+         (collection.isArray() || collection.isNil());
 }
 
 long long RedisClient::Response::getCursor() {
   if (!isArray()) return -1;
 
-  QVariantList result = m_result.toList();
-
-  return result.at(0).toLongLong();
+  return at(0).toInteger();
 }
 
 QVariantList RedisClient::Response::getCollection() {
   if (!isArray()) return QVariantList();
 
-  QVariantList result = m_result.toList();
-
-  return result.at(1).toList();
+  return at(1).toVariant().toList();
 }
 
 bool RedisClient::Response::isAskRedirect() const {
-  return m_type == Type::Error && m_result.toByteArray().startsWith("ASK");
+  return m_type == Type::Error && asBytes().startsWith("ASK");
 }
 
 bool RedisClient::Response::isMovedRedirect() const {
-  return m_type == Type::Error && m_result.toByteArray().startsWith("MOVED");
+  return m_type == Type::Error && asBytes().startsWith("MOVED");
 }
 
 QByteArray RedisClient::Response::getRedirectionHost() const {
   if (!isMovedRedirect() && !isAskRedirect()) return QByteArray();
 
-  QByteArray hostAndPort = m_result.toByteArray().split(' ')[2];
+  QByteArray hostAndPort = asBytes().split(' ')[2];
 
   return hostAndPort.split(':')[0];
 }
@@ -81,7 +225,7 @@ QByteArray RedisClient::Response::getRedirectionHost() const {
 uint RedisClient::Response::getRedirectionPort() const {
   if (!isMovedRedirect() && !isAskRedirect()) return 0;
 
-  QByteArray hostAndPort = m_result.toByteArray().split(' ')[2];
+  QByteArray hostAndPort = asBytes().split(' ')[2];
 
   return QString(hostAndPort.split(':')[1]).toUInt();
 }
@@ -89,9 +233,20 @@ uint RedisClient::Response::getRedirectionPort() const {
 QByteArray RedisClient::Response::getChannel() const {
   if (!isMessage()) return QByteArray{};
 
-  QVariantList result = m_result.toList();
+  // pmessage: pattern, channel, payload
+  return at(arraySize() - 2).toByteArray();
+}
+
+QByteArray RedisClient::Response::getPattern() const {
+  if (!isMessage() || arraySize() < 4) return QByteArray{};
+
+  return at(1).toByteArray();
+}
+
+QByteArray RedisClient::Response::getPayload() const {
+  if (!isMessage()) return QByteArray{};
 
-  return result[1].toByteArray();
+  return at(arraySize() - 1).asBytes();
 }
 
 QString RedisClient::Response::valueToHumanReadString(const QVariant& value,
@@ -135,20 +290,26 @@ bool RedisClient::Response::isErrorMessage() const {
 }
 
 bool RedisClient::Response::isErrorStateMessage() const {
-  return m_type == Type::Error &&
-         (m_result.toByteArray().startsWith("DENIED") ||
-          m_result.toByteArray().startsWith("LOADING") ||
-          m_result.toByteArray().startsWith("MISCONF"));
+  if (m_type != Type::Error) return false;
+
+  QByteArray error = asBytes();
+
+  return error.startsWith("DENIED") || error.startsWith("LOADING") ||
+         error.startsWith("MISCONF");
 }
 
 bool RedisClient::Response::isDisabledCommandErrorMessage() const {
-  return isErrorMessage() && m_result.toByteArray().contains("unknown command");
+  return isErrorMessage() && asBytes().contains("unknown command");
+}
+
+bool RedisClient::Response::isNoScriptErrorMessage() const {
+  return isErrorMessage() && asBytes().startsWith("NOSCRIPT");
 }
 
 bool RedisClient::Response::isOkMessage() const {
-  return m_type == Type::Status && m_result.toByteArray().startsWith("OK");
+  return m_type == Type::Status && asBytes().startsWith("OK");
 }
 
 bool RedisClient::Response::isQueuedMessage() const {
-  return m_type == Type::Status && m_result.toByteArray().startsWith("QUEUED");
+  return m_type == Type::Status && asBytes().startsWith("QUEUED");
 }
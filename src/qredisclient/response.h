@@ -12,30 +12,130 @@ struct redisReadTask;
 struct redisReplyObjectFunctions;
 
 namespace RedisClient {
+
+struct ReplyData;
+
+/**
+ * @brief The ResponseView class
+ * Lightweight accessor to an element of the reply.
+ * Views are valid as long as source Response exists.
+ */
+class ResponseView {
+ public:
+  ResponseView();
+  ResponseView(QSharedPointer<const ReplyData> data, int node);
+
+  bool isValid() const;
+  int type() const;
+  bool isNil() const;
+
+  /**
+   * @brief Array, RESP3 set or push frame
+   */
+  bool isArray() const;
+  bool isMap() const;
+
+  /**
+   * @brief Any element with nested elements (array, set, map, push)
+   */
+  bool isAggregate() const;
+
+  /**
+   * @brief Number of nested elements if view points to aggregate.
+   * Maps are represented as flat list of keys and values, so
+   * arraySize() of map is twice the number of its entries.
+   */
+  int arraySize() const;
+  ResponseView at(int i) const;
+
+  /**
+   * @brief Raw bytes of string element without copying.
+   * Returned QByteArray shares memory with the reply, so it shouldn't
+   * outlive source Response. Use toByteArray() to get a deep copy.
+   */
+  QByteArray asBytes() const;
+  QByteArray toByteArray() const;
+  qint64 toInteger() const;
+  double toDouble() const;
+  bool toBool() const;
+  QVariant toVariant() const;
+
+ private:
+  QSharedPointer<const ReplyData> m_data;
+  int m_node;
+};
+
 class Response {
   ADD_EXCEPTION
 
  public:
-  enum Type { String = 1, Array, Integer, Nil, Status, Error, Unknown };
+  /*
+   * Values match reply types of hiredis reader.
+   * RESP3 types are available on connections with protocolVersion() == 3
+   */
+  enum Type {
+    String = 1,
+    Array = 2,
+    Integer = 3,
+    Nil = 4,
+    Status = 5,
+    Error = 6,
+    Double = 7,
+    Boolean = 8,
+    Map = 9,
+    Set = 10,
+    Attribute = 11,
+    Push = 12,
+    BigNumber = 13,
+    Verbatim = 14,
+    Unknown = 15
+  };
 
  public:
   Response();
   Response(Response::Type, const QVariant &);
+  Response(QSharedPointer<const ReplyData> data);
 
   virtual ~Response(void);
 
+  /**
+   * @brief QVariant representation of the reply.
+   * Conversion is done on first call and cached, prefer typed accessors
+   * (arraySize(), at(), asBytes()) on hot paths.
+   */
   QVariant value() const;
   Type type() const;
 
+  /*
+   * Typed accessors
+   */
+  ResponseView view() const;
+  int arraySize() const;
+  ResponseView at(int i) const;
+  QByteArray asBytes() const;
+
+  /**
+   * @brief Approximate memory used by the reply in bytes
+   */
+  qint64 approximateSize() const;
+
   bool isEmpty() const;
   bool isErrorMessage() const;
   bool isErrorStateMessage() const;
   bool isDisabledCommandErrorMessage() const;
+  bool isNoScriptErrorMessage() const;
   bool isOkMessage() const;
   bool isQueuedMessage() const;
   bool isValid();
   bool isMessage() const;
   bool isArray() const;
+  bool isMap() const;
+
+  /**
+   * @brief Out-of-band RESP3 push frame (pub/sub messages,
+   * client tracking invalidations etc.)
+   */
+  bool isPush() const;
 
   // Scan response
   bool isValidScanResponse() const;
@@ -43,8 +143,23 @@ class Response {
   QVariantList getCollection();
 
   // Pub/Sub support
+  /**
+   * @brief Channel of message, pmessage or smessage
+   */
   QByteArray getChannel() const;
 
+  /**
+   * @brief Pattern of pmessage
+   */
+  QByteArray getPattern() const;
+
+  /**
+   * @brief Message payload without copying.
+   * Returned QByteArray shares memory with the reply, so it shouldn't
+   * outlive source Response.
+   */
+  QByteArray getPayload() const;
+
   // Cluster support
   bool isAskRedirect() const;
   bool isMovedRedirect() const;
@@ -55,6 +170,6 @@ class Response {
 
  protected:
   Type m_type;
-  QVariant m_result;
+  QSharedPointer<const ReplyData> m_data;
 };
 }  // namespace RedisClient
@@ -0,0 +1,243 @@
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QVector>
+#include <limits>
+#include "response.h"
+
+namespace RedisClient {
+
+/**
+ * @brief The ResponseDecoder struct
+ * Compile-time typed decoding of replies. Values are read directly from
+ * flat reply storage, QVariant tree is never built.
+ * Supported types: QByteArray, QString, qint64, int, double, bool,
+ * QVector<T>, QList<T>, QHash<K, V> and QMap<K, V>. Maps are decoded from
+ * RESP3 maps and from flat arrays of keys and values (e.g. HGETALL on
+ * RESP2). Nil is decoded into default-constructed value.
+ * Specialize ResponseDecoder to support custom types.
+ */
+template <typename T>
+struct ResponseDecoder;
+
+/**
+ * @brief Decode reply element into result
+ * @return false if reply doesn't match T, e.g. array is decoded as integer
+ */
+template <typename T>
+inline bool decode(const ResponseView& view, T& result) {
+  return ResponseDecoder<T>::decode(view, result);
+}
+
+/**
+ * @brief Decode reply, throws Response::Exception on type mismatch
+ */
+template <typename T>
+inline T decode(const Response& response) {
+  T result;
+
+  if (!decode(response.view(), result))
+    throw Response::Exception("Cannot decode reply: unexpected reply type");
+
+  return result;
+}
+
+inline bool isStringReply(int type) {
+  return type == Response::String || type == Response::Status ||
+         type == Response::Verbatim || type == Response::BigNumber ||
+         type == Response::Double;
+}
+
+template <>
+struct ResponseDecoder<QByteArray> {
+  static bool decode(const ResponseView& view, QByteArray& result) {
+    if (view.isNil()) {
+      result = QByteArray();
+      return true;
+    }
+
+    if (!isStringReply(view.type())) return false;
+
+    // Deep copy, so value can outlive reply
+    result = view.toByteArray();
+    return true;
+  }
+};
+
+template <>
+struct ResponseDecoder<QString> {
+  static bool decode(const ResponseView& view, QString& result) {
+    if (view.isNil()) {
+      result = QString();
+      return true;
+    }
+
+    if (!isStringReply(view.type())) return false;
+
+    result = QString::fromUtf8(view.asBytes());
+    return true;
+  }
+};
+
+template <>
+struct ResponseDecoder<qint64> {
+  static bool decode(const ResponseView& view, qint64& result) {
+    if (view.isNil()) {
+      result = 0;
+      return true;
+    }
+
+    if (view.type() == Response::Integer || view.type() == Response::Boolean) {
+      result = view.toInteger();
+      return true;
+    }
+
+    // Numbers in bulk strings, e.g. INCRBYFLOAT or CONFIG GET
+    if (!isStringReply(view.type())) return false;
+
+    bool ok = false;
+    result = view.asBytes().toLongLong(&ok);
+    return ok;
+  }
+};
+
+template <>
+struct ResponseDecoder<int> {
+  static bool decode(const ResponseView& view, int& result) {
+    qint64 value = 0;
+
+    if (!RedisClient::decode(view, value) ||
+        value < std::numeric_limits<int>::min() ||
+        value > std::numeric_limits<int>::max())
+      return false;
+
+    result = static_cast<int>(value);
+    return true;
+  }
+};
+
+template <>
+struct ResponseDecoder<double> {
+  static bool decode(const ResponseView& view, double& result) {
+    if (view.isNil()) {
+      result = 0.0;
+      return true;
+    }
+
+    if (view.type() == Response::Integer) {
+      result = static_cast<double>(view.toInteger());
+      return true;
+    }
+
+    if (view.type() == Response::Double) {
+      result = view.toDouble();
+      return true;
+    }
+
+    if (!isStringReply(view.type())) return false;
+
+    bool ok = false;
+    result = view.asBytes().toDouble(&ok);
+    return ok;
+  }
+};
+
+template <>
+struct ResponseDecoder<bool> {
+  static bool decode(const ResponseView& view, bool& result) {
+    if (view.isNil()) {
+      result = false;
+      return true;
+    }
+
+    if (view.type() != Response::Integer && view.type() != Response::Boolean)
+      return false;
+
+    result = view.toInteger() != 0;
+    return true;
+  }
+};
+
+template <typename T>
+struct ResponseArrayDecoder {
+  template <typename Container>
+  static bool decode(const ResponseView& view, Container& result) {
+    result.clear();
+
+    if (view.isNil()) return true;
+    if (!view.isArray()) return false;
+
+    int size = view.arraySize();
+    result.reserve(size);
+
+    for (int i = 0; i < size; ++i) {
+      T item;
+      if (!RedisClient::decode(view.at(i), item)) return false;
+      result.append(item);
+    }
+
+    return true;
+  }
+};
+
+template <typename T>
+struct ResponseDecoder<QVector<T>> {
+  static bool decode(const ResponseView& view, QVector<T>& result) {
+    return ResponseArrayDecoder<T>::decode(view, result);
+  }
+};
+
+template <typename T>
+struct ResponseDecoder<QList<T>> {
+  static bool decode(const ResponseView& view, QList<T>& result) {
+    return ResponseArrayDecoder<T>::decode(view, result);
+  }
+};
+
+template <typename K, typename V>
+struct ResponseMapDecoder {
+  template <typename Container>
+  static bool decode(const ResponseView& view, Container& result) {
+    result.clear();
+
+    if (view.isNil()) return true;
+
+    // Maps are stored as flat list of keys and values too
+    if (!view.isMap() && !view.isArray()) return false;
+
+    int size = view.arraySize();
+    if (size % 2 != 0) return false;
+
+    for (int i = 0; i < size; i += 2) {
+      K key;
+      V value;
+
+      if (!RedisClient::decode(view.at(i), key) ||
+          !RedisClient::decode(view.at(i + 1), value))
+        return false;
+
+      result.insert(key, value);
+    }
+
+    return true;
+  }
+};
+
+template <typename K, typename V>
+struct ResponseDecoder<QHash<K, V>> {
+  static bool decode(const ResponseView& view, QHash<K, V>& result) {
+    return ResponseMapDecoder<K, V>::decode(view, result);
+  }
+};
+
+template <typename K, typename V>
+struct ResponseDecoder<QMap<K, V>> {
+  static bool decode(const ResponseView& view, QMap<K, V>& result) {
+    return ResponseMapDecoder<K, V>::decode(view, result);
+  }
+};
+
+}  // namespace RedisClient
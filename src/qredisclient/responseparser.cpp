@@ -1,12 +1,19 @@
 #include "responseparser.h"
 #include <hiredis/read.h>
+#include <hiredis/sds.h>
 #include <QDebug>
+#include <cstring>
 #include "private/parsedresponse.h"
+#include "private/parsingarena.h"
+#include "private/replydata.h"
 #include "response.h"
 
 RedisClient::ResponseParser::ResponseParser()
-    : m_redisReader(
-          QSharedPointer<redisReader>(redisReaderCreate(), redisReaderFree)) {}
+    : m_arena(new ParsingArena()),
+      m_redisReader(QSharedPointer<redisReader>(
+          redisReaderCreate(m_arena.data()), redisReaderFree)),
+      m_replyAllocations(0),
+      m_maxBufferSize(0) {}
 
 QByteArray RedisClient::ResponseParser::buffer() const {
   return QByteArray(m_redisReader.data()->buf, m_redisReader.data()->len);
@@ -23,9 +30,69 @@ bool RedisClient::ResponseParser::feedBuffer(const QByteArray& b) {
     return false;
   }
 
+  if (isBufferLimitExceeded()) {
+    qDebug() << "hiredis buffer exceeds max size:"
+             << m_redisReader->len - m_redisReader->pos;
+    return false;
+  }
+
+  return true;
+}
+
+char* RedisClient::ResponseParser::prepareWrite(qint64 size) {
+  redisReader* r = m_redisReader.data();
+
+  if (r->err || size <= 0) return nullptr;
+
+  if (r->pos > 0 && sdsavail(r->buf) < static_cast<size_t>(size)) {
+    sdsrange(r->buf, r->pos, -1);
+    r->pos = 0;
+    r->len = sdslen(r->buf);
+  }
+
+  // Same as redisReaderFeed(): release buffer grown by large reply
+  if (r->len == 0 && r->maxbuf != 0 && sdsavail(r->buf) > r->maxbuf) {
+    sdsfree(r->buf);
+    r->buf = sdsempty();
+    r->pos = 0;
+
+    if (!r->buf) return nullptr;
+  }
+
+  sds buf = sdsMakeRoomFor(r->buf, static_cast<size_t>(size));
+
+  if (!buf) return nullptr;
+
+  r->buf = buf;
+  return r->buf + r->len;
+}
+
+bool RedisClient::ResponseParser::commitWrite(qint64 size) {
+  redisReader* r = m_redisReader.data();
+
+  if (size <= 0) return true;
+
+  sdsIncrLen(r->buf, static_cast<int>(size));
+  r->len = sdslen(r->buf);
+
+  if (isBufferLimitExceeded()) {
+    qDebug() << "hiredis buffer exceeds max size:" << r->len - r->pos;
+    return false;
+  }
+
   return true;
 }
 
+void RedisClient::ResponseParser::setMaxBufferSize(qint64 bytes) {
+  m_maxBufferSize = bytes;
+}
+
+bool RedisClient::ResponseParser::isBufferLimitExceeded() const {
+  return m_maxBufferSize > 0 &&
+         static_cast<qint64>(m_redisReader->len - m_redisReader->pos) >
+             m_maxBufferSize;
+}
+
 RedisClient::Response RedisClient::ResponseParser::getNextResponse() {
   if (!hasUnusedBuffer()) return Response();
 
@@ -39,22 +106,51 @@ RedisClient::Response RedisClient::ResponseParser::getNextResponse() {
     //                                        m_redisReader.data()->len);
     //    qDebug() << "all buffer:" << m_responseSource;
 
-    if (replyPtr) delete replyPtr;
+    m_arena->reset();
 
     return RedisClient::Response();
   }
 
   if (!replyPtr) return RedisClient::Response();
 
-  QScopedPointer<ParsingResult> reply(replyPtr);
+  // Attributes are not supported yet, skip them
+  if (replyPtr->type == Response::Attribute) {
+    m_arena->reset();
+    return getNextResponse();
+  }
 
-  return reply->toResponse();
+  // Reply is complete at this point, so hiredis doesn't hold
+  // any nodes from the arena and it can be released at once
+  QSharedPointer<ReplyData> data = ReplyData::fromParsingResult(replyPtr);
+  m_replyAllocations += data->allocations();
+  m_arena->reset();
+
+  RedisClient::Response response(data);
+
+  return response;
 }
 
 void RedisClient::ResponseParser::reset() {
   m_buffer.clear();
-  m_redisReader =
-      QSharedPointer<redisReader>(redisReaderCreate(), redisReaderFree);
+  m_redisReader = QSharedPointer<redisReader>(
+      redisReaderCreate(m_arena.data()), redisReaderFree);
+  m_arena->reset();
+}
+
+uint RedisClient::ResponseParser::arenaBlocksAllocated() const {
+  return m_arena->blocksAllocated();
+}
+
+quint64 RedisClient::ResponseParser::replyAllocations() const {
+  return m_replyAllocations + m_arena->blocksAllocated();
+}
+
+bool RedisClient::ResponseParser::isResp3Supported() {
+#ifdef REDIS_REPLY_MAP
+  return true;
+#else
+  return false;
+#endif
 }
 
 bool RedisClient::ResponseParser::hasUnusedBuffer() const {
@@ -72,31 +168,55 @@ QByteArray RedisClient::ResponseParser::unusedBuffer() {
  * Parsing
  **/
 
+#ifdef REDIS_REPLY_MAP
+// hiredis >= 1.0 with RESP3 support
 const redisReplyObjectFunctions RedisClient::ResponseParser::defaultFunctions =
     {RedisClient::ResponseParser::createStringObject,
      RedisClient::ResponseParser::createArrayObject,
      RedisClient::ResponseParser::createIntegerObject,
+     RedisClient::ResponseParser::createDoubleObject,
+     RedisClient::ResponseParser::createNilObject,
+     RedisClient::ResponseParser::createBoolObject,
+     RedisClient::ResponseParser::freeObject};
+#else
+// RESP2-only hiredis
+const redisReplyObjectFunctions RedisClient::ResponseParser::defaultFunctions =
+    {RedisClient::ResponseParser::createStringObject,
+     RedisClient::ResponseParser::createLegacyArrayObject,
+     RedisClient::ResponseParser::createIntegerObject,
      RedisClient::ResponseParser::createNilObject,
      RedisClient::ResponseParser::freeObject};
+#endif
 
-redisReader* RedisClient::ResponseParser::redisReaderCreate() {
-  return redisReaderCreateWithFunctions(
+redisReader* RedisClient::ResponseParser::redisReaderCreate(
+    ParsingArena* arena) {
+  redisReader* reader = redisReaderCreateWithFunctions(
       const_cast<redisReplyObjectFunctions*>(&defaultFunctions));
+
+  if (reader) reader->privdata = arena;
+
+  return reader;
+}
+
+inline RedisClient::ParsingArena* getArena(const redisReadTask* task) {
+  return static_cast<RedisClient::ParsingArena*>(task->privdata);
 }
 
 void setParent(const redisReadTask* task, RedisClient::ParsingResult* r) {
   auto parent = (RedisClient::ParsingResult*)task->parent->obj;
 
   Q_ASSERT(parent);
-  Q_ASSERT(task->idx < parent->array.size());
+  Q_ASSERT(task->idx < parent->elements);
 
   parent->array[task->idx] = r;
 }
 
 void* RedisClient::ResponseParser::createStringObject(const redisReadTask* task,
                                                       char* str, size_t len) {
-  ParsingResult* s =
-      new ParsingResult(task->type, QVariant(QByteArray(str, len)));
+  ParsingArena* arena = getArena(task);
+  ParsingResult* s = arena->create<ParsingResult>(task->type);
+  s->str = arena->copyString(str, len);
+  s->len = len;
 
   if (task->parent) setParent(task, s);
 
@@ -104,39 +224,64 @@ void* RedisClient::ResponseParser::createStringObject(const redisReadTask* task,
 }
 
 void* RedisClient::ResponseParser::createArrayObject(const redisReadTask* task,
-                                                     int elements) {
-  ParsingResult* arr = new ParsingResult(elements);
+                                                     size_t elements) {
+  ParsingArena* arena = getArena(task);
+  ParsingResult* arr = arena->create<ParsingResult>(task->type);
+  arr->elements = static_cast<int>(elements);
+
+  if (elements > 0) {
+    arr->array = static_cast<ParsingResult**>(arena->allocate(
+        sizeof(ParsingResult*) * elements, alignof(ParsingResult*)));
+    memset(arr->array, 0, sizeof(ParsingResult*) * elements);
+  }
 
   if (task->parent) setParent(task, arr);
 
   return arr;
 }
 
+#ifndef REDIS_REPLY_MAP
+void* RedisClient::ResponseParser::createLegacyArrayObject(
+    const redisReadTask* task, int elements) {
+  return createArrayObject(task, static_cast<size_t>(elements));
+}
+#endif
+
 void* RedisClient::ResponseParser::createIntegerObject(
     const redisReadTask* task, long long value) {
-  ParsingResult* val = new ParsingResult(task->type, QVariant(value));
+  ParsingResult* val = getArena(task)->create<ParsingResult>(task->type);
+  val->integer = value;
 
   if (task->parent) setParent(task, val);
 
   return val;
 }
 
+void* RedisClient::ResponseParser::createDoubleObject(const redisReadTask* task,
+                                                      double, char* str,
+                                                      size_t len) {
+  // Textual form is kept to avoid precision loss on formatting
+  return createStringObject(task, str, len);
+}
+
 void* RedisClient::ResponseParser::createNilObject(const redisReadTask* task) {
-  ParsingResult* nil = new ParsingResult(task->type, QVariant());
+  ParsingResult* nil = getArena(task)->create<ParsingResult>(task->type);
 
   if (task->parent) setParent(task, nil);
 
   return nil;
 }
 
-void RedisClient::ResponseParser::freeObject(void* obj) {
-  if (obj == nullptr) return;
+void* RedisClient::ResponseParser::createBoolObject(const redisReadTask* task,
+                                                    int value) {
+  ParsingResult* val = getArena(task)->create<ParsingResult>(task->type);
+  val->integer = value ? 1 : 0;
 
-  ParsingResult* o = (ParsingResult*)obj;
+  if (task->parent) setParent(task, val);
 
-  for (int index = 0; index < o->array.size(); ++index) {
-    freeObject((void*)o->array[index]);
-  }
+  return val;
+}
 
-  delete o;
+void RedisClient::ResponseParser::freeObject(void*) {
+  // Reply nodes are owned by ParsingArena
 }
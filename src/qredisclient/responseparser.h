@@ -11,6 +11,7 @@ struct redisReplyObjectFunctions;
 namespace RedisClient {
 
 class Response;
+class ParsingArena;
 
 class ResponseParser {
  public:
@@ -18,26 +19,67 @@ class ResponseParser {
 
   QByteArray buffer() const;
   bool feedBuffer(const QByteArray &);
+
+  /**
+   * @brief Writable space of at least size bytes at the end of parser
+   * buffer. Socket data can be read directly into it and committed with
+   * commitWrite(), so it isn't copied before parsing. Consumed data is
+   * discarded in place before buffer grows.
+   * @return nullptr if parser is in error state
+   */
+  char *prepareWrite(qint64 size);
+  bool commitWrite(qint64 size);
+
+  /**
+   * @brief Limit of buffered data which isn't parsed yet, 0 - unlimited.
+   * Parser fails once limit is exceeded.
+   */
+  void setMaxBufferSize(qint64 bytes);
+  bool isBufferLimitExceeded() const;
   bool hasUnusedBuffer() const;
   QByteArray unusedBuffer();
   Response getNextResponse();
   void reset();
 
+  /**
+   * @brief Number of heap blocks allocated for reply nodes
+   */
+  uint arenaBlocksAllocated() const;
+
+  /**
+   * @brief Number of heap allocations made for parsed replies,
+   * including arena blocks
+   */
+  quint64 replyAllocations() const;
+
+  /**
+   * @brief RESP3 types are parsed only if library is built
+   * against hiredis >= 1.0
+   */
+  static bool isResp3Supported();
+
  protected:
+  QSharedPointer<ParsingArena> m_arena;
   QSharedPointer<redisReader> m_redisReader;
   QByteArray m_buffer;
+  quint64 m_replyAllocations;
+  qint64 m_maxBufferSize;
 
  private:
   static void *createStringObject(const redisReadTask *task, char *str,
                                   size_t len);
-  static void *createArrayObject(const redisReadTask *t, int elements);
+  static void *createArrayObject(const redisReadTask *t, size_t elements);
+  static void *createLegacyArrayObject(const redisReadTask *t, int elements);
   static void *createIntegerObject(const redisReadTask *task, long long value);
+  static void *createDoubleObject(const redisReadTask *task, double value,
+                                  char *str, size_t len);
   static void *createNilObject(const redisReadTask *task);
+  static void *createBoolObject(const redisReadTask *task, int value);
   static void freeObject(void *obj);
 
   static const redisReplyObjectFunctions defaultFunctions;
 
-  static redisReader *redisReaderCreate(void);
+  static redisReader *redisReaderCreate(ParsingArena *arena);
 };
 
 }  // namespace RedisClient
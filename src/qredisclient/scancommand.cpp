@@ -6,29 +6,68 @@ void RedisClient::ScanCommand::setCursor(long long cursor)
     if (cursor <= 0)
         return;
 
-    if (isKeyScanCommand(m_commandWithArguments[0])) {
-        m_commandWithArguments[1] = QString::number(cursor).toUtf8();
-    } else if (isValueScanCommand(m_commandWithArguments[0])) {
-        m_commandWithArguments[2] = QString::number(cursor).toUtf8();
+    setCursor(QString::number(cursor).toUtf8());
+}
+
+void RedisClient::ScanCommand::setCursor(const QByteArray &cursor)
+{
+    int index = cursorIndex();
+
+    if (index < 0 || index >= m_data->m_commandWithArguments.size())
+        return;
+
+    m_data->m_commandWithArguments[index] = cursor;
+}
+
+void RedisClient::ScanCommand::setCount(uint count)
+{
+    int index = countIndex();
+
+    if (index < 0) {
+        m_data->m_commandWithArguments << "COUNT" << QByteArray::number(count);
+    } else {
+        m_data->m_commandWithArguments[index] = QByteArray::number(count);
     }
 }
 
+uint RedisClient::ScanCommand::count() const
+{
+    int index = countIndex();
+
+    return index < 0 ? 0 : m_data->m_commandWithArguments.at(index).toUInt();
+}
+
 bool RedisClient::ScanCommand::isValidScanCommand() const
 {
-    auto parts = getSplitedRepresentattion();
+    int size = m_data->m_commandWithArguments.size();
 
-    return (parts.size() > 1 && isKeyScanCommand(parts[0]))
-            || (parts.size() > 2 && isValueScanCommand(parts[0]));
+    return (size > 1 && info().is(CommandInfo::KeyScan))
+            || (size > 2 && info().is(CommandInfo::ValueScan));
 }
 
-bool RedisClient::ScanCommand::isKeyScanCommand(const QString &cmd) const
+int RedisClient::ScanCommand::cursorIndex() const
 {
-    return cmd.toLower() == "scan";
+    if (m_data->m_commandWithArguments.isEmpty())
+        return -1;
+
+    if (info().is(CommandInfo::KeyScan))
+        return 1;
+
+    if (info().is(CommandInfo::ValueScan))
+        return 2;
+
+    return -1;
 }
 
-bool RedisClient::ScanCommand::isValueScanCommand(const QString &cmd) const
+int RedisClient::ScanCommand::countIndex() const
 {
-    return cmd.toLower() == "zscan"
-            || cmd.toLower() == "sscan"
-            || cmd.toLower() == "hscan";
+    const QList<QByteArray> &parts = m_data->m_commandWithArguments;
+
+    // Options follow cursor as name-value pairs
+    for (int i = cursorIndex() + 1; i > 0 && i < parts.size() - 1; i += 2) {
+        if (CommandInfo::nameEquals(parts.at(i), "count"))
+            return i + 1;
+    }
+
+    return -1;
 }
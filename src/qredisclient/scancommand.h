@@ -11,12 +11,23 @@ public:
     ScanCommand(const QList<QByteArray>& cmd) : Command(cmd) {}    
 
     void setCursor(long long cursor);
+    void setCursor(const QByteArray& cursor);
+
+    /**
+     * @brief Replace value of COUNT argument or append it
+     */
+    void setCount(uint count);
+
+    /**
+     * @brief COUNT argument value or 0 if it's not specified
+     */
+    uint count() const;
 
     bool isValidScanCommand() const;
 
 private:
-    bool isKeyScanCommand(const QString& cmd) const;
-    bool isValueScanCommand(const QString& cmd) const;
+    int cursorIndex() const;
+    int countIndex() const;
 };
 
 }
@@ -0,0 +1,239 @@
+#include "scaniterator.h"
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QQueue>
+#include "connection.h"
+
+namespace {
+// Avoid oscillation of COUNT on latency spikes
+const double MAX_COUNT_GROWTH = 2.0;
+const double MAX_COUNT_SHRINK = 0.5;
+}  // namespace
+
+struct RedisClient::ScanIterator::State {
+  State(const ScanCommand &c)
+      : cmd(c),
+        count(0),
+        generation(0),
+        inFlight(false),
+        serverFinished(false),
+        done(false) {}
+
+  QPointer<Connection> connection;
+  ScanCommand cmd;
+  Options options;
+  QByteArray cursor;
+  uint count;
+
+  QQueue<Page> pages;
+  PageCallback waiting;
+  QString error;
+
+  // Replies for requests sent before reset() are ignored
+  quint64 generation;
+  bool inFlight;
+  bool serverFinished;
+  bool done;
+};
+
+RedisClient::ScanIterator::Options::Options()
+    : prefetch(1), targetPageLatency(50), minCount(10), maxCount(100000) {}
+
+RedisClient::ScanIterator::ScanIterator(Connection *connection,
+                                        const ScanCommand &cmd,
+                                        const Options &options)
+    : m_state(new State(cmd)) {
+  if (!cmd.isValidScanCommand()) throw Exception("Invalid command");
+
+  m_state->connection = connection;
+  m_state->options = options;
+  m_state->count = qBound(options.minCount, cmd.count() > 0 ? cmd.count() : 10,
+                          options.maxCount);
+  reset();
+}
+
+void RedisClient::ScanIterator::next(PageCallback callback) {
+  QSharedPointer<State> state = m_state;
+
+  if (state->waiting) throw Exception("Previous page is not loaded yet");
+
+  if (!state->pages.isEmpty()) {
+    Page page = state->pages.dequeue();
+    fill(state);
+    return deliver(state, callback, page, QString());
+  }
+
+  if (!state->error.isEmpty() || (state->serverFinished && !state->inFlight))
+    return deliver(state, callback, Page(), state->error);
+
+  if (!state->connection)
+    return deliver(state, callback, Page(),
+                   QString("Cannot load items: connection is closed"));
+
+  state->waiting = callback;
+
+  try {
+    fill(state);
+  } catch (const Connection::Exception &) {
+    state->waiting = nullptr;
+    throw;
+  }
+}
+
+bool RedisClient::ScanIterator::hasNext() const { return !m_state->done; }
+
+bool RedisClient::ScanIterator::isPending() const {
+  return static_cast<bool>(m_state->waiting);
+}
+
+void RedisClient::ScanIterator::reset() {
+  if (m_state->waiting) throw Exception("Previous page is not loaded yet");
+
+  m_state->generation++;
+  m_state->cursor = "0";
+  m_state->pages.clear();
+  m_state->error.clear();
+  m_state->inFlight = false;
+  m_state->serverFinished = false;
+  m_state->done = false;
+}
+
+uint RedisClient::ScanIterator::count() const { return m_state->count; }
+
+void RedisClient::ScanIterator::fill(QSharedPointer<State> state) {
+  if (state->inFlight || state->serverFinished || !state->error.isEmpty() ||
+      !state->connection)
+    return;
+
+  bool consumerWaits = state->waiting && state->pages.isEmpty();
+
+  if (!consumerWaits &&
+      static_cast<uint>(state->pages.size()) >= state->options.prefetch)
+    return;
+
+  requestPage(state);
+}
+
+void RedisClient::ScanIterator::requestPage(QSharedPointer<State> state) {
+  ScanCommand cmd = state->cmd;
+  cmd.setCursor(state->cursor);
+  cmd.setCount(state->count);
+
+  quint64 generation = state->generation;
+  QSharedPointer<QElapsedTimer> timer(new QElapsedTimer());
+
+  cmd.setCallBack(state->connection.data(), [state, generation, timer](
+                                                Response r, QString err) {
+    if (generation != state->generation) return;
+
+    processPage(state, r, err, timer->elapsed());
+  });
+
+  state->inFlight = true;
+  timer->start();
+
+  try {
+    state->connection->runCommand(cmd);
+  } catch (const Connection::Exception &) {
+    state->inFlight = false;
+    throw;
+  }
+}
+
+void RedisClient::ScanIterator::processPage(QSharedPointer<State> state,
+                                            const Response &r,
+                                            const QString &err,
+                                            qint64 elapsed) {
+  state->inFlight = false;
+
+  Page page;
+
+  if (!err.isEmpty()) {
+    state->error = QString("Cannot load items: %1").arg(err);
+  } else if (r.isDisabledCommandErrorMessage() &&
+             state->cmd.getPartAsString(0).toLower() == "scan") {
+    // aliyun cloud provides iscan command for scanning clusters
+    QList<QByteArray> rawCmd = state->cmd.getSplitedRepresentattion();
+    rawCmd.replace(0, "ISCAN");
+    state->cmd = ScanCommand(rawCmd, state->cmd.getDbIndex());
+
+    try {
+      return requestPage(state);
+    } catch (const Connection::Exception &e) {
+      state->error = QString("Cannot load items: %1").arg(e.what());
+    }
+  } else if (r.isErrorMessage()) {
+    state->error = QString("Cannot load items: %1")
+                       .arg(QString::fromUtf8(r.asBytes()));
+  } else if (!r.isValidScanResponse()) {
+    state->serverFinished = true;
+  } else {
+    adaptCount(state, elapsed);
+
+    ResponseView items = r.at(1);
+    page.reserve(items.arraySize());
+
+    for (int i = 0; i < items.arraySize(); ++i)
+      page.append(items.at(i).toByteArray());
+
+    state->cursor = r.at(0).toByteArray();
+    state->serverFinished = state->cursor == "0";
+  }
+
+  if (!state->waiting) {
+    if (state->error.isEmpty()) state->pages.enqueue(page);
+  } else {
+    PageCallback callback = state->waiting;
+    state->waiting = nullptr;
+
+    // Request next cursor before consumer processes current page
+    try {
+      fill(state);
+    } catch (const Connection::Exception &e) {
+      state->error = QString("Cannot load items: %1").arg(e.what());
+    }
+
+    return deliver(state, callback, page, state->error);
+  }
+
+  try {
+    fill(state);
+  } catch (const Connection::Exception &e) {
+    state->error = QString("Cannot load items: %1").arg(e.what());
+  }
+}
+
+void RedisClient::ScanIterator::adaptCount(QSharedPointer<State> state,
+                                           qint64 elapsed) {
+  const Options &options = state->options;
+
+  if (options.targetPageLatency == 0) return;
+
+  double factor = elapsed > 0
+                      ? static_cast<double>(options.targetPageLatency) / elapsed
+                      : MAX_COUNT_GROWTH;
+
+  factor = qBound(MAX_COUNT_SHRINK, factor, MAX_COUNT_GROWTH);
+
+  double count = state->count * factor;
+
+  state->count = static_cast<uint>(
+      qBound<double>(options.minCount, count, options.maxCount));
+}
+
+bool RedisClient::ScanIterator::isFinal(QSharedPointer<State> state) {
+  // Error is reported after prefetched pages
+  if (!state->error.isEmpty()) return state->pages.isEmpty();
+
+  return state->serverFinished && !state->inFlight && state->pages.isEmpty();
+}
+
+void RedisClient::ScanIterator::deliver(QSharedPointer<State> state,
+                                        PageCallback callback,
+                                        const Page &page, const QString &err) {
+  bool final = isFinal(state);
+
+  if (final) state->done = true;
+
+  callback(page, err, final);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <QByteArray>
+#include <QList>
+#include <QSharedPointer>
+#include <functional>
+#include "exception.h"
+#include "scancommand.h"
+
+namespace RedisClient {
+
+class Connection;
+
+/**
+ * @brief The ScanIterator class
+ * Streams pages of SCAN, HSCAN, SSCAN or ZSCAN replies.
+ * Next cursor is requested as soon as reply is parsed, before page is
+ * passed to consumer, so up to Options::prefetch pages are loaded ahead
+ * of consumer. COUNT is adjusted after each page to keep
+ * SCAN latency close to Options::targetPageLatency.
+ * Copies of iterator share cursor.
+ */
+class ScanIterator {
+  ADD_EXCEPTION
+
+ public:
+  typedef QList<QByteArray> Page;
+
+  /**
+   * @brief PageCallback
+   * @param items - keys or flat list of value scan items from a single reply
+   * @param err - error message, iteration stops on error
+   * @param final - true if there are no more pages. Last page can be empty.
+   */
+  typedef std::function<void(const Page &items, const QString &err,
+                             bool final)>
+      PageCallback;
+
+  struct Options {
+    Options();
+
+    uint prefetch;           // pages loaded ahead, 0 - load on demand only
+    uint targetPageLatency;  // in ms, 0 disables adaptive COUNT
+    uint minCount;
+    uint maxCount;
+  };
+
+ public:
+  /**
+   * @brief ScanIterator
+   * @param connection
+   * @param cmd - scan command, COUNT argument is used as initial COUNT
+   * @param options
+   */
+  ScanIterator(Connection *connection, const ScanCommand &cmd,
+               const Options &options = Options());
+
+  /**
+   * @brief Request next page. Only one page can be requested at a time.
+   * Callback is called in the thread of connection or immediately if
+   * page is already loaded.
+   */
+  void next(PageCallback callback);
+
+  bool hasNext() const;
+
+  /**
+   * @brief Consumer waits for page
+   */
+  bool isPending() const;
+
+  /**
+   * @brief Start iteration from the first page. Prefetched pages are dropped.
+   */
+  void reset();
+
+  /**
+   * @brief COUNT which will be used for next page
+   */
+  uint count() const;
+
+ private:
+  struct State;
+  static void fill(QSharedPointer<State> state);
+  static void requestPage(QSharedPointer<State> state);
+  static void processPage(QSharedPointer<State> state, const Response &r,
+                          const QString &err, qint64 elapsed);
+  static void adaptCount(QSharedPointer<State> state, qint64 elapsed);
+  static bool isFinal(QSharedPointer<State> state);
+  static void deliver(QSharedPointer<State> state, PageCallback callback,
+                      const Page &page, const QString &err);
+
+ private:
+  QSharedPointer<State> m_state;
+};
+
+}  // namespace RedisClient
@@ -0,0 +1,50 @@
+#include "scriptcache.h"
+#include <QCryptographicHash>
+#include <QMutexLocker>
+
+QByteArray RedisClient::ScriptCache::sha1(const QByteArray &body) {
+  return QCryptographicHash::hash(body, QCryptographicHash::Sha1).toHex();
+}
+
+QByteArray RedisClient::ScriptCache::add(const QByteArray &name,
+                                         const QByteArray &body) {
+  Script s;
+  s.name = name;
+  s.body = body;
+  s.sha1 = sha1(body);
+
+  QMutexLocker lock(&m_lock);
+  m_scripts.insert(name, s);
+  return s.sha1;
+}
+
+RedisClient::ScriptCache::Script RedisClient::ScriptCache::script(
+    const QByteArray &name) const {
+  QMutexLocker lock(&m_lock);
+  return m_scripts.value(name);
+}
+
+QList<RedisClient::ScriptCache::Script> RedisClient::ScriptCache::scripts()
+    const {
+  QMutexLocker lock(&m_lock);
+  return m_scripts.values();
+}
+
+bool RedisClient::ScriptCache::isLoaded(const QByteArray &sha1) const {
+  QMutexLocker lock(&m_lock);
+  return m_loaded.contains(sha1);
+}
+
+void RedisClient::ScriptCache::setLoaded(const QByteArray &sha1, bool loaded) {
+  QMutexLocker lock(&m_lock);
+
+  if (loaded)
+    m_loaded.insert(sha1);
+  else
+    m_loaded.remove(sha1);
+}
+
+void RedisClient::ScriptCache::resetLoaded() {
+  QMutexLocker lock(&m_lock);
+  m_loaded.clear();
+}
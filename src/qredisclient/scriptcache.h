@@ -0,0 +1,65 @@
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+
+namespace RedisClient {
+
+/**
+ * @brief The ScriptCache class
+ * Registry of lua scripts executed with EVALSHA.
+ * SHA1 digests are calculated on client side, so script body is sent to
+ * redis-server only once per connection with SCRIPT LOAD.
+ * Cache is thread-safe: scripts are loaded from callbacks in the thread
+ * of command owner.
+ */
+class ScriptCache {
+ public:
+  struct Script {
+    QByteArray name;
+    QByteArray body;
+    QByteArray sha1;
+
+    bool isValid() const { return !sha1.isEmpty(); }
+  };
+
+ public:
+  /**
+   * @brief SHA1 digest of lua script as calculated by redis-server
+   * @return Lowercase hex string
+   */
+  static QByteArray sha1(const QByteArray& body);
+
+  /**
+   * @brief Register script. Script with the same name is replaced.
+   * @return SHA1 digest of script
+   */
+  QByteArray add(const QByteArray& name, const QByteArray& body);
+
+  /**
+   * @brief Find script by name
+   * @return Invalid script if script is not registered
+   */
+  Script script(const QByteArray& name) const;
+  QList<Script> scripts() const;
+
+  /**
+   * @brief Script is loaded to script cache of current redis-server
+   */
+  bool isLoaded(const QByteArray& sha1) const;
+  void setLoaded(const QByteArray& sha1, bool loaded = true);
+
+  /**
+   * @brief Forget loaded scripts after reconnect or failover
+   */
+  void resetLoaded();
+
+ private:
+  mutable QMutex m_lock;
+  QHash<QByteArray, Script> m_scripts;
+  QSet<QByteArray> m_loaded;
+};
+
+}  // namespace RedisClient
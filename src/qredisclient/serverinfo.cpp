@@ -0,0 +1,287 @@
+#include "serverinfo.h"
+#include <QMutexLocker>
+#include <cstring>
+
+namespace {
+struct NumericField {
+  const char *name;
+  qint64 RedisClient::ServerInfo::*member;
+};
+
+const NumericField NUMERIC_FIELDS[] = {
+    {"uptime_in_seconds", &RedisClient::ServerInfo::uptimeInSeconds},
+    {"connected_clients", &RedisClient::ServerInfo::connectedClients},
+    {"used_memory", &RedisClient::ServerInfo::usedMemory},
+    {"used_memory_peak", &RedisClient::ServerInfo::usedMemoryPeak},
+    {"total_commands_processed",
+     &RedisClient::ServerInfo::totalCommandsProcessed},
+    {"instantaneous_ops_per_sec",
+     &RedisClient::ServerInfo::instantaneousOpsPerSec},
+    {"keyspace_hits", &RedisClient::ServerInfo::keyspaceHits},
+    {"keyspace_misses", &RedisClient::ServerInfo::keyspaceMisses}};
+
+bool equals(const char *begin, const char *end, const char *literal) {
+  size_t length = strlen(literal);
+  return static_cast<size_t>(end - begin) == length &&
+         memcmp(begin, literal, length) == 0;
+}
+
+// Parse leading decimal digits, returns -1 if there are no digits
+qint64 toNumber(const char *begin, const char *end,
+                const char **stop = nullptr) {
+  qint64 result = -1;
+
+  for (; begin < end && *begin >= '0' && *begin <= '9'; ++begin)
+    result = (result < 0 ? 0 : result * 10) + (*begin - '0');
+
+  if (stop) *stop = begin;
+
+  return result;
+}
+
+// Calls f(lineBegin, lineEnd, nextLinePos) for each line without "\r\n"
+template <typename F>
+void forEachLine(const char *raw, int begin, int end, F f) {
+  int pos = begin;
+
+  while (pos < end) {
+    const char *lineBegin = raw + pos;
+    const char *newline =
+        static_cast<const char *>(memchr(lineBegin, '\n', end - pos));
+    const char *lineEnd = newline ? newline : raw + end;
+    int next = newline ? static_cast<int>(newline - raw) + 1 : end;
+
+    if (lineEnd > lineBegin && *(lineEnd - 1) == '\r') --lineEnd;
+
+    f(lineBegin, lineEnd, next);
+    pos = next;
+  }
+}
+
+void parseWellKnownField(RedisClient::ServerInfo &info, const char *key,
+                         const char *keyEnd, const char *value,
+                         const char *valueEnd) {
+  // db0:keys=1,expires=0,avg_ttl=0
+  if (keyEnd - key > 2 && key[0] == 'd' && key[1] == 'b') {
+    const char *stop = nullptr;
+    qint64 dbIndex = toNumber(key + 2, keyEnd, &stop);
+
+    if (dbIndex < 0 || stop != keyEnd || valueEnd - value < 5 ||
+        memcmp(value, "keys=", 5) != 0)
+      return;
+
+    qint64 keys = toNumber(value + 5, valueEnd);
+
+    if (keys >= 0)
+      info.databases.insert(static_cast<int>(dbIndex), static_cast<int>(keys));
+    return;
+  }
+
+  if (equals(key, keyEnd, "redis_version")) {
+    info.versionString = QByteArray(value, static_cast<int>(valueEnd - value));
+
+    // Only major.minor is used for feature checks
+    const char *stop = nullptr;
+    if (toNumber(value, valueEnd, &stop) < 0 || stop == valueEnd ||
+        *stop != '.')
+      return;
+
+    const char *minorEnd = nullptr;
+    if (toNumber(stop + 1, valueEnd, &minorEnd) < 0) return;
+
+    info.version =
+        QByteArray::fromRawData(value, static_cast<int>(minorEnd - value))
+            .toDouble();
+  } else if (equals(key, keyEnd, "redis_mode")) {
+    info.clusterMode = equals(value, valueEnd, "cluster");
+    info.sentinelMode = equals(value, valueEnd, "sentinel");
+  } else if (equals(key, keyEnd, "role")) {
+    info.role = QByteArray(value, static_cast<int>(valueEnd - value));
+  } else {
+    for (const NumericField &field : NUMERIC_FIELDS) {
+      if (!equals(key, keyEnd, field.name)) continue;
+
+      info.*field.member = toNumber(value, valueEnd);
+      return;
+    }
+  }
+}
+}  // namespace
+
+RedisClient::ServerInfo::ServerInfo()
+    : version(0.0),
+      clusterMode(false),
+      sentinelMode(false),
+      uptimeInSeconds(-1),
+      connectedClients(-1),
+      usedMemory(-1),
+      usedMemoryPeak(-1),
+      totalCommandsProcessed(-1),
+      instantaneousOpsPerSec(-1),
+      keyspaceHits(-1),
+      keyspaceMisses(-1) {}
+
+RedisClient::ServerInfo RedisClient::ServerInfo::fromString(
+    const QString &info) {
+  return fromBytes(info.toUtf8());
+}
+
+RedisClient::ServerInfo RedisClient::ServerInfo::fromBytes(
+    const QByteArray &info) {
+  ServerInfo result;
+
+  ParsedServerInfo::Data *data = new ParsedServerInfo::Data();
+  data->raw = info;
+  result.parsed.m_data = data;
+
+  QByteArray currentSection("unknown");
+  int sectionBegin = 0;
+  bool sectionHasFields = false;
+
+  auto closeSection = [&](int end) {
+    if (!sectionHasFields) return;
+
+    if (!data->ranges.contains(currentSection))
+      data->order.append(currentSection);
+
+    data->ranges.insert(currentSection, qMakePair(sectionBegin, end));
+  };
+
+  forEachLine(info.constData(), 0, info.size(),
+              [&](const char *line, const char *lineEnd, int next) {
+                if (line == lineEnd) return;
+
+                if (*line == '#') {
+                  closeSection(static_cast<int>(line - info.constData()));
+
+                  // "# Server" -> "server"
+                  const char *name = line + 1;
+                  while (name < lineEnd && *name == ' ') ++name;
+
+                  currentSection =
+                      QByteArray(name, static_cast<int>(lineEnd - name))
+                          .toLower();
+                  sectionBegin = next;
+                  sectionHasFields = false;
+                  return;
+                }
+
+                const char *separator = static_cast<const char *>(
+                    memchr(line, ':', lineEnd - line));
+
+                if (!separator) return;
+
+                sectionHasFields = true;
+                parseWellKnownField(result, line, separator, separator + 1,
+                                    lineEnd);
+              });
+
+  closeSection(info.size());
+
+  if (result.clusterMode) {
+    result.databases.clear();
+    result.databases.insert(0, 0);
+    return result;
+  } else if (result.sentinelMode) {
+    result.databases.clear();
+    return result;
+  }
+
+  if (result.databases.size() == 0) return result;
+
+  int lastKnownDbIndex = result.databases.lastKey();
+  for (int dbIndex = 0; dbIndex < lastKnownDbIndex; ++dbIndex) {
+    if (!result.databases.contains(dbIndex)) {
+      result.databases.insert(dbIndex, 0);
+    }
+  }
+
+  return result;
+}
+
+RedisClient::ServerInfo::ParsedServerInfo::ParsedServerInfo() {}
+
+QStringList RedisClient::ServerInfo::ParsedServerInfo::sections() const {
+  QStringList result;
+
+  if (!m_data) return result;
+
+  for (const QByteArray &name : m_data->order)
+    result.append(QString::fromUtf8(name));
+
+  return result;
+}
+
+bool RedisClient::ServerInfo::ParsedServerInfo::contains(
+    const QString &section) const {
+  return m_data && m_data->ranges.contains(section.toUtf8());
+}
+
+bool RedisClient::ServerInfo::ParsedServerInfo::isEmpty() const {
+  return !m_data || m_data->ranges.isEmpty();
+}
+
+RedisClient::ServerInfo::ParsedServerInfo::Section
+RedisClient::ServerInfo::ParsedServerInfo::section(const QString &name) const {
+  if (!m_data) return Section();
+
+  QMutexLocker lock(&m_data->lock);
+  return loadSection(name.toUtf8());
+}
+
+QString RedisClient::ServerInfo::ParsedServerInfo::value(
+    const QString &section, const QString &field) const {
+  return this->section(section).value(field);
+}
+
+QVariantMap RedisClient::ServerInfo::ParsedServerInfo::toVariantMap() const {
+  if (!m_data) return QVariantMap();
+
+  QMutexLocker lock(&m_data->lock);
+
+  if (m_data->hasVariantMap) return m_data->variantMap;
+
+  for (const QByteArray &name : m_data->order) {
+    Section s = loadSection(name);
+    QVariantMap properties;
+
+    for (auto it = s.constBegin(); it != s.constEnd(); ++it)
+      properties.insert(it.key(), it.value());
+
+    m_data->variantMap.insert(QString::fromUtf8(name), properties);
+  }
+
+  m_data->hasVariantMap = true;
+  return m_data->variantMap;
+}
+
+RedisClient::ServerInfo::ParsedServerInfo::Section
+RedisClient::ServerInfo::ParsedServerInfo::loadSection(
+    const QByteArray &name) const {
+  auto cached = m_data->sections.constFind(name);
+
+  if (cached != m_data->sections.constEnd()) return cached.value();
+
+  auto range = m_data->ranges.constFind(name);
+
+  if (range == m_data->ranges.constEnd()) return Section();
+
+  Section result;
+
+  forEachLine(m_data->raw.constData(), range->first, range->second,
+              [&result](const char *line, const char *lineEnd, int) {
+                const char *separator = static_cast<const char *>(
+                    memchr(line, ':', lineEnd - line));
+
+                if (!separator) return;
+
+                int keySize = static_cast<int>(separator - line);
+                int valueSize = static_cast<int>(lineEnd - separator - 1);
+
+                result.insert(QString::fromUtf8(line, keySize),
+                              QString::fromUtf8(separator + 1, valueSize));
+              });
+
+  m_data->sections.insert(name, result);
+  return result;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <QByteArray>
+#include <QExplicitlySharedDataPointer>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QSharedData>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+namespace RedisClient {
+
+typedef QMap<int, int> DatabaseList;
+
+/**
+ * @brief The ServerInfo struct
+ * Represents redis-server information parsed from INFO command.
+ * Well-known fields are extracted in a single pass over raw reply,
+ * other fields are available through lazily parsed sections.
+ */
+struct ServerInfo {
+  ServerInfo();
+
+  double version;
+  bool clusterMode;
+  bool sentinelMode;
+  DatabaseList databases;
+
+  /*
+   * Well-known fields, -1 if field is not present in reply
+   */
+  QByteArray versionString;
+  QByteArray role;
+  qint64 uptimeInSeconds;
+  qint64 connectedClients;
+  qint64 usedMemory;
+  qint64 usedMemoryPeak;
+  qint64 totalCommandsProcessed;
+  qint64 instantaneousOpsPerSec;
+  qint64 keyspaceHits;
+  qint64 keyspaceMisses;
+
+  /**
+   * @brief The ParsedServerInfo class
+   * Sections of INFO reply. Raw reply is shared between copies and
+   * section is converted to hash on first request.
+   */
+  class ParsedServerInfo {
+   public:
+    typedef QHash<QString, QString> Section;
+
+    ParsedServerInfo();
+
+    QStringList sections() const;
+    bool contains(const QString &section) const;
+    bool isEmpty() const;
+
+    Section section(const QString &name) const;
+    Section operator[](const QString &name) const { return section(name); }
+    QString value(const QString &section, const QString &field) const;
+
+    /**
+     * @brief All sections as nested maps. Result is cached.
+     */
+    QVariantMap toVariantMap() const;
+
+   private:
+    friend struct ServerInfo;
+
+    // Requires m_data->lock
+    Section loadSection(const QByteArray &name) const;
+
+    struct Data : public QSharedData {
+      Data() : hasVariantMap(false) {}
+
+      QByteArray raw;
+      QList<QByteArray> order;
+      QHash<QByteArray, QPair<int, int>> ranges;  // [begin, end) in raw
+
+      QMutex lock;
+      QHash<QByteArray, Section> sections;
+      QVariantMap variantMap;
+      bool hasVariantMap;
+    };
+
+    QExplicitlySharedDataPointer<Data> m_data;
+  };
+
+  ParsedServerInfo parsed;
+
+  static ServerInfo fromString(const QString &info);
+
+  /**
+   * @brief Parse raw INFO reply without conversion to QString
+   */
+  static ServerInfo fromBytes(const QByteArray &info);
+};
+
+}  // namespace RedisClient
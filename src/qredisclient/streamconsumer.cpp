@@ -0,0 +1,405 @@
+#include "streamconsumer.h"
+#include "connection.h"
+
+namespace {
+const char *CLAIM_START_ID = "0-0";
+
+// Values of views outlive the reply in containers of consumer
+QByteArray deepCopy(const QByteArray &value) {
+  return QByteArray(value.constData(), value.size());
+}
+
+QString replyError(const RedisClient::Response &r, const QString &err) {
+  return err.isEmpty() ? QString::fromUtf8(r.asBytes()) : err;
+}
+}  // namespace
+
+QByteArray RedisClient::StreamConsumer::Entry::value(
+    const QByteArray &field) const {
+  for (const FieldValue &item : fields) {
+    if (item.first == field) return item.second;
+  }
+
+  return QByteArray();
+}
+
+RedisClient::StreamConsumer::Options::Options()
+    : dbIndex(0),
+      createGroup(false),
+      groupStartId("$"),
+      count(500),
+      block(2000),
+      autoAck(false),
+      ackBatch(500),
+      ackInterval(100),
+      claimMinIdle(0),
+      claimInterval(30000),
+      claimCount(100),
+      retryInterval(1000) {}
+
+RedisClient::StreamConsumer::Stats::Stats()
+    : received(0), claimed(0), acked(0), errors(0) {}
+
+RedisClient::StreamConsumer::StreamConsumer(Connection *connection,
+                                            const Options &options,
+                                            QObject *parent)
+    : QObject(parent),
+      m_connection(connection),
+      m_options(options),
+      m_running(false),
+      m_generation(0),
+      m_reading(false),
+      m_claiming(false),
+      m_pendingClaims(0),
+      m_pendingAcks(0) {
+  if (m_options.count == 0) m_options.count = 1;
+  if (m_options.ackBatch == 0) m_options.ackBatch = 1;
+
+  m_ackTimer.setSingleShot(true);
+  m_ackTimer.setInterval(m_options.ackInterval);
+  QObject::connect(&m_ackTimer, &QTimer::timeout, this,
+                   &StreamConsumer::flushAcks);
+
+  m_claimTimer.setInterval(m_options.claimInterval);
+  QObject::connect(&m_claimTimer, &QTimer::timeout, this,
+                   &StreamConsumer::claim);
+}
+
+RedisClient::StreamConsumer::~StreamConsumer() { flushAcks(); }
+
+void RedisClient::StreamConsumer::start() {
+  if (m_running) return;
+
+  if (m_options.group.isEmpty() || m_options.consumer.isEmpty() ||
+      m_options.streams.isEmpty())
+    throw Exception("Group, consumer and streams are required");
+
+  if (!m_connection) throw Exception("Connection was removed");
+
+  if (!m_reader) m_reader = m_connection->clone();
+
+  m_running = true;
+  m_generation++;
+  m_reading = false;
+  m_claiming = false;
+  m_claimCursors.clear();
+
+  for (int i = 0; i < m_options.streams.size(); ++i)
+    m_claimCursors.append(CLAIM_START_ID);
+
+  if (m_options.createGroup) createGroups();
+
+  read();
+
+  if (m_options.claimMinIdle > 0) {
+    m_claimTimer.start();
+    claim();
+  }
+}
+
+void RedisClient::StreamConsumer::stop() {
+  if (!m_running) return;
+
+  m_running = false;
+  m_generation++;
+  m_reading = false;
+  m_claiming = false;
+  m_claimTimer.stop();
+
+  flushAcks();
+}
+
+bool RedisClient::StreamConsumer::isRunning() const { return m_running; }
+
+void RedisClient::StreamConsumer::ack(const QByteArray &stream,
+                                      const QByteArray &id) {
+  if (stream.isEmpty() || id.isEmpty()) return;
+
+  auto it = m_acks.find(stream);
+
+  if (it == m_acks.end())
+    it = m_acks.insert(deepCopy(stream), QList<QByteArray>());
+
+  it->append(deepCopy(id));
+  m_pendingAcks++;
+
+  if (static_cast<uint>(m_pendingAcks) >= m_options.ackBatch)
+    flushAcks();
+  else if (!m_ackTimer.isActive())
+    m_ackTimer.start();
+}
+
+void RedisClient::StreamConsumer::ack(const Entry &entry) {
+  ack(entry.stream, entry.id);
+}
+
+void RedisClient::StreamConsumer::ack(const Batch &batch) {
+  for (const Entry &entry : batch.entries) ack(entry.stream, entry.id);
+}
+
+void RedisClient::StreamConsumer::flushAcks() {
+  m_ackTimer.stop();
+
+  if (m_pendingAcks == 0) return;
+
+  if (!m_connection) {
+    m_acks.clear();
+    m_pendingAcks = 0;
+    return;
+  }
+
+  // One XACK per stream, all streams are pipelined
+  QList<Command> commands;
+  commands.reserve(m_acks.size());
+
+  for (auto it = m_acks.constBegin(); it != m_acks.constEnd(); ++it) {
+    QList<QByteArray> args;
+    args.reserve(it.value().size() + 3);
+    args << "XACK" << it.key() << m_options.group;
+    args.append(it.value());
+
+    commands.append(Command(args, this,
+                            [this](const Response &r, const QString &err) {
+                              if (!err.isEmpty() || r.isErrorMessage()) {
+                                m_stats.errors++;
+                                emit error(QString("Cannot ack entries: %1")
+                                               .arg(replyError(r, err)));
+                                return;
+                              }
+
+                              m_stats.acked += r.view().toInteger();
+                            },
+                            m_options.dbIndex));
+  }
+
+  m_acks.clear();
+  m_pendingAcks = 0;
+
+  try {
+    m_connection->runCommands(commands);
+  } catch (const Connection::Exception &e) {
+    m_stats.errors++;
+    emit error(QString("Cannot ack entries: %1").arg(e.what()));
+  }
+}
+
+int RedisClient::StreamConsumer::pendingAcks() const { return m_pendingAcks; }
+
+RedisClient::StreamConsumer::Stats RedisClient::StreamConsumer::stats()
+    const {
+  return m_stats;
+}
+
+void RedisClient::StreamConsumer::createGroups() {
+  // Sent over reader connection, so groups exist before first XREADGROUP
+  QList<Command> commands;
+
+  for (const QByteArray &stream : m_options.streams) {
+    commands.append(Command(
+        {"XGROUP", "CREATE", stream, m_options.group, m_options.groupStartId,
+         "MKSTREAM"},
+        this,
+        [this](const Response &r, const QString &err) {
+          if (r.isErrorMessage() && r.asBytes().startsWith("BUSYGROUP"))
+            return;
+
+          if (!err.isEmpty() || r.isErrorMessage()) {
+            m_stats.errors++;
+            emit error(QString("Cannot create consumer group: %1")
+                           .arg(replyError(r, err)));
+          }
+        },
+        m_options.dbIndex));
+  }
+
+  try {
+    m_reader->runCommands(commands);
+  } catch (const Connection::Exception &e) {
+    m_stats.errors++;
+    emit error(QString("Cannot create consumer group: %1").arg(e.what()));
+  }
+}
+
+void RedisClient::StreamConsumer::read() {
+  if (!m_running || m_reading) return;
+
+  QList<QByteArray> args;
+  args.reserve(m_options.streams.size() * 2 + 8);
+  args << "XREADGROUP"
+       << "GROUP" << m_options.group << m_options.consumer << "COUNT"
+       << QByteArray::number(m_options.count) << "BLOCK"
+       << QByteArray::number(m_options.block) << "STREAMS";
+  args.append(m_options.streams);
+
+  for (int i = 0; i < m_options.streams.size(); ++i) args.append(">");
+
+  quint64 generation = m_generation;
+
+  Command cmd(args, this,
+              [this, generation](const Response &r, const QString &err) {
+                processRead(generation, r, err);
+              },
+              m_options.dbIndex);
+
+  m_reading = true;
+
+  try {
+    m_reader->runCommand(cmd);
+  } catch (const Connection::Exception &e) {
+    m_reading = false;
+    retry(QString("Cannot read streams: %1").arg(e.what()));
+  }
+}
+
+void RedisClient::StreamConsumer::processRead(quint64 generation,
+                                              const Response &r,
+                                              const QString &err) {
+  if (generation != m_generation) return;
+
+  m_reading = false;
+
+  if (!err.isEmpty() || r.isErrorMessage())
+    return retry(QString("Cannot read streams: %1").arg(replyError(r, err)));
+
+  // Nil reply - BLOCK timeout expired
+  ResponseView streams = r.view();
+  Batch batch;
+  batch.reply = r;
+
+  if (!streams.isNil()) {
+    if (!streams.isAggregate())
+      return retry(QString("Cannot read streams: unexpected reply"));
+
+    // RESP3 reply is a map of stream name to entries
+    if (streams.isMap()) {
+      for (int i = 0; i + 1 < streams.arraySize(); i += 2)
+        appendEntries(streams.at(i).asBytes(), streams.at(i + 1),
+                      batch.entries);
+    } else {
+      for (int i = 0; i < streams.arraySize(); ++i)
+        appendEntries(streams.at(i).at(0).asBytes(), streams.at(i).at(1),
+                      batch.entries);
+    }
+  }
+
+  m_stats.received += batch.entries.size();
+
+  if (!batch.entries.isEmpty()) deliver(batch);
+
+  read();
+}
+
+void RedisClient::StreamConsumer::claim() {
+  if (!m_running || m_claiming || m_options.claimMinIdle == 0 ||
+      !m_connection)
+    return;
+
+  quint64 generation = m_generation;
+  QList<Command> commands;
+
+  for (int i = 0; i < m_options.streams.size(); ++i) {
+    commands.append(Command(
+        {"XAUTOCLAIM", m_options.streams.at(i), m_options.group,
+         m_options.consumer, QByteArray::number(m_options.claimMinIdle),
+         m_claimCursors.at(i), "COUNT",
+         QByteArray::number(m_options.claimCount)},
+        this,
+        [this, generation, i](const Response &r, const QString &err) {
+          processClaim(generation, i, r, err);
+        },
+        m_options.dbIndex));
+  }
+
+  m_claiming = true;
+  m_pendingClaims = commands.size();
+
+  try {
+    m_connection->runCommands(commands);
+  } catch (const Connection::Exception &e) {
+    m_claiming = false;
+    m_stats.errors++;
+    emit error(QString("Cannot claim entries: %1").arg(e.what()));
+  }
+}
+
+void RedisClient::StreamConsumer::processClaim(quint64 generation,
+                                               int streamIndex,
+                                               const Response &r,
+                                               const QString &err) {
+  if (generation != m_generation) return;
+
+  ResponseView reply = r.view();
+
+  if (!err.isEmpty() || r.isErrorMessage()) {
+    // Scan of PEL is restarted on next claim timer
+    m_claimCursors[streamIndex] = CLAIM_START_ID;
+    m_stats.errors++;
+    emit error(QString("Cannot claim entries: %1").arg(replyError(r, err)));
+  } else if (reply.isArray() && reply.arraySize() >= 2) {
+    // [next cursor, entries] or [next cursor, entries, deleted IDs]
+    m_claimCursors[streamIndex] = reply.at(0).toByteArray();
+
+    Batch batch;
+    batch.reply = r;
+    batch.claimed = true;
+    appendEntries(m_options.streams.at(streamIndex), reply.at(1),
+                  batch.entries);
+
+    m_stats.claimed += batch.entries.size();
+
+    if (!batch.entries.isEmpty()) deliver(batch);
+  }
+
+  if (--m_pendingClaims > 0 || !m_claiming) return;
+
+  m_claiming = false;
+
+  // Continue scan of PEL, otherwise wait for claim timer
+  for (const QByteArray &cursor : m_claimCursors) {
+    if (cursor != CLAIM_START_ID) return claim();
+  }
+}
+
+void RedisClient::StreamConsumer::deliver(Batch &batch) {
+  emit entriesReceived(batch);
+
+  if (m_options.autoAck) ack(batch);
+}
+
+void RedisClient::StreamConsumer::retry(const QString &err) {
+  m_stats.errors++;
+  emit error(err);
+
+  if (!m_running) return;
+
+  quint64 generation = m_generation;
+
+  QTimer::singleShot(m_options.retryInterval, this, [this, generation]() {
+    if (generation == m_generation) read();
+  });
+}
+
+void RedisClient::StreamConsumer::appendEntries(const QByteArray &stream,
+                                                const ResponseView &entries,
+                                                QVector<Entry> &result) {
+  result.reserve(result.size() + entries.arraySize());
+
+  for (int i = 0; i < entries.arraySize(); ++i) {
+    ResponseView item = entries.at(i);
+    ResponseView fields = item.at(1);
+
+    // Entry was deleted but its ID is still in PEL
+    if (fields.isNil()) continue;
+
+    Entry entry;
+    entry.stream = stream;
+    entry.id = item.at(0).asBytes();
+    entry.fields.reserve(fields.arraySize() / 2);
+
+    for (int j = 0; j + 1 < fields.arraySize(); j += 2)
+      entry.fields.append(
+          FieldValue(fields.at(j).asBytes(), fields.at(j + 1).asBytes()));
+
+    result.append(entry);
+  }
+}
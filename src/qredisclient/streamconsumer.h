@@ -0,0 +1,170 @@
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVector>
+#include "exception.h"
+#include "response.h"
+
+namespace RedisClient {
+
+class Connection;
+
+/**
+ * @brief The StreamConsumer class
+ * Reads entries of one or more streams as member of a consumer group.
+ * XREADGROUP ... BLOCK is sent over a dedicated connection created with
+ * Connection::clone(), so blocked reads don't delay other commands of
+ * source connection. All streams are read with a single XREADGROUP,
+ * next batch is requested right after entriesReceived() returns.
+ *
+ * Acknowledged IDs are coalesced into one XACK per stream and pipelined
+ * through source connection when Options::ackBatch IDs are collected or
+ * Options::ackInterval elapsed. Entries idle in other consumers longer
+ * than Options::claimMinIdle are reclaimed with XAUTOCLAIM.
+ *
+ * In cluster mode all streams should hash to the same slot.
+ */
+class StreamConsumer : public QObject {
+  Q_OBJECT
+  ADD_EXCEPTION
+
+ public:
+  typedef QPair<QByteArray, QByteArray> FieldValue;
+
+  /**
+   * @brief Stream entry. Stream name, ID, fields and values share memory
+   * with the reply, so they are valid while Batch is alive.
+   * Use QByteArray(data, size) to keep a value after that.
+   */
+  struct Entry {
+    QByteArray stream;
+    QByteArray id;
+    QVector<FieldValue> fields;
+
+    /**
+     * @brief Value of the first field with given name, null if not found
+     */
+    QByteArray value(const QByteArray &field) const;
+  };
+
+  struct Batch {
+    Batch() : claimed(false) {}
+
+    Response reply;  // keeps memory of entries
+    QVector<Entry> entries;
+    bool claimed;  // entries are reclaimed with XAUTOCLAIM
+  };
+
+  struct Options {
+    Options();
+
+    QByteArray group;
+    QByteArray consumer;
+    QList<QByteArray> streams;
+    int dbIndex;
+
+    // XGROUP CREATE ... MKSTREAM, existing groups are kept
+    bool createGroup;
+    QByteArray groupStartId;
+
+    uint count;          // entries per XREADGROUP
+    uint block;          // in ms
+    bool autoAck;        // ack batch when entriesReceived() returns
+    uint ackBatch;       // IDs which trigger XACK
+    uint ackInterval;    // in ms, max delay of collected IDs
+    uint claimMinIdle;   // in ms, 0 disables XAUTOCLAIM
+    uint claimInterval;  // in ms
+    uint claimCount;
+    uint retryInterval;  // in ms, delay of XREADGROUP after error
+  };
+
+  struct Stats {
+    Stats();
+
+    quint64 received;
+    quint64 claimed;
+    quint64 acked;
+    quint64 errors;
+  };
+
+ public:
+  StreamConsumer(Connection *connection, const Options &options,
+                 QObject *parent = nullptr);
+  ~StreamConsumer();
+
+  /**
+   * @brief Create group if required and start reading
+   * @throws StreamConsumer::Exception if options are invalid
+   */
+  void start();
+
+  /**
+   * @brief Stop reading and flush collected acks.
+   * Entries of pending XREADGROUP stay in PEL and can be reclaimed.
+   */
+  void stop();
+
+  bool isRunning() const;
+
+  /**
+   * @brief Collect ID for XACK
+   */
+  void ack(const QByteArray &stream, const QByteArray &id);
+  void ack(const Entry &entry);
+  void ack(const Batch &batch);
+
+  /**
+   * @brief Send collected acks immediately
+   */
+  void flushAcks();
+
+  int pendingAcks() const;
+  Stats stats() const;
+
+ signals:
+  void entriesReceived(const RedisClient::StreamConsumer::Batch &batch);
+  void error(const QString &err);
+
+ private:
+  void createGroups();
+  void read();
+  void processRead(quint64 generation, const Response &r, const QString &err);
+  void claim();
+  void processClaim(quint64 generation, int streamIndex, const Response &r,
+                    const QString &err);
+  void deliver(Batch &batch);
+  void retry(const QString &err);
+
+  static void appendEntries(const QByteArray &stream,
+                            const ResponseView &entries,
+                            QVector<Entry> &result);
+
+ private:
+  QPointer<Connection> m_connection;
+  QSharedPointer<Connection> m_reader;
+  Options m_options;
+  bool m_running;
+
+  // Replies of requests sent before stop() are ignored
+  quint64 m_generation;
+  bool m_reading;
+  bool m_claiming;
+  int m_pendingClaims;
+  QList<QByteArray> m_claimCursors;
+
+  QHash<QByteArray, QList<QByteArray>> m_acks;
+  int m_pendingAcks;
+  QTimer m_ackTimer;
+  QTimer m_claimTimer;
+  Stats m_stats;
+};
+
+}  // namespace RedisClient
+
+Q_DECLARE_METATYPE(RedisClient::StreamConsumer::Batch)
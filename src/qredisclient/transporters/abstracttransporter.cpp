@@ -1,22 +1,87 @@
 #include "abstracttransporter.h"
 #include <QDebug>
+#include <QPointer>
+#include <QThread>
+#include <climits>
+#include <random>
+#include <utility>
 #include "qredisclient/connection.h"
-#include "qredisclient/private/responseemmiter.h"
+#include "qredisclient/private/responsedispatcher.h"
 #include "qredisclient/utils/text.h"
 
 RedisClient::AbstractTransporter::AbstractTransporter(
     RedisClient::Connection *connection)
-    : m_connection(connection), m_reconnectEnabled(true) {
+    : m_connection(connection),
+      m_subscriberCounters(new SubscriberQueue::Counters()),
+      m_pausedSubscriberQueues(0),
+      m_reconnectEnabled(true),
+      m_selectedDb(0),
+      m_serverSubscriptions(0),
+      m_redirectPort(0),
+      m_writeBatchCommands(0),
+      m_writeBatchBytes(0),
+      m_writeBatchTimer(new QTimer(this)),
+      m_writeBatchTailOpen(false),
+      m_queueProcessingScheduled(false),
+      m_submissionWakeUpPending(0),
+      m_nextQueuedDeadline(0),
+      m_executionTimer(new QTimer(this)),
+      m_connectTimer(new QTimer(this)),
+      m_connecting(false),
+      m_reconnectTimer(new QTimer(this)),
+      m_reconnectAttempts(0),
+      m_connectionEstablished(false),
+      m_queuedCommands(0),
+      m_queuedBytes(0),
+      m_queueMaxCommands(0),
+      m_queueMaxBytes(0),
+      m_queueOverflowPolicy(ConnectionConfig::QueueOverflowPolicy::Fail),
+      m_queueBlockTimeout(0),
+      m_blockedProducers(0),
+      m_queuePressure(0),
+      m_metrics(connection->m_metrics) {
+  loadWriteBatchPolicy();
+  loadSubscriberQueuePolicy();
+  loadCommandQueuePolicy();
+  m_queueClock.start();
+
+  m_writeBatchTimer->setSingleShot(true);
+  m_writeBatchTimer->setTimerType(Qt::PreciseTimer);
+  connect(m_writeBatchTimer, &QTimer::timeout, this,
+          &AbstractTransporter::flushWriteBatch);
+
+  m_executionTimer->setSingleShot(true);
+  connect(m_executionTimer, &QTimer::timeout, this,
+          &AbstractTransporter::executionTimeout);
+
+  m_connectTimer->setSingleShot(true);
+  connect(m_connectTimer, &QTimer::timeout, this,
+          &AbstractTransporter::connectTimeout);
+
+  m_reconnectTimer->setSingleShot(true);
+  connect(m_reconnectTimer, &QTimer::timeout, this,
+          &AbstractTransporter::reconnect);
+
+  connect(this, &AbstractTransporter::connected, this, [this]() {
+    m_reconnectTimer->stop();
+    m_reconnectAttempts = 0;
+    m_connectionEstablished = true;
+
+    // Handlers of connected() see state of the new socket
+    resetDbIndex();
+  });
+
   // connect signals & slots between connection & transporter
-  connect(connection, SIGNAL(addCommandToWorker(const Command &)), this,
-          SLOT(addCommand(const Command &)));
+  // Emitted by handshake in this thread too, reconnect after reply is processed
   connect(connection, SIGNAL(reconnectTo(const QString &, int)), this,
-          SLOT(reconnectTo(const QString &, int)));
+          SLOT(reconnectTo(const QString &, int)), Qt::QueuedConnection);
   connect(this, SIGNAL(logEvent(const QString &)), connection,
           SIGNAL(log(const QString &)));
 
   connect(this, &AbstractTransporter::errorOccurred, this,
           &AbstractTransporter::cancelRunningCommands);
+  connect(this, &AbstractTransporter::errorOccurred, this,
+          [this]() { finishConnect(); });
 
   connect(m_connection, &Connection::authOk, this,
           &AbstractTransporter::processCommandQueue);
@@ -31,25 +96,289 @@ void RedisClient::AbstractTransporter::init() {
 
   qDebug() << "Init transporter";
 
+  loadWriteBatchPolicy();
+  loadSubscriberQueuePolicy();
+  loadCommandQueuePolicy();
+  m_parser.setMaxBufferSize(
+      m_connection->sharedSettings()->maxReplyBufferSize);
   initSocket();
   connectToHost();
 }
 
 void RedisClient::AbstractTransporter::disconnectFromHost() {
   cancelRunningCommands();
+
+  QList<Command> queued;
+  queued.reserve(m_commands.size());
+
+  for (const QueuedCommand &q : m_commands) queued.append(q.cmd);
+
   m_commands.clear();
+  untrackQueuedCommands(queued);
+  failDroppedCommands(queued);
+
+  m_connectTimer->stop();
+  m_connecting = false;
+  m_reconnectTimer->stop();
+  m_reconnectAttempts = 0;
+  m_connectionEstablished = false;
 }
 
-void RedisClient::AbstractTransporter::addCommand(const Command &cmd) {
+void RedisClient::AbstractTransporter::detachToThread(QThread *thread) {
+  disconnectFromHost();
+  m_writeBatchTimer->stop();
+  moveToThread(thread);
+}
+
+void RedisClient::AbstractTransporter::submitCommand(const Command &cmd) {
+  if (!admitCommands(1, cmd.payloadSize(), cmd.isHiPriorityCommand())) {
+    m_metrics->addRejectedCommands(1);
+    return failCommand(cmd, "Command queue is full");
+  }
+
+  m_submissions.push(Submission{cmd, QList<Command>()});
+  wakeUpForSubmissions();
+}
+
+void RedisClient::AbstractTransporter::submitCommands(
+    const QList<Command> &commands) {
+  if (commands.isEmpty()) return;
+
+  qint64 bytes = 0;
+
+  for (const Command &cmd : commands) bytes += cmd.payloadSize();
+
+  if (!admitCommands(commands.size(), bytes,
+                     commands.first().isHiPriorityCommand())) {
+    m_metrics->addRejectedCommands(commands.size());
+
+    for (const Command &cmd : commands)
+      failCommand(cmd, "Command queue is full");
+    return;
+  }
+
+  m_submissions.push(Submission{Command(), commands});
+  wakeUpForSubmissions();
+}
+
+bool RedisClient::AbstractTransporter::admitCommands(int count, qint64 bytes,
+                                                     bool hiPriority) {
+  if (m_queueMaxCommands == 0 && m_queueMaxBytes == 0) {
+    m_queuedCommands.fetchAndAddOrdered(count);
+    m_queuedBytes.fetchAndAddOrdered(bytes);
+    return true;
+  }
+
+  // Space is reserved before check, so concurrent producers
+  // can't exceed limits together
+  auto reserve = [this, count, bytes, hiPriority]() -> bool {
+    int commands = m_queuedCommands.fetchAndAddOrdered(count) + count;
+    qint64 total = m_queuedBytes.fetchAndAddOrdered(bytes) + bytes;
+
+    if (hiPriority || !isCommandQueueFull(commands, total, count)) return true;
+
+    if (m_queueOverflowPolicy ==
+        ConnectionConfig::QueueOverflowPolicy::ShedLowestPriority) {
+      // Queued commands are shed by transporter
+      setQueuePressure(true);
+      return true;
+    }
+
+    m_queuedCommands.fetchAndAddOrdered(-count);
+    m_queuedBytes.fetchAndAddOrdered(-bytes);
+    return false;
+  };
+
+  if (reserve()) return true;
+
+  setQueuePressure(true);
+
+  // Transporter thread can't wait for itself
+  if (m_queueOverflowPolicy != ConnectionConfig::QueueOverflowPolicy::Block ||
+      QThread::currentThread() == thread())
+    return false;
+
+  QElapsedTimer waitTimer;
+  waitTimer.start();
+
+  QMutexLocker lock(&m_queueSpaceLock);
+  m_blockedProducers.fetchAndAddOrdered(1);
+
+  bool admitted = false;
+
+  while (!(admitted = reserve())) {
+    qint64 remaining = m_queueBlockTimeout - waitTimer.elapsed();
+
+    if (remaining <= 0) break;
+
+    m_queueSpace.wait(&m_queueSpaceLock, static_cast<ulong>(remaining));
+  }
+
+  m_blockedProducers.fetchAndAddOrdered(-1);
+  return admitted;
+}
+
+bool RedisClient::AbstractTransporter::isCommandQueueFull(int commands,
+                                                          qint64 bytes,
+                                                          int incoming) const {
+  if (m_queueMaxCommands > 0 && commands > m_queueMaxCommands) return true;
+
+  // Large command is accepted by empty queue
+  return m_queueMaxBytes > 0 && bytes > m_queueMaxBytes && commands > incoming;
+}
+
+void RedisClient::AbstractTransporter::trackQueuedCommand(const Command &cmd,
+                                                          int delta) {
+  m_queuedCommands.fetchAndAddOrdered(delta);
+  m_queuedBytes.fetchAndAddOrdered(delta * cmd.payloadSize());
+
+  if (delta > 0) return;
+
+  if (m_blockedProducers.loadAcquire() > 0) {
+    QMutexLocker lock(&m_queueSpaceLock);
+    m_queueSpace.wakeAll();
+  }
+
+  if (m_queuePressure.loadAcquire() == 0) return;
+
+  bool drained =
+      (m_queueMaxCommands == 0 ||
+       m_queuedCommands.loadAcquire() <= m_queueMaxCommands / 2) &&
+      (m_queueMaxBytes == 0 || m_queuedBytes.loadAcquire() <= m_queueMaxBytes / 2);
+
+  if (drained) setQueuePressure(false);
+}
+
+void RedisClient::AbstractTransporter::untrackQueuedCommands(
+    const QList<Command> &commands) {
+  for (const Command &cmd : commands) trackQueuedCommand(cmd, -1);
+}
+
+void RedisClient::AbstractTransporter::shedQueuedCommands() {
+  if (m_queueOverflowPolicy !=
+      ConnectionConfig::QueueOverflowPolicy::ShedLowestPriority)
+    return;
+
+  while (isCommandQueueFull(m_queuedCommands.loadAcquire(),
+                            m_queuedBytes.loadAcquire(), 1)) {
+    // Most recent command of the lowest priority class
+    auto victim = m_commands.end();
+
+    for (auto it = m_commands.end(); it != m_commands.begin();) {
+      --it;
+      Command::Priority priority = it->cmd.priority();
+
+      if (priority == Command::Priority::High) continue;
+
+      if (victim == m_commands.end() || priority > victim->cmd.priority())
+        victim = it;
+
+      if (priority == Command::Priority::Bulk) break;
+    }
+
+    if (victim == m_commands.end()) return;
+
+    Command cmd = victim->cmd;
+    m_commands.erase(victim);
+    trackQueuedCommand(cmd, -1);
+    m_metrics->addShedCommands(1);
+    failCommand(cmd, "Command was shed from full queue");
+  }
+}
+
+void RedisClient::AbstractTransporter::setQueuePressure(bool underPressure) {
+  if (m_queuePressure.testAndSetOrdered(underPressure ? 0 : 1,
+                                        underPressure ? 1 : 0))
+    emit queuePressureChanged(underPressure);
+}
+
+RedisClient::AbstractTransporter::CommandQueueStats
+RedisClient::AbstractTransporter::commandQueueStats() const {
+  CommandQueueStats stats;
+  stats.commands = m_queuedCommands.loadAcquire();
+  stats.bytes = m_queuedBytes.loadAcquire();
+  stats.blockedProducers = m_blockedProducers.loadAcquire();
+  stats.underPressure = m_queuePressure.loadAcquire() != 0;
+  return stats;
+}
+
+void RedisClient::AbstractTransporter::wakeUpForSubmissions() {
+  // Only first submission after queue was drained posts an event
+  if (!m_submissionWakeUpPending.testAndSetOrdered(0, 1)) return;
+
+  QMetaObject::invokeMethod(this, "processSubmittedCommands",
+                            Qt::QueuedConnection);
+}
+
+void RedisClient::AbstractTransporter::processSubmittedCommands() {
+  m_submissionWakeUpPending.storeRelease(0);
+
+  Submission submission;
+  bool added = false;
+
+  while (m_submissions.pop(submission)) {
+    if (submission.batch.isEmpty()) {
+      enqueueCommand(submission.cmd);
+    } else {
+      enqueueCommands(submission.batch);
+      submission.batch.clear();
+    }
+    added = true;
+  }
+
+  // Producer is still linking pushed command, check again later
+  if (!m_submissions.isEmpty() &&
+      m_submissionWakeUpPending.testAndSetOrdered(0, 1))
+    QMetaObject::invokeMethod(this, "processSubmittedCommands",
+                              Qt::QueuedConnection);
+
+  if (!added) return;
+
+  shedQueuedCommands();
+
+  emit commandAdded();
+
+  if (isInitialized()) processCommandQueue();
+}
+
+void RedisClient::AbstractTransporter::enqueueCommand(const Command &cmd) {
   if (cmd.isHiPriorityCommand())
-    m_commands.prepend(cmd);
+    m_commands.prepend(markQueued(cmd));
   else
-    m_commands.enqueue(cmd);
+    m_commands.enqueue(markQueued(cmd));
+}
+
+void RedisClient::AbstractTransporter::enqueueCommands(
+    const QList<Command> &commands) {
+  QList<Command> grouped = groupCommandsByDb(commands);
+
+  if (grouped.isEmpty() || !grouped.first().isHiPriorityCommand()) {
+    for (const Command &cmd : grouped) m_commands.enqueue(markQueued(cmd));
+    return;
+  }
+
+  // Keep order of hi-priority batch (e.g. connection handshake)
+  for (int i = grouped.size() - 1; i >= 0; --i)
+    m_commands.prepend(markQueued(grouped.at(i)));
+}
+
+void RedisClient::AbstractTransporter::addCommand(const Command &cmd) {
+  trackQueuedCommand(cmd, 1);
+  enqueueCommand(cmd);
+
+  emit commandAdded();
+
+  if (isInitialized()) scheduleCommandQueueProcessing();
+}
+
+void RedisClient::AbstractTransporter::addCommands(
+    const QList<Command> &commands) {
+  for (const Command &cmd : commands) trackQueuedCommand(cmd, 1);
+  enqueueCommands(commands);
 
   emit commandAdded();
 
-  if (isInitialized())
-    QTimer::singleShot(0, this, &AbstractTransporter::processCommandQueue);
+  if (isInitialized()) processCommandQueue();
 }
 
 void RedisClient::AbstractTransporter::cancelCommands(QObject *owner) {
@@ -58,41 +387,41 @@ void RedisClient::AbstractTransporter::cancelCommands(QObject *owner) {
   reAddRunningCommandToQueue(owner);
 
   // Remove subscriptions
-  Subscriptions::iterator i = m_subscriptions.begin();
-  while (i != m_subscriptions.constEnd()) {
-    if (i.value()->owner == owner) {
-      i = m_subscriptions.erase(i);
-      emit logEvent("Subscription was canceled.");
-    } else {
-      ++i;
-    }
-  }
-
-  if (m_commands.size() == 0) return;
+  QList<Command> unsubscribe = m_subscriptions.removeOwner(owner);
 
   // Cancel command in queue
   for (auto curr = m_commands.begin(); curr != m_commands.end();) {
-    if (curr->getOwner() == owner) {
+    if (curr->cmd.getOwner() == owner) {
+      trackQueuedCommand(curr->cmd, -1);
       curr = m_commands.erase(curr);
       emit logEvent("Command was canceled.");
     } else {
       ++curr;
     }
   }
+
+  if (unsubscribe.isEmpty()) return;
+
+  emit logEvent("Subscription was canceled.");
+
+  // Messages of removed channels are dropped until server confirms
+  for (const Command &cmd : unsubscribe) addCommand(cmd);
 }
 
 void RedisClient::AbstractTransporter::sendResponse(
     const RedisClient::Response &response) {
   //logResponse(response);
 
-  if (response.isMessage()) {
-    QByteArray channel = response.getChannel();
-
-    if (m_subscriptions.contains(channel))
-      m_subscriptions[channel]->sendResponse(response, QString());
+  // RESP3 push frames are out-of-band and never match running commands
+  if (response.isPush()) return processPushMessage(response);
 
+  // With RESP3 pub/sub messages are always delivered as push frames.
+  // Regular replies skip message detection until first subscription.
+  if ((!m_subscriptions.isEmpty() || m_serverSubscriptions > 0) &&
+      m_connection->protocolVersion() < 3 &&
+      (m_subscriptions.dispatch(response) ||
+       processSubscriptionConfirmation(response)))
     return;
-  }
 
   if (m_runningCommands.size() == 0) {
     qDebug() << "Response recieved but no commands are running";
@@ -110,51 +439,165 @@ void RedisClient::AbstractTransporter::sendResponse(
   }
 
   auto runningCommand = m_runningCommands.dequeue();
+  m_metrics->setInFlight(m_runningCommands.size());
 
   // Reconnect to different server in cluster and reissue current
   // command if needed
   if (m_connection->mode() == Connection::Mode::Cluster &&
+      !runningCommand->expired &&
       (response.isAskRedirect() || response.isMovedRedirect())) {
     return processClusterRedirect(runningCommand, response);
   }
 
-  if (runningCommand->cmd.isUnSubscriptionCommand()) {
-    QList<QByteArray> channels =
-        runningCommand->cmd.getSplitedRepresentattion().mid(1);
-    for (QByteArray channel : channels) {
-      m_subscriptions.remove(channel);
+  completeRunningCommand(runningCommand, response);
+
+  if (!m_redirectHost.isEmpty() && m_runningCommands.isEmpty())
+    processClusterRedirect(QSharedPointer<RunningCommand>(), Response());
+}
+
+void RedisClient::AbstractTransporter::processPushMessage(
+    const RedisClient::Response &response) {
+  if (m_subscriptions.dispatch(response)) return;
+
+  // Confirmations of (un)subscription commands are delivered as push frames
+  QByteArray kind = response.at(0).asBytes().toLower();
+
+  // Client tracking invalidation, nil means that all keys were flushed
+  if (kind == "invalidate" && m_connection->m_cacheEnabled.loadAcquire()) {
+    ResponseView keys = response.at(1);
+
+    if (keys.isNil()) {
+      m_connection->m_cache->clear();
+    } else {
+      QList<QByteArray> invalidated;
+      invalidated.reserve(keys.arraySize());
+
+      for (int i = 0; i < keys.arraySize(); ++i)
+        invalidated.append(keys.at(i).toByteArray());
+
+      m_connection->m_cache->invalidate(invalidated);
     }
   }
 
-  if (runningCommand->cmd.isSelectCommand() && response.isOkMessage()) {
-    m_connection->changeCurrentDbNumber(
-        runningCommand->cmd.getPartAsString(1).toInt());
+  if (kind.endsWith("subscribe") && !m_runningCommands.isEmpty()) {
+    const Command &head = m_runningCommands.head()->cmd;
+
+    if (head.isSubscriptionCommand() || head.isUnSubscriptionCommand())
+      return completeRunningCommand(m_runningCommands.dequeue(), response);
   }
 
-  runningCommand->cmd.getDeferred().complete(response);
+  emit pushMessageReceived(response);
+}
+
+bool RedisClient::AbstractTransporter::processSubscriptionConfirmation(
+    const RedisClient::Response &response) {
+  int kind = SubscriptionIndex::confirmationKind(response);
+
+  if (kind < 0) return false;
 
-  if (runningCommand->emitter) {
-    runningCommand->emitter->sendResponse(response, QString());
+  if (!m_runningCommands.isEmpty()) {
+    const Command &head = m_runningCommands.head()->cmd;
+    QList<QByteArray> channels = head.getSplitedRepresentattion().mid(1);
 
-    if (runningCommand->cmd.isSubscriptionCommand())
+    // Reply of command is its first confirmation, unsubscribe without
+    // channels is confirmed for any channel
+    if ((head.isSubscriptionCommand() || head.isUnSubscriptionCommand()) &&
+        (channels.isEmpty() || channels.contains(response.at(1).asBytes())))
+      return false;
+  }
+
+  // Following confirmations of multi-channel commands don't have
+  // running commands
+  updateServerSubscriptions(response);
+  return true;
+}
+
+void RedisClient::AbstractTransporter::updateServerSubscriptions(
+    const RedisClient::Response &response) {
+  if (SubscriptionIndex::confirmationKind(response) < 0) return;
+
+  m_serverSubscriptions = static_cast<int>(response.at(2).toInteger());
+}
+
+void RedisClient::AbstractTransporter::completeRunningCommand(
+    QSharedPointer<RunningCommand> runningCommand,
+    const RedisClient::Response &response) {
+  recordCommandMetrics(runningCommand);
+
+  if (runningCommand->deadline > 0 && !runningCommand->expired)
+    untrackDeadline(runningCommand);
+
+  if (runningCommand->cmd.isUnSubscriptionCommand())
+    m_subscriptions.unsubscribe(runningCommand->cmd);
+
+  if (runningCommand->cmd.isSubscriptionCommand() ||
+      runningCommand->cmd.isUnSubscriptionCommand())
+    updateServerSubscriptions(response);
+
+  if (runningCommand->cmd.isSelectCommand()) {
+    if (response.isOkMessage()) {
+      m_connection->changeCurrentDbNumber(
+          runningCommand->cmd.getPartAsString(1).toInt());
+    } else {
+      // Force SELECT before next command
+      m_selectedDb = -1;
+    }
+  }
+
+  if (runningCommand->expired) {
+    // Server has subscribed anyway, keep its messages apart from replies
+    if (runningCommand->cmd.isSubscriptionCommand() &&
+        !response.isErrorMessage())
       addSubscriptionsFromRunningCommand(runningCommand);
+
+    emit logEvent("Reply of timed out command is discarded");
+    return;
+  }
+
+  if (m_connection->m_cacheEnabled.loadAcquire() && runningCommand->db >= 0 &&
+      !response.isErrorMessage() &&
+      ClientSideCache::isCacheable(runningCommand->cmd)) {
+    m_connection->m_cache->store(runningCommand->cmd, runningCommand->db,
+                                 response);
   }
+
+  runningCommand->cmd.getDeferred().complete(response);
+
+  if (ResponseDispatcher::canDispatch(runningCommand->cmd))
+    ResponseDispatcher::dispatch(runningCommand->cmd, response);
+
+  // Channels without callback are indexed too, so their messages
+  // are not mistaken for replies
+  if (runningCommand->cmd.isSubscriptionCommand() &&
+      !response.isErrorMessage())
+    addSubscriptionsFromRunningCommand(runningCommand);
+
   runningCommand.clear();
 }
 
 void RedisClient::AbstractTransporter::resetDbIndex() {
+  m_selectedDb = 0;
   m_connection->changeCurrentDbNumber(0);
+
+  // New socket isn't subscribed to anything
+  m_serverSubscriptions = 0;
 }
 
 void RedisClient::AbstractTransporter::reAddRunningCommandToQueue(
     QObject *ignoreOwner) {
+  // Unsent commands will be written again from the queue
+  discardWriteBatch();
+
   for (auto curr = m_runningCommands.end();
        curr != m_runningCommands.begin();) {
     --curr;
 
     auto rCmd = *curr;
-    if (ignoreOwner == nullptr || rCmd->cmd.getOwner() != ignoreOwner) {
-      m_commands.prepend(rCmd->cmd);
+    if (!rCmd->expired &&
+        (ignoreOwner == nullptr || rCmd->cmd.getOwner() != ignoreOwner)) {
+      m_commands.prepend(QueuedCommand(rCmd->cmd, rCmd->queuedAt));
+      trackQueuedCommand(rCmd->cmd, 1);
+      trackQueuedDeadline(m_commands.head());
       qDebug() << "Running command was re-added to queue";
       emit logEvent("Running command was re-added to queue.");
     }
@@ -165,26 +608,574 @@ void RedisClient::AbstractTransporter::reAddRunningCommandToQueue(
 
 void RedisClient::AbstractTransporter::cancelRunningCommands() {
   emit logEvent("Cancel running commands");
+
+  // Expired commands were failed already
+  QList<Command> dropped;
+
+  for (const QueuedCommand &redirected : m_redirectedCommands)
+    dropped.append(redirected.cmd);
+
+  for (auto rCmd : m_runningCommands)
+    if (!rCmd->expired) dropped.append(rCmd->cmd);
+
   m_runningCommands.clear();
+  m_metrics->setInFlight(0);
+  m_deadlines.clear();
+  m_streamReader.reset();
+  m_redirectedCommands.clear();
+  m_redirectHost.clear();
+  discardWriteBatch();
+  m_selectedDb = -1;
+  m_serverSubscriptions = 0;
+
+  failDroppedCommands(dropped);
+}
+
+void RedisClient::AbstractTransporter::failDroppedCommands(
+    const QList<Command> &commands) {
+  if (commands.isEmpty()) return;
+
+  emit logEvent(QString("%1 commands were dropped").arg(commands.size()));
+
+  // Futures and callbacks of dropped commands don't wait forever
+  for (const Command &cmd : commands) {
+    cmd.getDeferred().cancel();
+
+    if (ResponseDispatcher::canDispatch(cmd))
+      ResponseDispatcher::dispatch(cmd, Response(), "Connection was closed");
+  }
 }
 
 void RedisClient::AbstractTransporter::processCommandQueue() {
+  m_queueProcessingScheduled = false;
+
   if (m_commands.isEmpty()) {
+    flushWriteBatch();
     emit queueIsEmpty();
     return;
   }
 
+  // Drain commands queued during current event loop turn into
+  // write batch. Batch is flushed by runCommand() once it's full.
+  int processed = 0;
+
+  do {
+    if (!runNextQueuedCommand()) break;
+    ++processed;
+  } while (processed < m_writeBatchMaxCommands && !m_commands.isEmpty() &&
+           !isSocketReconnectRequired());
+
+  if (m_writeBatchMaxDelay == 0 || !m_commands.isEmpty()) {
+    flushWriteBatch();
+  } else if (!m_writeBatch.isEmpty() && !m_writeBatchTimer->isActive()) {
+    // Wait for more commands but not longer than max delay
+    m_writeBatchTimer->start(qMax(1u, (m_writeBatchMaxDelay + 999) / 1000));
+  }
+
+  if (m_commands.isEmpty())
+    emit queueIsEmpty();
+  else if (m_redirectHost.isEmpty())
+    scheduleCommandQueueProcessing();
+}
+
+void RedisClient::AbstractTransporter::scheduleCommandQueueProcessing() {
+  if (m_queueProcessingScheduled) return;
+
+  m_queueProcessingScheduled = true;
+  QTimer::singleShot(0, this, &AbstractTransporter::processCommandQueue);
+}
+
+void RedisClient::AbstractTransporter::loadWriteBatchPolicy() {
+  auto settings = m_connection->sharedSettings();
+  m_writeBatchMaxBytes =
+      qBound(1u, settings->writeBatchMaxBytes, uint(INT_MAX));
+  m_writeBatchMaxCommands =
+      qBound(1u, settings->writeBatchMaxCommands, uint(INT_MAX));
+  m_writeBatchMaxDelay = settings->writeBatchMaxDelay;
+}
+
+void RedisClient::AbstractTransporter::loadSubscriberQueuePolicy() {
+  auto settings = m_connection->sharedSettings();
+  QPointer<AbstractTransporter> self(this);
+
+  m_subscriptions.setQueuePolicy(
+      settings->subscriberQueueLimit, settings->subscriberOverflowPolicy,
+      m_subscriberCounters, [self](bool paused) {
+        if (!self) return;
+
+        // Pause is requested from transporter thread while message is
+        // dispatched, resume - from owner thread once queue is drained
+        if (paused) return self->pauseReading();
+
+        QMetaObject::invokeMethod(self.data(), "resumeReading",
+                                  Qt::QueuedConnection);
+      });
+}
+
+void RedisClient::AbstractTransporter::loadCommandQueuePolicy() {
+  auto settings = m_connection->sharedSettings();
+
+  m_queueMaxCommands = static_cast<int>(
+      qMin(settings->commandQueueMaxCommands, static_cast<uint>(INT_MAX)));
+  m_queueMaxBytes = settings->commandQueueMaxBytes;
+  m_queueOverflowPolicy = settings->commandQueueOverflowPolicy;
+  m_queueBlockTimeout = settings->commandQueueBlockTimeout;
+}
+
+void RedisClient::AbstractTransporter::pauseReading() {
+  if (m_pausedSubscriberQueues.fetchAndAddOrdered(1) > 0) return;
+
+  emit logEvent("Subscriber queue is full, reading is paused");
+  setSocketReadingPaused(true);
+}
+
+void RedisClient::AbstractTransporter::resumeReading() {
+  if (m_pausedSubscriberQueues.loadAcquire() <= 0) return;
+
+  if (m_pausedSubscriberQueues.fetchAndAddOrdered(-1) > 1) return;
+
+  setSocketReadingPaused(false);
+
+  // Data buffered while reading was paused doesn't trigger readyRead again
+  readyRead();
+}
+
+RedisClient::AbstractTransporter::SubscriberQueueStats
+RedisClient::AbstractTransporter::subscriberQueueStats() const {
+  SubscriberQueueStats stats;
+  stats.depth = m_subscriberCounters->depth.loadAcquire();
+  stats.delivered = m_subscriberCounters->delivered.loadAcquire();
+  stats.dropped = m_subscriberCounters->dropped.loadAcquire();
+  stats.readingPaused = m_pausedSubscriberQueues.loadAcquire() > 0;
+  return stats;
+}
+
+void RedisClient::AbstractTransporter::appendToWriteBatch(
+    const QList<QByteArray> &chunks) {
+  for (const QByteArray &chunk : chunks) {
+    m_writeBatchBytes += chunk.size();
+
+    if (chunk.size() >= Command::SCATTER_GATHER_THRESHOLD) {
+      // Large chunks are shared with command and written as is
+      m_writeBatch.append(chunk);
+      m_writeBatchTailOpen = false;
+    } else if (m_writeBatchTailOpen) {
+      m_writeBatch.last().append(chunk);
+    } else if (!m_writeBatch.isEmpty() &&
+               m_writeBatch.last().size() < Command::SCATTER_GATHER_THRESHOLD) {
+      // Start contiguous buffer for small commands
+      QByteArray buffer;
+      buffer.reserve(
+          qMin(m_writeBatchMaxBytes, int(Command::SCATTER_GATHER_THRESHOLD)));
+      buffer.append(m_writeBatch.last()).append(chunk);
+      m_writeBatch.last() = buffer;
+      m_writeBatchTailOpen = true;
+    } else {
+      m_writeBatch.append(chunk);
+    }
+  }
+}
+
+bool RedisClient::AbstractTransporter::isWriteBatchFull() const {
+  return m_writeBatchCommands >= m_writeBatchMaxCommands ||
+         m_writeBatchBytes >= m_writeBatchMaxBytes;
+}
+
+void RedisClient::AbstractTransporter::flushWriteBatch() {
+  m_writeBatchTimer->stop();
+
+  if (m_writeBatch.isEmpty()) return;
+
+  for (const QByteArray &buffer : m_writeBatch) sendCommand(buffer);
+
+  flushSocket();
+
+  uint batchSize = m_writeBatchCommands;
+  qint64 now = m_queueClock.nsecsElapsed();
+
+  // Commands of the batch are at the tail of running queue
+  for (int i = m_runningCommands.size() - 1, n = batchSize; i >= 0 && n > 0;
+       --i, --n)
+    m_runningCommands.at(i)->writtenAt = now;
+
+  m_metrics->addBytesOut(m_writeBatchBytes);
+  m_statBatches.fetchAndAddRelaxed(1);
+  m_statCommands.fetchAndAddRelaxed(batchSize);
+  m_statBytes.fetchAndAddRelaxed(m_writeBatchBytes);
+  m_statLastBatchSize.storeRelease(batchSize);
+  if (batchSize > m_statMaxBatchSize.loadAcquire())
+    m_statMaxBatchSize.storeRelease(batchSize);
+
+  m_writeBatch.clear();
+  m_writeBatchCommands = 0;
+  m_writeBatchBytes = 0;
+  m_writeBatchTailOpen = false;
+}
+
+void RedisClient::AbstractTransporter::discardWriteBatch() {
+  m_writeBatchTimer->stop();
+  m_writeBatch.clear();
+  m_writeBatchCommands = 0;
+  m_writeBatchBytes = 0;
+  m_writeBatchTailOpen = false;
+}
+
+QList<RedisClient::Command> RedisClient::AbstractTransporter::groupCommandsByDb(
+    const QList<Command> &commands) const {
+  if (m_connection->mode() == Connection::Mode::Cluster) return commands;
+
+  QList<Command> result;
+  result.reserve(commands.size());
+
+  int currentDb = m_selectedDb;
+  int i = 0;
+
+  while (i < commands.size()) {
+    // Commands without db index depend on db selected on the socket
+    // and keep their position
+    if (!commands[i].hasDbIndex() || commands[i].isSelectCommand()) {
+      if (commands[i].isSelectCommand())
+        currentDb = commands[i].getDbIndex();
+
+      result.append(commands[i++]);
+      continue;
+    }
+
+    int end = i;
+    QList<int> dbOrder;
+    QHash<int, QList<int>> groups;
+
+    for (; end < commands.size() && commands[end].hasDbIndex() &&
+           !commands[end].isSelectCommand();
+         ++end) {
+      int db = commands[end].getDbIndex();
+      if (!groups.contains(db)) dbOrder.append(db);
+      groups[db].append(end);
+    }
+
+    // Start from db which is already selected
+    int selectedPos = dbOrder.indexOf(currentDb);
+    if (selectedPos > 0) dbOrder.move(selectedPos, 0);
+
+    for (int db : dbOrder) {
+      for (int index : groups[db]) result.append(commands[index]);
+    }
+
+    currentDb = dbOrder.last();
+    i = end;
+  }
+
+  return result;
+}
+
+RedisClient::AbstractTransporter::WriteBatchStats
+RedisClient::AbstractTransporter::writeBatchStats() const {
+  WriteBatchStats stats;
+  stats.batches = m_statBatches.loadAcquire();
+  stats.commands = m_statCommands.loadAcquire();
+  stats.bytes = m_statBytes.loadAcquire();
+  stats.lastBatchSize = m_statLastBatchSize.loadAcquire();
+  stats.maxBatchSize = m_statMaxBatchSize.loadAcquire();
+  return stats;
+}
+
+bool RedisClient::AbstractTransporter::runNextQueuedCommand() {
+  // Wait for cluster redirect
+  if (m_commands.isEmpty() || !m_redirectHost.isEmpty()) return false;
+
+  const QueuedCommand &head = m_commands.head();
+  qint64 deadline = commandDeadline(head.cmd, head.queuedAt);
+
+  if (deadline > 0 && deadline <= m_queueClock.nsecsElapsed()) {
+    Command expired = m_commands.dequeue().cmd;
+    trackQueuedCommand(expired, -1);
+    failExpiredCommand(expired);
+    return true;
+  }
+
   if (m_connection->mode() != Connection::Mode::Cluster
-          && m_commands.head().hasDbIndex()) {
+          && head.cmd.hasDbIndex()
+          && head.cmd.getDbIndex() != m_selectedDb) {
     QList<QByteArray> selectCmdRaw = {
-        "SELECT", QString::number(m_commands.head().getDbIndex()).toLatin1()};
+        "SELECT", QString::number(head.cmd.getDbIndex()).toLatin1()};
     Command selectCmd(selectCmdRaw);
     runCommand(selectCmd);
   }
 
-  runCommand(m_commands.dequeue());
+  QueuedCommand queued = m_commands.dequeue();
+  trackQueuedCommand(queued.cmd, -1);
+  recordQueueWait(queued);
+  runCommand(queued.cmd, queued.queuedAt);
+  return true;
+}
 
-  QTimer::singleShot(0, this, &AbstractTransporter::processCommandQueue);
+RedisClient::AbstractTransporter::QueuedCommand
+RedisClient::AbstractTransporter::markQueued(const Command &cmd) {
+  // Zero means that command was queued without timestamp
+  QueuedCommand queued(cmd, qMax(Q_INT64_C(1), m_queueClock.nsecsElapsed()));
+
+  if (cmd.timeout() > 0) trackQueuedDeadline(queued);
+
+  return queued;
+}
+
+qint64 RedisClient::AbstractTransporter::commandDeadline(
+    const Command &cmd, qint64 queuedAt) const {
+  if (cmd.timeout() == 0 || queuedAt <= 0) return 0;
+
+  return queuedAt + static_cast<qint64>(cmd.timeout()) * 1000000;
+}
+
+void RedisClient::AbstractTransporter::trackDeadline(
+    QSharedPointer<RunningCommand> runningCommand) {
+  m_deadlines.insert(runningCommand->deadline, runningCommand);
+  scheduleExecutionTimeout();
+}
+
+void RedisClient::AbstractTransporter::untrackDeadline(
+    QSharedPointer<RunningCommand> runningCommand) {
+  qint64 deadline = runningCommand->deadline;
+
+  for (auto it = m_deadlines.find(deadline);
+       it != m_deadlines.end() && it.key() == deadline; ++it) {
+    if (it.value() == runningCommand) {
+      m_deadlines.erase(it);
+      return;
+    }
+  }
+}
+
+void RedisClient::AbstractTransporter::trackQueuedDeadline(
+    const QueuedCommand &queued) {
+  qint64 deadline = commandDeadline(queued.cmd, queued.queuedAt);
+
+  if (deadline <= 0) return;
+
+  // Queue is scanned only when the earliest deadline is reached
+  if (m_nextQueuedDeadline == 0 || deadline < m_nextQueuedDeadline) {
+    m_nextQueuedDeadline = deadline;
+    scheduleExecutionTimeout();
+  }
+}
+
+void RedisClient::AbstractTransporter::scheduleExecutionTimeout() {
+  qint64 next = m_nextQueuedDeadline;
+
+  if (!m_deadlines.isEmpty() && (next == 0 || m_deadlines.firstKey() < next))
+    next = m_deadlines.firstKey();
+
+  if (next == 0) return m_executionTimer->stop();
+
+  qint64 wait = qMax(Q_INT64_C(0),
+                     (next - m_queueClock.nsecsElapsed() + 999999) / 1000000);
+
+  if (m_executionTimer->isActive() &&
+      m_executionTimer->remainingTime() <= wait)
+    return;
+
+  m_executionTimer->start(static_cast<int>(qMin(wait, qint64(INT_MAX))));
+}
+
+QList<RedisClient::Command>
+RedisClient::AbstractTransporter::takeExpiredQueuedCommands(qint64 now) {
+  QList<Command> expired;
+  m_nextQueuedDeadline = 0;
+
+  for (auto it = m_commands.begin(); it != m_commands.end();) {
+    qint64 deadline = commandDeadline(it->cmd, it->queuedAt);
+
+    if (deadline > 0 && deadline <= now) {
+      expired.append(it->cmd);
+      trackQueuedCommand(it->cmd, -1);
+      it = m_commands.erase(it);
+      continue;
+    }
+
+    if (deadline > 0 &&
+        (m_nextQueuedDeadline == 0 || deadline < m_nextQueuedDeadline))
+      m_nextQueuedDeadline = deadline;
+
+    ++it;
+  }
+
+  return expired;
+}
+
+void RedisClient::AbstractTransporter::failExpiredCommand(const Command &cmd) {
+  failCommand(cmd, "Execution timeout");
+}
+
+void RedisClient::AbstractTransporter::failCommand(const Command &cmd,
+                                                   const QString &error) {
+  emit logEvent(QString("%1 > %2: %3")
+                    .arg(m_connection->sharedSettings()->name)
+                    .arg(error)
+                    .arg(printableString(cmd.getRawString())));
+
+  cmd.getDeferred().cancel();
+
+  if (ResponseDispatcher::canDispatch(cmd))
+    ResponseDispatcher::dispatch(cmd, Response(), error);
+}
+
+void RedisClient::AbstractTransporter::connectionFailed(const QString &error) {
+  finishConnect();
+
+  if (!m_connectionEstablished || !m_reconnectEnabled) {
+    emit errorOccurred(error);
+    return;
+  }
+
+  emit logEvent(QString("%1 > %2")
+                    .arg(m_connection->sharedSettings()->name)
+                    .arg(error));
+
+  replayInterruptedCommands();
+  scheduleReconnect();
+}
+
+void RedisClient::AbstractTransporter::beginConnect() {
+  m_connecting = true;
+  m_connectTimer->start(m_connection->sharedSettings()->connectionTimeout);
+}
+
+bool RedisClient::AbstractTransporter::finishConnect() {
+  if (!m_connecting) return false;
+
+  m_connecting = false;
+  m_connectTimer->stop();
+  return true;
+}
+
+void RedisClient::AbstractTransporter::connectTimeout() {
+  if (!finishConnect()) return;
+
+  // Late connected() of aborted socket is not reported
+  abortConnect();
+
+  emit logEvent(QString("%1 > connection failed")
+                    .arg(m_connection->sharedSettings()->name));
+  connectionFailed("Connection timeout");
+}
+
+void RedisClient::AbstractTransporter::scheduleReconnect() {
+  if (m_reconnectTimer->isActive()) return;
+
+  auto settings = m_connection->sharedSettings();
+
+  if (settings->reconnectMaxAttempts > 0 &&
+      m_reconnectAttempts >= settings->reconnectMaxAttempts) {
+    m_connectionEstablished = false;
+    emit errorOccurred(QString("Connection was lost. Reconnect failed after "
+                               "%1 attempts")
+                           .arg(m_reconnectAttempts));
+    return;
+  }
+
+  uint delay = reconnectDelay(settings->reconnectMinDelay,
+                              settings->reconnectMaxDelay, m_reconnectAttempts);
+  ++m_reconnectAttempts;
+
+  emit logEvent(QString("%1 > Reconnect attempt %2 in %3 ms")
+                    .arg(settings->name)
+                    .arg(m_reconnectAttempts)
+                    .arg(delay));
+
+  m_reconnectTimer->start(delay);
+}
+
+uint RedisClient::AbstractTransporter::reconnectDelay(uint minDelay,
+                                                      uint maxDelay,
+                                                      uint attempt) {
+  // Seeded per thread, so clients restarted together don't reconnect
+  // in lockstep
+  static thread_local std::minstd_rand generator(std::random_device{}());
+
+  quint64 delay = qMax(1u, minDelay);
+
+  for (uint i = 0; i < attempt && delay < maxDelay; ++i) delay *= 2;
+
+  delay = qMin<quint64>(delay, qMax(minDelay, maxDelay));
+
+  // Half of delay is fixed, the rest is random
+  std::uniform_int_distribution<quint64> jitter(0, delay / 2);
+  return static_cast<uint>(delay - delay / 2 + jitter(generator));
+}
+
+void RedisClient::AbstractTransporter::replayInterruptedCommands() {
+  auto policy = m_connection->sharedSettings()->replayPolicy;
+  QList<Command> interrupted;
+
+  // Commands which may be applied by server already are not sent again
+  for (auto rCmd : m_runningCommands) {
+    if (rCmd->expired || policy == ConnectionConfig::ReplayPolicy::All ||
+        (policy == ConnectionConfig::ReplayPolicy::ReadOnly &&
+         rCmd->cmd.isReadOnlyCommand()))
+      continue;
+
+    interrupted.append(rCmd->cmd);
+
+    // Skipped by reAddRunningCommandToQueue()
+    rCmd->expired = true;
+  }
+
+  reAddRunningCommandToQueue();
+  m_metrics->setInFlight(0);
+  m_streamReader.reset();
+  m_parser.reset();
+
+  for (const Command &cmd : interrupted)
+    failCommand(cmd, "Connection was interrupted");
+}
+
+void RedisClient::AbstractTransporter::recordQueueWait(
+    const QueuedCommand &queued) {
+  if (queued.queuedAt <= 0) return;
+
+  int priority = static_cast<int>(queued.cmd.priority());
+  quint64 wait = static_cast<quint64>(
+      qMax(Q_INT64_C(0), m_queueClock.nsecsElapsed() - queued.queuedAt) /
+      1000);
+
+  m_statQueuedCommands[priority].fetchAndAddRelaxed(1);
+  m_statQueueWait[priority].fetchAndAddRelaxed(wait);
+
+  // Stats are updated only from transporter thread
+  if (wait > m_statMaxQueueWait[priority].loadAcquire())
+    m_statMaxQueueWait[priority].storeRelease(wait);
+}
+
+RedisClient::AbstractTransporter::QueueWaitStats
+RedisClient::AbstractTransporter::queueWaitStats(
+    Command::Priority priority) const {
+  int i = static_cast<int>(priority);
+
+  QueueWaitStats stats;
+  stats.commands = m_statQueuedCommands[i].loadAcquire();
+  stats.totalWait = m_statQueueWait[i].loadAcquire();
+  stats.maxWait = m_statMaxQueueWait[i].loadAcquire();
+  return stats;
+}
+
+void RedisClient::AbstractTransporter::recordCommandMetrics(
+    QSharedPointer<RunningCommand> runningCommand) {
+  if (runningCommand->sentAt <= 0) return;
+
+  const Command &cmd = runningCommand->cmd;
+  qint64 now = m_queueClock.nsecsElapsed();
+  qint64 sentAt = runningCommand->sentAt;
+  qint64 writtenAt = qMax(runningCommand->writtenAt, sentAt);
+  qint64 queuedAt = runningCommand->queuedAt > 0
+                        ? qMin(runningCommand->queuedAt, sentAt)
+                        : sentAt;
+
+  static const QByteArray pipeline("pipeline");
+
+  m_metrics->recordCommand(
+      cmd.isPipelineCommand() ? pipeline
+                              : cmd.getSplitedRepresentattion().value(0),
+      (sentAt - queuedAt) / 1000, (writtenAt - sentAt) / 1000,
+      qMax(Q_INT64_C(0), now - writtenAt) / 1000);
 }
 
 void RedisClient::AbstractTransporter::logResponse(
@@ -201,7 +1192,7 @@ void RedisClient::AbstractTransporter::logResponse(
   }
 
   emit logEvent(QString("%1 > Response received : %2")
-                    .arg(m_connection->getConfig().name())
+                    .arg(m_connection->sharedSettings()->name)
                     .arg(result));
 
   // qDebug() << "Response:" << response.source();
@@ -210,21 +1201,40 @@ void RedisClient::AbstractTransporter::logResponse(
 void RedisClient::AbstractTransporter::processClusterRedirect(
     QSharedPointer<RunningCommand> runningCommand,
     const RedisClient::Response &response) {
-  Q_ASSERT(runningCommand);
-  qDebug() << "Cluster redirect";
+  if (runningCommand) {
+    qDebug() << "Cluster redirect";
 
-  m_commands.prepend(runningCommand->cmd);
-  runningCommand.clear();
+    m_redirectedCommands.append(
+        QueuedCommand(runningCommand->cmd, runningCommand->queuedAt));
+    runningCommand.clear();
 
-  QString host;
-  int port = response.getRedirectionPort();
+    if (m_redirectHost.isEmpty()) {
+      m_redirectPort = response.getRedirectionPort();
 
-  if (m_connection->m_config.overrideClusterHost()) {
-    host = response.getRedirectionHost();
-  } else {
-    host = m_connection->m_config.host();
+      auto settings = m_connection->sharedSettings();
+
+      if (settings->overrideClusterHost) {
+        m_redirectHost = response.getRedirectionHost();
+      } else {
+        m_redirectHost = settings->host;
+      }
+    }
   }
 
+  // Pipelined commands are still running on current node
+  if (!m_runningCommands.isEmpty()) return;
+
+  for (auto cmd = m_redirectedCommands.rbegin();
+       cmd != m_redirectedCommands.rend(); ++cmd) {
+    m_commands.prepend(*cmd);
+    trackQueuedCommand(cmd->cmd, 1);
+  }
+  m_redirectedCommands.clear();
+
+  QString host = m_redirectHost;
+  int port = m_redirectPort;
+  m_redirectHost.clear();
+
   QTimer::singleShot(1, this,
                      [this, host, port]() { reconnectTo(host, port); });
 }
@@ -239,6 +1249,11 @@ void RedisClient::AbstractTransporter::reconnectTo(const QString &host,
   config.setPort(port);
   m_connection->setConnectionConfig(config);
 
+  // Commands are held in queue while connection is switched to another
+  // node (sentinel failover) and are sent once new node is ready.
+  // Interrupted commands are replayed according to replay policy.
+  replayInterruptedCommands();
+
   reconnect();
 }
 
@@ -246,75 +1261,214 @@ void RedisClient::AbstractTransporter::addSubscriptionsFromRunningCommand(
     QSharedPointer<RunningCommand> runningCommand) {
   Q_ASSERT(runningCommand);
 
-  if (!runningCommand->emitter) return;
+  m_subscriptions.subscribe(runningCommand->cmd);
+}
+
+void RedisClient::AbstractTransporter::executionTimeout() {
+  qint64 now = m_queueClock.nsecsElapsed();
+  QList<Command> expired;
+
+  while (!m_deadlines.isEmpty() && m_deadlines.firstKey() <= now) {
+    QSharedPointer<RunningCommand> runningCommand =
+        m_deadlines.begin().value().toStrongRef();
+    m_deadlines.erase(m_deadlines.begin());
 
-  QList<QByteArray> channels =
-      runningCommand->cmd.getSplitedRepresentattion().mid(1);
+    if (!runningCommand) continue;
 
-  for (QByteArray channel : channels) {
-    m_subscriptions.insert(channel, runningCommand->emitter);
+    // Reply is still expected, so command keeps its place in
+    // running queue until reply arrives
+    runningCommand->expired = true;
+    expired.append(runningCommand->cmd);
   }
-}
 
-void RedisClient::AbstractTransporter::executionTimeout() {
-  qDebug() << "Command execution/download timeout";
-  emit errorOccurred("Execution timeout");
+  if (m_nextQueuedDeadline > 0 && m_nextQueuedDeadline <= now)
+    expired.append(takeExpiredQueuedCommands(now));
+
+  // Callbacks are called after queues are updated
+  for (const Command &cmd : expired) failExpiredCommand(cmd);
+
+  scheduleExecutionTimeout();
 }
 
 void RedisClient::AbstractTransporter::readyRead() {
-  if (!canReadFromSocket()) return;
-
-  if (!m_parser.feedBuffer(readFromSocket())) {
-    // TODO: reset???!
+  if (m_pausedSubscriberQueues.loadAcquire() > 0 || !canReadFromSocket())
     return;
+
+  quint64 allocations = m_parser.replyAllocations();
+  QIODevice *device = socketDevice();
+  int replies = 0;
+
+  if (device && !isStreamingReplyExpected()) {
+    replies = readIntoParser(device);
+  } else {
+    QByteArray data = readFromSocket();
+    m_metrics->addBytesIn(data.size());
+    replies = processIncomingData(std::move(data));
   }
 
-  QList<RedisClient::Response> responses;
+  m_metrics->addReplies(replies, m_parser.replyAllocations() - allocations);
+}
+
+int RedisClient::AbstractTransporter::readIntoParser(QIODevice *device) {
+  qint64 available = device->bytesAvailable();
+  char *buffer = m_parser.prepareWrite(available);
+
+  if (!buffer) return 0;
+
+  qint64 size = device->read(buffer, available);
+
+  if (size <= 0) return 0;
+
+  m_metrics->addBytesIn(size);
+
+  if (!m_parser.commitWrite(size)) {
+    failOnParserError();
+    return 0;
+  }
+
+  QByteArray rest;
+  int replies = takeParsedReplies(rest);
+
+  if (!rest.isEmpty()) replies += processIncomingData(std::move(rest));
+
+  return replies;
+}
+
+int RedisClient::AbstractTransporter::takeParsedReplies(QByteArray &rest) {
+  int replies = 0;
   RedisClient::Response resp;
 
   do {
     resp = m_parser.getNextResponse();
 
-    if (resp.isValid()) responses.append(resp);
+    if (!resp.isValid()) break;
+
+    sendResponse(resp);
+    ++replies;
+
+    // Hand over the rest of buffer to streaming reader
+    if (isStreamingReplyExpected() && m_parser.hasUnusedBuffer()) {
+      rest = m_parser.unusedBuffer();
+      m_parser.reset();
+      break;
+    }
   } while (resp.isValid());
 
-  for (auto r : responses) {
-    sendResponse(r);
+  return replies;
+}
+
+void RedisClient::AbstractTransporter::failOnParserError() {
+  if (!m_parser.isBufferLimitExceeded()) return;
+
+  // Unparsed part of runaway reply can't be skipped, so connection
+  // is closed and parser is ready for next connection
+  m_parser.reset();
+  emit errorOccurred("Reply exceeds max reply buffer size");
+}
+
+int RedisClient::AbstractTransporter::processIncomingData(QByteArray data) {
+  int replies = 0;
+
+  while (!data.isEmpty()) {
+    if (isStreamingReplyExpected()) {
+      if (!m_streamReader.isActive())
+        m_streamReader.start(
+            m_runningCommands.head()->cmd.getStreamCallback());
+
+      // Chunks are passed to stream callback which may keep them, so
+      // data referencing receive buffer of transporter is copied here
+      data.detach();
+
+      data = m_streamReader.feed(data);
+
+      if (m_streamReader.isFinished()) {
+        sendResponse(m_streamReader.takeResponse());
+        ++replies;
+      }
+
+      continue;
+    }
+
+    if (!m_parser.feedBuffer(data)) {
+      // TODO: reset???!
+      failOnParserError();
+      return replies;
+    }
+
+    data.clear();
+    replies += takeParsedReplies(data);
   }
+
+  return replies;
+}
+
+bool RedisClient::AbstractTransporter::isStreamingReplyExpected() const {
+  return m_streamReader.isActive() ||
+         (!m_runningCommands.isEmpty() &&
+          m_runningCommands.head()->cmd.isStreamingCommand());
 }
 
 void RedisClient::AbstractTransporter::runCommand(
-    const RedisClient::Command &command) {
+    const RedisClient::Command &command, qint64 queuedAt) {
   if (isSocketReconnectRequired()) {
     if (!m_reconnectEnabled) {
       qDebug() << "Connection disconnected on error. Ignoring commands.";
       return;
     }
     qDebug() << "Cannot run command. Reconnect is required.";
-    m_commands.enqueue(command);
-    reconnect();
+    m_commands.enqueue(QueuedCommand(command, queuedAt));
+    trackQueuedCommand(command, 1);
+
+    // Otherwise command is sent once scheduled reconnect succeeds
+    if (!m_reconnectTimer->isActive()) reconnect();
     return;
   }
 
-  emit logEvent(QString("%1 > [runCommand] %2")
-                    .arg(m_connection->getConfig().name())
-                    .arg(printableString(command.getRawString())));
+  qint64 deadline = commandDeadline(command, queuedAt);
+  Command cmd = command;
+
+  // Server stops blocking before command times out, so socket isn't
+  // occupied by command nobody waits for
+  if (deadline > 0) {
+    cmd.limitBlockingTimeout(
+        (deadline - m_queueClock.nsecsElapsed()) / 1000000,
+        m_connection->m_fractionalTimeouts.loadAcquire() != 0);
+  }
+
+  // Formatting of raw command is expensive, skip it if nobody listens
+  if (m_connection->isLogEnabled()) {
+    emit logEvent(QString("%1 > [runCommand] %2")
+                      .arg(m_connection->sharedSettings()->name)
+                      .arg(printableString(cmd.getRawString())));
+  }
 
   // m_response.reset();
-  auto runningCommand =
-      QSharedPointer<RunningCommand>(new RunningCommand(command));
+  auto runningCommand = QSharedPointer<RunningCommand>(new RunningCommand(cmd));
+  runningCommand->queuedAt = queuedAt;
+  runningCommand->sentAt = m_queueClock.nsecsElapsed();
   m_runningCommands.enqueue(runningCommand);
+  m_metrics->setInFlight(m_runningCommands.size());
 
-  sendCommand(runningCommand->cmd.getByteRepresentation());
+  if (deadline > 0) {
+    runningCommand->deadline = deadline;
+    trackDeadline(runningCommand);
+  }
+
+  if (command.isSelectCommand()) m_selectedDb = command.getDbIndex();
+  runningCommand->db = m_selectedDb;
+
+  appendToWriteBatch(runningCommand->cmd.getByteRepresentationChunks());
+  ++m_writeBatchCommands;
+
+  if (isWriteBatchFull()) flushWriteBatch();
 }
 
 RedisClient::AbstractTransporter::RunningCommand::RunningCommand(
     const RedisClient::Command &cmd)
-    : cmd(cmd), emitter(nullptr) {
-  auto callback = cmd.getCallBack();
-  auto owner = cmd.getOwner();
-  if (callback && owner) {
-    emitter =
-        QSharedPointer<ResponseEmitter>(new ResponseEmitter(owner, callback));
-  }
-}
+    : cmd(cmd),
+      db(-1),
+      deadline(0),
+      queuedAt(0),
+      sentAt(0),
+      writtenAt(0),
+      expired(false) {}
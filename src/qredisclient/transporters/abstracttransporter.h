@@ -1,17 +1,27 @@
 #pragma once
+#include <QAtomicInteger>
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QMap>
+#include <QMutex>
 #include <QObject>
 #include <QQueue>
 #include <QSharedPointer>
 #include <QTimer>
+#include <QWaitCondition>
 #include <functional>
 
 #include "qredisclient/command.h"
+#include "qredisclient/connectionconfig.h"
+#include "qredisclient/connectionmetrics.h"
+#include "qredisclient/private/mpscqueue.h"
+#include "qredisclient/private/streamingreplyreader.h"
+#include "qredisclient/private/subscriptionindex.h"
 #include "qredisclient/responseparser.h"
 
 namespace RedisClient {
 
-class ResponseEmitter;
 class Connection;
 
 /**
@@ -25,6 +35,94 @@ class AbstractTransporter : public QObject {
   AbstractTransporter(Connection* c);  // TODO: replace raw pointer by WeakPtr
   virtual ~AbstractTransporter();
 
+  /**
+   * @brief The WriteBatchStats struct
+   * Snapshot of write coalescing counters
+   */
+  struct WriteBatchStats {
+    quint64 batches;
+    quint64 commands;
+    quint64 bytes;
+    uint lastBatchSize;
+    uint maxBatchSize;
+
+    double averageBatchSize() const {
+      return batches > 0 ? double(commands) / batches : 0.0;
+    }
+  };
+
+  /**
+   * @brief writeBatchStats
+   * Thread-safe, can be called from any thread
+   */
+  WriteBatchStats writeBatchStats() const;
+
+  /**
+   * @brief The SubscriberQueueStats struct
+   * Snapshot of pub/sub delivery counters
+   */
+  struct SubscriberQueueStats {
+    qint64 depth;  // messages waiting for delivery in all subscriptions
+    quint64 delivered;
+    quint64 dropped;
+    bool readingPaused;
+  };
+
+  /**
+   * @brief subscriberQueueStats
+   * Thread-safe, can be called from any thread
+   */
+  SubscriberQueueStats subscriberQueueStats() const;
+
+  /**
+   * @brief The QueueWaitStats struct
+   * Time spent by commands of priority class in transporter queue
+   * before they were written to socket
+   */
+  struct QueueWaitStats {
+    quint64 commands;
+    quint64 totalWait;  // in microseconds
+    quint64 maxWait;    // in microseconds
+
+    double averageWait() const {
+      return commands > 0 ? double(totalWait) / commands : 0.0;
+    }
+  };
+
+  /**
+   * @brief queueWaitStats
+   * Thread-safe, can be called from any thread
+   */
+  QueueWaitStats queueWaitStats(Command::Priority priority) const;
+
+  /**
+   * @brief The CommandQueueStats struct
+   * Commands which are waiting to be written to socket, including
+   * commands submitted from caller threads
+   */
+  struct CommandQueueStats {
+    int commands;
+    qint64 bytes;
+    int blockedProducers;
+    bool underPressure;
+  };
+
+  /**
+   * @brief commandQueueStats
+   * Thread-safe, can be called from any thread
+   */
+  CommandQueueStats commandQueueStats() const;
+
+  /**
+   * @brief Submit command from any thread.
+   * Command is pushed to lock-free queue and transporter is woken up
+   * by single event when queue becomes non-empty.
+   * If command queue is full command fails or caller is blocked
+   * according to QueueOverflowPolicy.
+   */
+  void submitCommand(const Command& cmd);
+  void submitCommands(const QList<Command>& commands);
+
  signals:
   void errorOccurred(const QString&);
   void logEvent(const QString&);
@@ -32,56 +130,285 @@ class AbstractTransporter : public QObject {
   void commandAdded();
   void queueIsEmpty();
 
+  /**
+   * @brief RESP3 push frame which doesn't belong to any subscription
+   * or running command (e.g. client tracking invalidation)
+   */
+  void pushMessageReceived(const Response&);
+
+  /**
+   * @brief Command queue reached its limits (true) or was drained
+   * below half of them (false). Emitted from any thread.
+   */
+  void queuePressureChanged(bool underPressure);
+
  public slots:
   virtual void init();
   virtual void disconnectFromHost();
+
+  /**
+   * @brief Disconnect and move transporter to another thread.
+   * Used to release shared I/O thread before transporter is destroyed.
+   */
+  virtual void detachToThread(QThread* thread);
   virtual void addCommand(const Command&);
+  virtual void addCommands(const QList<Command>&);
   virtual void cancelCommands(QObject*);
   virtual void readyRead();
 
  protected slots:
+  /**
+   * @brief Fail commands which passed their deadline.
+   * Connection and other running commands are not affected.
+   */
   virtual void executionTimeout();
   virtual void reconnect() = 0;
   virtual void reconnectTo(const QString& host, int port);
+  virtual void connectTimeout();
   virtual void processCommandQueue();
+  virtual void flushWriteBatch();
   virtual void cancelRunningCommands();
+  virtual void processSubmittedCommands();
+  virtual void resumeReading();
 
  protected:
   virtual bool isInitialized() const = 0;
   virtual bool isSocketReconnectRequired() const = 0;
   virtual bool canReadFromSocket() = 0;
+
+  /**
+   * @brief Returned data may reference internal buffer of transporter,
+   * it should be consumed before next read
+   */
   virtual QByteArray readFromSocket() = 0;
+
+  /**
+   * @brief Socket which allows reading directly into parser buffer,
+   * nullptr if data is available only through readFromSocket()
+   */
+  virtual QIODevice* socketDevice() { return nullptr; }
   virtual void initSocket() = 0;
-  virtual bool connectToHost() = 0;
-  virtual void runCommand(const Command& command);
+
+  /**
+   * @brief Start connection attempt without blocking transporter thread.
+   * Socket signals complete it with finishConnect() and connected()
+   * or connectionFailed(). Attempt which cannot be started is reported
+   * with errorOccurred().
+   */
+  virtual void connectToHost() = 0;
+
+  /**
+   * @brief Abort socket of connection attempt which timed out
+   */
+  virtual void abortConnect() {}
+  virtual void runCommand(const Command& command, qint64 queuedAt = 0);
   virtual void sendCommand(const QByteArray& cmd) = 0;
+  virtual void flushSocket() {}
+
+  /**
+   * @brief Stop reading from OS socket buffer, so redis-server
+   * is throttled by TCP flow control
+   */
+  virtual void setSocketReadingPaused(bool paused) { Q_UNUSED(paused); }
   virtual void sendResponse(const Response& response);
   void resetDbIndex();
+  void enqueueCommand(const Command& cmd);
+  void enqueueCommands(const QList<Command>& commands);
+  void wakeUpForSubmissions();
+
+  /**
+   * @brief Socket was closed or connection attempt failed.
+   * Connection which was established before is restored in background
+   * with backoff. Otherwise or once attempts are exhausted error is emitted.
+   */
+  void connectionFailed(const QString& error);
+
+  /**
+   * @brief Connection attempt fails unless finishConnect() is called
+   * within connection timeout
+   */
+  void beginConnect();
+
+  /**
+   * @return false if there is no pending connection attempt
+   */
+  bool finishConnect();
 
  protected:
   class RunningCommand {
    public:
     RunningCommand(const Command& cmd);
     Command cmd;
-    QSharedPointer<ResponseEmitter> emitter;
+    int db;  // db selected on the socket when command was sent
+    qint64 deadline;  // m_queueClock nsecs, 0 - no timeout
+    qint64 queuedAt;  // m_queueClock nsecs, 0 - command wasn't queued
+
+    // m_queueClock nsecs, 0 - command wasn't sent by runCommand()
+    qint64 sentAt;
+    qint64 writtenAt;
+
+    // Command failed by timeout, reply is discarded when it arrives
+    bool expired;
+  };
+
+  // Command in transporter queue. Queue timestamp is kept here instead of
+  // shared data of command, so queued command isn't detached from caller.
+  struct QueuedCommand {
+    QueuedCommand(const Command& cmd = Command(), qint64 queuedAt = 0)
+        : cmd(cmd), queuedAt(queuedAt) {}
+
+    Command cmd;
+    qint64 queuedAt;  // m_queueClock nsecs, 0 - queued without timestamp
   };
 
+  QueuedCommand markQueued(const Command& cmd);
+  void recordQueueWait(const QueuedCommand& queued);
+
   void reAddRunningCommandToQueue(QObject* ignoreOwner = nullptr);
+  bool runNextQueuedCommand();
+  void scheduleCommandQueueProcessing();
+  void appendToWriteBatch(const QList<QByteArray>& chunks);
+  bool isWriteBatchFull() const;
+  void loadWriteBatchPolicy();
+  void loadSubscriberQueuePolicy();
+  void loadCommandQueuePolicy();
+  void pauseReading();
+  void discardWriteBatch();
+  QList<Command> groupCommandsByDb(const QList<Command>& commands) const;
+
+  /**
+   * @brief Parse data and dispatch replies
+   * @return Number of parsed replies
+   */
+  int processIncomingData(QByteArray data);
+  int readIntoParser(QIODevice* device);
+  int takeParsedReplies(QByteArray& rest);
+  void failOnParserError();
+  bool isStreamingReplyExpected() const;
 
  private:
   void logResponse(const Response& response);
+  void recordCommandMetrics(QSharedPointer<RunningCommand> runningCommand);
+  void processPushMessage(const Response& response);
+  bool processSubscriptionConfirmation(const Response& response);
+  void updateServerSubscriptions(const Response& response);
+  void completeRunningCommand(QSharedPointer<RunningCommand> runningCommand,
+                              const Response& response);
   void processClusterRedirect(QSharedPointer<RunningCommand> runningCommand,
                               const Response& r);
+  qint64 commandDeadline(const Command& cmd, qint64 queuedAt) const;
+  void trackDeadline(QSharedPointer<RunningCommand> runningCommand);
+  void untrackDeadline(QSharedPointer<RunningCommand> runningCommand);
+  void trackQueuedDeadline(const QueuedCommand& queued);
+  void scheduleExecutionTimeout();
+  QList<Command> takeExpiredQueuedCommands(qint64 now);
+  void failExpiredCommand(const Command& cmd);
+  void failCommand(const Command& cmd, const QString& error);
+  void failDroppedCommands(const QList<Command>& commands);
+  void scheduleReconnect();
+  bool admitCommands(int count, qint64 bytes, bool hiPriority);
+  bool isCommandQueueFull(int commands, qint64 bytes, int incoming) const;
+  void trackQueuedCommand(const Command& cmd, int delta);
+  void untrackQueuedCommands(const QList<Command>& commands);
+  void shedQueuedCommands();
+  void setQueuePressure(bool underPressure);
+  void replayInterruptedCommands();
   void addSubscriptionsFromRunningCommand(
       QSharedPointer<RunningCommand> runningCommand);
 
  protected:
+  /**
+   * @brief Delay before reconnect attempt, doubled with every attempt
+   * up to max delay. Half of delay is randomized.
+   */
+  static uint reconnectDelay(uint minDelay, uint maxDelay, uint attempt);
+
   Connection* m_connection;
   QQueue<QSharedPointer<RunningCommand>> m_runningCommands;
-  QQueue<Command> m_commands;
-  typedef QHash<QByteArray, QSharedPointer<ResponseEmitter>> Subscriptions;
-  Subscriptions m_subscriptions;
+  QQueue<QueuedCommand> m_commands;
+  SubscriptionIndex m_subscriptions;
+  QSharedPointer<SubscriberQueue::Counters> m_subscriberCounters;
+
+  // Number of subscriber queues over the limit with PauseReading policy
+  QAtomicInt m_pausedSubscriberQueues;
   bool m_reconnectEnabled;
+
+  // DB index selected on the socket, including SELECT commands
+  // which are still in flight. -1 means unknown.
+  int m_selectedDb;
+
+  // Subscriptions count reported by the last confirmation. Server stays
+  // in pub/sub mode until it is 0, even if index is already empty.
+  int m_serverSubscriptions;
+
+  // Cluster redirect is postponed until responses of all
+  // in-flight commands are received
+  QList<QueuedCommand> m_redirectedCommands;
+  QString m_redirectHost;
+  int m_redirectPort;
   ResponseParser m_parser;
+  StreamingReplyReader m_streamReader;
+
+  // Write coalescing
+  QList<QByteArray> m_writeBatch;
+  int m_writeBatchCommands;
+  int m_writeBatchBytes;
+  int m_writeBatchMaxBytes;
+  int m_writeBatchMaxCommands;
+  uint m_writeBatchMaxDelay;
+  QTimer* m_writeBatchTimer;
+  bool m_writeBatchTailOpen;
+  bool m_queueProcessingScheduled;
+
+  // Commands submitted from caller threads.
+  // Batch is used for pipelined commands to keep submission order.
+  struct Submission {
+    Command cmd;
+    QList<Command> batch;
+  };
+  MpscQueue<Submission> m_submissions;
+  QAtomicInt m_submissionWakeUpPending;
+
+  QAtomicInteger<quint64> m_statBatches;
+  QAtomicInteger<quint64> m_statCommands;
+  QAtomicInteger<quint64> m_statBytes;
+  QAtomicInteger<uint> m_statLastBatchSize;
+  QAtomicInteger<uint> m_statMaxBatchSize;
+
+  QElapsedTimer m_queueClock;
+  QAtomicInteger<quint64> m_statQueuedCommands[Command::PRIORITY_CLASSES];
+  QAtomicInteger<quint64> m_statQueueWait[Command::PRIORITY_CLASSES];
+  QAtomicInteger<quint64> m_statMaxQueueWait[Command::PRIORITY_CLASSES];
+
+  // Deadlines of running commands ordered by time. Single timer is armed
+  // for the earliest deadline of running or queued commands.
+  QMultiMap<qint64, QWeakPointer<RunningCommand>> m_deadlines;
+  qint64 m_nextQueuedDeadline;  // 0 - no queued commands with timeout
+  QTimer* m_executionTimer;
+
+  // Pending connection attempt, see beginConnect()
+  QTimer* m_connectTimer;
+  bool m_connecting;
+
+  // Background reconnect with exponential backoff
+  QTimer* m_reconnectTimer;
+  uint m_reconnectAttempts;
+  bool m_connectionEstablished;  // connected at least once since init()
+
+  // Bounded command queue. Counters include commands submitted from
+  // caller threads which are not moved to m_commands yet.
+  QAtomicInt m_queuedCommands;
+  QAtomicInteger<qint64> m_queuedBytes;
+  int m_queueMaxCommands;  // 0 - unlimited
+  qint64 m_queueMaxBytes;  // 0 - unlimited
+  ConnectionConfig::QueueOverflowPolicy m_queueOverflowPolicy;
+  uint m_queueBlockTimeout;
+  QAtomicInt m_blockedProducers;
+  QAtomicInt m_queuePressure;
+  QMutex m_queueSpaceLock;
+  QWaitCondition m_queueSpace;
+
+  // Shared with connection, so metrics outlive transporter
+  QSharedPointer<ConnectionMetrics> m_metrics;
 };
 }  // namespace RedisClient
@@ -1,14 +1,15 @@
 #include "defaulttransporter.h"
 #include "qredisclient/connection.h"
 #include "qredisclient/connectionconfig.h"
-#include "qredisclient/utils/sync.h"
+#include "qredisclient/private/sslcontextcache.h"
 
 #include <QSslConfiguration>
 
+// Max amount of data buffered by socket while reading is paused
+const qint64 PAUSED_READ_BUFFER_SIZE = 64 * 1024;
+
 RedisClient::DefaultTransporter::DefaultTransporter(RedisClient::Connection *c)
-    : RedisClient::AbstractTransporter(c),
-      m_socket(nullptr),
-      m_errorOccurred(false) {}
+    : RedisClient::AbstractTransporter(c), m_socket(nullptr) {}
 
 RedisClient::DefaultTransporter::~DefaultTransporter() {}
 
@@ -30,9 +31,13 @@ void RedisClient::DefaultTransporter::initSocket() {
           &AbstractTransporter::readyRead);
   connect(m_socket.data(), &QSslSocket::encrypted, this,
           [this]() { emit logEvent("SSL encryption: OK"); });
+  connect(m_socket.data(), &QAbstractSocket::connected, this,
+          &DefaultTransporter::socketConnected);
+  connect(m_socket.data(), &QSslSocket::encrypted, this,
+          &DefaultTransporter::socketConnected);
   connect(m_socket.data(), &QAbstractSocket::disconnected, this, [this]() {
     if (m_runningCommands.size() > 0) {
-      emit errorOccurred("Connection was interrupted");
+      connectionFailed("Connection was interrupted");
     }
   });
 }
@@ -64,94 +69,83 @@ QByteArray RedisClient::DefaultTransporter::readFromSocket() {
   return m_socket->readAll();
 }
 
-bool RedisClient::DefaultTransporter::connectToHost() {
-  m_errorOccurred = false;
+QIODevice *RedisClient::DefaultTransporter::socketDevice() { return m_socket.data(); }
+
+void RedisClient::DefaultTransporter::setSocketReadingPaused(bool paused) {
+  if (!m_socket) return;
 
-  auto conf = m_connection->getConfig();
+  // Socket stops reading from OS buffer once internal buffer is full
+  m_socket->setReadBufferSize(paused ? PAUSED_READ_BUFFER_SIZE : 0);
+}
 
-  bool connectionResult = false;
+void RedisClient::DefaultTransporter::connectToHost() {
+  auto settings = m_connection->sharedSettings();
 
-  if (conf.useSsl()) {
+  if (settings->useSsl) {
     if (!QSslSocket::supportsSsl()) {
       emit errorOccurred(
           QString("SSL Error: Openssl is missing. Please install Openssl (%1)")
               .arg(QSslSocket::sslLibraryBuildVersionString()));
-      return false;
+      return;
     }
 
-    m_socket->setSslConfiguration(QSslConfiguration::defaultConfiguration());
-
-    QList<QSslCertificate> trustedCas = conf.sslCaCertificates();
+    // Certificates are parsed once, handshake resumes previous session
+    // with the same host if server supports it
+    m_socket->setSslConfiguration(
+        SslContextCache::instance().configuration(settings->config));
 
-    if (!trustedCas.empty()) {
-      m_socket->addCaCertificates(trustedCas);
-    }
-
-    QString privateKey = conf.sslPrivateKeyPath();
-    if (!privateKey.isEmpty()) {
-      m_socket->setPrivateKey(privateKey);
-    }
+    beginConnect();
+    m_socket->connectToHostEncrypted(settings->host, settings->port);
+  } else {
+    beginConnect();
+    m_socket->connectToHost(settings->host, settings->port);
+  }
+}
 
-    QString localCert = conf.sslLocalCertPath();
-    if (!localCert.isEmpty()) {
-      m_socket->setLocalCertificate(localCert);
-    }
+void RedisClient::DefaultTransporter::abortConnect() {
+  if (m_socket) m_socket->abort();
+}
 
-    m_socket->connectToHostEncrypted(conf.host(), conf.port());
-    connectionResult = m_socket->waitForEncrypted(conf.connectionTimeout());
+void RedisClient::DefaultTransporter::socketConnected() {
+  // TLS connection is established once handshake is finished
+  if (m_socket->mode() != QSslSocket::UnencryptedMode &&
+      !m_socket->isEncrypted())
+    return;
 
-  } else {
-    SignalWaiter socketWaiter(conf.connectionTimeout());
-    socketWaiter.addAbortSignal(
-        m_socket.data(),
-        static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(
-            &QAbstractSocket::error));
-    socketWaiter.addAbortSignal(m_socket.data(),
-                                &QAbstractSocket::disconnected);
-    socketWaiter.addSuccessSignal(m_socket.data(), &QAbstractSocket::connected);
-
-    m_socket->connectToHost(conf.host(), conf.port());
-    connectionResult = socketWaiter.wait();
-  }
+  if (!finishConnect()) return;
 
-  if (connectionResult) {
-    emit connected();
-    emit logEvent(QString("%1 > connected").arg(conf.name()));
-    return true;
-  }
+  auto settings = m_connection->sharedSettings();
 
-  if (!m_errorOccurred) emit errorOccurred("Connection timeout");
+  if (m_socket->isEncrypted())
+    SslContextCache::instance().storeSession(settings->config,
+                                             m_socket->sslConfiguration());
 
-  emit logEvent(QString("%1 > connection failed").arg(conf.name()));
-  return false;
+  emit connected();
+  emit logEvent(QString("%1 > connected").arg(settings->name));
 }
 
 void RedisClient::DefaultTransporter::sendCommand(const QByteArray &cmd) {
-  QByteArray command = cmd;
-  char *data = command.data();
-  qint64 total = 0;
-  qint64 sent;
+  // Passing QByteArray as is allows Qt to share the buffer
+  // instead of copying it into the socket write buffer
+  qint64 total = m_socket->write(cmd);
 
-  while (total < cmd.size()) {
-    sent = m_socket->write(data + total, cmd.size() - total);
+  while (total >= 0 && total < cmd.size()) {
+    qint64 sent = m_socket->write(cmd.constData() + total, cmd.size() - total);
+    if (sent < 0) break;
     total += sent;
   }
+}
 
-  if (m_socket->bytesToWrite() > 1000 || m_commands.size() == 0)
-    m_socket->flush();
+void RedisClient::DefaultTransporter::flushSocket() {
+  // Called once per write batch
+  m_socket->flush();
 }
 
 void RedisClient::DefaultTransporter::error(
     QAbstractSocket::SocketError error) {
-  if (error == QAbstractSocket::UnknownSocketError && connectToHost() &&
-      m_runningCommands.size() > 0) {
-    reAddRunningCommandToQueue();
-    return processCommandQueue();
-  }
-
-  m_errorOccurred = true;
+  Q_UNUSED(error);
 
-  emit errorOccurred(
+  connectionFailed(
       QString("Connection error: %1").arg(m_socket->errorString()));
 }
 
@@ -168,20 +162,17 @@ void RedisClient::DefaultTransporter::sslError(const QList<QSslError> &errors) {
   for (QSslError err : errors)
       allErrors.append(QString("SSL error: %1\n").arg(err.errorString()));
 
-  if (m_connection->getConfig().ignoreAllSslErrors()) {
+  if (m_connection->sharedSettings()->ignoreAllSslErrors) {
       m_socket->ignoreSslErrors();
       emit logEvent(QString("SSL: Ignoring SSL errors:\n %1").arg(allErrors));
       return;
   }
 
-  m_errorOccurred = true;
   emit errorOccurred(QString("SSL errors:\n %1").arg(allErrors));
 }
 
 void RedisClient::DefaultTransporter::reconnect() {
+  m_metrics->addReconnect();
   m_socket->abort();
-
-  if (connectToHost()) {
-    resetDbIndex();
-  }
+  connectToHost();
 }
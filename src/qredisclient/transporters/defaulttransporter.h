@@ -25,9 +25,13 @@ class DefaultTransporter : public AbstractTransporter {
   bool isSocketReconnectRequired() const override;
   bool canReadFromSocket() override;
   QByteArray readFromSocket() override;
+  QIODevice* socketDevice() override;
   void initSocket() override;
-  bool connectToHost() override;
+  void connectToHost() override;
+  void abortConnect() override;
   void sendCommand(const QByteArray& cmd) override;
+  void flushSocket() override;
+  void setSocketReadingPaused(bool paused) override;
 
  protected slots:
   void reconnect() override;
@@ -35,10 +39,10 @@ class DefaultTransporter : public AbstractTransporter {
  private slots:
   void error(QAbstractSocket::SocketError error);
   void sslError(const QList<QSslError>& errors);
+  void socketConnected();
 
  protected:
   QSharedPointer<QSslSocket> m_socket;
   QMutex m_disconnectLock;
-  bool m_errorOccurred;
 };
 }  // namespace RedisClient
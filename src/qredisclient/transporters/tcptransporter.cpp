@@ -0,0 +1,208 @@
+#include "tcptransporter.h"
+#include "qredisclient/connection.h"
+#include "qredisclient/connectionconfig.h"
+
+// Max amount of data buffered by socket while reading is paused
+const qint64 PAUSED_READ_BUFFER_SIZE = 64 * 1024;
+
+// Receive buffer grows up to size of data available in socket and
+// is shrunk back once large reply is processed
+const int RECEIVE_BUFFER_SIZE = 64 * 1024;
+const int MAX_RETAINED_RECEIVE_BUFFER_SIZE = 1024 * 1024;
+
+RedisClient::TcpTransporter::TcpTransporter(RedisClient::Connection *c)
+    : RedisClient::AbstractTransporter(c),
+      m_socket(nullptr),
+      m_standbyPort(0) {}
+
+RedisClient::TcpTransporter::~TcpTransporter() {}
+
+void RedisClient::TcpTransporter::initSocket() {
+  m_socket = QSharedPointer<QTcpSocket>(new QTcpSocket());
+  m_receiveBuffer.resize(RECEIVE_BUFFER_SIZE);
+  connectSocketSignals();
+}
+
+void RedisClient::TcpTransporter::connectSocketSignals() {
+  connect(m_socket.data(),
+          static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(
+              &QAbstractSocket::error),
+          this, &TcpTransporter::error);
+  connect(m_socket.data(), &QAbstractSocket::readyRead, this,
+          &AbstractTransporter::readyRead);
+  connect(m_socket.data(), &QAbstractSocket::connected, this,
+          &TcpTransporter::socketConnected);
+  connect(m_socket.data(), &QAbstractSocket::disconnected, this, [this]() {
+    if (m_runningCommands.size() > 0) {
+      connectionFailed("Connection was interrupted");
+    }
+  });
+}
+
+void RedisClient::TcpTransporter::applySocketOptions() {
+  auto settings = m_connection->sharedSettings();
+
+  m_socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+  m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+  if (settings->socketReceiveBufferSize > 0)
+    m_socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption,
+                              settings->socketReceiveBufferSize);
+
+  if (settings->socketSendBufferSize > 0)
+    m_socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption,
+                              settings->socketSendBufferSize);
+}
+
+void RedisClient::TcpTransporter::openStandbySocket() {
+  auto settings = m_connection->sharedSettings();
+
+  if (!settings->useStandbyConnection) return;
+
+  // Handshake commands are sent once socket replaces active one
+  m_standbySocket = QSharedPointer<QTcpSocket>(new QTcpSocket());
+  m_standbyHost = settings->host;
+  m_standbyPort = settings->port;
+  m_standbySocket->connectToHost(m_standbyHost, m_standbyPort);
+}
+
+bool RedisClient::TcpTransporter::switchToStandbySocket() {
+  if (m_standbySocket.isNull()) return false;
+
+  auto settings = m_connection->sharedSettings();
+
+  // Standby socket is useless after failover to another node
+  if (m_standbySocket->state() != QAbstractSocket::ConnectedState ||
+      m_standbyHost != settings->host || m_standbyPort != settings->port) {
+    m_standbySocket->abort();
+    m_standbySocket.clear();
+    return false;
+  }
+
+  m_socket->disconnect(this);
+  m_socket->abort();
+  m_socket = m_standbySocket;
+  m_standbySocket.clear();
+
+  connectSocketSignals();
+  applySocketOptions();
+
+  emit connected();
+  emit logEvent(
+      QString("%1 > switched to standby connection").arg(settings->name));
+
+  openStandbySocket();
+  return true;
+}
+
+void RedisClient::TcpTransporter::disconnectFromHost() {
+  QMutexLocker lock(&m_disconnectLock);
+
+  RedisClient::AbstractTransporter::disconnectFromHost();
+
+  if (!m_standbySocket.isNull()) {
+    m_standbySocket->abort();
+    m_standbySocket.clear();
+  }
+
+  if (m_socket.isNull()) return;
+
+  m_socket->abort();
+  m_socket.clear();
+}
+
+bool RedisClient::TcpTransporter::isInitialized() const {
+  return !m_socket.isNull();
+}
+
+bool RedisClient::TcpTransporter::isSocketReconnectRequired() const {
+  return m_socket && m_socket->state() == QAbstractSocket::UnconnectedState;
+}
+
+bool RedisClient::TcpTransporter::canReadFromSocket() {
+  return m_socket->bytesAvailable() > 0;
+}
+
+QByteArray RedisClient::TcpTransporter::readFromSocket() {
+  qint64 available = m_socket->bytesAvailable();
+
+  if (available > m_receiveBuffer.size()) {
+    m_receiveBuffer.resize(static_cast<int>(available));
+  } else if (m_receiveBuffer.size() > MAX_RETAINED_RECEIVE_BUFFER_SIZE &&
+             available <= RECEIVE_BUFFER_SIZE) {
+    m_receiveBuffer = QByteArray(RECEIVE_BUFFER_SIZE, Qt::Uninitialized);
+  }
+
+  qint64 size = m_socket->read(m_receiveBuffer.data(), m_receiveBuffer.size());
+
+  if (size <= 0) return QByteArray();
+
+  return QByteArray::fromRawData(m_receiveBuffer.constData(),
+                                 static_cast<int>(size));
+}
+
+QIODevice *RedisClient::TcpTransporter::socketDevice() { return m_socket.data(); }
+
+void RedisClient::TcpTransporter::setSocketReadingPaused(bool paused) {
+  if (!m_socket) return;
+
+  // Socket stops reading from OS buffer once internal buffer is full
+  m_socket->setReadBufferSize(paused ? PAUSED_READ_BUFFER_SIZE : 0);
+}
+
+void RedisClient::TcpTransporter::connectToHost() {
+  auto settings = m_connection->sharedSettings();
+
+  beginConnect();
+  m_socket->connectToHost(settings->host, settings->port);
+}
+
+void RedisClient::TcpTransporter::abortConnect() {
+  if (m_socket) m_socket->abort();
+}
+
+void RedisClient::TcpTransporter::socketConnected() {
+  if (!finishConnect()) return;
+
+  // Options of native socket are available only after connect
+  applySocketOptions();
+
+  emit connected();
+  emit logEvent(
+      QString("%1 > connected").arg(m_connection->sharedSettings()->name));
+
+  if (m_standbySocket.isNull()) openStandbySocket();
+}
+
+void RedisClient::TcpTransporter::sendCommand(const QByteArray &cmd) {
+  // Passing QByteArray as is allows Qt to share the buffer
+  // instead of copying it into the socket write buffer
+  qint64 total = m_socket->write(cmd);
+
+  while (total >= 0 && total < cmd.size()) {
+    qint64 sent = m_socket->write(cmd.constData() + total, cmd.size() - total);
+    if (sent < 0) break;
+    total += sent;
+  }
+}
+
+void RedisClient::TcpTransporter::flushSocket() {
+  // Called once per write batch
+  m_socket->flush();
+}
+
+void RedisClient::TcpTransporter::error(QAbstractSocket::SocketError error) {
+  Q_UNUSED(error);
+
+  connectionFailed(
+      QString("Connection error: %1").arg(m_socket->errorString()));
+}
+
+void RedisClient::TcpTransporter::reconnect() {
+  m_metrics->addReconnect();
+
+  if (switchToStandbySocket()) return;
+
+  m_socket->abort();
+  connectToHost();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QMutex>
+#include <QTcpSocket>
+#include "abstracttransporter.h"
+
+namespace RedisClient {
+
+/**
+ * @brief The TcpTransporter class
+ * Provides execution of redis commands through plain TCP socket.
+ * Used when SSL is disabled: Nagle's algorithm is turned off.
+ * Replies are read directly into parser buffer, streaming replies -
+ * into reusable receive buffer.
+ * Optional standby socket is connected in advance and replaces
+ * lost connection on reconnect.
+ */
+class TcpTransporter : public AbstractTransporter {
+  Q_OBJECT
+ public:
+  TcpTransporter(Connection* c);
+  ~TcpTransporter() override;
+
+ public slots:
+  void disconnectFromHost() override;
+
+ protected:
+  bool isInitialized() const override;
+  bool isSocketReconnectRequired() const override;
+  bool canReadFromSocket() override;
+
+  /**
+   * @brief Returned data references receive buffer and is valid
+   * until next call
+   */
+  QByteArray readFromSocket() override;
+  QIODevice* socketDevice() override;
+  void initSocket() override;
+  void connectToHost() override;
+  void abortConnect() override;
+  void sendCommand(const QByteArray& cmd) override;
+  void flushSocket() override;
+  void setSocketReadingPaused(bool paused) override;
+
+ protected slots:
+  void reconnect() override;
+
+ private slots:
+  void error(QAbstractSocket::SocketError error);
+  void socketConnected();
+
+ private:
+  void connectSocketSignals();
+  void applySocketOptions();
+  void openStandbySocket();
+  bool switchToStandbySocket();
+
+ protected:
+  QSharedPointer<QTcpSocket> m_socket;
+  QSharedPointer<QTcpSocket> m_standbySocket;
+  QString m_standbyHost;
+  uint m_standbyPort;
+  QByteArray m_receiveBuffer;
+  QMutex m_disconnectLock;
+};
+}  // namespace RedisClient
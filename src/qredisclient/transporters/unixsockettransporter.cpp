@@ -0,0 +1,112 @@
+#include "unixsockettransporter.h"
+#include "qredisclient/connection.h"
+#include "qredisclient/connectionconfig.h"
+
+// Max amount of data buffered by socket while reading is paused
+const qint64 PAUSED_READ_BUFFER_SIZE = 64 * 1024;
+
+RedisClient::UnixSocketTransporter::UnixSocketTransporter(
+    RedisClient::Connection *c)
+    : RedisClient::AbstractTransporter(c), m_socket(nullptr) {}
+
+RedisClient::UnixSocketTransporter::~UnixSocketTransporter() {}
+
+void RedisClient::UnixSocketTransporter::initSocket() {
+  m_socket = QSharedPointer<QLocalSocket>(new QLocalSocket());
+
+  connect(m_socket.data(),
+          static_cast<void (QLocalSocket::*)(QLocalSocket::LocalSocketError)>(
+              &QLocalSocket::error),
+          this, &UnixSocketTransporter::error);
+  connect(m_socket.data(), &QLocalSocket::readyRead, this,
+          &AbstractTransporter::readyRead);
+  connect(m_socket.data(), &QLocalSocket::connected, this,
+          &UnixSocketTransporter::socketConnected);
+  connect(m_socket.data(), &QLocalSocket::disconnected, this, [this]() {
+    if (m_runningCommands.size() > 0) {
+      connectionFailed("Connection was interrupted");
+    }
+  });
+}
+
+void RedisClient::UnixSocketTransporter::disconnectFromHost() {
+  QMutexLocker lock(&m_disconnectLock);
+
+  RedisClient::AbstractTransporter::disconnectFromHost();
+
+  if (m_socket.isNull()) return;
+
+  m_socket->abort();
+  m_socket.clear();
+}
+
+bool RedisClient::UnixSocketTransporter::isInitialized() const {
+  return !m_socket.isNull();
+}
+
+bool RedisClient::UnixSocketTransporter::isSocketReconnectRequired() const {
+  return m_socket && m_socket->state() == QLocalSocket::UnconnectedState;
+}
+
+bool RedisClient::UnixSocketTransporter::canReadFromSocket() {
+  return m_socket->bytesAvailable() > 0;
+}
+
+QByteArray RedisClient::UnixSocketTransporter::readFromSocket() {
+  return m_socket->readAll();
+}
+
+QIODevice *RedisClient::UnixSocketTransporter::socketDevice() { return m_socket.data(); }
+
+void RedisClient::UnixSocketTransporter::setSocketReadingPaused(bool paused) {
+  if (!m_socket) return;
+
+  m_socket->setReadBufferSize(paused ? PAUSED_READ_BUFFER_SIZE : 0);
+}
+
+void RedisClient::UnixSocketTransporter::connectToHost() {
+  // connected() can be emitted before connectToServer() returns
+  beginConnect();
+  m_socket->connectToServer(m_connection->sharedSettings()->unixSocketPath);
+}
+
+void RedisClient::UnixSocketTransporter::abortConnect() {
+  if (m_socket) m_socket->abort();
+}
+
+void RedisClient::UnixSocketTransporter::socketConnected() {
+  if (!finishConnect()) return;
+
+  auto settings = m_connection->sharedSettings();
+
+  emit connected();
+  emit logEvent(QString("%1 > connected to %2")
+                    .arg(settings->name)
+                    .arg(settings->unixSocketPath));
+}
+
+void RedisClient::UnixSocketTransporter::sendCommand(const QByteArray &cmd) {
+  qint64 total = m_socket->write(cmd);
+
+  while (total >= 0 && total < cmd.size()) {
+    qint64 sent = m_socket->write(cmd.constData() + total, cmd.size() - total);
+    if (sent < 0) break;
+    total += sent;
+  }
+}
+
+void RedisClient::UnixSocketTransporter::flushSocket() { m_socket->flush(); }
+
+void RedisClient::UnixSocketTransporter::error(
+    QLocalSocket::LocalSocketError error) {
+  Q_UNUSED(error);
+
+  connectionFailed(
+      QString("Connection error: %1").arg(m_socket->errorString()));
+}
+
+void RedisClient::UnixSocketTransporter::reconnect() {
+  m_metrics->addReconnect();
+  m_socket->abort();
+  connectToHost();
+}
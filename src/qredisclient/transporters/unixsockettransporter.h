@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QLocalSocket>
+#include <QMutex>
+#include "abstracttransporter.h"
+
+namespace RedisClient {
+
+/**
+ * @brief The UnixSocketTransporter class
+ * Provides execution of redis commands through unix domain socket
+ * of local redis-server. SSL is not supported.
+ */
+class UnixSocketTransporter : public AbstractTransporter {
+  Q_OBJECT
+ public:
+  UnixSocketTransporter(Connection* c);
+  ~UnixSocketTransporter() override;
+
+ public slots:
+  void disconnectFromHost() override;
+
+ protected:
+  bool isInitialized() const override;
+  bool isSocketReconnectRequired() const override;
+  bool canReadFromSocket() override;
+  QByteArray readFromSocket() override;
+  QIODevice* socketDevice() override;
+  void initSocket() override;
+  void connectToHost() override;
+  void abortConnect() override;
+  void sendCommand(const QByteArray& cmd) override;
+  void flushSocket() override;
+  void setSocketReadingPaused(bool paused) override;
+
+ protected slots:
+  void reconnect() override;
+
+ private slots:
+  void error(QLocalSocket::LocalSocketError error);
+  void socketConnected();
+
+ protected:
+  QSharedPointer<QLocalSocket> m_socket;
+  QMutex m_disconnectLock;
+};
+}  // namespace RedisClient
@@ -0,0 +1,100 @@
+#include "transporterthreadpool.h"
+#include <QMutexLocker>
+
+RedisClient::TransporterThreadPool&
+RedisClient::TransporterThreadPool::instance() {
+  static TransporterThreadPool pool;
+  return pool;
+}
+
+RedisClient::TransporterThreadPool::TransporterThreadPool()
+    : m_maxThreads(qMax(1, QThread::idealThreadCount())) {}
+
+RedisClient::TransporterThreadPool::~TransporterThreadPool() {
+  QMutexLocker lock(&m_lock);
+
+  for (const Worker& w : m_workers) stopThread(w.thread);
+
+  m_workers.clear();
+}
+
+void RedisClient::TransporterThreadPool::setMaxThreads(int count) {
+  QMutexLocker lock(&m_lock);
+  m_maxThreads = qMax(1, count);
+}
+
+int RedisClient::TransporterThreadPool::maxThreads() const {
+  QMutexLocker lock(&m_lock);
+  return m_maxThreads;
+}
+
+int RedisClient::TransporterThreadPool::threadsCount() const {
+  QMutexLocker lock(&m_lock);
+  return m_workers.size();
+}
+
+int RedisClient::TransporterThreadPool::connectionsCount() const {
+  QMutexLocker lock(&m_lock);
+
+  int count = 0;
+  for (const Worker& w : m_workers) count += w.connections;
+  return count;
+}
+
+QSharedPointer<QThread> RedisClient::TransporterThreadPool::acquire() {
+  QMutexLocker lock(&m_lock);
+
+  int leastLoaded = -1;
+
+  for (int i = 0; i < m_workers.size(); ++i) {
+    if (leastLoaded == -1 ||
+        m_workers.at(i).connections < m_workers.at(leastLoaded).connections)
+      leastLoaded = i;
+  }
+
+  // Prefer idle thread over starting new one
+  bool hasIdleThread =
+      leastLoaded >= 0 && m_workers.at(leastLoaded).connections == 0;
+
+  if (!hasIdleThread && m_workers.size() < m_maxThreads) {
+    QSharedPointer<QThread> thread(new QThread);
+    thread->setObjectName(
+        QString("qredisclient::shared_transporter_thread_%1")
+            .arg(m_workers.size()));
+    thread->start();
+
+    m_workers.append(Worker{thread, 1});
+    return thread;
+  }
+
+  m_workers[leastLoaded].connections++;
+  return m_workers.at(leastLoaded).thread;
+}
+
+void RedisClient::TransporterThreadPool::release(
+    QSharedPointer<QThread> thread) {
+  QSharedPointer<QThread> stoppedThread;
+
+  {
+    QMutexLocker lock(&m_lock);
+
+    for (int i = 0; i < m_workers.size(); ++i) {
+      if (m_workers.at(i).thread != thread) continue;
+
+      if (--m_workers[i].connections <= 0) {
+        stoppedThread = m_workers.at(i).thread;
+        m_workers.removeAt(i);
+      }
+      break;
+    }
+  }
+
+  // Don't block other connections while thread is stopping
+  if (stoppedThread) stopThread(stoppedThread);
+}
+
+void RedisClient::TransporterThreadPool::stopThread(
+    QSharedPointer<QThread> thread) {
+  thread->quit();
+  thread->wait();
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QThread>
+
+namespace RedisClient {
+
+/**
+ * @brief The TransporterThreadPool class
+ * Bounded pool of I/O threads shared by transporters of connections
+ * with ConnectionConfig::useSharedTransporterThread() enabled.
+ * Each thread runs own event loop and serves several connections.
+ * New connections are assigned to the least loaded thread.
+ * Thread-safe.
+ */
+class TransporterThreadPool {
+ public:
+  static TransporterThreadPool& instance();
+
+  ~TransporterThreadPool();
+
+  /**
+   * @brief Max number of I/O threads, QThread::idealThreadCount() by default.
+   * Doesn't affect already running threads.
+   */
+  void setMaxThreads(int count);
+  int maxThreads() const;
+
+  int threadsCount() const;
+  int connectionsCount() const;
+
+  /**
+   * @brief Get running thread for new transporter.
+   * Starts new thread if all threads are loaded and limit is not reached.
+   */
+  QSharedPointer<QThread> acquire();
+
+  /**
+   * @brief Release thread acquired by transporter.
+   * Thread is stopped once it doesn't serve any transporter.
+   */
+  void release(QSharedPointer<QThread> thread);
+
+ private:
+  TransporterThreadPool();
+
+  struct Worker {
+    QSharedPointer<QThread> thread;
+    int connections;
+  };
+
+  static void stopThread(QSharedPointer<QThread> thread);
+
+ private:
+  mutable QMutex m_lock;
+  QList<Worker> m_workers;
+  int m_maxThreads;
+};
+
+}  // namespace RedisClient
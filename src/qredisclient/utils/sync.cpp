@@ -1,34 +1,57 @@
 #include "sync.h"
-#include "qredisclient/command.h"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+
+struct RedisClient::SignalWaiter::State {
+  State() : resultReceived(false), result(false) {}
+
+  QMutex lock;
+  QWaitCondition finished;
+  bool resultReceived;
+  bool result;
+};
 
 RedisClient::SignalWaiter::SignalWaiter(uint timeout)
-    : m_result(false), m_resultReceived(false) {
-  m_timeoutTimer.setSingleShot(true);
-  m_timeoutTimer.setInterval(timeout);
+    : m_state(new State()), m_timeout(timeout) {}
 
-  connect(&m_timeoutTimer, SIGNAL(timeout()), &m_loop, SLOT(quit()));
+RedisClient::SignalWaiter::~SignalWaiter() {
+  for (const QMetaObject::Connection &c : m_connections)
+    QObject::disconnect(c);
 }
 
 bool RedisClient::SignalWaiter::wait() {
-  if (m_resultReceived) {  // result recieved before wait() call
-    return m_result;
+  QElapsedTimer timer;
+  timer.start();
+
+  QMutexLocker lock(&m_state->lock);
+
+  while (!m_state->resultReceived) {
+    qint64 remaining = static_cast<qint64>(m_timeout) - timer.elapsed();
+
+    if (remaining <= 0) break;
+
+    m_state->finished.wait(&m_state->lock, static_cast<ulong>(remaining));
   }
 
-  m_timeoutTimer.start();
-  m_loop.exec();
-  return m_result;
+  // Result received before wait() call is returned immediately
+  return m_state->resultReceived && m_state->result;
 }
 
-void RedisClient::SignalWaiter::abort() {
-  m_result = false;
-  m_resultReceived = true;
-  m_loop.quit();
-  emit aborted();
+std::function<void()> RedisClient::SignalWaiter::successTrigger() {
+  QSharedPointer<State> state = m_state;
+  return [state]() { finish(state, true); };
 }
 
-void RedisClient::SignalWaiter::success() {
-  m_result = true;
-  m_resultReceived = true;
-  m_loop.quit();
-  emit succeed();
+void RedisClient::SignalWaiter::finish(const QSharedPointer<State> &state,
+                                       bool result) {
+  QMutexLocker lock(&state->lock);
+
+  // First signal wins
+  if (state->resultReceived) return;
+
+  state->result = result;
+  state->resultReceived = true;
+  state->finished.wakeAll();
 }
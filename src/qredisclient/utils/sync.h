@@ -1,54 +1,68 @@
 #pragma once
-#include <QEventLoop>
+#include <QList>
 #include <QObject>
-#include <QTimer>
-
-#include <asyncfuture.h>
-#include <qredisclient/response.h>
+#include <QSharedPointer>
+#include <functional>
 
 /**
  * Utilitary functions and classes for internal implementation.
  */
 namespace RedisClient {
 
-class Command;
-
-class SignalWaiter : public QObject {
-  Q_OBJECT
+/**
+ * @brief The SignalWaiter class
+ * Blocks calling thread until success or abort signal is emitted or
+ * timeout expires. Signals are connected directly and wake up waiting
+ * thread through condition variable, so they can be emitted from any
+ * thread. Nested event loop is not used: other objects of waiting thread
+ * are not re-entered while it waits, so awaited signals must not depend
+ * on events of this thread.
+ */
+class SignalWaiter {
  public:
   SignalWaiter(uint timeout);
+  ~SignalWaiter();
 
+  /**
+   * @return false on abort signal or timeout
+   */
   bool wait();
 
+  /**
+   * @brief Function which finishes wait with success. Can be called
+   * from any thread, also after waiter is destroyed.
+   */
+  std::function<void()> successTrigger();
+
   template <typename Func1>
   void addAbortSignal(
       const typename QtPrivate::FunctionPointer<Func1>::Object *sender,
       Func1 signal) {
-    connect(sender, signal, this, &SignalWaiter::abort);
+    QSharedPointer<State> state = m_state;
+    m_connections.append(QObject::connect(
+        sender, signal, [state]() { finish(state, false); }));
   }
 
   template <typename Func1>
   void addSuccessSignal(
       const typename QtPrivate::FunctionPointer<Func1>::Object *sender,
       Func1 signal) {
-    connect(sender, signal, this, &SignalWaiter::success);
+    QSharedPointer<State> state = m_state;
+    m_connections.append(QObject::connect(
+        sender, signal, [state]() { finish(state, true); }));
   }
 
- signals:
-  void succeed();
-  void aborted();
-
- protected slots:
-  void abort();
-  void success();
+ private:
+  Q_DISABLE_COPY(SignalWaiter)
 
- protected:
-  QEventLoop m_loop;
-  QTimer m_timeoutTimer;
-  bool m_resultReceived;
+  // Shared with connections, signal can be emitted while waiter
+  // is destroyed in another thread
+  struct State;
+  static void finish(const QSharedPointer<State> &state, bool result);
 
- private:
-  bool m_result;
+  QSharedPointer<State> m_state;
+  QList<QMetaObject::Connection> m_connections;
+  uint m_timeout;
 };
 
 }  // namespace RedisClient
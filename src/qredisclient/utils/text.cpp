@@ -1,60 +1,207 @@
 #include "text.h"
+#include <cstring>
 #include <functional>
 
-bool byteArrayToValidUnicode(const QByteArray &raw, QString *result = nullptr,
-                             bool strict = false) {
-  QTextCodec::ConverterState state;
-  QTextCodec *codec = QTextCodec::codecForName("UTF-8");
-  const QString text = codec->toUnicode(raw.constData(), raw.size(), &state);
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
-  if (state.invalidChars == 0) {
-    foreach (QChar c, text) {
-      if (strict) {
-        if (!c.isPrint() || (c.isSpace() && c != ' ')) return false;
-      } else {
-        if (c.isSpace()) continue;
-        if (!c.isPrint()) return false;
-      }
-    }
+namespace {
+
+const char HEX[16] = {'0', '1', '2', '3', '4', '5', '6', '7',
+                      '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+
+inline bool isPrintableAscii(uchar c, bool allowSpaces) {
+  return (c >= 0x20 && c < 0x7F) || (allowSpaces && c >= 0x09 && c <= 0x0D);
+}
+
+/*
+ * Length of prefix which consists of printable ASCII characters
+ * (and \t \n \v \f \r if allowSpaces). Checks 16 bytes per iteration
+ * where SSE2 or NEON are available.
+ */
+int printableAsciiLength(const char *data, int size, bool allowSpaces) {
+  int i = 0;
 
-    if (result) *result = text;
-    return true;
+#if defined(__SSE2__)
+  const __m128i lowBound = _mm_set1_epi8(0x1F);
+  const __m128i highBound = _mm_set1_epi8(0x7F);
+  const __m128i spaceLowBound = _mm_set1_epi8(0x08);
+  const __m128i spaceHighBound = _mm_set1_epi8(0x0E);
+
+  for (; i + 16 <= size; i += 16) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+
+    // Signed comparison: bytes >= 0x80 are negative and never match
+    __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(chunk, lowBound),
+                               _mm_cmplt_epi8(chunk, highBound));
+
+    if (allowSpaces)
+      ok = _mm_or_si128(ok, _mm_and_si128(_mm_cmpgt_epi8(chunk, spaceLowBound),
+                                          _mm_cmplt_epi8(chunk, spaceHighBound)));
+
+    if (_mm_movemask_epi8(ok) != 0xFFFF) break;
   }
-  return false;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const uint8x16_t lowBound = vdupq_n_u8(0x20);
+  const uint8x16_t highBound = vdupq_n_u8(0x7E);
+  const uint8x16_t spaceLowBound = vdupq_n_u8(0x09);
+  const uint8x16_t spaceHighBound = vdupq_n_u8(0x0D);
+
+  for (; i + 16 <= size; i += 16) {
+    uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t *>(data + i));
+    uint8x16_t ok =
+        vandq_u8(vcgeq_u8(chunk, lowBound), vcleq_u8(chunk, highBound));
+
+    if (allowSpaces)
+      ok = vorrq_u8(ok, vandq_u8(vcgeq_u8(chunk, spaceLowBound),
+                                 vcleq_u8(chunk, spaceHighBound)));
+
+    if (vminvq_u8(ok) != 0xFF) break;
+  }
+#endif
+
+  while (i < size && isPrintableAscii(static_cast<uchar>(data[i]), allowSpaces))
+    ++i;
+
+  return i;
 }
 
-QString printableString(const QByteArray &raw, bool strictChecks) {
-  QString text;
+inline bool isPrintableCodePoint(uint ucs4, bool strict) {
+  if (strict) return QChar::isPrint(ucs4) && !QChar::isSpace(ucs4);
+
+  return QChar::isSpace(ucs4) || QChar::isPrint(ucs4);
+}
+
+/*
+ * Validates UTF-8 and checks that all characters are printable.
+ * Returns number of bytes which can be decoded or -1 if data is binary.
+ * If data is truncated (preview of longer value) incomplete sequence
+ * at the end is not an error and isn't included in result.
+ */
+int validUnicodeLength(const char *data, int size, bool strict,
+                       bool truncated) {
+  int i = 0;
 
-  if (byteArrayToValidUnicode(raw, &text, strictChecks)) return text;
+  while (true) {
+    i += printableAsciiLength(data + i, size - i, !strict);
 
-  QByteArray escapedBinaryString;
-  char const hex[16] = {'0', '1', '2', '3', '4', '5', '6', '7',
-                        '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+    if (i >= size) return size;
 
-  bool printableChar = false;
+    uchar c = static_cast<uchar>(data[i]);
+    uint ucs4;
+    uint minValue;
+    int length;
 
-  foreach (char i, raw) {
-    if (strictChecks) {
-      printableChar =
-          isprint((unsigned char)i) && (!isspace((unsigned char)i) || i == ' ');
+    if ((c & 0xE0) == 0xC0) {
+      ucs4 = c & 0x1F;
+      minValue = 0x80;
+      length = 2;
+    } else if ((c & 0xF0) == 0xE0) {
+      ucs4 = c & 0x0F;
+      minValue = 0x800;
+      length = 3;
+    } else if ((c & 0xF8) == 0xF0) {
+      ucs4 = c & 0x07;
+      minValue = 0x10000;
+      length = 4;
     } else {
-      printableChar = isprint((unsigned char)i);
+      return -1;  // control character or invalid lead byte
     }
 
-    if (printableChar) {
-      escapedBinaryString.append(i);
-    } else {
-      escapedBinaryString.append("\\x");
-      escapedBinaryString.append(&hex[(i & 0xF0) >> 4], 1);
-      escapedBinaryString.append(&hex[i & 0xF], 1);
+    int available = qMin(length, size - i);
+
+    for (int k = 1; k < available; ++k) {
+      uchar next = static_cast<uchar>(data[i + k]);
+
+      if ((next & 0xC0) != 0x80) return -1;
+
+      ucs4 = (ucs4 << 6) | (next & 0x3F);
     }
+
+    if (available < length) return truncated ? i : -1;
+
+    if (ucs4 < minValue || ucs4 > 0x10FFFF ||
+        (ucs4 >= 0xD800 && ucs4 <= 0xDFFF))
+      return -1;
+
+    if (!isPrintableCodePoint(ucs4, strict)) return -1;
+
+    i += length;
+  }
+}
+
+bool byteArrayToValidUnicode(const QByteArray &raw, int limit,
+                             QString *result = nullptr, bool strict = false) {
+  const char *data = raw.constData();
+  int size = raw.size();
+  bool truncated = limit >= 0 && limit < size;
+
+  if (truncated) size = limit;
+
+  // UTF-8 BOM is skipped like QTextCodec does
+  if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+    data += 3;
+    size -= 3;
   }
-  return escapedBinaryString;
+
+  int length = validUnicodeLength(data, size, strict, truncated);
+
+  if (length < 0) return false;
+
+  if (result) *result = QString::fromUtf8(data, length);
+  return true;
+}
+
+QString escapeBinary(const QByteArray &raw, int limit) {
+  const char *data = raw.constData();
+  int size = (limit >= 0 && limit < raw.size()) ? limit : raw.size();
+
+  // Count escaped bytes first to allocate output once
+  int escaped = 0;
+
+  for (int i = printableAsciiLength(data, size, false); i < size;
+       i += 1 + printableAsciiLength(data + i + 1, size - i - 1, false))
+    ++escaped;
+
+  QByteArray out(size + escaped * 3, Qt::Uninitialized);
+  char *pos = out.data();
+  int i = 0;
+
+  while (i < size) {
+    int run = printableAsciiLength(data + i, size - i, false);
+
+    memcpy(pos, data + i, run);
+    pos += run;
+    i += run;
+
+    if (i >= size) break;
+
+    uchar c = static_cast<uchar>(data[i++]);
+    *pos++ = '\\';
+    *pos++ = 'x';
+    *pos++ = HEX[c >> 4];
+    *pos++ = HEX[c & 0xF];
+  }
+
+  return QString::fromLatin1(out.constData(), out.size());
+}
+
+}  // namespace
+
+QString printableString(const QByteArray &raw, bool strictChecks, int limit) {
+  QString text;
+
+  if (byteArrayToValidUnicode(raw, limit, &text, strictChecks)) return text;
+
+  return escapeBinary(raw, limit);
 }
 
-bool isBinary(const QByteArray &raw) {
-  return !byteArrayToValidUnicode(raw, nullptr, false);
+bool isBinary(const QByteArray &raw, int limit) {
+  return !byteArrayToValidUnicode(raw, limit);
 }
 
 QByteArray printableStringToBinary(const QString &str) {
@@ -4,8 +4,13 @@
 #include <QTextCodec>
 #include <cctype>
 
-QString printableString(const QByteArray& raw, bool strictChecks = false);
+/*
+ * limit - preview mode: only first limit bytes are checked and converted,
+ * -1 - whole value
+ */
+QString printableString(const QByteArray& raw, bool strictChecks = false,
+                        int limit = -1);
 
-bool isBinary(const QByteArray& raw);
+bool isBinary(const QByteArray& raw, int limit = -1);
 
 QByteArray printableStringToBinary(const QString& str);
@@ -0,0 +1,423 @@
+#include "valuereader.h"
+#include <QPointer>
+#include <QQueue>
+#include <limits>
+#include "connection.h"
+
+namespace {
+const char *LENGTH_COMMANDS[] = {"HLEN", "SCARD", "ZCARD", "LLEN", "XLEN"};
+
+// Smallest stream ID which is greater than id
+QByteArray nextStreamId(const QByteArray &id) {
+  int separator = id.indexOf('-');
+  quint64 ms = id.left(separator).toULongLong();
+  quint64 seq = separator < 0 ? 0 : id.mid(separator + 1).toULongLong();
+
+  if (seq == std::numeric_limits<quint64>::max()) {
+    ms++;
+    seq = 0;
+  } else {
+    seq++;
+  }
+
+  return QByteArray::number(ms) + "-" + QByteArray::number(seq);
+}
+}  // namespace
+
+struct RedisClient::ValueReader::State {
+  State(const QByteArray &k, Type t)
+      : key(k),
+        type(t),
+        pageSize(0),
+        requested(0),
+        length(-1),
+        memoryUsage(-1),
+        pendingSizeReplies(0),
+        sized(false),
+        offset(0),
+        generation(0),
+        inFlight(false),
+        serverFinished(false),
+        done(false) {}
+
+  QPointer<Connection> connection;
+  QByteArray key;
+  Type type;
+  Options options;
+
+  uint pageSize;
+  uint requested;  // elements requested by the last range command
+  qint64 length;
+  qint64 memoryUsage;
+  int pendingSizeReplies;
+  bool sized;
+
+  QByteArray cursor;       // HSCAN, SSCAN
+  qint64 offset;           // index of next element
+  QByteArray streamStart;  // XRANGE
+
+  QQueue<Page> pages;
+  PageCallback waiting;
+  QString error;
+
+  // Replies for requests sent before reset() are ignored
+  quint64 generation;
+  bool inFlight;
+  bool serverFinished;
+  bool done;
+};
+
+RedisClient::ValueReader::Options::Options()
+    : dbIndex(0),
+      prefetch(1),
+      targetPageBytes(256 * 1024),
+      pageSize(1000),
+      minPageSize(10),
+      maxPageSize(10000) {}
+
+int RedisClient::ValueReader::Page::size() const {
+  return members.size() + fields.size() + scored.size() + entries.size();
+}
+
+RedisClient::ValueReader::ValueReader(Connection *connection,
+                                      const QByteArray &key, Type type,
+                                      const Options &options)
+    : m_state(new State(key, type)) {
+  if (key.isEmpty()) throw Exception("Invalid key");
+
+  m_state->connection = connection;
+  m_state->options = options;
+  m_state->pageSize =
+      qBound(options.minPageSize, options.pageSize, options.maxPageSize);
+  reset();
+}
+
+void RedisClient::ValueReader::next(PageCallback callback) {
+  QSharedPointer<State> state = m_state;
+
+  if (state->waiting) throw Exception("Previous page is not loaded yet");
+
+  if (!state->pages.isEmpty()) {
+    Page page = state->pages.dequeue();
+    fill(state);
+    return deliver(state, callback, page, QString());
+  }
+
+  if (!state->error.isEmpty() || (state->serverFinished && !state->inFlight))
+    return deliver(state, callback, Page(), state->error);
+
+  if (!state->connection)
+    return deliver(state, callback, Page(),
+                   QString("Cannot load value: connection is closed"));
+
+  state->waiting = callback;
+
+  try {
+    fill(state);
+  } catch (const Connection::Exception &) {
+    state->waiting = nullptr;
+    throw;
+  }
+}
+
+bool RedisClient::ValueReader::hasNext() const { return !m_state->done; }
+
+bool RedisClient::ValueReader::isPending() const {
+  return static_cast<bool>(m_state->waiting);
+}
+
+void RedisClient::ValueReader::reset() {
+  if (m_state->waiting) throw Exception("Previous page is not loaded yet");
+
+  // Estimated page size is kept
+  m_state->generation++;
+  m_state->pendingSizeReplies = 0;
+  m_state->cursor = "0";
+  m_state->offset = 0;
+  m_state->streamStart = "-";
+  m_state->pages.clear();
+  m_state->error.clear();
+  m_state->inFlight = false;
+  m_state->serverFinished = false;
+  m_state->done = false;
+}
+
+qint64 RedisClient::ValueReader::length() const { return m_state->length; }
+
+uint RedisClient::ValueReader::pageSize() const { return m_state->pageSize; }
+
+void RedisClient::ValueReader::fill(QSharedPointer<State> state) {
+  if (state->inFlight || state->serverFinished || !state->error.isEmpty() ||
+      !state->connection)
+    return;
+
+  bool consumerWaits = state->waiting && state->pages.isEmpty();
+
+  if (!consumerWaits &&
+      static_cast<uint>(state->pages.size()) >= state->options.prefetch)
+    return;
+
+  if (!state->sized) return requestSize(state);
+
+  requestPage(state);
+}
+
+void RedisClient::ValueReader::requestSize(QSharedPointer<State> state) {
+  if (state->options.targetPageBytes == 0) {
+    state->sized = true;
+    return requestPage(state);
+  }
+
+  quint64 generation = state->generation;
+
+  auto sizeCommand = [state, generation](const QList<QByteArray> &args,
+                                         bool isLength) -> Command {
+    Command cmd(args, state->options.dbIndex);
+    cmd.setCallBack(state->connection.data(),
+                    [state, generation, isLength](Response r, QString err) {
+                      if (generation != state->generation) return;
+
+                      processSize(state, isLength, r, err);
+                    });
+    return cmd;
+  };
+
+  Command length = sizeCommand(
+      {LENGTH_COMMANDS[static_cast<int>(state->type)], state->key}, true);
+  Command memory = sizeCommand(
+      {"MEMORY", "USAGE", state->key, "SAMPLES", "5"}, false);
+
+  // Both commands are pipelined, replies can be delivered immediately
+  state->inFlight = true;
+  state->pendingSizeReplies = 2;
+
+  try {
+    state->connection->runCommand(length);
+    state->connection->runCommand(memory);
+  } catch (const Connection::Exception &) {
+    state->inFlight = false;
+    state->generation++;
+    throw;
+  }
+}
+
+void RedisClient::ValueReader::processSize(QSharedPointer<State> state,
+                                           bool isLength, const Response &r,
+                                           const QString &err) {
+  // MEMORY USAGE is not available before redis-server 4.0
+  if (err.isEmpty() && !r.isErrorMessage()) {
+    if (isLength)
+      state->length = r.view().toInteger();
+    else
+      state->memoryUsage = r.view().toInteger();
+  }
+
+  if (--state->pendingSizeReplies > 0) return;
+
+  state->inFlight = false;
+  state->sized = true;
+
+  if (state->length > 0 && state->memoryUsage > 0) {
+    qint64 elementSize = qMax<qint64>(1, state->memoryUsage / state->length);
+    qint64 pageSize = state->options.targetPageBytes / elementSize;
+
+    state->pageSize = static_cast<uint>(qBound<qint64>(
+        state->options.minPageSize, pageSize, state->options.maxPageSize));
+  }
+
+  // Key doesn't exist or collection is empty
+  if (state->length == 0) state->serverFinished = true;
+
+  try {
+    fill(state);
+  } catch (const Connection::Exception &e) {
+    state->error = QString("Cannot load value: %1").arg(e.what());
+  }
+
+  if (state->waiting && !state->inFlight) {
+    PageCallback callback = state->waiting;
+    state->waiting = nullptr;
+    deliver(state, callback, Page(), state->error);
+  }
+}
+
+void RedisClient::ValueReader::requestPage(QSharedPointer<State> state) {
+  QByteArray count = QByteArray::number(state->pageSize);
+  QByteArray start = QByteArray::number(state->offset);
+  QByteArray stop = QByteArray::number(state->offset + state->pageSize - 1);
+  QList<QByteArray> args;
+
+  switch (state->type) {
+    case Type::Hash:
+      args << "HSCAN" << state->key << state->cursor << "COUNT" << count;
+      break;
+    case Type::Set:
+      args << "SSCAN" << state->key << state->cursor << "COUNT" << count;
+      break;
+    case Type::ZSet:
+      args << "ZRANGE" << state->key << start << stop << "WITHSCORES";
+      break;
+    case Type::List:
+      args << "LRANGE" << state->key << start << stop;
+      break;
+    case Type::Stream:
+      args << "XRANGE" << state->key << state->streamStart << "+"
+           << "COUNT" << count;
+      break;
+  }
+
+  quint64 generation = state->generation;
+
+  Command cmd(args, state->options.dbIndex);
+  cmd.setCallBack(state->connection.data(),
+                  [state, generation](Response r, QString err) {
+                    if (generation != state->generation) return;
+
+                    processPage(state, r, err);
+                  });
+
+  state->requested = state->pageSize;
+  state->inFlight = true;
+
+  try {
+    state->connection->runCommand(cmd);
+  } catch (const Connection::Exception &) {
+    state->inFlight = false;
+    throw;
+  }
+}
+
+void RedisClient::ValueReader::processPage(QSharedPointer<State> state,
+                                           const Response &r,
+                                           const QString &err) {
+  state->inFlight = false;
+
+  Page page;
+
+  if (!err.isEmpty()) {
+    state->error = QString("Cannot load value: %1").arg(err);
+  } else if (r.isErrorMessage()) {
+    state->error = QString("Cannot load value: %1")
+                       .arg(QString::fromUtf8(r.asBytes()));
+  } else if (!parsePage(state, r, page)) {
+    state->error = QString("Cannot load value: unexpected reply");
+  }
+
+  if (!state->waiting) {
+    if (state->error.isEmpty()) state->pages.enqueue(page);
+  } else {
+    PageCallback callback = state->waiting;
+    state->waiting = nullptr;
+
+    // Request next page before consumer processes current page
+    try {
+      fill(state);
+    } catch (const Connection::Exception &e) {
+      state->error = QString("Cannot load value: %1").arg(e.what());
+    }
+
+    return deliver(state, callback, page, state->error);
+  }
+
+  try {
+    fill(state);
+  } catch (const Connection::Exception &e) {
+    state->error = QString("Cannot load value: %1").arg(e.what());
+  }
+}
+
+bool RedisClient::ValueReader::parsePage(QSharedPointer<State> state,
+                                         const Response &r, Page &page) {
+  ResponseView items = r.view();
+  page.offset = state->offset;
+
+  if (state->type == Type::Hash || state->type == Type::Set) {
+    if (!r.isValidScanResponse()) return false;
+
+    state->cursor = r.at(0).toByteArray();
+    state->serverFinished = state->cursor == "0";
+    items = r.at(1);
+  } else if (!items.isArray()) {
+    return false;
+  }
+
+  int size = items.arraySize();
+
+  switch (state->type) {
+    case Type::Hash:
+      page.fields.reserve(size / 2);
+
+      for (int i = 0; i + 1 < size; i += 2)
+        page.fields.append(FieldValue(items.at(i).toByteArray(),
+                                      items.at(i + 1).toByteArray()));
+      break;
+    case Type::Set:
+    case Type::List:
+      page.members.reserve(size);
+
+      for (int i = 0; i < size; ++i)
+        page.members.append(items.at(i).toByteArray());
+      break;
+    case Type::ZSet:
+      // RESP3 replies contain [member, score] pairs
+      if (size > 0 && items.at(0).isArray()) {
+        page.scored.reserve(size);
+
+        for (int i = 0; i < size; ++i)
+          page.scored.append(ScoredMember(items.at(i).at(0).toByteArray(),
+                                          items.at(i).at(1).toDouble()));
+      } else {
+        page.scored.reserve(size / 2);
+
+        for (int i = 0; i + 1 < size; i += 2)
+          page.scored.append(ScoredMember(items.at(i).toByteArray(),
+                                          items.at(i + 1).toDouble()));
+      }
+      break;
+    case Type::Stream:
+      page.entries.reserve(size);
+
+      for (int i = 0; i < size; ++i) {
+        ResponseView entry = items.at(i);
+        ResponseView fields = entry.at(1);
+        StreamEntry e;
+        e.id = entry.at(0).toByteArray();
+        e.fields.reserve(fields.arraySize() / 2);
+
+        for (int j = 0; j + 1 < fields.arraySize(); j += 2)
+          e.fields.append(FieldValue(fields.at(j).toByteArray(),
+                                     fields.at(j + 1).toByteArray()));
+
+        page.entries.append(e);
+      }
+
+      if (!page.entries.isEmpty())
+        state->streamStart = nextStreamId(page.entries.last().id);
+      break;
+  }
+
+  state->offset += page.size();
+
+  if (state->type != Type::Hash && state->type != Type::Set) {
+    state->serverFinished =
+        static_cast<uint>(page.size()) < state->requested ||
+        (state->length >= 0 && state->type != Type::Stream &&
+         state->offset >= state->length);
+  }
+
+  return true;
+}
+
+void RedisClient::ValueReader::deliver(QSharedPointer<State> state,
+                                       PageCallback callback,
+                                       const Page &page, const QString &err) {
+  // Error is reported after prefetched pages
+  bool final = state->error.isEmpty()
+                   ? state->serverFinished && !state->inFlight &&
+                         state->pages.isEmpty()
+                   : state->pages.isEmpty();
+
+  if (final) state->done = true;
+
+  callback(page, err, final);
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <QByteArray>
+#include <QPair>
+#include <QSharedPointer>
+#include <QVector>
+#include <functional>
+#include "exception.h"
+
+namespace RedisClient {
+
+class Connection;
+class Response;
+
+/**
+ * @brief The ValueReader class
+ * Streams elements of a large hash, set, sorted set, list or stream page
+ * by page. Hashes and sets are read with HSCAN/SSCAN, sorted sets, lists
+ * and streams with ZRANGE/LRANGE/XRANGE in key order. Page size is
+ * estimated from MEMORY USAGE and *LEN of the key so each page is close
+ * to Options::targetPageBytes. Up to Options::prefetch pages are loaded
+ * ahead of consumer, so memory usage doesn't depend on value size.
+ * Copies of reader share position.
+ */
+class ValueReader {
+  ADD_EXCEPTION
+
+ public:
+  enum class Type { Hash, Set, ZSet, List, Stream };
+
+  typedef QPair<QByteArray, QByteArray> FieldValue;
+  typedef QPair<QByteArray, double> ScoredMember;
+
+  struct StreamEntry {
+    QByteArray id;
+    QVector<FieldValue> fields;
+  };
+
+  /**
+   * @brief Elements of a single reply, only container of reader type
+   * is filled
+   */
+  struct Page {
+    Page() : offset(0) {}
+
+    QVector<QByteArray> members;   // Set, List
+    QVector<FieldValue> fields;    // Hash
+    QVector<ScoredMember> scored;  // ZSet
+    QVector<StreamEntry> entries;  // Stream
+    qint64 offset;                 // index of first element
+
+    int size() const;
+    bool isEmpty() const { return size() == 0; }
+  };
+
+  /**
+   * @brief PageCallback
+   * @param page - elements from a single reply
+   * @param err - error message, iteration stops on error
+   * @param final - true if there are no more pages. Last page can be empty.
+   */
+  typedef std::function<void(const Page &page, const QString &err,
+                             bool final)>
+      PageCallback;
+
+  struct Options {
+    Options();
+
+    int dbIndex;
+    uint prefetch;         // pages loaded ahead, 0 - load on demand only
+    uint targetPageBytes;  // 0 disables page sizing by MEMORY USAGE
+    uint pageSize;         // elements per page if size cannot be estimated
+    uint minPageSize;
+    uint maxPageSize;
+  };
+
+ public:
+  ValueReader(Connection *connection, const QByteArray &key, Type type,
+              const Options &options = Options());
+
+  /**
+   * @brief Request next page. Only one page can be requested at a time.
+   * Callback is called in the thread of connection or immediately if
+   * page is already loaded.
+   */
+  void next(PageCallback callback);
+
+  bool hasNext() const;
+  bool isPending() const;
+
+  /**
+   * @brief Start from the first element. Prefetched pages are dropped.
+   */
+  void reset();
+
+  /**
+   * @brief Number of elements reported by *LEN, -1 until it's loaded
+   */
+  qint64 length() const;
+
+  /**
+   * @brief Elements per page which will be requested next
+   */
+  uint pageSize() const;
+
+ private:
+  struct State;
+  static void fill(QSharedPointer<State> state);
+  static void requestSize(QSharedPointer<State> state);
+  static void processSize(QSharedPointer<State> state, bool isLength,
+                          const Response &r, const QString &err);
+  static void requestPage(QSharedPointer<State> state);
+  static void processPage(QSharedPointer<State> state, const Response &r,
+                          const QString &err);
+  static bool parsePage(QSharedPointer<State> state, const Response &r,
+                        Page &page);
+  static void deliver(QSharedPointer<State> state, PageCallback callback,
+                      const Page &page, const QString &err);
+
+ private:
+  QSharedPointer<State> m_state;
+};
+
+}  // namespace RedisClient
@@ -0,0 +1,100 @@
+#include "benchmark.h"
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+namespace {
+// Batch is long enough to make QElapsedTimer overhead negligible
+const qint64 MIN_BATCH_TIME = 50000;  // in nanoseconds
+const quint64 MAX_BATCH_SIZE = 1 << 20;
+}  // namespace
+
+BenchmarkResult::BenchmarkResult(const QString &name)
+    : name(name), operations(0), bytes(0), errors(0), elapsed(0) {}
+
+double BenchmarkResult::opsPerSecond() const {
+  return elapsed > 0 ? operations * 1e9 / elapsed : 0.0;
+}
+
+double BenchmarkResult::megabytesPerSecond() const {
+  return elapsed > 0 ? bytes * 1e9 / elapsed / (1024 * 1024) : 0.0;
+}
+
+QJsonObject BenchmarkResult::toJson() const {
+  QJsonObject result;
+  result["name"] = name;
+  result["operations"] = static_cast<double>(operations);
+  result["errors"] = static_cast<double>(errors);
+  result["elapsed_ns"] = static_cast<double>(elapsed);
+  result["ops_per_sec"] = opsPerSecond();
+  result["mb_per_sec"] = megabytesPerSecond();
+  result["mean_ns"] = latency.mean();
+  result["p50_ns"] = static_cast<double>(latency.percentile(50));
+  result["p99_ns"] = static_cast<double>(latency.percentile(99));
+  result["max_ns"] = static_cast<double>(latency.max());
+  return result;
+}
+
+BenchmarkResult runMicrobenchmark(const QString &name, Operation op,
+                                  qint64 minTime) {
+  BenchmarkResult result(name);
+  QElapsedTimer timer;
+
+  // Warm up and calibrate batch size
+  quint64 batchSize = 1;
+
+  while (batchSize < MAX_BATCH_SIZE) {
+    timer.start();
+    for (quint64 i = 0; i < batchSize; ++i) op();
+
+    if (timer.nsecsElapsed() >= MIN_BATCH_TIME) break;
+
+    batchSize *= 2;
+  }
+
+  QElapsedTimer total;
+  total.start();
+
+  while (total.elapsed() < minTime) {
+    quint64 bytes = 0;
+
+    timer.start();
+    for (quint64 i = 0; i < batchSize; ++i) bytes += op();
+    qint64 batchTime = timer.nsecsElapsed();
+
+    result.operations += batchSize;
+    result.bytes += bytes;
+    result.elapsed += batchTime;
+    result.latency.record(static_cast<quint64>(batchTime) / batchSize);
+  }
+
+  return result;
+}
+
+void printResults(const QList<BenchmarkResult> &results, QTextStream &out) {
+  out << qSetFieldWidth(36) << left << "benchmark" << qSetFieldWidth(14)
+      << right << "ops/sec"
+      << "MB/sec"
+      << "p50, us"
+      << "p99, us"
+      << "errors" << qSetFieldWidth(0) << "\n";
+
+  for (const BenchmarkResult &r : results) {
+    out << qSetFieldWidth(36) << left << r.name << qSetFieldWidth(14) << right
+        << QString::number(r.opsPerSecond(), 'f', 0)
+        << QString::number(r.megabytesPerSecond(), 'f', 1)
+        << QString::number(r.latency.percentile(50) / 1000.0, 'f', 3)
+        << QString::number(r.latency.percentile(99) / 1000.0, 'f', 3)
+        << r.errors << qSetFieldWidth(0) << "\n";
+  }
+
+  out.flush();
+}
+
+QByteArray resultsToJson(const QList<BenchmarkResult> &results) {
+  QJsonArray array;
+
+  for (const BenchmarkResult &r : results) array.append(r.toJson());
+
+  return QJsonDocument(array).toJson();
+}
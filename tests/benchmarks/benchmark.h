@@ -0,0 +1,68 @@
+#pragma once
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QTextStream>
+#include <functional>
+#include "qredisclient/connectionmetrics.h"
+
+namespace RedisClient {
+class Connection;
+}
+
+/**
+ * @brief Result of a single benchmark case.
+ * Latencies are stored in nanoseconds.
+ */
+struct BenchmarkResult {
+  BenchmarkResult(const QString &name = QString());
+
+  QString name;
+  quint64 operations;
+  quint64 bytes;  // payload processed by all operations, 0 if not applicable
+  quint64 errors;
+  qint64 elapsed;  // in nanoseconds
+  RedisClient::LatencyHistogram latency;
+
+  double opsPerSecond() const;
+  double megabytesPerSecond() const;
+  QJsonObject toJson() const;
+};
+
+/**
+ * @brief Operation of microbenchmark
+ * @return Number of payload bytes processed by operation
+ */
+typedef std::function<quint64()> Operation;
+
+/**
+ * @brief Run operation in batches until minTime is spent.
+ * Batch size is calibrated so timer overhead doesn't affect results,
+ * latency percentiles are calculated from per-batch averages.
+ * @param minTime - in milliseconds
+ */
+BenchmarkResult runMicrobenchmark(const QString &name, Operation op,
+                                  qint64 minTime);
+
+QList<BenchmarkResult> parserBenchmarks(qint64 minTime);
+QList<BenchmarkResult> serializerBenchmarks(qint64 minTime);
+
+struct EndToEndOptions {
+  EndToEndOptions();
+
+  QList<int> concurrency;  // commands in flight
+  int requests;            // per command type and concurrency level
+  int valueSize;
+  int keys;
+  uint timeout;  // per run, in milliseconds
+  QString transport;  // used in names of results, e.g. "tcp"
+};
+
+/**
+ * @brief Pipelined SET and GET against running redis-server
+ */
+QList<BenchmarkResult> endToEndBenchmarks(RedisClient::Connection *connection,
+                                          const EndToEndOptions &options);
+
+void printResults(const QList<BenchmarkResult> &results, QTextStream &out);
+QByteArray resultsToJson(const QList<BenchmarkResult> &results);
@@ -0,0 +1,83 @@
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include "benchmark.h"
+#include "qredisclient/connection.h"
+
+namespace {
+
+QByteArray benchmarkKey(int i, int keys) {
+  return "qredis-bench:key:" + QByteArray::number(i % keys);
+}
+
+BenchmarkResult runPipelined(RedisClient::Connection *connection,
+                             const QByteArray &type, int concurrency,
+                             const EndToEndOptions &options) {
+  BenchmarkResult result(QString("e2e/%1/%2/c%3")
+                             .arg(options.transport)
+                             .arg(QString::fromLatin1(type).toLower())
+                             .arg(concurrency));
+
+  QEventLoop loop;
+  QElapsedTimer clock;
+  QByteArray value(options.valueSize, 'v');
+  int issued = 0;
+  int completed = 0;
+
+  std::function<void()> issue;
+  issue = [&]() {
+    QByteArray key = benchmarkKey(issued++, options.keys);
+    QList<QByteArray> cmd = type == "SET" ? QList<QByteArray>{"SET", key, value}
+                                          : QList<QByteArray>{"GET", key};
+    qint64 startedAt = clock.nsecsElapsed();
+
+    connection->command(
+        cmd, &loop,
+        [&, startedAt](RedisClient::Response r, QString err) {
+          result.latency.record(clock.nsecsElapsed() - startedAt);
+
+          if (!err.isEmpty() || r.isErrorMessage()) result.errors++;
+
+          if (++completed == options.requests) return loop.quit();
+
+          if (issued < options.requests) issue();
+        });
+  };
+
+  clock.start();
+
+  for (int i = 0; i < concurrency && i < options.requests; ++i) issue();
+
+  QTimer::singleShot(options.timeout, &loop, &QEventLoop::quit);
+  loop.exec();
+
+  result.elapsed = clock.nsecsElapsed();
+  result.operations = completed;
+  result.errors += options.requests - completed;
+  result.bytes = static_cast<quint64>(completed) * options.valueSize;
+
+  return result;
+}
+
+}  // namespace
+
+EndToEndOptions::EndToEndOptions()
+    : concurrency(QList<int>() << 1 << 16 << 128),
+      requests(100000),
+      valueSize(64),
+      keys(10000),
+      timeout(600000),
+      transport("tcp") {}
+
+QList<BenchmarkResult> endToEndBenchmarks(RedisClient::Connection *connection,
+                                          const EndToEndOptions &options) {
+  QList<BenchmarkResult> results;
+
+  for (int concurrency : options.concurrency) {
+    // GET reads keys written by SET
+    results << runPipelined(connection, "SET", concurrency, options)
+            << runPipelined(connection, "GET", concurrency, options);
+  }
+
+  return results;
+}
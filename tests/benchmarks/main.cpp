@@ -0,0 +1,121 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+#include <iostream>
+#include <stdexcept>
+#include "benchmark.h"
+#include "qredisclient/redisclient.h"
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  initRedisClient();
+
+  QCoreApplication::setApplicationName("qredis-benchmarks");
+  QCoreApplication::setApplicationVersion("0.0.1");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "Microbenchmarks of parser and serializer and end-to-end throughput "
+      "against local redis-server");
+  parser.addHelpOption();
+  parser.addVersionOption();
+
+  QCommandLineOption hostOption("host", "redis-server host", "host",
+                                "127.0.0.1");
+  QCommandLineOption portOption("port", "redis-server port", "port", "6379");
+  QCommandLineOption unixSocketOption(
+      "unix-socket",
+      "Also run end-to-end benchmarks through unix socket of redis-server",
+      "path");
+  QCommandLineOption requestsOption(
+      "requests", "Requests per end-to-end case", "count", "100000");
+  QCommandLineOption concurrencyOption(
+      "concurrency", "Comma-separated commands in flight", "list", "1,16,128");
+  QCommandLineOption valueSizeOption("value-size", "SET value size in bytes",
+                                     "bytes", "64");
+  QCommandLineOption minTimeOption(
+      "min-time", "Minimal duration of microbenchmark in ms", "ms", "500");
+  QCommandLineOption microOnlyOption("micro-only",
+                                     "Skip end-to-end benchmarks");
+  QCommandLineOption jsonOption("json", "Write results as JSON to file",
+                                "file");
+
+  parser.addOptions({hostOption, portOption, unixSocketOption,
+                     requestsOption, concurrencyOption, valueSizeOption,
+                     minTimeOption, microOnlyOption, jsonOption});
+  parser.process(app);
+
+  int exitCode = 0;
+
+  QTimer::singleShot(0, [&]() {
+    QList<BenchmarkResult> results;
+    qint64 minTime = parser.value(minTimeOption).toLongLong();
+
+    try {
+      results << parserBenchmarks(minTime) << serializerBenchmarks(minTime);
+    } catch (const std::runtime_error &e) {
+      std::cerr << "Microbenchmark failed: " << e.what() << std::endl;
+      exitCode = 1;
+    }
+
+    QList<RedisClient::ConnectionConfig> configs;
+
+    if (!parser.isSet(microOnlyOption)) {
+      RedisClient::ConnectionConfig tcp(parser.value(hostOption), "benchmark");
+      tcp.setPort(parser.value(portOption).toInt());
+      configs << tcp;
+
+      if (parser.isSet(unixSocketOption)) {
+        RedisClient::ConnectionConfig local = tcp;
+        local.setUnixSocketPath(parser.value(unixSocketOption));
+        configs << local;
+      }
+    }
+
+    for (const RedisClient::ConnectionConfig &config : configs) {
+      RedisClient::Connection connection(config);
+
+      EndToEndOptions options;
+      options.requests = parser.value(requestsOption).toInt();
+      options.valueSize = parser.value(valueSizeOption).toInt();
+      options.transport = config.useUnixSocket() ? "unix" : "tcp";
+      options.concurrency.clear();
+
+      for (const QString &c : parser.value(concurrencyOption).split(','))
+        options.concurrency.append(c.toInt());
+
+      try {
+        if (!connection.connect())
+          throw RedisClient::Connection::Exception("Connection timeout");
+
+        results << endToEndBenchmarks(&connection, options);
+      } catch (const RedisClient::Connection::Exception &e) {
+        std::cerr << "Cannot run end-to-end benchmarks over "
+                  << options.transport.toStdString() << ": " << e.what()
+                  << std::endl;
+        exitCode = 2;
+      }
+    }
+
+    QTextStream out(stdout);
+    printResults(results, out);
+
+    if (parser.isSet(jsonOption)) {
+      QFile f(parser.value(jsonOption));
+
+      if (f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        f.write(resultsToJson(results));
+      } else {
+        std::cerr << "Cannot write results to "
+                  << parser.value(jsonOption).toStdString() << std::endl;
+        exitCode = 1;
+      }
+    }
+
+    app.exit(exitCode);
+  });
+
+  return app.exec();
+}
@@ -0,0 +1,104 @@
+#include <stdexcept>
+#include "benchmark.h"
+#include "qredisclient/command.h"
+#include "qredisclient/response.h"
+#include "qredisclient/responseparser.h"
+
+namespace {
+
+QByteArray bulk(const QByteArray &value) {
+  return "$" + QByteArray::number(value.size()) + "\r\n" + value + "\r\n";
+}
+
+QByteArray statusReplies(int count) { return QByteArray("+OK\r\n").repeated(count); }
+
+QByteArray hugeBulkReply(int size) { return bulk(QByteArray(size, 'x')); }
+
+QByteArray nestedArrayReply(int depth) {
+  QByteArray reply = bulk("leaf");
+
+  for (int i = 0; i < depth; ++i)
+    reply = "*3\r\n:" + QByteArray::number(i) + "\r\n" + bulk("node") + reply;
+
+  return reply;
+}
+
+QByteArray scanPageReply(int keys) {
+  QByteArray reply = "*2\r\n" + bulk("1234567") + "*" +
+                     QByteArray::number(keys) + "\r\n";
+
+  for (int i = 0; i < keys; ++i)
+    reply.append(bulk("user:" + QByteArray::number(100000 + i) + ":profile"));
+
+  return reply;
+}
+
+Operation parseOperation(const QByteArray &payload, int replies) {
+  QSharedPointer<RedisClient::ResponseParser> parser(
+      new RedisClient::ResponseParser());
+
+  return [parser, payload, replies]() -> quint64 {
+    parser->feedBuffer(payload);
+
+    int parsed = 0;
+    while (parser->getNextResponse().isValid()) ++parsed;
+
+    if (parsed != replies) throw std::runtime_error("Unexpected replies count");
+
+    return payload.size();
+  };
+}
+
+Operation serializeOperation(const RedisClient::Command &cmd) {
+  return [cmd]() -> quint64 { return cmd.getByteRepresentation().size(); };
+}
+
+}  // namespace
+
+QList<BenchmarkResult> parserBenchmarks(qint64 minTime) {
+  QList<BenchmarkResult> results;
+
+  results << runMicrobenchmark("parser/status_x1000",
+                               parseOperation(statusReplies(1000), 1000),
+                               minTime)
+          << runMicrobenchmark("parser/bulk_8mb",
+                               parseOperation(hugeBulkReply(8 << 20), 1),
+                               minTime)
+          << runMicrobenchmark("parser/nested_array_depth64",
+                               parseOperation(nestedArrayReply(64), 1),
+                               minTime)
+          << runMicrobenchmark("parser/scan_page_1000",
+                               parseOperation(scanPageReply(1000), 1),
+                               minTime);
+
+  return results;
+}
+
+QList<BenchmarkResult> serializerBenchmarks(qint64 minTime) {
+  QByteArray key = "qredis-bench:key:000001";
+
+  RedisClient::Command pipeline;
+  for (int i = 0; i < 100; ++i)
+    pipeline.addToPipeline({"SET", key, QByteArray(64, 'v')});
+
+  QList<BenchmarkResult> results;
+
+  results << runMicrobenchmark("serializer/get",
+                               serializeOperation(RedisClient::Command(
+                                   QList<QByteArray>{"GET", key})),
+                               minTime)
+          << runMicrobenchmark(
+                 "serializer/set_1kb",
+                 serializeOperation(RedisClient::Command(
+                     QList<QByteArray>{"SET", key, QByteArray(1024, 'v')})),
+                 minTime)
+          << runMicrobenchmark(
+                 "serializer/set_1mb",
+                 serializeOperation(RedisClient::Command(QList<QByteArray>{
+                     "SET", key, QByteArray(1 << 20, 'v')})),
+                 minTime)
+          << runMicrobenchmark("serializer/pipeline_100",
+                               serializeOperation(pipeline), minTime);
+
+  return results;
+}
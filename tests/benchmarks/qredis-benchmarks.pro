@@ -0,0 +1,23 @@
+QT       += core network
+
+TARGET = qredis-benchmarks
+TEMPLATE = app
+
+CONFIG += release c++11 console
+CONFIG-=app_bundle
+
+DEFINES += QT_NO_DEBUG_OUTPUT
+
+PROJECT_ROOT = $$PWD/../../
+DESTDIR = $$PWD/bin
+
+HEADERS += \
+    $$PWD/benchmark.h
+
+SOURCES += \
+    $$PWD/benchmark.cpp \
+    $$PWD/endtoend.cpp \
+    $$PWD/main.cpp \
+    $$PWD/microbenchmarks.cpp
+
+include($$PROJECT_ROOT/qredisclient.pri)
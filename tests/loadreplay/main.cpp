@@ -0,0 +1,214 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QScopedPointer>
+#include <QTextStream>
+#include <QTimer>
+#include <iostream>
+#include <stdexcept>
+#include "mockserver.h"
+#include "qredisclient/redisclient.h"
+#include "replaydriver.h"
+#include "trace.h"
+
+namespace {
+void printHistogram(QTextStream &out, const QString &name,
+                    const RedisClient::LatencyHistogram &h) {
+  out << qSetFieldWidth(14) << left << name << qSetFieldWidth(10) << right
+      << QString::number(h.percentile(50) / 1000.0, 'f', 3)
+      << QString::number(h.percentile(90) / 1000.0, 'f', 3)
+      << QString::number(h.percentile(99) / 1000.0, 'f', 3)
+      << QString::number(h.percentile(99.9) / 1000.0, 'f', 3)
+      << QString::number(h.max() / 1000.0, 'f', 3) << qSetFieldWidth(0)
+      << "\n";
+}
+
+void printResult(const ReplayDriver::Result &r, QTextStream &out) {
+  out << "sent: " << r.sent << ", completed: " << r.completed
+      << ", errors: " << r.errors << ", qps: "
+      << QString::number(r.achievedQps(), 'f', 0)
+      << ", max send lag, ms: " << QString::number(r.maxSendLag / 1e6, 'f', 3)
+      << "\n";
+
+  out << qSetFieldWidth(14) << left << "latency, ms" << qSetFieldWidth(10)
+      << right << "p50"
+      << "p90"
+      << "p99"
+      << "p99.9"
+      << "max" << qSetFieldWidth(0) << "\n";
+
+  printHistogram(out, "corrected", r.corrected);
+  printHistogram(out, "uncorrected", r.uncorrected);
+  out.flush();
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  initRedisClient();
+
+  QCoreApplication::setApplicationName("qredis-loadreplay");
+  QCoreApplication::setApplicationVersion("0.0.1");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "Replays command trace at fixed rate against in-process mock "
+      "redis-server with injected latency and reports latency percentiles "
+      "corrected for coordinated omission");
+  parser.addHelpOption();
+  parser.addVersionOption();
+
+  QCommandLineOption traceOption(
+      "trace", "Command trace: MONITOR output or one command per line",
+      "file");
+  QCommandLineOption repliesOption(
+      "replies", "Recorded RESP stream of requests and their replies",
+      "file");
+  QCommandLineOption qpsOption("qps", "Commands per second", "rate", "10000");
+  QCommandLineOption requestsOption("requests", "Commands to send", "count",
+                                    "100000");
+  QCommandLineOption warmupOption(
+      "warmup", "First commands excluded from latencies", "count", "1000");
+  QCommandLineOption latencyOption(
+      "latency", "Latency injected by mock server in ms", "ms", "0.5");
+  QCommandLineOption jitterOption(
+      "jitter", "Max random extra latency in ms", "ms", "0");
+  QCommandLineOption bandwidthOption(
+      "bandwidth", "Bandwidth of mock server connection, 0 - unlimited",
+      "bytes/sec", "0");
+  QCommandLineOption seedOption("seed", "Seed of jitter", "seed", "1");
+  QCommandLineOption hostOption(
+      "host", "Replay against redis-server instead of mock server", "host");
+  QCommandLineOption portOption("port", "redis-server port", "port", "6379");
+  QCommandLineOption connectionsOption(
+      "connections", "Connections, commands are sent round-robin", "count",
+      "1");
+  QCommandLineOption batchCommandsOption(
+      "write-batch-commands", "Max commands coalesced into one write",
+      "count");
+  QCommandLineOption batchDelayOption(
+      "write-batch-delay", "Max delay of coalesced write in us", "us");
+  QCommandLineOption sharedThreadOption(
+      "shared-thread", "Run connections in shared transporter threads");
+  QCommandLineOption jsonOption("json", "Write result as JSON to file",
+                                "file");
+
+  parser.addOptions({traceOption, repliesOption, qpsOption, requestsOption,
+                     warmupOption, latencyOption, jitterOption,
+                     bandwidthOption, seedOption, hostOption, portOption,
+                     connectionsOption, batchCommandsOption, batchDelayOption,
+                     sharedThreadOption, jsonOption});
+  parser.process(app);
+
+  int exitCode = 0;
+
+  QTimer::singleShot(0, [&]() {
+    Trace trace;
+    ReplyBook replies;
+
+    try {
+      trace = parser.isSet(traceOption)
+                  ? Trace::load(parser.value(traceOption))
+                  : Trace::synthetic(10000, 1000, 64, 0.2);
+
+      if (parser.isSet(repliesOption))
+        replies.load(parser.value(repliesOption));
+    } catch (const std::runtime_error &e) {
+      std::cerr << e.what() << std::endl;
+      return app.exit(1);
+    }
+
+    QScopedPointer<MockServer> server;
+    RedisClient::ConnectionConfig config("127.0.0.1");
+    config.setName("loadreplay");
+
+    if (parser.isSet(hostOption)) {
+      config.setHost(parser.value(hostOption));
+      config.setPort(parser.value(portOption).toUInt());
+    } else {
+      MockServer::Options serverOptions;
+      serverOptions.latency = parser.value(latencyOption).toDouble();
+      serverOptions.jitter = parser.value(jitterOption).toDouble();
+      serverOptions.bandwidth = parser.value(bandwidthOption).toLongLong();
+      serverOptions.seed = parser.value(seedOption).toUInt();
+
+      server.reset(new MockServer(serverOptions, replies));
+      quint16 port = server->start();
+
+      if (port == 0) {
+        std::cerr << "Mock server cannot listen on localhost" << std::endl;
+        return app.exit(2);
+      }
+
+      config.setPort(port);
+    }
+
+    if (parser.isSet(batchCommandsOption) || parser.isSet(batchDelayOption)) {
+      uint maxCommands = parser.isSet(batchCommandsOption)
+                             ? parser.value(batchCommandsOption).toUInt()
+                             : config.writeBatchMaxCommands();
+      uint maxDelay = parser.isSet(batchDelayOption)
+                          ? parser.value(batchDelayOption).toUInt()
+                          : config.writeBatchMaxDelay();
+      config.setWriteBatchLimits(config.writeBatchMaxBytes(), maxCommands,
+                                 maxDelay);
+    }
+
+    config.setSharedTransporterThread(parser.isSet(sharedThreadOption));
+
+    QList<QSharedPointer<RedisClient::Connection>> connections;
+    QList<RedisClient::Connection *> targets;
+    int connectionsCount = qMax(1, parser.value(connectionsOption).toInt());
+
+    for (int i = 0; i < connectionsCount; ++i) {
+      QSharedPointer<RedisClient::Connection> connection(
+          new RedisClient::Connection(config));
+
+      try {
+        if (!connection->connect())
+          throw RedisClient::Connection::Exception("Connection timeout");
+      } catch (const RedisClient::Connection::Exception &e) {
+        std::cerr << "Cannot connect: " << e.what() << std::endl;
+        return app.exit(2);
+      }
+
+      connections << connection;
+      targets << connection.data();
+    }
+
+    ReplayDriver::Options options;
+    options.qps = parser.value(qpsOption).toDouble();
+    options.requests = parser.value(requestsOption).toInt();
+    options.warmup = parser.value(warmupOption).toInt();
+
+    ReplayDriver driver(targets, trace, options);
+    ReplayDriver::Result result = driver.run();
+
+    QTextStream out(stdout);
+    printResult(result, out);
+
+    if (server)
+      out << "mock server requests: " << server->requests() << "\n";
+
+    if (parser.isSet(jsonOption)) {
+      QFile f(parser.value(jsonOption));
+
+      if (f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        f.write(QJsonDocument(result.toJson()).toJson());
+      } else {
+        std::cerr << "Cannot write result to "
+                  << parser.value(jsonOption).toStdString() << std::endl;
+        exitCode = 1;
+      }
+    }
+
+    if (result.errors > 0 && exitCode == 0) exitCode = 3;
+
+    for (auto connection : connections) connection->disconnect();
+
+    app.exit(exitCode);
+  });
+
+  return app.exec();
+}
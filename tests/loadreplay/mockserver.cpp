@@ -0,0 +1,250 @@
+#include "mockserver.h"
+#include <QFile>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <stdexcept>
+#include "resp.h"
+
+ReplyBook::ReplyBook() : m_defaultReply("+OK\r\n") {
+  // Handshake of Connection, RESP3 is not negotiated
+  m_builtIn.insert("PING", "+PONG\r\n");
+  m_builtIn.insert("HELLO", Resp::error("ERR unknown command 'HELLO'"));
+  m_builtIn.insert("INFO", Resp::bulkString("# Server\r\n"
+                                            "redis_version:7.2.0\r\n"
+                                            "redis_mode:standalone\r\n"));
+}
+
+void ReplyBook::load(const QString &path) {
+  QFile file(path);
+
+  if (!file.open(QIODevice::ReadOnly))
+    throw std::runtime_error(
+        QString("Cannot open replies %1").arg(path).toStdString());
+
+  QByteArray data = file.readAll();
+  int offset = 0;
+
+  while (offset < data.size()) {
+    int requestSize = Resp::frameSize(data, offset);
+    int replySize =
+        requestSize > 0 ? Resp::frameSize(data, offset + requestSize) : -1;
+
+    if (replySize <= 0)
+      throw std::runtime_error(
+          QString("Invalid RESP in %1 at offset %2").arg(path).arg(offset)
+              .toStdString());
+
+    QList<QByteArray> request =
+        Resp::requestArgs(data.mid(offset, requestSize));
+
+    if (!request.isEmpty())
+      add(request, data.mid(offset + requestSize, replySize));
+
+    offset += requestSize + replySize;
+  }
+}
+
+void ReplyBook::add(const QList<QByteArray> &request,
+                    const QByteArray &reply) {
+  if (request.isEmpty()) return;
+
+  m_exact.insert(Resp::encodeRequest(request), reply);
+  m_byCommand[request.first().toUpper()].append(reply);
+}
+
+void ReplyBook::setDefaultReply(const QByteArray &reply) {
+  m_defaultReply = reply;
+}
+
+QByteArray ReplyBook::reply(const QList<QByteArray> &request) {
+  if (request.isEmpty()) return m_defaultReply;
+
+  if (!m_exact.isEmpty()) {
+    auto exact = m_exact.constFind(Resp::encodeRequest(request));
+
+    if (exact != m_exact.constEnd()) return exact.value();
+  }
+
+  QByteArray command = request.first().toUpper();
+  auto recorded = m_byCommand.constFind(command);
+
+  if (recorded != m_byCommand.constEnd() && !recorded->isEmpty()) {
+    int &next = m_nextReply[command];
+    QByteArray result = recorded->at(next);
+    next = (next + 1) % recorded->size();
+    return result;
+  }
+
+  return m_builtIn.value(command, m_defaultReply);
+}
+
+int ReplyBook::size() const { return m_exact.size(); }
+
+MockServer::Options::Options()
+    : latency(0), jitter(0), bandwidth(0), seed(1) {}
+
+MockServer::MockServer(const Options &options, const ReplyBook &replies)
+    : m_requests(new QAtomicInteger<quint64>(0)) {
+  m_thread.setObjectName("qredis-loadreplay::mock_server");
+  m_worker = new MockServerWorker(options, replies, m_requests);
+  m_worker->moveToThread(&m_thread);
+}
+
+MockServer::~MockServer() {
+  stop();
+  delete m_worker;
+}
+
+quint16 MockServer::start() {
+  if (!m_thread.isRunning()) m_thread.start();
+
+  int port = 0;
+  QMetaObject::invokeMethod(m_worker, "listen", Qt::BlockingQueuedConnection,
+                            Q_RETURN_ARG(int, port));
+  return static_cast<quint16>(port);
+}
+
+void MockServer::stop() {
+  if (!m_thread.isRunning()) return;
+
+  QMetaObject::invokeMethod(m_worker, "close", Qt::BlockingQueuedConnection);
+  m_thread.quit();
+  m_thread.wait();
+}
+
+quint64 MockServer::requests() const { return m_requests->loadAcquire(); }
+
+MockServerWorker::MockServerWorker(
+    const MockServer::Options &options, const ReplyBook &replies,
+    QSharedPointer<QAtomicInteger<quint64>> requests)
+    : m_options(options),
+      m_replies(replies),
+      m_requests(requests),
+      m_server(nullptr),
+      m_clientSeed(0) {}
+
+MockServerWorker::~MockServerWorker() {}
+
+int MockServerWorker::listen() {
+  if (!m_server) {
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this,
+            &MockServerWorker::acceptClients);
+  }
+
+  if (!m_clock.isValid()) m_clock.start();
+
+  if (!m_server->isListening() &&
+      !m_server->listen(QHostAddress::LocalHost, 0))
+    return 0;
+
+  return m_server->serverPort();
+}
+
+void MockServerWorker::close() {
+  for (auto client : m_clients) {
+    client->socket->abort();
+    delete client->socket;
+  }
+
+  m_clients.clear();
+
+  // Server is deleted in its own thread
+  delete m_server;
+  m_server = nullptr;
+}
+
+void MockServerWorker::acceptClients() {
+  while (m_server->hasPendingConnections()) {
+    QTcpSocket *socket = m_server->nextPendingConnection();
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    QSharedPointer<Client> client(new Client(m_options.seed + m_clientSeed++));
+    client->socket = socket;
+    client->timer = new QTimer(socket);
+    client->timer->setSingleShot(true);
+    client->timer->setTimerType(Qt::PreciseTimer);
+    m_clients.insert(socket, client);
+
+    connect(socket, &QTcpSocket::readyRead, this,
+            [this, client]() { readRequests(client); });
+    connect(client->timer, &QTimer::timeout, this,
+            [this, client]() { sendDueReplies(client); });
+    connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+      m_clients.remove(socket);
+      socket->deleteLater();
+    });
+  }
+}
+
+void MockServerWorker::readRequests(QSharedPointer<Client> client) {
+  client->buffer.append(client->socket->readAll());
+
+  int offset = 0;
+
+  while (offset < client->buffer.size()) {
+    int size = Resp::frameSize(client->buffer, offset);
+
+    if (size == 0) break;
+
+    // Inline commands are not sent by qredisclient
+    if (size < 0) {
+      client->buffer.clear();
+      client->socket->write(Resp::error("ERR Protocol error"));
+      client->socket->disconnectFromHost();
+      return;
+    }
+
+    QList<QByteArray> args =
+        Resp::requestArgs(client->buffer.mid(offset, size));
+    offset += size;
+    m_requests->fetchAndAddRelaxed(1);
+
+    scheduleReply(client, args.isEmpty()
+                              ? Resp::error("ERR Protocol error")
+                              : m_replies.reply(args));
+  }
+
+  client->buffer.remove(0, offset);
+  sendDueReplies(client);
+}
+
+void MockServerWorker::scheduleReply(QSharedPointer<Client> client,
+                                     const QByteArray &reply) {
+  qint64 now = m_clock.nsecsElapsed();
+  double delay = m_options.latency;
+
+  if (m_options.jitter > 0) {
+    std::uniform_real_distribution<double> jitter(0.0, m_options.jitter);
+    delay += jitter(client->generator);
+  }
+
+  // Reply is ready after delay and is transmitted once previous
+  // replies of connection are sent
+  qint64 due = qMax(now + static_cast<qint64>(delay * 1000000),
+                    client->lineFreeAt);
+
+  if (m_options.bandwidth > 0)
+    due += static_cast<qint64>(reply.size() * 1000000000.0 /
+                               m_options.bandwidth);
+
+  client->lineFreeAt = due;
+  client->replies.enqueue(PendingReply{due, reply});
+}
+
+void MockServerWorker::sendDueReplies(QSharedPointer<Client> client) {
+  qint64 now = m_clock.nsecsElapsed();
+  QByteArray batch;
+
+  while (!client->replies.isEmpty() && client->replies.head().due <= now)
+    batch.append(client->replies.dequeue().data);
+
+  if (!batch.isEmpty()) client->socket->write(batch);
+
+  if (client->replies.isEmpty()) return;
+
+  // Timer has millisecond resolution, replies are never sent early
+  qint64 wait = client->replies.head().due - now;
+  client->timer->start(static_cast<int>((wait + 999999) / 1000000));
+}
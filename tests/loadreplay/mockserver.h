@@ -0,0 +1,140 @@
+#pragma once
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QThread>
+#include <QVector>
+#include <random>
+
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+
+/**
+ * @brief Recorded replies of mock server.
+ * Recording is a RESP stream where each request frame is followed by
+ * its reply frame, e.g. both directions of a session captured by proxy.
+ * Reply is looked up by exact request, then by command name in
+ * round-robin order, then in built-in handshake replies.
+ */
+class ReplyBook {
+ public:
+  ReplyBook();
+
+  /**
+   * @throws std::runtime_error if file cannot be read or isn't valid RESP
+   */
+  void load(const QString &path);
+  void add(const QList<QByteArray> &request, const QByteArray &reply);
+
+  /**
+   * @brief Reply of commands which are not recorded, +OK by default
+   */
+  void setDefaultReply(const QByteArray &reply);
+
+  QByteArray reply(const QList<QByteArray> &request);
+  int size() const;
+
+ private:
+  QHash<QByteArray, QByteArray> m_exact;  // encoded request
+  QHash<QByteArray, QVector<QByteArray>> m_byCommand;
+  QHash<QByteArray, int> m_nextReply;
+  QHash<QByteArray, QByteArray> m_builtIn;
+  QByteArray m_defaultReply;
+};
+
+class MockServerWorker;
+
+/**
+ * @brief The MockServer class
+ * In-process fake redis-server for latency tests. It listens on
+ * localhost in its own thread and answers each request with recorded
+ * reply after injected latency. Replies of a connection are sent in
+ * request order and share connection bandwidth, like replies of
+ * redis-server. Jitter is generated from fixed seed per connection,
+ * so runs with the same options are reproducible.
+ */
+class MockServer {
+ public:
+  struct Options {
+    Options();
+
+    double latency;    // in ms, added to every reply
+    double jitter;     // in ms, uniformly distributed extra delay
+    qint64 bandwidth;  // bytes per second per connection, 0 - unlimited
+    quint32 seed;
+  };
+
+ public:
+  MockServer(const Options &options, const ReplyBook &replies);
+  ~MockServer();
+
+  /**
+   * @return port on localhost, 0 if server cannot listen
+   */
+  quint16 start();
+  void stop();
+
+  quint64 requests() const;
+
+ private:
+  Q_DISABLE_COPY(MockServer)
+
+  QThread m_thread;
+  MockServerWorker *m_worker;
+  QSharedPointer<QAtomicInteger<quint64>> m_requests;
+};
+
+/**
+ * @brief Lives in thread of MockServer
+ */
+class MockServerWorker : public QObject {
+  Q_OBJECT
+
+ public:
+  MockServerWorker(const MockServer::Options &options,
+                   const ReplyBook &replies,
+                   QSharedPointer<QAtomicInteger<quint64>> requests);
+  ~MockServerWorker() override;
+
+ public slots:
+  int listen();
+  void close();
+
+ private:
+  struct PendingReply {
+    qint64 due;  // m_clock nsecs
+    QByteArray data;
+  };
+
+  struct Client {
+    Client(quint32 seed)
+        : socket(nullptr), timer(nullptr), generator(seed), lineFreeAt(0) {}
+
+    QTcpSocket *socket;
+    QTimer *timer;
+    QByteArray buffer;
+    QQueue<PendingReply> replies;
+    std::mt19937 generator;
+    qint64 lineFreeAt;  // last reply is transmitted, m_clock nsecs
+  };
+
+  void acceptClients();
+  void readRequests(QSharedPointer<Client> client);
+  void scheduleReply(QSharedPointer<Client> client, const QByteArray &reply);
+  void sendDueReplies(QSharedPointer<Client> client);
+
+ private:
+  MockServer::Options m_options;
+  ReplyBook m_replies;
+  QSharedPointer<QAtomicInteger<quint64>> m_requests;
+  QTcpServer *m_server;
+  QHash<QTcpSocket *, QSharedPointer<Client>> m_clients;
+  QElapsedTimer m_clock;
+  quint32 m_clientSeed;
+};
@@ -0,0 +1,27 @@
+QT       += core network
+
+TARGET = qredis-loadreplay
+TEMPLATE = app
+
+CONFIG += release c++11 console
+CONFIG-=app_bundle
+
+DEFINES += QT_NO_DEBUG_OUTPUT
+
+PROJECT_ROOT = $$PWD/../../
+DESTDIR = $$PWD/bin
+
+HEADERS += \
+    $$PWD/mockserver.h \
+    $$PWD/replaydriver.h \
+    $$PWD/resp.h \
+    $$PWD/trace.h
+
+SOURCES += \
+    $$PWD/main.cpp \
+    $$PWD/mockserver.cpp \
+    $$PWD/replaydriver.cpp \
+    $$PWD/resp.cpp \
+    $$PWD/trace.cpp
+
+include($$PROJECT_ROOT/qredisclient.pri)
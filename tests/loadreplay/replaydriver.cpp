@@ -0,0 +1,148 @@
+#include "replaydriver.h"
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QHash>
+#include <QTimer>
+#include "qredisclient/connection.h"
+
+namespace {
+// Sends are checked every millisecond, commands due within the tick
+// are sent together
+const int SEND_TICK = 1;
+
+quint64 toUsecs(qint64 nsecs) {
+  return static_cast<quint64>(qMax(Q_INT64_C(0), nsecs) / 1000);
+}
+}  // namespace
+
+ReplayDriver::Options::Options()
+    : qps(1000), requests(10000), warmup(0), timeout(10000) {}
+
+ReplayDriver::Result::Result()
+    : sent(0), completed(0), errors(0), elapsed(0), maxSendLag(0) {}
+
+double ReplayDriver::Result::achievedQps() const {
+  return elapsed > 0 ? completed * 1e9 / elapsed : 0.0;
+}
+
+QJsonObject ReplayDriver::Result::toJson() const {
+  auto histogram = [](const RedisClient::LatencyHistogram &h) {
+    QJsonObject result;
+    result["mean_us"] = h.mean();
+    result["p50_us"] = static_cast<double>(h.percentile(50));
+    result["p90_us"] = static_cast<double>(h.percentile(90));
+    result["p99_us"] = static_cast<double>(h.percentile(99));
+    result["p999_us"] = static_cast<double>(h.percentile(99.9));
+    result["max_us"] = static_cast<double>(h.max());
+    return result;
+  };
+
+  QJsonObject result;
+  result["sent"] = static_cast<double>(sent);
+  result["completed"] = static_cast<double>(completed);
+  result["errors"] = static_cast<double>(errors);
+  result["elapsed_ns"] = static_cast<double>(elapsed);
+  result["qps"] = achievedQps();
+  result["max_send_lag_ns"] = static_cast<double>(maxSendLag);
+  result["corrected"] = histogram(corrected);
+  result["uncorrected"] = histogram(uncorrected);
+  return result;
+}
+
+ReplayDriver::ReplayDriver(const QList<RedisClient::Connection *> &connections,
+                           const Trace &trace, const Options &options)
+    : m_connections(connections), m_trace(trace), m_options(options) {}
+
+ReplayDriver::Result ReplayDriver::run() {
+  Result result;
+
+  if (m_connections.isEmpty() || m_trace.commands.isEmpty() ||
+      m_options.requests <= 0 || m_options.qps <= 0)
+    return result;
+
+  QEventLoop loop;
+  QTimer sendTimer;
+  QTimer timeoutTimer;
+  QElapsedTimer clock;
+  double interval = 1e9 / m_options.qps;
+  int next = 0;
+  QHash<int, qint64> inFlight;  // scheduled time of measured commands
+  quint64 requests = static_cast<quint64>(m_options.requests);
+
+  auto scheduledAt = [interval](int i) {
+    return static_cast<qint64>(i * interval);
+  };
+
+  auto send = [&](int i) {
+    const TraceCommand &traced =
+        m_trace.commands.at(i % m_trace.commands.size());
+    RedisClient::Connection *connection =
+        m_connections.at(i % m_connections.size());
+    qint64 sentAt = clock.nsecsElapsed();
+    qint64 scheduled = scheduledAt(i);
+    bool measured = i >= m_options.warmup;
+
+    result.maxSendLag = qMax(result.maxSendLag, sentAt - scheduled);
+
+    RedisClient::Command cmd(traced.args, traced.db);
+    cmd.setCallBack(&loop, [&, i, sentAt, scheduled, measured](
+                               RedisClient::Response r, QString err) {
+      qint64 now = clock.nsecsElapsed();
+
+      if (measured) {
+        inFlight.remove(i);
+        result.corrected.record(toUsecs(now - scheduled));
+        result.uncorrected.record(toUsecs(now - sentAt));
+      }
+
+      if (!err.isEmpty() || r.isErrorMessage()) result.errors++;
+
+      if (++result.completed == requests) loop.quit();
+    });
+
+    if (measured) inFlight.insert(i, scheduled);
+
+    try {
+      connection->runCommand(cmd);
+      result.sent++;
+    } catch (const RedisClient::Connection::Exception &) {
+      inFlight.remove(i);
+      result.errors++;
+      result.completed++;
+    }
+  };
+
+  sendTimer.setTimerType(Qt::PreciseTimer);
+  sendTimer.setInterval(SEND_TICK);
+  QObject::connect(&sendTimer, &QTimer::timeout, [&]() {
+    qint64 now = clock.nsecsElapsed();
+
+    while (next < m_options.requests && scheduledAt(next) <= now)
+      send(next++);
+
+    if (result.completed == requests) return loop.quit();
+
+    if (next < m_options.requests) return;
+
+    sendTimer.stop();
+    timeoutTimer.start(m_options.timeout);
+  });
+
+  timeoutTimer.setSingleShot(true);
+  QObject::connect(&timeoutTimer, &QTimer::timeout, &loop, &QEventLoop::quit);
+
+  clock.start();
+  sendTimer.start();
+  loop.exec();
+
+  result.elapsed = clock.nsecsElapsed();
+
+  // Commands without reply are errors. Their latency is at least time
+  // since schedule, skipping them would hide the stall.
+  for (qint64 scheduled : inFlight)
+    result.corrected.record(toUsecs(result.elapsed - scheduled));
+
+  result.errors += requests - qMin(requests, result.completed);
+
+  return result;
+}
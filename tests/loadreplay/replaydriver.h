@@ -0,0 +1,64 @@
+#pragma once
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include "qredisclient/connectionmetrics.h"
+#include "trace.h"
+
+namespace RedisClient {
+class Connection;
+}
+
+/**
+ * @brief The ReplayDriver class
+ * Sends commands of trace at fixed rate: command i is scheduled at
+ * i / qps seconds after start regardless of replies of previous commands.
+ * Corrected latency is measured from scheduled time, so stalls of client
+ * or server are not hidden by delayed sends (coordinated omission).
+ * Latency from actual send is reported for comparison.
+ */
+class ReplayDriver {
+ public:
+  struct Options {
+    Options();
+
+    double qps;
+    int requests;  // trace is repeated if it is shorter
+    int warmup;    // first requests are not included in latencies
+    uint timeout;  // in ms, for commands in flight after last send
+  };
+
+  struct Result {
+    Result();
+
+    quint64 sent;
+    quint64 completed;
+    quint64 errors;
+    qint64 elapsed;  // in nanoseconds
+    qint64 maxSendLag;  // latest send after scheduled time, in nanoseconds
+
+    // In microseconds
+    RedisClient::LatencyHistogram corrected;
+    RedisClient::LatencyHistogram uncorrected;
+
+    double achievedQps() const;
+    QJsonObject toJson() const;
+  };
+
+ public:
+  /**
+   * @param connections - commands are distributed round-robin
+   */
+  ReplayDriver(const QList<RedisClient::Connection *> &connections,
+               const Trace &trace, const Options &options);
+
+  /**
+   * @brief Replay trace in local event loop
+   */
+  Result run();
+
+ private:
+  QList<RedisClient::Connection *> m_connections;
+  Trace m_trace;
+  Options m_options;
+};
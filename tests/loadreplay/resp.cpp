@@ -0,0 +1,121 @@
+#include "resp.h"
+
+namespace {
+const int INCOMPLETE = -1;
+const int INVALID = -2;
+const int MAX_DEPTH = 64;
+
+// Position after CRLF of line which starts at pos
+int lineEnd(const QByteArray &data, int pos) {
+  int crlf = data.indexOf("\r\n", pos);
+  return crlf < 0 ? INCOMPLETE : crlf + 2;
+}
+
+bool parseLength(const QByteArray &data, int from, int to, qint64 &length) {
+  bool ok = false;
+  length = QByteArray::fromRawData(data.constData() + from, to - from)
+               .toLongLong(&ok);
+  return ok;
+}
+
+int frameEnd(const QByteArray &data, int pos, int depth) {
+  if (pos >= data.size()) return INCOMPLETE;
+  if (depth > MAX_DEPTH) return INVALID;
+
+  char type = data.at(pos);
+  int end = lineEnd(data, pos + 1);
+
+  if (end < 0) return end;
+
+  qint64 length = 0;
+
+  switch (type) {
+    case '+':
+    case '-':
+    case ':':
+    case '_':
+    case ',':
+    case '#':
+    case '(':
+      return end;
+    case '$':
+    case '=':
+    case '!':
+      if (!parseLength(data, pos + 1, end - 2, length)) return INVALID;
+      if (length < 0) return end;  // RESP2 nil
+      if (data.size() < end + length + 2) return INCOMPLETE;
+      return end + static_cast<int>(length) + 2;
+    case '*':
+    case '~':
+    case '>':
+    case '%':
+    case '|':
+      if (!parseLength(data, pos + 1, end - 2, length)) return INVALID;
+      if (length < 0) return end;
+      if (type == '%' || type == '|') length *= 2;
+
+      for (qint64 i = 0; i < length; ++i) {
+        end = frameEnd(data, end, depth + 1);
+        if (end < 0) return end;
+      }
+
+      // Attributes are followed by reply they describe
+      return type == '|' ? frameEnd(data, end, depth + 1) : end;
+    default:
+      return INVALID;
+  }
+}
+}  // namespace
+
+int Resp::frameSize(const QByteArray &data, int offset) {
+  int end = frameEnd(data, offset, 0);
+
+  if (end == INCOMPLETE) return 0;
+  if (end == INVALID) return -1;
+
+  return end - offset;
+}
+
+QList<QByteArray> Resp::requestArgs(const QByteArray &frame) {
+  QList<QByteArray> args;
+
+  if (!frame.startsWith('*')) return args;
+
+  int pos = lineEnd(frame, 1);
+  qint64 count = 0;
+
+  if (pos < 0 || !parseLength(frame, 1, pos - 2, count)) return args;
+
+  args.reserve(static_cast<int>(qMax<qint64>(0, count)));
+
+  for (qint64 i = 0; i < count; ++i) {
+    int end = lineEnd(frame, pos + 1);
+    qint64 length = 0;
+
+    if (pos >= frame.size() || frame.at(pos) != '$' || end < 0 ||
+        !parseLength(frame, pos + 1, end - 2, length) || length < 0 ||
+        frame.size() < end + length + 2)
+      return QList<QByteArray>();
+
+    args.append(frame.mid(end, static_cast<int>(length)));
+    pos = end + static_cast<int>(length) + 2;
+  }
+
+  return args;
+}
+
+QByteArray Resp::encodeRequest(const QList<QByteArray> &args) {
+  QByteArray result = "*" + QByteArray::number(args.size()) + "\r\n";
+
+  for (const QByteArray &arg : args) result.append(bulkString(arg));
+
+  return result;
+}
+
+QByteArray Resp::bulkString(const QByteArray &value) {
+  return "$" + QByteArray::number(value.size()) + "\r\n" + value + "\r\n";
+}
+
+QByteArray Resp::error(const QByteArray &message) {
+  return "-" + message + "\r\n";
+}
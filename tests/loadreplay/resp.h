@@ -0,0 +1,27 @@
+#pragma once
+#include <QByteArray>
+#include <QList>
+
+/**
+ * RESP framing for mock server. Frames are not decoded: recorded replies
+ * are sent as is, requests are split into arguments.
+ */
+namespace Resp {
+
+/**
+ * @brief Size of complete RESP2 or RESP3 frame at offset
+ * @return 0 - frame is incomplete, -1 - data is not valid RESP
+ */
+int frameSize(const QByteArray &data, int offset = 0);
+
+/**
+ * @brief Arguments of request frame
+ * @return empty list if frame is not an array of bulk strings
+ */
+QList<QByteArray> requestArgs(const QByteArray &frame);
+
+QByteArray encodeRequest(const QList<QByteArray> &args);
+QByteArray bulkString(const QByteArray &value);
+QByteArray error(const QByteArray &message);
+
+}  // namespace Resp
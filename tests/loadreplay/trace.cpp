@@ -0,0 +1,158 @@
+#include "trace.h"
+#include <QFile>
+#include <random>
+#include <stdexcept>
+
+namespace {
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Quoted argument escaped by sdscatrepr() of redis-server
+int parseQuoted(const QByteArray &line, int pos, QByteArray &arg) {
+  for (++pos; pos < line.size(); ++pos) {
+    char c = line.at(pos);
+
+    if (c == '"') return pos + 1;
+
+    if (c != '\\' || pos + 1 >= line.size()) {
+      arg.append(c);
+      continue;
+    }
+
+    char escaped = line.at(++pos);
+
+    switch (escaped) {
+      case 'n':
+        arg.append('\n');
+        break;
+      case 'r':
+        arg.append('\r');
+        break;
+      case 't':
+        arg.append('\t');
+        break;
+      case 'a':
+        arg.append('\a');
+        break;
+      case 'b':
+        arg.append('\b');
+        break;
+      case 'x':
+        if (pos + 2 < line.size() && hexValue(line.at(pos + 1)) >= 0 &&
+            hexValue(line.at(pos + 2)) >= 0) {
+          arg.append(static_cast<char>(hexValue(line.at(pos + 1)) * 16 +
+                                       hexValue(line.at(pos + 2))));
+          pos += 2;
+        } else {
+          arg.append(escaped);
+        }
+        break;
+      default:
+        arg.append(escaped);
+    }
+  }
+
+  return -1;  // unterminated quote
+}
+}  // namespace
+
+Trace Trace::load(const QString &path) {
+  QFile file(path);
+
+  if (!file.open(QIODevice::ReadOnly))
+    throw std::runtime_error(
+        QString("Cannot open trace %1").arg(path).toStdString());
+
+  Trace trace;
+  TraceCommand command;
+
+  while (!file.atEnd()) {
+    if (parseLine(file.readLine(), command)) trace.commands.append(command);
+  }
+
+  return trace;
+}
+
+Trace Trace::synthetic(int commands, int keys, int valueSize,
+                       double writes) {
+  Trace trace;
+  std::mt19937 generator(1);
+  std::uniform_int_distribution<int> key(0, qMax(1, keys) - 1);
+  std::uniform_real_distribution<double> kind(0.0, 1.0);
+  QByteArray value(valueSize, 'v');
+
+  trace.commands.reserve(commands);
+
+  for (int i = 0; i < commands; ++i) {
+    TraceCommand command;
+    QByteArray name = "qredis-replay:key:" + QByteArray::number(key(generator));
+
+    if (kind(generator) < writes)
+      command.args << "SET" << name << value;
+    else
+      command.args << "GET" << name;
+
+    trace.commands.append(command);
+  }
+
+  return trace;
+}
+
+bool Trace::parseLine(const QByteArray &rawLine, TraceCommand &command) {
+  QByteArray line = rawLine.trimmed();
+  command = TraceCommand();
+
+  if (line.isEmpty() || line.startsWith('#') || line == "OK") return false;
+
+  int pos = 0;
+
+  // MONITOR prefix: timestamp [db client]
+  int bracket = line.indexOf(" [");
+
+  if (bracket > 0 && line.indexOf('"') > bracket) {
+    int close = line.indexOf(']', bracket);
+
+    if (close < 0) return false;
+
+    bool ok = false;
+    int space = line.indexOf(' ', bracket + 2);
+    int db = line.mid(bracket + 2, space - bracket - 2).toInt(&ok);
+
+    if (ok) command.db = db;
+
+    pos = close + 1;
+  }
+
+  while (pos < line.size()) {
+    char c = line.at(pos);
+
+    if (c == ' ' || c == '\t') {
+      ++pos;
+      continue;
+    }
+
+    QByteArray arg;
+
+    if (c == '"') {
+      pos = parseQuoted(line, pos, arg);
+
+      if (pos < 0) return false;
+    } else {
+      int end = pos;
+
+      while (end < line.size() && line.at(end) != ' ' && line.at(end) != '\t')
+        ++end;
+
+      arg = line.mid(pos, end - pos);
+      pos = end;
+    }
+
+    command.args.append(arg);
+  }
+
+  return !command.args.isEmpty();
+}
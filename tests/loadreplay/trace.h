@@ -0,0 +1,40 @@
+#pragma once
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+struct TraceCommand {
+  TraceCommand() : db(-1) {}
+
+  QList<QByteArray> args;
+  int db;  // -1 - current db of connection
+};
+
+/**
+ * @brief Command trace replayed by ReplayDriver.
+ * Each line is either MONITOR output of redis-server:
+ *   1700000000.123456 [0 127.0.0.1:50000] "SET" "key" "value"
+ * or space-separated arguments. Empty lines and lines starting
+ * with # are skipped. Timestamps are ignored, commands are sent
+ * at rate of replay.
+ */
+struct Trace {
+  QList<TraceCommand> commands;
+
+  /**
+   * @throws std::runtime_error if file cannot be read
+   */
+  static Trace load(const QString &path);
+
+  /**
+   * @brief Deterministic GET/SET mix over fixed set of keys
+   * @param writes - share of SET commands, 0..1
+   */
+  static Trace synthetic(int commands, int keys, int valueSize,
+                         double writes);
+
+  /**
+   * @return false if line doesn't contain command
+   */
+  static bool parseLine(const QByteArray &line, TraceCommand &command);
+};
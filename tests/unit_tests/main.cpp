@@ -4,13 +4,27 @@
 // tests
 #include <iostream>
 #include "qredisclient/redisclient.h"
+#include "test_bulk.h"
+#include "test_clientsidecache.h"
+#include "test_clusterslotmap.h"
 #include "test_command.h"
+#include "test_compactkeylist.h"
 #include "test_config.h"
 #include "test_connection.h"
+#include "test_connectionmetrics.h"
+#include "test_connectionpool.h"
+#include "test_keyiterator.h"
+#include "test_keyspaceanalyzer.h"
+#include "test_namespacetree.h"
 #include "test_response.h"
 #include "test_responseparer.h"
+#include "test_scriptcache.h"
+#include "test_serverinfo.h"
+#include "test_streamconsumer.h"
+#include "test_sync.h"
 #include "test_text.h"
 #include "test_transporters.h"
+#include "test_valuereader.h"
 
 int main(int argc, char *argv[]) {
   QCoreApplication app(argc, argv);
@@ -24,6 +38,20 @@ int main(int argc, char *argv[]) {
   QScopedPointer<QObject> testText(new TestText);
   QScopedPointer<QObject> testTransporters(new TestTransporters);
   QScopedPointer<QObject> testConnection(new TestConnection);
+  QScopedPointer<QObject> testClientSideCache(new TestClientSideCache);
+  QScopedPointer<QObject> testClusterSlotMap(new TestClusterSlotMap);
+  QScopedPointer<QObject> testConnectionPool(new TestConnectionPool);
+  QScopedPointer<QObject> testServerInfo(new TestServerInfo);
+  QScopedPointer<QObject> testKeyIterator(new TestKeyIterator);
+  QScopedPointer<QObject> testNamespaceTree(new TestNamespaceTree);
+  QScopedPointer<QObject> testScriptCache(new TestScriptCache);
+  QScopedPointer<QObject> testConnectionMetrics(new TestConnectionMetrics);
+  QScopedPointer<QObject> testBulk(new TestBulk);
+  QScopedPointer<QObject> testValueReader(new TestValueReader);
+  QScopedPointer<QObject> testStreamConsumer(new TestStreamConsumer);
+  QScopedPointer<QObject> testKeyspaceAnalyzer(new TestKeyspaceAnalyzer);
+  QScopedPointer<QObject> testSync(new TestSync);
+  QScopedPointer<QObject> testCompactKeyList(new TestCompactKeyList);
 
   int allTestsResult = 0 + QTest::qExec(testCommand.data(), argc, argv) +
                        QTest::qExec(testResponseParser.data(), argc, argv) +
@@ -31,7 +59,21 @@ int main(int argc, char *argv[]) {
                        QTest::qExec(testConfig.data(), argc, argv) +
                        QTest::qExec(testText.data(), argc, argv) +
                        QTest::qExec(testTransporters.data(), argc, argv) +
-                       QTest::qExec(testConnection.data(), argc, argv);
+                       QTest::qExec(testConnection.data(), argc, argv) +
+                       QTest::qExec(testClientSideCache.data(), argc, argv) +
+                       QTest::qExec(testClusterSlotMap.data(), argc, argv) +
+                       QTest::qExec(testConnectionPool.data(), argc, argv) +
+                       QTest::qExec(testServerInfo.data(), argc, argv) +
+                       QTest::qExec(testKeyIterator.data(), argc, argv) +
+                       QTest::qExec(testNamespaceTree.data(), argc, argv) +
+                       QTest::qExec(testScriptCache.data(), argc, argv) +
+                       QTest::qExec(testConnectionMetrics.data(), argc, argv) +
+                       QTest::qExec(testBulk.data(), argc, argv) +
+                       QTest::qExec(testValueReader.data(), argc, argv) +
+                       QTest::qExec(testStreamConsumer.data(), argc, argv) +
+                       QTest::qExec(testKeyspaceAnalyzer.data(), argc, argv) +
+                       QTest::qExec(testSync.data(), argc, argv) +
+                       QTest::qExec(testCompactKeyList.data(), argc, argv);
 
   if (allTestsResult == 0)
     qDebug() << "[Tests PASS]";
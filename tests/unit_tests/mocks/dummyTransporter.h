@@ -15,12 +15,15 @@ class DummyTransporter : public RedisClient::AbstractTransporter {
         disconnectCalls(0),
         addCommandCalls(0),
         cancelCommandsCalls(0),
-        m_catchParsedResponses(false) {}
+        flushCalls(0),
+        m_catchParsedResponses(false),
+        m_useWriteBatching(false) {}
 
   int initCalls;
   int disconnectCalls;
   int addCommandCalls;
   int cancelCommandsCalls;
+  int flushCalls;
 
   void setFakeResponses(const QStringList& respList) {
     for (QString response : respList) {
@@ -29,14 +32,31 @@ class DummyTransporter : public RedisClient::AbstractTransporter {
     }
   }
 
-  void setFakeReadBuffer(const QByteArray& buf) {
+  void setFakeReadBuffer(const QByteArray& buf, bool catchResponses = true) {
     m_fakeBuffer = buf;
-    m_catchParsedResponses = true;
+    m_catchParsedResponses = catchResponses;
+  }
+
+  // Pass commands through write batching instead of faking responses
+  void setWriteBatchingEnabled(bool enabled) { m_useWriteBatching = enabled; }
+
+  void addRunningCommand(const RedisClient::Command& cmd) {
+    m_runningCommands.enqueue(
+        QSharedPointer<RunningCommand>(new RunningCommand(cmd)));
+  }
+
+  using RedisClient::AbstractTransporter::reconnectDelay;
+
+  QList<RedisClient::Command> queuedCommands() const {
+    QList<RedisClient::Command> result;
+    for (const QueuedCommand& queued : m_commands) result.append(queued.cmd);
+    return result;
   }
 
   QList<RedisClient::Command> executedCommands;
   QList<RedisClient::Response> fakeResponses;
   QList<RedisClient::Response> catchedResponses;
+  QList<QByteArray> writtenBuffers;
 
  public slots:
   void addCommand(const RedisClient::Command& cmd) override {
@@ -47,7 +67,11 @@ class DummyTransporter : public RedisClient::AbstractTransporter {
   void init() {
     initCalls++;
 
-    // Init command tested after socket connection
+    // Handshake commands: PING, INFO server, INFO keyspace
+    RedisClient::Response keyspace(RedisClient::Response::Type::String,
+                                   "# Keyspace");
+    fakeResponses.push_front(keyspace);
+
     RedisClient::Response info(RedisClient::Response::Type::String,
                                "redis_version:999.999.999");
     fakeResponses.push_front(info);
@@ -61,9 +85,13 @@ class DummyTransporter : public RedisClient::AbstractTransporter {
   virtual void cancelCommands(QObject*) override { cancelCommandsCalls++; }
 
  protected:
-  virtual void runCommand(const RedisClient::Command& cmd) override {
+  virtual void runCommand(const RedisClient::Command& cmd,
+                          qint64 queuedAt) override {
     executedCommands.push_back(cmd);
 
+    if (m_useWriteBatching)
+      return AbstractTransporter::runCommand(cmd, queuedAt);
+
     RedisClient::Response resp;
 
     if (fakeResponses.size() > 0) {
@@ -98,10 +126,14 @@ class DummyTransporter : public RedisClient::AbstractTransporter {
   bool canReadFromSocket() override { return !m_fakeBuffer.isEmpty(); }
   QByteArray readFromSocket() override { return m_fakeBuffer; }
   void initSocket() override {}
-  bool connectToHost() override { return true; }
-  void sendCommand(const QByteArray&) override {}
+  void connectToHost() override {}
+  void sendCommand(const QByteArray& buf) override {
+    writtenBuffers.append(buf);
+  }
+  void flushSocket() override { flushCalls++; }
 
  private:
   QByteArray m_fakeBuffer;
   bool m_catchParsedResponses;
+  bool m_useWriteBatching;
 };
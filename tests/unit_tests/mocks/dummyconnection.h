@@ -80,6 +80,10 @@ class DummyConnection : public RedisClient::Connection {
     return d.future();
   }
 
+  void runCommands(const QList<RedisClient::Command>& commands) override {
+    for (const RedisClient::Command& cmd : commands) runCommand(cmd);
+  }
+
   uint runCommandCalled;
   uint retrieveCollectionCalled;
   uint getServerVersionCalled;
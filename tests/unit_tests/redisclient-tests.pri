@@ -16,5 +16,20 @@ SOURCES += \
     $$REDISCLIENT_SRC_DIR/private/*.cpp \
     $$REDISCLIENT_SRC_DIR/utils/*.cpp \
 
+# Mock redis-server of load-replay harness
+LOADREPLAY_DIR = $$PWD/../loadreplay/
+
+INCLUDEPATH += $$LOADREPLAY_DIR
+
+HEADERS += \
+    $$LOADREPLAY_DIR/mockserver.h \
+    $$LOADREPLAY_DIR/resp.h \
+    $$LOADREPLAY_DIR/trace.h
+
+SOURCES += \
+    $$LOADREPLAY_DIR/mockserver.cpp \
+    $$LOADREPLAY_DIR/resp.cpp \
+    $$LOADREPLAY_DIR/trace.cpp
+
 OTHER_FILES += \
     connections.xml
@@ -0,0 +1,123 @@
+#include "test_bulk.h"
+#include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QTest>
+#include "qredisclient/bulkexport.h"
+#include "qredisclient/bulkimport.h"
+#include "qredisclient/private/dumpfile.h"
+
+using RedisClient::BulkExport;
+using RedisClient::BulkImport;
+
+namespace {
+QString writeTemporaryFile(QTemporaryFile &file, const QByteArray &data) {
+  file.open();
+  file.write(data);
+  file.close();
+  return file.fileName();
+}
+}  // namespace
+
+void TestBulk::importRespFile() {
+  // given
+  QSharedPointer<RedisClient::Connection> connection =
+      getRealConnectionWithDummyTransporter(
+          QStringList() << "+OK\r\n" << "+OK\r\n" << ":2\r\n");
+  auto transporter =
+      connection->getTransporter().dynamicCast<DummyTransporter>();
+  QTemporaryFile file;
+  QString path = writeTemporaryFile(
+      file,
+      "*3\r\n$3\r\nSET\r\n$1\r\na\r\n$1\r\n1\r\n"
+      "*3\r\n$3\r\nSET\r\n$1\r\nb\r\n$3\r\n\r\n2\r\n"
+      "*2\r\n$4\r\nINCR\r\n$1\r\na\r\n");
+  BulkImport::Options options;
+  options.window = 2;
+  BulkImport import(connection.data(), path, options);
+  QSignalSpy finished(&import, &BulkImport::finished);
+
+  // when
+  QVERIFY(import.start());
+  for (int i = 0; i < 100 && finished.isEmpty(); ++i) wait(10);
+
+  // then
+  QCOMPARE(finished.size(), 1);
+  QCOMPARE(import.error(), QString());
+  QCOMPARE(import.progress().commands, 3ull);
+  QCOMPARE(import.progress().replies, 3ull);
+  QCOMPARE(import.progress().errors, 0ull);
+  QCOMPARE(import.progress().bytesRead, import.progress().totalBytes);
+  QCOMPARE(transporter->executedCommands.size(), 6);
+  QCOMPARE(transporter->executedCommands.at(4).getPartAsString(2),
+           QString("\r\n2"));
+  QCOMPARE(transporter->executedCommands.at(5).getRawString(),
+           QByteArray("INCR a"));
+}
+
+void TestBulk::importInlineFileWithErrors() {
+  // given
+  QSharedPointer<RedisClient::Connection> connection =
+      getRealConnectionWithDummyTransporter(
+          QStringList() << "+OK\r\n" << "-ERR wrong type\r\n");
+  QTemporaryFile file;
+  QString path =
+      writeTemporaryFile(file, "SET a \"hello world\"\r\n\nLPUSH a b\n\n");
+  BulkImport import(connection.data(), path);
+  QSignalSpy finished(&import, &BulkImport::finished);
+
+  // when
+  QVERIFY(import.start());
+  for (int i = 0; i < 100 && finished.isEmpty(); ++i) wait(10);
+
+  // then
+  QCOMPARE(finished.size(), 1);
+  QCOMPARE(import.error(), QString());
+  QCOMPARE(import.progress().replies, 2ull);
+  QCOMPARE(import.progress().errors, 1ull);
+  QCOMPARE(import.progress().lastError, QString("ERR wrong type"));
+}
+
+void TestBulk::exportAndRestoreDump() {
+  // given
+  QSharedPointer<RedisClient::Connection> connection =
+      getRealConnectionWithDummyTransporter(
+          QStringList() << "*2\r\n$1\r\n0\r\n*2\r\n$1\r\na\r\n$1\r\nb\r\n"
+                        << "$3\r\nxyz\r\n" << ":-1\r\n"
+                        << "$-1\r\n" << ":-2\r\n"
+                        << "+OK\r\n");
+  auto transporter =
+      connection->getTransporter().dynamicCast<DummyTransporter>();
+  QTemporaryFile file;
+  file.open();
+  BulkExport dump(connection.data(), file.fileName());
+  QSignalSpy exported(&dump, &BulkExport::finished);
+
+  // when
+  QVERIFY(dump.start());
+  for (int i = 0; i < 100 && exported.isEmpty(); ++i) wait(10);
+
+  // then
+  QCOMPARE(exported.size(), 1);
+  QCOMPARE(dump.error(), QString());
+  QCOMPARE(dump.progress().scannedKeys, 2ull);
+  QCOMPARE(dump.progress().exportedKeys, 1ull);
+  QCOMPARE(dump.progress().skippedKeys, 1ull);
+
+  QByteArray expected(RedisClient::DumpFile::MAGIC,
+                      RedisClient::DumpFile::MAGIC_SIZE);
+  RedisClient::DumpFile::appendRecord(expected, "a", 0, "xyz");
+  QCOMPARE(file.readAll(), expected);
+  QCOMPARE(dump.progress().bytesWritten, qint64(expected.size()));
+
+  // when
+  BulkImport restore(connection.data(), file.fileName());
+  QSignalSpy restored(&restore, &BulkImport::finished);
+  QVERIFY(restore.start());
+  for (int i = 0; i < 100 && restored.isEmpty(); ++i) wait(10);
+
+  // then
+  QCOMPARE(restored.size(), 1);
+  QCOMPARE(restore.progress().errors, 0ull);
+  QCOMPARE(transporter->executedCommands.last().getSplitedRepresentattion(),
+           QList<QByteArray>({"RESTORE", "a", "0", "xyz"}));
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+#include "basetestcase.h"
+
+class TestBulk : public BaseTestCase {
+  Q_OBJECT
+
+ private slots:
+  void importRespFile();
+  void importInlineFileWithErrors();
+  void exportAndRestoreDump();
+};
@@ -0,0 +1,80 @@
+#include "test_clientsidecache.h"
+#include <QTest>
+#include "qredisclient/clientsidecache.h"
+
+using RedisClient::ClientSideCache;
+using RedisClient::Command;
+using RedisClient::Response;
+
+void TestClientSideCache::lookupStoredReply() {
+  // given
+  ClientSideCache cache(1024 * 1024);
+  Command get({"GET", "foo"});
+  cache.store(get, 0, Response(Response::String, QByteArray("bar")));
+
+  // when
+  Response hit;
+  Response miss;
+  bool isHit = cache.lookup(Command({"get", "foo"}), 0, hit);
+  bool isMiss = !cache.lookup(get, 1, miss);
+
+  // then
+  QVERIFY(isHit);
+  QVERIFY(isMiss);
+  QCOMPARE(hit.value().toByteArray(), QByteArray("bar"));
+  QCOMPARE(cache.stats().hits, quint64(1));
+  QCOMPARE(cache.stats().misses, quint64(1));
+}
+
+void TestClientSideCache::invalidateKeys() {
+  // given
+  ClientSideCache cache(1024 * 1024);
+  Command mget({"MGET", "a", "b"});
+  Command get({"GET", "c"});
+  cache.store(mget, 0, Response(Response::Array, QVariantList{"1", "2"}));
+  cache.store(get, 0, Response(Response::String, QByteArray("3")));
+
+  // when
+  cache.invalidate({"b"});
+
+  // then
+  Response result;
+  QVERIFY(!cache.lookup(mget, 0, result));
+  QVERIFY(cache.lookup(get, 0, result));
+  QCOMPARE(cache.stats().entries, 1);
+  QCOMPARE(cache.stats().invalidations, quint64(1));
+}
+
+void TestClientSideCache::evictLeastRecentlyUsed() {
+  // given
+  QByteArray value(256, 'x');
+  Response reply(Response::String, value);
+  Command first({"GET", "first"});
+  Command second({"GET", "second"});
+  Command third({"GET", "third"});
+
+  ClientSideCache cache(reply.approximateSize() * 2 + 512);
+  cache.store(first, 0, reply);
+  cache.store(second, 0, reply);
+
+  // when
+  Response result;
+  cache.lookup(first, 0, result);
+  cache.store(third, 0, reply);
+
+  // then
+  QVERIFY(cache.lookup(first, 0, result));
+  QVERIFY(!cache.lookup(second, 0, result));
+  QVERIFY(cache.lookup(third, 0, result));
+  QVERIFY(cache.stats().memoryUsage <= cache.maxMemory());
+  QCOMPARE(cache.stats().evictions, quint64(1));
+}
+
+void TestClientSideCache::skipNonCacheableCommands() {
+  QVERIFY(ClientSideCache::isCacheable(Command({"HGETALL", "hash"})));
+  QVERIFY(!ClientSideCache::isCacheable(Command({"SET", "foo", "bar"})));
+  QVERIFY(!ClientSideCache::isCacheable(Command({"TTL", "foo"})));
+  QVERIFY(!ClientSideCache::isCacheable(
+      Command({"GET", "foo"}, nullptr,
+              [](RedisClient::Response, QString) {})));
+}
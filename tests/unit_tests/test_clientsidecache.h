@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+
+class TestClientSideCache : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void lookupStoredReply();
+  void invalidateKeys();
+  void evictLeastRecentlyUsed();
+  void skipNonCacheableCommands();
+};
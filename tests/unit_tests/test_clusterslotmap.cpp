@@ -0,0 +1,96 @@
+#include "test_clusterslotmap.h"
+#include <QTest>
+#include "qredisclient/clusterslotmap.h"
+
+using RedisClient::ClusterSlotMap;
+using RedisClient::Command;
+using RedisClient::Response;
+
+void TestClusterSlotMap::keySlot() {
+  // given
+  QFETCH(QByteArray, key);
+  QFETCH(int, slot);
+
+  // when
+  int actualResult = ClusterSlotMap::keySlot(key);
+
+  // then
+  QCOMPARE(actualResult, slot);
+}
+
+void TestClusterSlotMap::keySlot_data() {
+  QTest::addColumn<QByteArray>("key");
+  QTest::addColumn<int>("slot");
+
+  QTest::newRow("foo") << QByteArray("foo") << 12182;
+  QTest::newRow("bar") << QByteArray("bar") << 5061;
+  QTest::newRow("crc16 check value") << QByteArray("123456789") << 12739;
+}
+
+void TestClusterSlotMap::hashTags() {
+  // when
+  int following = ClusterSlotMap::keySlot("{user1000}.following");
+  int followers = ClusterSlotMap::keySlot("{user1000}.followers");
+  int emptyTag = ClusterSlotMap::keySlot("foo{}{bar}");
+
+  // then
+  QCOMPARE(following, followers);
+  QCOMPARE(following, ClusterSlotMap::keySlot("user1000"));
+  QCOMPARE(emptyTag, 8363);  // whole key is hashed
+}
+
+void TestClusterSlotMap::commandSlot() {
+  // then
+  QCOMPARE(ClusterSlotMap::commandSlot(Command({"GET", "foo"})), 12182);
+  QCOMPARE(ClusterSlotMap::commandSlot(Command({"PING"})), -1);
+  QCOMPARE(ClusterSlotMap::commandSlot(Command({"INFO", "memory"})), -1);
+  QCOMPARE(ClusterSlotMap::commandSlot(Command({"EVAL", "return 1", "0"})),
+           -1);
+  QCOMPARE(ClusterSlotMap::commandSlot(
+               Command({"EVALSHA", "abcd", "1", "bar", "arg"})),
+           5061);
+  QCOMPARE(ClusterSlotMap::commandSlot(Command({"WATCH", "foo", "bar"})),
+           12182);
+  QCOMPARE(ClusterSlotMap::commandSlot(
+               Command({"XREAD", "COUNT", "2", "STREAMS", "foo", "0"})),
+           12182);
+  QCOMPARE(ClusterSlotMap::commandSlot(Command(
+               {"XREADGROUP", "GROUP", "streams", "c", "STREAMS", "foo", ">"})),
+           12182);
+  QCOMPARE(ClusterSlotMap::commandSlot(Command({"XREAD", "STREAMS"})), -1);
+  QCOMPARE(ClusterSlotMap::commandSlot(Command({"OBJECT", "ENCODING", "foo"})),
+           12182);
+  QCOMPARE(ClusterSlotMap::commandSlot(Command({"MEMORY", "STATS"})), -1);
+  QCOMPARE(ClusterSlotMap::commandSlot(Command(
+               {"MIGRATE", "host", "6379", "", "0", "5000", "KEYS", "foo"})),
+           12182);
+}
+
+void TestClusterSlotMap::loadClusterSlots() {
+  // given
+  ClusterSlotMap map;
+  Response clusterSlots(
+      Response::Array,
+      QVariantList{
+          QVariantList{0, 5460, QVariantList{"127.0.0.1", 7000}},
+          QVariantList{5461, 10922, QVariantList{"127.0.0.1", 7001}},
+          QVariantList{10923, 16383, QVariantList{"127.0.0.1", 7002},
+                       QVariantList{"127.0.0.1", 7005}}});
+
+  // when
+  bool loaded = map.load(clusterSlots);
+  map.setNodeForSlot(12182, ClusterSlotMap::Host("127.0.0.1", 7001));
+
+  // then
+  QVERIFY(loaded);
+  QCOMPARE(map.masters().size(), 3);
+  QCOMPARE(map.nodeForSlot(0), ClusterSlotMap::Host("127.0.0.1", 7000));
+  QCOMPARE(map.nodeForSlot(5061), ClusterSlotMap::Host("127.0.0.1", 7000));
+  QCOMPARE(map.nodeForSlot(10922), ClusterSlotMap::Host("127.0.0.1", 7001));
+  QCOMPARE(map.nodeForSlot(16383), ClusterSlotMap::Host("127.0.0.1", 7002));
+  QCOMPARE(map.nodeForSlot(12182), ClusterSlotMap::Host("127.0.0.1", 7001));
+  QVERIFY(map.nodeForSlot(-1).first.isEmpty());
+  QCOMPARE(map.replicasForSlot(16383),
+           QList<ClusterSlotMap::Host>{ClusterSlotMap::Host("127.0.0.1", 7005)});
+  QVERIFY(map.replicasForSlot(0).isEmpty());
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+
+class TestClusterSlotMap : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void keySlot();
+  void keySlot_data();
+  void hashTags();
+  void commandSlot();
+  void loadClusterSlots();
+};
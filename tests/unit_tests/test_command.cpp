@@ -17,6 +17,23 @@ void TestCommand::prepareCommand()
     QCOMPARE(actualResult, QByteArray("*2\r\n$6\r\nEXISTS\r\n$12\r\ntestkey:test\r\n"));
 }
 
+void TestCommand::prepareCommandChunks()
+{
+    //given
+    QByteArray largeValue(RedisClient::Command::SCATTER_GATHER_THRESHOLD, 'x');
+    RedisClient::Command cmd({"SET", "testkey", largeValue});
+
+    //when
+    QList<QByteArray> actualResult = cmd.getByteRepresentationChunks();
+
+    //then
+    QCOMPARE(actualResult.size(), 3);
+    QVERIFY(actualResult.at(1).constData() == largeValue.constData());
+    QCOMPARE(actualResult.join(), cmd.getByteRepresentation());
+    QCOMPARE(actualResult.first(),
+             QByteArray("*3\r\n$3\r\nSET\r\n$7\r\ntestkey\r\n$65536\r\n"));
+}
+
 void TestCommand::parseCommandString()
 {
     //given
@@ -121,3 +138,137 @@ void TestCommand::pipelineCommand()
     QByteArray actualResult = cmd.getByteRepresentation();
     QCOMPARE(actualResult, QByteArray("*1\r\n$5\r\nMULTI\r\n*1\r\n$4\r\nPING\r\n*3\r\n$3\r\nSET\r\n$3\r\nfoo\r\n$3\r\nbar\r\n*1\r\n$4\r\nEXEC\r\n"));
 }
+
+void TestCommand::priorityClasses()
+{
+    //given
+    RedisClient::Command get({"GET", "foo"});
+    RedisClient::Command hgetall({"hgetall", "foo"});
+    RedisClient::Command handshake({"PING"});
+    RedisClient::Command tagged({"GET", "big_value"});
+
+    //when
+    handshake.markAsHiPriorityCommand();
+    tagged.setPriority(RedisClient::Command::Priority::Bulk);
+
+    //then
+    QCOMPARE(get.priority(), RedisClient::Command::Priority::Normal);
+    QCOMPARE(hgetall.priority(), RedisClient::Command::Priority::Bulk);
+    QCOMPARE(handshake.priority(), RedisClient::Command::Priority::High);
+    QVERIFY(handshake.isHiPriorityCommand());
+    QCOMPARE(tagged.priority(), RedisClient::Command::Priority::Bulk);
+    QVERIFY(!tagged.isHiPriorityCommand());
+}
+
+void TestCommand::readOnlyCommands()
+{
+    //given
+    RedisClient::Command get({"GET", "foo"});
+    RedisClient::Command zrange({"zrange", "foo", "0", "-1"});
+    RedisClient::Command set({"SET", "foo", "bar"});
+    RedisClient::Command memoryUsage({"MEMORY", "USAGE", "foo"});
+    RedisClient::Command memoryPurge({"MEMORY", "PURGE"});
+    RedisClient::Command pipeline({"GET", "foo"});
+
+    //when
+    pipeline.setPipelineCommand(true);
+
+    //then
+    QVERIFY(get.isReadOnlyCommand());
+    QVERIFY(zrange.isReadOnlyCommand());
+    QVERIFY(!set.isReadOnlyCommand());
+    QVERIFY(memoryUsage.isReadOnlyCommand());
+    QVERIFY(!memoryPurge.isReadOnlyCommand());
+    QVERIFY(!pipeline.isReadOnlyCommand());
+}
+
+void TestCommand::classifyCommandNames()
+{
+    //given
+    RedisClient::Command hgetall({"HgetAll", "foo"});
+    RedisClient::Command mset({"MSET", "k1", "v1", "k2", "v2"});
+    RedisClient::Command blpop({"blpop", "l1", "l2", "0"});
+    RedisClient::Command unknown({"MYMODULE.CMD", "foo", "bar"});
+    RedisClient::Command watch({"WATCH", "k1", "k2"});
+    RedisClient::Command xread({"XREAD", "BLOCK", "0", "STREAMS", "s1", "s2", "0", "$"});
+    RedisClient::Command blmpop({"BLMPOP", "0", "2", "l1", "l2", "LEFT"});
+    RedisClient::Command bzmpop({"BZMPOP", "1.5", "1", "z1", "MIN"});
+    RedisClient::Command sintercard({"SINTERCARD", "2", "s1", "s2", "LIMIT", "5"});
+    RedisClient::Command zdiff({"ZDIFF", "2", "z1", "z2"});
+    RedisClient::Command zinter({"ZINTER", "2", "z1", "z2", "WITHSCORES"});
+    RedisClient::Command zintercard({"ZINTERCARD", "1", "z1"});
+    RedisClient::Command zunion({"ZUNION", "2", "z1", "z2", "AGGREGATE", "MAX"});
+    RedisClient::Command eval({"EVAL", "return 1", "1", "k1", "arg"});
+    RedisClient::Command appended;
+
+    //when
+    appended.append("PSUBSCRIBE").append("news.*");
+
+    //then
+    QCOMPARE(QByteArray(hgetall.info().name), QByteArray("hgetall"));
+    QVERIFY(hgetall.info().is(RedisClient::CommandInfo::Cacheable));
+    QVERIFY(hgetall.info().is(RedisClient::CommandInfo::Bulk));
+    QCOMPARE(mset.keys(), QList<QByteArray>({"k1", "k2"}));
+    QCOMPARE(blpop.keys(), QList<QByteArray>({"l1", "l2"}));
+    QVERIFY(blpop.info().is(RedisClient::CommandInfo::Blocking));
+    QVERIFY(!unknown.info().isKnown());
+    QCOMPARE(unknown.keys(), QList<QByteArray>({"foo"}));
+    QCOMPARE(watch.keys(), QList<QByteArray>({"k1", "k2"}));
+    QCOMPARE(xread.keys(), QList<QByteArray>({"s1", "s2"}));
+    QCOMPARE(blmpop.keys(), QList<QByteArray>({"l1", "l2"}));
+    QCOMPARE(bzmpop.keys(), QList<QByteArray>({"z1"}));
+    QCOMPARE(sintercard.keys(), QList<QByteArray>({"s1", "s2"}));
+    QCOMPARE(zdiff.keys(), QList<QByteArray>({"z1", "z2"}));
+    QCOMPARE(zinter.keys(), QList<QByteArray>({"z1", "z2"}));
+    QCOMPARE(zintercard.keys(), QList<QByteArray>({"z1"}));
+    QCOMPARE(zunion.keys(), QList<QByteArray>({"z1", "z2"}));
+    QCOMPARE(eval.keys(), QList<QByteArray>({"k1"}));
+    QCOMPARE(blmpop.info().firstKeyIndex(blmpop.getSplitedRepresentattion()), 3);
+    QCOMPARE(zunion.info().firstKeyIndex(zunion.getSplitedRepresentattion()), 2);
+    QVERIFY(appended.isSubscriptionCommand());
+    QVERIFY(appended.info().is(RedisClient::CommandInfo::PatternChannel));
+    QVERIFY(RedisClient::CommandInfo::nameEquals("Streams", "streams"));
+    QVERIFY(!RedisClient::CommandInfo::nameEquals("stream", "streams"));
+}
+
+void TestCommand::copyIsImplicitlyShared()
+{
+    //given
+    int callbackCalls = 0;
+    RedisClient::Command cmd({"GET", "foo"}, nullptr,
+                             [&callbackCalls](RedisClient::Response, QString) {
+                                 callbackCalls++;
+                             });
+
+    //when
+    RedisClient::Command copy = cmd;
+    RedisClient::Command moved = std::move(copy);
+    RedisClient::Command detached = cmd;
+    detached.append("bar");
+
+    //then
+    QCOMPARE(&moved.getSplitedRepresentattion(), &cmd.getSplitedRepresentattion());
+    QCOMPARE(&moved.getCallBack(), &cmd.getCallBack());
+    QVERIFY(&detached.getSplitedRepresentattion() != &cmd.getSplitedRepresentattion());
+    QCOMPARE(cmd.length(), 2);
+    QCOMPARE(detached.length(), 3);
+
+    // copies share future
+    detached.getDeferred().complete(RedisClient::Response());
+    QVERIFY(cmd.getDeferred().future().isFinished());
+}
+
+void TestCommand::benchmarkCommandHandoff()
+{
+    RedisClient::Command cmd({"SET", "key", QByteArray(64, 'x')}, nullptr,
+                             [](RedisClient::Response, QString) {});
+
+    // Copies made on the way from Connection to RunningCommand
+    QBENCHMARK {
+        QList<RedisClient::Command> queue;
+        queue.append(cmd);
+        RedisClient::Command running = queue.takeFirst();
+        RedisClient::Command redirected = running;
+        Q_UNUSED(redirected);
+    }
+}
@@ -9,6 +9,7 @@ class TestCommand : public QObject
 
 private slots:
 	void prepareCommand();
+    void prepareCommandChunks();
     void parseCommandString();
     void parseCommandString_data();
     void isSelectCommand();
@@ -19,5 +20,12 @@ private slots:
     void scanCommandIsValid_data();
 
     void pipelineCommand();
+
+    void priorityClasses();
+    void readOnlyCommands();
+    void classifyCommandNames();
+
+    void copyIsImplicitlyShared();
+    void benchmarkCommandHandoff();
 };
 
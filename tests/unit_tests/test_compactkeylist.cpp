@@ -0,0 +1,153 @@
+#include "test_compactkeylist.h"
+#include <QTest>
+#include <algorithm>
+#include "qredisclient/compactkeylist.h"
+
+using namespace RedisClient;
+
+namespace {
+// Keys of several restart blocks, including keys with 0xff bytes
+QList<QByteArray> testKeys() {
+  QList<QByteArray> keys;
+
+  for (int i = 0; i < 40; ++i)
+    keys.append(QByteArray("user:") + QByteArray::number(i % 7) + ":" +
+                QByteArray::number(i));
+
+  keys << "" << "order:1"
+       << "user\xff"
+       << "user\xff\xff:1"
+       << "user\xfe\xff" << QByteArray("\x00zero", 5);
+  return keys;
+}
+
+QList<QByteArray> sorted(QList<QByteArray> keys) {
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+}  // namespace
+
+void TestCompactKeyList::appendAndIterate() {
+  // given
+  QFETCH(int, layout);
+  QList<QByteArray> keys = testKeys();
+  CompactKeyList list;
+
+  // when
+  list.append(keys);
+  list.arrange(static_cast<CompactKeyList::Layout>(layout));
+
+  // then
+  QList<QByteArray> expected =
+      layout == static_cast<int>(CompactKeyList::Layout::Unsorted)
+          ? keys
+          : sorted(keys);
+
+  QCOMPARE(list.size(), expected.size());
+  QCOMPARE(list.toList(), expected);
+
+  for (int i = 0; i < expected.size(); ++i)
+    QCOMPARE(list.at(i), expected.at(i));
+
+  int index = 0;
+  for (const QByteArray &key : list) QCOMPARE(key, expected.at(index++));
+
+  QCOMPARE(index, expected.size());
+}
+
+void TestCompactKeyList::appendAndIterate_data() {
+  QTest::addColumn<int>("layout");
+
+  QTest::newRow("Unsorted")
+      << static_cast<int>(CompactKeyList::Layout::Unsorted);
+  QTest::newRow("Sorted") << static_cast<int>(CompactKeyList::Layout::Sorted);
+  QTest::newRow("SortedCompressed")
+      << static_cast<int>(CompactKeyList::Layout::SortedCompressed);
+}
+
+void TestCompactKeyList::sortedPrefixSearch() {
+  // given
+  QFETCH(bool, compressed);
+  QFETCH(QByteArray, prefix);
+  CompactKeyList list;
+  list.append(testKeys());
+  list.arrange(compressed ? CompactKeyList::Layout::SortedCompressed
+                          : CompactKeyList::Layout::Sorted);
+
+  QList<QByteArray> expected;
+  for (const QByteArray &key : sorted(testKeys())) {
+    if (key.startsWith(prefix)) expected.append(key);
+  }
+
+  // when
+  QPair<int, int> range = list.prefixRange(prefix);
+  CompactKeyList result = list.keysWithPrefix(prefix);
+
+  // then
+  QCOMPARE(list.isCompressed(), compressed);
+  QCOMPARE(range.second - range.first, expected.size());
+  QCOMPARE(result.toList(), expected);
+  QCOMPARE(result.isSorted(), true);
+  QCOMPARE(result.isCompressed(), compressed);
+
+  for (const QByteArray &key : expected) QVERIFY(list.contains(key));
+
+  QVERIFY(!list.contains(prefix + "missing"));
+}
+
+void TestCompactKeyList::sortedPrefixSearch_data() {
+  QTest::addColumn<bool>("compressed");
+  QTest::addColumn<QByteArray>("prefix");
+
+  for (bool compressed : {false, true}) {
+    const char *mode = compressed ? "compressed" : "plain";
+
+    QTest::newRow(qPrintable(QString("%1: all").arg(mode)))
+        << compressed << QByteArray();
+    QTest::newRow(qPrintable(QString("%1: namespace").arg(mode)))
+        << compressed << QByteArray("user:3:");
+    QTest::newRow(qPrintable(QString("%1: 0xff").arg(mode)))
+        << compressed << QByteArray("user\xff");
+    QTest::newRow(qPrintable(QString("%1: 0xfe 0xff").arg(mode)))
+        << compressed << QByteArray("user\xfe\xff");
+    QTest::newRow(qPrintable(QString("%1: missing").arg(mode)))
+        << compressed << QByteArray("session:");
+  }
+}
+
+void TestCompactKeyList::unsortedPrefixSearch() {
+  // given
+  CompactKeyList list;
+  list.append(QByteArray("b:2"));
+  list.append(QByteArray("a:1"));
+  list.append(QByteArray("b:1"));
+
+  // when
+  CompactKeyList result = list.keysWithPrefix("b:");
+
+  // then
+  QCOMPARE(list.isSorted(), false);
+  QCOMPARE(result.toList(), QList<QByteArray>({"b:2", "b:1"}));
+  QVERIFY(list.contains("a:1"));
+  QVERIFY_EXCEPTION_THROWN(list.prefixRange("b:"), CompactKeyList::Exception);
+}
+
+void TestCompactKeyList::outOfOrderAppendToCompressedList() {
+  // given
+  CompactKeyList list;
+  list.append(sorted(testKeys()));
+  list.compress();
+
+  // when
+  list.append(QByteArray("zzz"));
+  bool compressedAfterOrderedAppend = list.isCompressed();
+  list.append(QByteArray("aaa"));
+
+  // then
+  QCOMPARE(compressedAfterOrderedAppend, true);
+  QCOMPARE(list.isCompressed(), false);
+  QCOMPARE(list.isSorted(), false);
+  QCOMPARE(list.size(), testKeys().size() + 2);
+  QCOMPARE(list.at(list.size() - 2), QByteArray("zzz"));
+  QCOMPARE(list.at(list.size() - 1), QByteArray("aaa"));
+}
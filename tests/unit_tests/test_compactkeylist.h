@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+
+class TestCompactKeyList : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void appendAndIterate();
+  void appendAndIterate_data();
+  void sortedPrefixSearch();
+  void sortedPrefixSearch_data();
+  void unsortedPrefixSearch();
+  void outOfOrderAppendToCompressedList();
+};
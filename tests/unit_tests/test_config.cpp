@@ -69,3 +69,94 @@ void TestConfig::testSerialization()
     QCOMPARE(actualResult.contains("namespaceSeparator"), false);
     QCOMPARE(actualResult.size(), test.size());
 }
+
+void TestConfig::testUnixSocket()
+{
+    //given
+    ConnectionConfig config;
+
+    //when
+    config.setUnixSocketPath("/var/run/redis/redis.sock");
+
+    //then
+    QCOMPARE(config.useUnixSocket(), true);
+    QCOMPARE(config.unixSocketPath(), QString("/var/run/redis/redis.sock"));
+    QCOMPARE(config.isNull(), false);
+    QCOMPARE(config.isValid(), true);
+}
+
+void TestConfig::testSocketBufferSizes()
+{
+    //given
+    ConnectionConfig config("127.0.0.1");
+
+    //when
+    uint defaultReceiveBuffer = config.socketReceiveBufferSize();
+    config.setSocketBufferSizes(4 * 1024 * 1024, 1024 * 1024);
+
+    //then
+    QCOMPARE(defaultReceiveBuffer, 0u);
+    QCOMPARE(config.socketReceiveBufferSize(), 4u * 1024 * 1024);
+    QCOMPARE(config.socketSendBufferSize(), 1024u * 1024);
+}
+
+void TestConfig::testSentinelSettings()
+{
+    //given
+    ConnectionConfig config("127.0.0.1", "", 26379);
+
+    //when
+    config.setSentinelMasterName("mymaster");
+    config.setSentinels(QStringList{"10.0.0.2:26379", "10.0.0.3:26379"});
+    ConnectionConfig restored = ConnectionConfig::fromJsonObject(config.toJsonObject());
+
+    //then
+    QCOMPARE(restored.sentinelMasterName(), QString("mymaster"));
+    QCOMPARE(restored.sentinels(),
+             QStringList({"10.0.0.2:26379", "10.0.0.3:26379"}));
+}
+
+void TestConfig::testReconnectSettings()
+{
+    //given
+    ConnectionConfig config("127.0.0.1");
+
+    //when
+    ConnectionConfig::ReplayPolicy defaultPolicy = config.replayPolicy();
+    config.setReconnectBackoff(500, 200, 0);
+    config.setReplayPolicy(ConnectionConfig::ReplayPolicy::ReadOnly);
+    config.setStandbyConnection(true);
+
+    //then
+    QCOMPARE(defaultPolicy, ConnectionConfig::ReplayPolicy::All);
+    QCOMPARE(config.reconnectMinDelay(), 500u);
+    QCOMPARE(config.reconnectMaxDelay(), 500u);
+    QCOMPARE(config.reconnectMaxAttempts(), 0u);
+    QCOMPARE(config.replayPolicy(), ConnectionConfig::ReplayPolicy::ReadOnly);
+    QCOMPARE(config.useStandbyConnection(), true);
+}
+
+void TestConfig::testSharedSettings()
+{
+    //given
+    ConnectionConfig config("fake_host", "fake_auth", 1111, "fake_name");
+    config.setReadFrom(ConnectionConfig::ReadFrom::Replica);
+    config.setCommandQueueLimits(100, 1024);
+    Connection connection(config, false);
+
+    //when
+    QSharedPointer<Connection> clone = connection.clone();
+    QSharedPointer<const ConnectionSettings> shared = connection.sharedSettings();
+    connection.setConnectionConfig(ConnectionConfig("other_host"));
+
+    //then
+    QCOMPARE(clone->sharedSettings()->name, QString("fake_name"));
+    QCOMPARE(clone->sharedSettings()->port, 1111u);
+    QCOMPARE(clone->sharedSettings()->useAuth, true);
+    QCOMPARE(clone->sharedSettings()->readFrom, ConnectionConfig::ReadFrom::Replica);
+    QCOMPARE(clone->sharedSettings()->commandQueueMaxCommands, 100u);
+    QCOMPARE(clone->getConfig().host(), QString("fake_host"));
+    QCOMPARE(connection.sharedSettings()->host, QString("other_host"));
+    QCOMPARE(clone->sharedSettings(), shared);
+    QVERIFY(connection.sharedSettings() != shared);
+}
@@ -11,6 +11,11 @@ private slots:
     void testGetParam();
     void testOwner();
     void testSerialization();
+    void testUnixSocket();
+    void testSocketBufferSizes();
+    void testSentinelSettings();
+    void testReconnectSettings();
+    void testSharedSettings();
 };
 
 
@@ -1,12 +1,80 @@
 #include "test_connection.h"
+#include <QSignalSpy>
 #include <QTest>
 #include <chrono>
 #include <thread>
 #include "qredisclient/command.h"
 #include "qredisclient/connection.h"
+#include "qredisclient/coroutines.h"
+#include "mockserver.h"
+#include "resp.h"
+
+#if defined(QREDISCLIENT_REQUIRE_COROUTINES) && \
+    !defined(QREDISCLIENT_HAS_COROUTINES)
+#error "Coroutine tests are requested but compiler doesn't support them"
+#endif
 
 using namespace RedisClient;
 
+namespace {
+typedef Connection::Host Host;
+typedef Connection::HostList HostList;
+
+class SentinelConnection : public Connection {
+ public:
+  SentinelConnection(const ConnectionConfig &c) : Connection(c) {}
+
+  using Connection::processSwitchMaster;
+
+  void setMaster(const QString &name, const Host &master,
+                 const HostList &replicas) {
+    m_sentinelMasterName = name;
+    m_sentinelMaster = master;
+    m_sentinelReplicas = replicas;
+  }
+
+  Host master() const { return m_sentinelMaster; }
+  HostList replicas() const { return m_sentinelReplicas; }
+};
+
+#ifdef QREDISCLIENT_HAS_COROUTINES
+// Eager fire-and-forget coroutine
+struct Task {
+  struct promise_type {
+    Task get_return_object() { return Task(); }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() {}
+  };
+};
+
+struct AwaitResult {
+  AwaitResult() : done(false), thread(nullptr) {}
+
+  bool done;
+  QThread *thread;
+  QByteArray value;
+  QVector<Response> pipeline;
+  QVariantList page;
+};
+
+Task awaitCommands(Connection &connection, AwaitResult &result) {
+  Response r = co_await coro::exec(connection, {"GET", "key"});
+  result.thread = QThread::currentThread();
+  result.value = r.value().toByteArray();
+
+  result.pipeline =
+      co_await coro::pipeline(connection, {{"GET", "key"}, {"GET", "key"}});
+
+  coro::ScanCursor cursor(connection, {"SCAN", "0"});
+  while (!cursor.atEnd()) result.page += co_await cursor.next();
+
+  result.done = true;
+}
+#endif
+}  // namespace
+
 void TestConnection::init() {
   qRegisterMetaType<RedisClient::Command>("Command");
   qRegisterMetaType<RedisClient::Response>("RedisClient::Response");
@@ -412,6 +480,216 @@ void TestConnection::testWithDummyTransporter() {
   QCOMPARE(actualResult.value().toString(), QString("PONG"));
 }
 
+void TestConnection::testPipelineWithDummyTransporter() {
+  // given
+  QSharedPointer<Connection> connection = getRealConnectionWithDummyTransporter(
+      QStringList() << QString("+OK\r\n") << QString(":1\r\n")
+                    << QString("$3\r\nbar\r\n"));
+
+  // when
+  QVERIFY(connection->connect());
+  QFuture<QVector<Response>> future = connection->pipeline()
+                                          .add({"SET", "foo", "bar"})
+                                          .add({"INCR", "counter"})
+                                          .add({"GET", "foo"})
+                                          .exec();
+
+  for (int i = 0; i < 100 && !future.isFinished(); ++i) wait(10);
+
+  // then
+  QVERIFY(future.isFinished());
+  QVector<Response> actualResult = future.result();
+  QCOMPARE(actualResult.size(), 3);
+  QVERIFY(actualResult.at(0).isOkMessage());
+  QCOMPARE(actualResult.at(1).value().toInt(), 1);
+  QCOMPARE(actualResult.at(2).value().toByteArray(), QByteArray("bar"));
+}
+
+void TestConnection::testHandshakeIsPipelined() {
+  // given
+  QSharedPointer<Connection> connection =
+      getRealConnectionWithDummyTransporter(QStringList());
+  auto transporter =
+      connection->getTransporter().dynamicCast<DummyTransporter>();
+
+  // when
+  QVERIFY(connection->connect());
+
+  // then
+  QCOMPARE(transporter->executedCommands.size(), 3);
+  QCOMPARE(transporter->executedCommands.at(0).getRawString(),
+           QByteArray("PING"));
+  QCOMPARE(transporter->executedCommands.at(1).getRawString(),
+           QByteArray("INFO server"));
+  QCOMPARE(transporter->executedCommands.at(2).getRawString(),
+           QByteArray("INFO keyspace"));
+  QCOMPARE(connection->getServerVersion(), 999.999);
+}
+
+void TestConnection::commandSyncOnBulkLane() {
+  // given
+  ReplyBook replies;
+  replies.add({"GET", "key"}, Resp::bulkString("value"));
+  MockServer server(MockServer::Options(), replies);
+  quint16 port = server.start();
+  QVERIFY(port > 0);
+
+  ConnectionConfig laneConfig("127.0.0.1", "", port, "bulk lane");
+  laneConfig.setTimeouts(2000, 2000);
+  laneConfig.setBulkLane(true);
+  Connection connection(laneConfig);
+  QVERIFY(connection.connect(true));
+
+  Command cmd({"GET", "key"});
+  cmd.setPriority(Command::Priority::Bulk);
+
+  // when
+  // reply of lane connection is forwarded without event loop
+  Response result = connection.commandSync(cmd);
+
+  // then
+  QCOMPARE(result.value().toByteArray(), QByteArray("value"));
+
+  connection.disconnect();
+  server.stop();
+}
+
+void TestConnection::bulkLaneFromThreadWithoutEventLoop() {
+  // given
+  ReplyBook replies;
+  replies.add({"GET", "key"}, Resp::bulkString("value"));
+  MockServer server(MockServer::Options(), replies);
+  quint16 port = server.start();
+  QVERIFY(port > 0);
+
+  ConnectionConfig laneConfig("127.0.0.1", "", port, "bulk lane");
+  laneConfig.setTimeouts(2000, 2000);
+  laneConfig.setBulkLane(true);
+  Connection connection(laneConfig);
+  QVERIFY(connection.connect(true));
+
+  Command cmd({"GET", "key"});
+  cmd.setPriority(Command::Priority::Bulk);
+  QFuture<Response> result;
+
+  // when
+  // lane connection is created by thread which never runs event loop
+  std::thread worker([&]() { result = connection.runCommand(cmd); });
+  worker.join();
+
+  // then
+  QTRY_VERIFY_WITH_TIMEOUT(result.isFinished(), 5000);
+  QCOMPARE(result.result().value().toByteArray(), QByteArray("value"));
+
+  connection.disconnect();
+  server.stop();
+}
+
+void TestConnection::runCommandsFailOnConnectError() {
+  // given
+  MockServer server(MockServer::Options(), ReplyBook());
+  quint16 port = server.start();
+  QVERIFY(port > 0);
+  server.stop();
+
+  ConnectionConfig closedConfig("127.0.0.1", "", port, "closed");
+  closedConfig.setTimeouts(1000, 1000);
+  Connection connection(closedConfig);
+
+  Command first({"GET", "key"});
+  Command second({"GET", "other"});
+  QString error;
+  first.setCallBack(this, [&error](Response, QString err) { error = err; });
+
+  // when
+  connection.runCommands({first, second});
+
+  // then
+  QTRY_VERIFY_WITH_TIMEOUT(first.getDeferred().future().isCanceled(), 5000);
+  QVERIFY(second.getDeferred().future().isCanceled());
+  QTRY_VERIFY(!error.isEmpty());
+}
+
+void TestConnection::awaitCommandInCallerThread() {
+#ifndef QREDISCLIENT_HAS_COROUTINES
+  QSKIP("Compiler doesn't support coroutines");
+#else
+  // given
+  ReplyBook replies;
+  replies.add({"GET", "key"}, Resp::bulkString("value"));
+  replies.add({"SCAN", "0"}, "*2\r\n$1\r\n0\r\n*1\r\n$3\r\nkey\r\n");
+  MockServer server(MockServer::Options(), replies);
+  quint16 port = server.start();
+  QVERIFY(port > 0);
+
+  ConnectionConfig mockConfig("127.0.0.1", "", port, "coroutines");
+  mockConfig.setTimeouts(2000, 2000);
+  Connection connection(mockConfig);
+  QVERIFY(connection.connect(true));
+  AwaitResult result;
+
+  // when
+  awaitCommands(connection, result);
+
+  // then
+  // awaiters are resumed in awaiting thread, not in transporter thread
+  QTRY_VERIFY(result.done);
+  QCOMPARE(result.thread, QThread::currentThread());
+  QCOMPARE(result.value, QByteArray("value"));
+  QCOMPARE(result.pipeline.size(), 2);
+  QCOMPARE(result.pipeline.at(1).value().toByteArray(), QByteArray("value"));
+  QCOMPARE(result.page, QVariantList() << QByteArray("key"));
+
+  connection.disconnect();
+  server.stop();
+#endif
+}
+
+void TestConnection::processSentinelSwitchMaster() {
+  // given
+  SentinelConnection connection(config);
+  ConnectionConfig sentinel("sentinel.local", "", 26379, "sentinel");
+  Host oldMaster{"10.0.0.1", 6379};
+  Host promoted{"10.0.0.2", 6379};
+  connection.setMaster("mymaster", oldMaster,
+                       HostList() << promoted << Host{"10.0.0.3", 6379});
+  QSignalSpy reconnects(&connection, &Connection::reconnectTo);
+
+  // when
+  // <master name> <old ip> <old port> <new ip> <new port>
+  connection.processSwitchMaster("othermaster 10.0.0.1 6379 10.0.0.9 6379",
+                                 sentinel);
+  connection.processSwitchMaster("mymaster 10.0.0.1 6379", sentinel);
+
+  // then
+  QCOMPARE(reconnects.size(), 0);
+  QCOMPARE(connection.master(), oldMaster);
+
+  // when
+  connection.processSwitchMaster("mymaster 10.0.0.1 6379 10.0.0.2 6379",
+                                 sentinel);
+  // every sentinel publishes the event
+  connection.processSwitchMaster("mymaster 10.0.0.1 6379 10.0.0.2 6379",
+                                 sentinel);
+
+  // then
+  QCOMPARE(reconnects.size(), 1);
+  QCOMPARE(reconnects.at(0).at(0).toString(), QString("10.0.0.2"));
+  QCOMPARE(reconnects.at(0).at(1).toInt(), 6379);
+  QCOMPARE(connection.master(), promoted);
+  QCOMPARE(connection.replicas(), HostList() << Host{"10.0.0.3", 6379});
+
+  // when
+  // local address of sentinel host is reached through sentinel host
+  connection.processSwitchMaster("mymaster 10.0.0.2 6379 127.0.0.1 6380",
+                                 sentinel);
+
+  // then
+  QCOMPARE(reconnects.size(), 2);
+  QCOMPARE(reconnects.at(1).at(0).toString(), QString("sentinel.local"));
+  QCOMPARE(reconnects.at(1).at(1).toInt(), 6380);
+}
+
 void TestConnection::testParseServerInfo() {
   // given
   QString testInfo(
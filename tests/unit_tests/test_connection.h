@@ -19,6 +19,18 @@ class TestConnection : public BaseTestCase {
    * Dummy transporter test
    */
   void testWithDummyTransporter();
+  void testPipelineWithDummyTransporter();
+  void testHandshakeIsPipelined();
+
+  /*
+   * Mock server tests
+   */
+  void commandSyncOnBulkLane();
+  void bulkLaneFromThreadWithoutEventLoop();
+  void runCommandsFailOnConnectError();
+  void awaitCommandInCallerThread();
+
+  void processSentinelSwitchMaster();
 
   void testParseServerInfo();
   void testConfig();
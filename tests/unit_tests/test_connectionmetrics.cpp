@@ -0,0 +1,107 @@
+#include "test_connectionmetrics.h"
+#include <QTest>
+#include "mocks/dummyTransporter.h"
+#include "qredisclient/connectionmetrics.h"
+
+using RedisClient::ConnectionMetrics;
+using RedisClient::LatencyHistogram;
+
+void TestConnectionMetrics::histogramBuckets() {
+  // then
+  for (quint64 v : {0ull, 1ull, 15ull, 16ull, 31ull, 32ull, 1000ull,
+                    123456789ull}) {
+    int index = LatencyHistogram::bucketIndex(v);
+    QVERIFY(LatencyHistogram::bucketUpperBound(index) >= v);
+    QVERIFY(index == 0 || LatencyHistogram::bucketUpperBound(index - 1) < v);
+  }
+
+  QCOMPARE(LatencyHistogram::bucketIndex(Q_UINT64_C(1) << 50),
+           LatencyHistogram::BUCKETS - 1);
+}
+
+void TestConnectionMetrics::histogramPercentiles() {
+  // given
+  LatencyHistogram h;
+
+  // when
+  for (quint64 v = 1; v <= 1000; ++v) h.record(v);
+
+  // then
+  QCOMPARE(h.count(), quint64(1000));
+  QCOMPARE(h.min(), quint64(1));
+  QCOMPARE(h.max(), quint64(1000));
+  QCOMPARE(h.percentile(100), quint64(1000));
+
+  // Relative error is bounded by bucket width
+  quint64 median = h.percentile(50);
+  QVERIFY(median >= 500 && median <= 500 + 500 / LatencyHistogram::SUB_BUCKETS);
+}
+
+void TestConnectionMetrics::recordCommandsByName() {
+  // given
+  ConnectionMetrics metrics;
+
+  // when
+  metrics.recordCommand("GET", 1, 2, 30);
+  metrics.recordCommand("get", 1, 2, 50);
+  metrics.recordCommand("SET", 1, 2, 10);
+
+  // then
+  auto snapshot = metrics.snapshot();
+  QCOMPARE(snapshot.commands.size(), 2);
+  QCOMPARE(snapshot.commands["get"].calls(), quint64(2));
+  QCOMPARE(snapshot.commands["get"].phases[ConnectionMetrics::Server].max(),
+           quint64(50));
+  QCOMPARE(snapshot.commands["set"].phases[ConnectionMetrics::QueueWait].sum(),
+           quint64(1));
+}
+
+void TestConnectionMetrics::prometheusExport() {
+  // given
+  ConnectionMetrics metrics;
+  metrics.recordCommand("GET", 0, 0, 1500);
+  metrics.addBytesIn(10);
+
+  // when
+  QByteArray text = metrics.snapshot().toPrometheus("local");
+
+  // then
+  QVERIFY(text.contains(
+      "qredisclient_bytes_received_total{connection=\"local\"} 10\n"));
+  QVERIFY(text.contains("qredisclient_command_duration_seconds_count{"
+                        "connection=\"local\",command=\"get\","
+                        "phase=\"server\"} 1\n"));
+  QVERIFY(text.contains("qredisclient_command_duration_seconds{"
+                        "connection=\"local\",command=\"get\","
+                        "phase=\"server\",quantile=\"0.5\"} 0.0015"));
+}
+
+void TestConnectionMetrics::transporterRecordsReplies() {
+  // given
+  RedisClient::ConnectionConfig config("127.0.0.1");
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(config));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+  transporter->setWriteBatchingEnabled(true);
+
+  // when
+  transporter->addCommands(QList<RedisClient::Command>()
+                           << RedisClient::Command({"GET", "a"})
+                           << RedisClient::Command({"PING"}));
+  QTRY_COMPARE(transporter->executedCommands.size(), 2);
+
+  transporter->setFakeReadBuffer("$1\r\nv\r\n+PONG\r\n", false);
+  transporter->readyRead();
+
+  // then
+  auto metrics = connection->metrics();
+  QCOMPARE(metrics.replies, quint64(2));
+  QCOMPARE(metrics.bytesIn, quint64(14));
+  QVERIFY(metrics.bytesOut > 0);
+  QVERIFY(metrics.replyAllocations >= 2);
+  QCOMPARE(metrics.inFlight, 0);
+  QCOMPARE(metrics.maxInFlight, 2);
+  QCOMPARE(metrics.commands["get"].calls(), quint64(1));
+  QCOMPARE(metrics.commands["ping"].calls(), quint64(1));
+}
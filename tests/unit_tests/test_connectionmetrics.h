@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+
+class TestConnectionMetrics : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void histogramBuckets();
+  void histogramPercentiles();
+  void recordCommandsByName();
+  void prometheusExport();
+  void transporterRecordsReplies();
+};
@@ -0,0 +1,157 @@
+#include "test_connectionpool.h"
+#include <QTest>
+#include "qredisclient/connectionpool.h"
+
+using RedisClient::Command;
+using RedisClient::ConnectionConfig;
+using RedisClient::ConnectionPool;
+
+namespace {
+// Exposes dispatching without running commands
+class DispatchingPool : public ConnectionPool {
+ public:
+  DispatchingPool(int size)
+      : ConnectionPool(ConnectionConfig("127.0.0.1", "", 6379, "test"), size,
+                       ConnectionPool::Dispatch::RoundRobin) {}
+
+  using ConnectionPool::commandFinished;
+  using ConnectionPool::connectionIndexFor;
+};
+
+Command owned(const QList<QByteArray> &args, QObject *owner) {
+  return Command(args, owner, [](RedisClient::Response, QString) {});
+}
+}  // namespace
+
+void TestConnectionPool::initialState() {
+  // given
+  ConnectionConfig config("127.0.0.1", "", 6379, "test");
+
+  // when
+  ConnectionPool pool(config, 4, ConnectionPool::Dispatch::RoundRobin);
+
+  // then
+  QCOMPARE(pool.size(), 4);
+  QVERIFY(!pool.isConnected());
+  QVERIFY(pool.connectionAt(0));
+  QVERIFY(pool.connectionAt(0) != pool.connectionAt(3));
+  QVERIFY(!pool.connectionAt(4));
+  QCOMPARE(pool.outstandingCommands(0), 0);
+  QCOMPARE(pool.connectionAt(3)->getConfig().name(), config.name());
+  QCOMPARE(pool.connectionAt(0)->sharedSettings(),
+           pool.connectionAt(3)->sharedSettings());
+}
+
+void TestConnectionPool::statefulCommands() {
+  // given
+  QFETCH(QList<QByteArray>, rawCmd);
+  QFETCH(bool, stateful);
+
+  // when
+  bool actualResult = ConnectionPool::isStatefulCommand(Command(rawCmd));
+
+  // then
+  QCOMPARE(actualResult, stateful);
+}
+
+void TestConnectionPool::statefulCommands_data() {
+  QTest::addColumn<QList<QByteArray>>("rawCmd");
+  QTest::addColumn<bool>("stateful");
+
+  QTest::newRow("get") << QList<QByteArray>{"GET", "foo"} << false;
+  QTest::newRow("select") << QList<QByteArray>{"SELECT", "1"} << true;
+  QTest::newRow("multi") << QList<QByteArray>{"multi"} << true;
+  QTest::newRow("blpop") << QList<QByteArray>{"BLPOP", "q", "0"} << true;
+  QTest::newRow("subscribe") << QList<QByteArray>{"SUBSCRIBE", "ch"} << true;
+  QTest::newRow("watch") << QList<QByteArray>{"WATCH", "foo"} << true;
+  QTest::newRow("discard") << QList<QByteArray>{"Discard"} << true;
+  QTest::newRow("monitor") << QList<QByteArray>{"MONITOR"} << true;
+  QTest::newRow("xread") << QList<QByteArray>{"XREAD", "STREAMS", "s", "0"}
+                         << false;
+  QTest::newRow("xread block")
+      << QList<QByteArray>{"XREAD", "BLOCK", "0", "STREAMS", "s", "0"} << true;
+}
+
+void TestConnectionPool::transactionExcludesConnection() {
+  // given
+  DispatchingPool pool(2);
+  QObject owner, otherOwner;
+  int pinned = pool.connectionIndexFor(owned({"MULTI"}, &owner));
+
+  // when
+  int other = pool.connectionIndexFor(Command({"GET", "foo"}));
+  int otherOwned = pool.connectionIndexFor(owned({"GET", "foo"}, &otherOwner));
+  int queued = pool.connectionIndexFor(owned({"SET", "foo", "1"}, &owner));
+  int exec = pool.connectionIndexFor(owned({"EXEC"}, &owner));
+
+  // then
+  QVERIFY(other != pinned);
+  QVERIFY(otherOwned != pinned);
+  QCOMPARE(queued, pinned);
+  QCOMPARE(exec, pinned);
+
+  // EXEC releases connection
+  QSet<int> used;
+  for (int i = 0; i < 4; ++i)
+    used.insert(pool.connectionIndexFor(Command({"GET", "foo"})));
+
+  QCOMPARE(used.size(), 2);
+}
+
+void TestConnectionPool::blockingPopExcludesConnection() {
+  // given
+  DispatchingPool pool(2);
+  QObject owner;
+  Command blpop = owned({"BLPOP", "queue", "0"}, &owner);
+  int pinned = pool.connectionIndexFor(blpop);
+
+  // when
+  QList<int> whileBlocked;
+  for (int i = 0; i < 4; ++i)
+    whileBlocked.append(pool.connectionIndexFor(Command({"GET", "foo"})));
+
+  pool.commandFinished(blpop);
+
+  QSet<int> afterReply;
+  for (int i = 0; i < 4; ++i)
+    afterReply.insert(pool.connectionIndexFor(Command({"GET", "foo"})));
+
+  // then
+  QVERIFY(!whileBlocked.contains(pinned));
+  QCOMPARE(afterReply.size(), 2);
+}
+
+void TestConnectionPool::subscriptionReleasedOnUnsubscribe() {
+  // given
+  DispatchingPool pool(1);
+  QObject owner;
+  pool.connectionIndexFor(owned({"SUBSCRIBE", "a", "b"}, &owner));
+  pool.connectionIndexFor(owned({"UNSUBSCRIBE", "a"}, &owner));
+
+  // when
+  bool leasedAfterPartialUnsubscribe = false;
+  try {
+    pool.connectionIndexFor(Command({"GET", "foo"}));
+  } catch (const RedisClient::Connection::Exception &) {
+    leasedAfterPartialUnsubscribe = true;
+  }
+
+  pool.connectionIndexFor(owned({"UNSUBSCRIBE", "b"}, &owner));
+  int index = pool.connectionIndexFor(Command({"GET", "foo"}));
+
+  // then
+  QVERIFY(leasedAfterPartialUnsubscribe);
+  QCOMPARE(index, 0);
+}
+
+void TestConnectionPool::statefulCommandWithoutOwner() {
+  // given
+  DispatchingPool pool(2);
+
+  // when - then
+  QVERIFY_EXCEPTION_THROWN(pool.connectionIndexFor(Command({"MULTI"})),
+                           RedisClient::Connection::Exception);
+  QVERIFY_EXCEPTION_THROWN(
+      pool.connectionIndexFor(Command({"BLPOP", "queue", "0"})),
+      RedisClient::Connection::Exception);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+
+class TestConnectionPool : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void initialState();
+  void statefulCommands();
+  void statefulCommands_data();
+  void transactionExcludesConnection();
+  void blockingPopExcludesConnection();
+  void subscriptionReleasedOnUnsubscribe();
+  void statefulCommandWithoutOwner();
+};
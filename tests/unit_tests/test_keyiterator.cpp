@@ -0,0 +1,179 @@
+#include "test_keyiterator.h"
+#include <QTest>
+#include "mocks/dummyconnection.h"
+#include "qredisclient/keyiterator.h"
+#include "qredisclient/scaniterator.h"
+
+using RedisClient::KeyIterator;
+using RedisClient::ScanIterator;
+
+namespace {
+struct PageResult {
+  PageResult() : final(false), calls(0) {}
+
+  KeyIterator::Page keys;
+  QString err;
+  bool final;
+  int calls;
+};
+
+KeyIterator::PageCallback collectPage(PageResult &result) {
+  return [&result](const KeyIterator::Page &keys, const QString &err,
+                   bool final) {
+    result.keys = keys;
+    result.err = err;
+    result.final = final;
+    result.calls++;
+  };
+}
+}  // namespace
+
+void TestKeyIterator::requestPagesOnDemand() {
+  // given
+  DummyConnection connection;
+  connection.setFakeResponses(
+      QStringList()
+      << "*2\r\n$2\r\n17\r\n*2\r\n$1\r\na\r\n$1\r\nb\r\n"
+      << "*2\r\n$1\r\n0\r\n*1\r\n$1\r\nc\r\n");
+  KeyIterator::Options options;
+  options.prefetch = 0;
+  KeyIterator iterator(&connection, options);
+  PageResult first, second;
+
+  // when
+  iterator.next(collectPage(first));
+
+  // then - next page is requested only by consumer
+  QCOMPARE(connection.runCommandCalled, 1u);
+  QCOMPARE(first.keys, KeyIterator::Page() << "a" << "b");
+  QCOMPARE(first.final, false);
+  QVERIFY(iterator.hasNext());
+
+  // when
+  iterator.next(collectPage(second));
+
+  // then
+  QCOMPARE(connection.runCommandCalled, 2u);
+  QCOMPARE(connection.executedCommands.at(1).getPartAsString(1),
+           QString("17"));
+  QCOMPARE(second.keys, KeyIterator::Page() << "c");
+  QCOMPARE(second.final, true);
+  QVERIFY(!iterator.hasNext());
+}
+
+void TestKeyIterator::filterByType() {
+  // given
+  DummyConnection connection(6.0);
+  connection.setFakeResponses(QStringList()
+                              << "*2\r\n$1\r\n0\r\n*1\r\n$1\r\nh\r\n");
+  KeyIterator::Options options;
+  options.type = "hash";
+  KeyIterator iterator(&connection, options);
+  PageResult result;
+
+  // when
+  iterator.next(collectPage(result));
+
+  // then
+  QCOMPARE(connection.executedCommands.size(), 1);
+  QVERIFY(connection.executedCommands.first().getRawString().endsWith(
+      "TYPE hash"));
+  QCOMPARE(result.keys, KeyIterator::Page() << "h");
+  QVERIFY(result.err.isEmpty());
+}
+
+void TestKeyIterator::filterByTypeOnOldServer() {
+  // given
+  DummyConnection connection(5.0);
+  KeyIterator::Options options;
+  options.type = "hash";
+  KeyIterator iterator(&connection, options);
+  PageResult result;
+
+  // when
+  iterator.next(collectPage(result));
+
+  // then
+  QCOMPARE(connection.runCommandCalled, 0u);
+  QVERIFY(!result.err.isEmpty());
+  QCOMPARE(result.final, true);
+}
+
+void TestKeyIterator::prefetchNextPage() {
+  // given
+  DummyConnection connection;
+  connection.setFakeResponses(
+      QStringList()
+      << "*2\r\n$1\r\n5\r\n*1\r\n$1\r\na\r\n"
+      << "*2\r\n$1\r\n9\r\n*1\r\n$1\r\nb\r\n"
+      << "*2\r\n$1\r\n0\r\n*1\r\n$1\r\nc\r\n");
+  KeyIterator iterator(&connection);
+  PageResult first, second, third;
+
+  // when
+  iterator.next(collectPage(first));
+
+  // then - next cursor is requested before page is passed to consumer
+  QCOMPARE(connection.runCommandCalled, 2u);
+  QCOMPARE(first.keys, KeyIterator::Page() << "a");
+
+  // when
+  iterator.next(collectPage(second));
+  iterator.next(collectPage(third));
+
+  // then
+  QCOMPARE(connection.runCommandCalled, 3u);
+  QCOMPARE(second.keys, KeyIterator::Page() << "b");
+  QCOMPARE(second.final, false);
+  QCOMPARE(third.keys, KeyIterator::Page() << "c");
+  QCOMPARE(third.final, true);
+}
+
+void TestKeyIterator::scanValues() {
+  // given
+  DummyConnection connection;
+  connection.setFakeResponses(
+      QStringList()
+      << "*2\r\n$1\r\n3\r\n*2\r\n$1\r\nf\r\n$1\r\nv\r\n"
+      << "*2\r\n$1\r\n0\r\n*0\r\n");
+  RedisClient::ScanCommand cmd({"HSCAN", "hash", "0", "COUNT", "50"});
+  ScanIterator::Options options;
+  options.prefetch = 0;
+  options.targetPageLatency = 0;
+  ScanIterator iterator(&connection, cmd, options);
+  PageResult first, second;
+
+  // when
+  iterator.next(collectPage(first));
+  iterator.next(collectPage(second));
+
+  // then
+  QCOMPARE(first.keys, ScanIterator::Page() << "f" << "v");
+  QCOMPARE(connection.executedCommands.at(1).getRawString(),
+           QByteArray("HSCAN hash 3 COUNT 50"));
+  QCOMPARE(second.final, true);
+}
+
+void TestKeyIterator::adaptCount() {
+  // given
+  DummyConnection connection;
+  connection.setFakeResponses(
+      QStringList() << "*2\r\n$2\r\n42\r\n*0\r\n"
+                    << "*2\r\n$2\r\n42\r\n*0\r\n");
+  KeyIterator::Options adaptive;
+  adaptive.count = 1000;
+  adaptive.prefetch = 0;
+  KeyIterator::Options fixed = adaptive;
+  fixed.targetPageLatency = 0;
+  KeyIterator adaptiveIterator(&connection, adaptive);
+  KeyIterator fixedIterator(&connection, fixed);
+  PageResult result;
+
+  // when - replies are faster than target latency
+  adaptiveIterator.next(collectPage(result));
+  fixedIterator.next(collectPage(result));
+
+  // then
+  QCOMPARE(adaptiveIterator.count(), 2000u);
+  QCOMPARE(fixedIterator.count(), 1000u);
+}
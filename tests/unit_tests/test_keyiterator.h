@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+
+class TestKeyIterator : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void requestPagesOnDemand();
+  void filterByType();
+  void filterByTypeOnOldServer();
+  void prefetchNextPage();
+  void scanValues();
+  void adaptCount();
+};
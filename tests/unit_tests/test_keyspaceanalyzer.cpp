@@ -0,0 +1,107 @@
+#include "test_keyspaceanalyzer.h"
+#include <QTest>
+#include "mocks/dummyconnection.h"
+#include "qredisclient/keyspaceanalyzer.h"
+
+using RedisClient::KeyspaceAnalyzer;
+
+void TestKeyspaceAnalyzer::analyzeDatabase() {
+  // given
+  DummyConnection connection;
+  connection.setFakeResponses(
+      QStringList()
+      << "*2\r\n$1\r\n0\r\n*3\r\n$6\r\nuser:1\r\n$6\r\nuser:2\r\n$1\r\nt\r\n"
+      << "+hash\r\n" << ":1000\r\n" << ":-1\r\n"
+      << "+string\r\n" << ":50\r\n" << ":30000\r\n"
+      << "+none\r\n" << "$-1\r\n" << ":-2\r\n");
+  KeyspaceAnalyzer::Report report;
+  QString error;
+  int finalCalls = 0;
+
+  // when
+  connection.analyzeKeyspace(
+      [&](const KeyspaceAnalyzer::Report &r, const QString &err, bool final) {
+        report = r;
+        error = err;
+        if (final) finalCalls++;
+      });
+
+  // then - TYPE, MEMORY USAGE and PTTL of page are pipelined
+  QCOMPARE(finalCalls, 1);
+  QCOMPARE(error, QString());
+  QCOMPARE(connection.runCommandCalled, 10u);
+  QList<QByteArray> commands;
+
+  for (const RedisClient::Command &cmd : connection.executedCommands)
+    commands.append(cmd.getRawString());
+
+  QVERIFY(commands.contains("TYPE user:2"));
+  QVERIFY(commands.contains("MEMORY USAGE user:1 SAMPLES 5"));
+  QVERIFY(commands.contains("PTTL t"));
+
+  QCOMPARE(report.scannedKeys, 3ull);
+  QCOMPARE(report.sampledKeys, 2ull);
+  QCOMPARE(report.missingKeys, 1ull);
+  QCOMPARE(report.total.bytes, 1050ll);
+  QCOMPARE(report.types.value("hash").bytes, 1000ll);
+  QCOMPARE(report.types.value("string").keys, 1ull);
+  QCOMPARE(report.namespaces.size(), 1);
+  QCOMPARE(report.namespaces.value("user").keys, 2ull);
+  QCOMPARE(report.ttl.at(KeyspaceAnalyzer::NoTtl), 1ull);
+  QCOMPARE(report.ttl.at(KeyspaceAnalyzer::LessThanMinute), 1ull);
+  QCOMPARE(report.bigKeys.size(), 2);
+  QCOMPARE(report.bigKeys.first().key, QByteArray("user:1"));
+  QCOMPARE(report.scale(), 1.5);
+}
+
+void TestKeyspaceAnalyzer::aggregateInFixedMemory() {
+  // given
+  KeyspaceAnalyzer::Options options;
+  options.topKeys = 2;
+  options.maxNamespaces = 2;
+  KeyspaceAnalyzer analyzer(options);
+
+  // when
+  analyzer.addKey("a:1", "string", 10, -1);
+  analyzer.addKey("b:1", "list", 30, 3600 * 1000);
+  analyzer.addKey("c:1", "string", 20, 10 * 24 * 3600 * 1000ll);
+  analyzer.addKey("a:2", "string", 5, 1);
+
+  // then - smallest keys and namespaces over the limit are merged
+  KeyspaceAnalyzer::Report report = analyzer.report();
+
+  QCOMPARE(report.sampledKeys, 4ull);
+  QCOMPARE(report.bigKeys.size(), 2);
+  QCOMPARE(report.bigKeys.at(0).key, QByteArray("b:1"));
+  QCOMPARE(report.bigKeys.at(0).ttl, 3600 * 1000ll);
+  QCOMPARE(report.bigKeys.at(1).key, QByteArray("c:1"));
+  QCOMPARE(report.namespaces.size(), 2);
+  QCOMPARE(report.namespaces.value("a").keys, 2ull);
+  QCOMPARE(report.namespaces.value("a").bytes, 15ll);
+  QCOMPARE(report.otherNamespaces.keys, 1ull);
+  QCOMPARE(report.otherNamespaces.bytes, 20ll);
+  QCOMPARE(report.ttl.at(KeyspaceAnalyzer::LessThanDay), 1ull);
+  QCOMPARE(report.ttl.at(KeyspaceAnalyzer::MoreThanWeek), 1ull);
+}
+
+void TestKeyspaceAnalyzer::sampleKeys() {
+  // given
+  KeyspaceAnalyzer::Options options;
+  options.sampleRate = 0.1;
+  KeyspaceAnalyzer analyzer(options);
+  KeyspaceAnalyzer other(options);
+  int sampled = 0;
+
+  // when
+  for (int i = 0; i < 10000; ++i) {
+    QByteArray key = "key:" + QByteArray::number(i);
+
+    if (analyzer.isSampled(key)) sampled++;
+
+    // then - sampling doesn't depend on analyzer instance
+    QCOMPARE(other.isSampled(key), analyzer.isSampled(key));
+  }
+
+  // then
+  QVERIFY(sampled > 800 && sampled < 1200);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+
+class TestKeyspaceAnalyzer : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void analyzeDatabase();
+  void aggregateInFixedMemory();
+  void sampleKeys();
+};
@@ -0,0 +1,96 @@
+#include "test_namespacetree.h"
+#include <QTest>
+#include "qredisclient/namespacetree.h"
+
+using RedisClient::NamespaceTree;
+
+void TestNamespaceTree::rootItems() {
+  // given
+  NamespaceTree tree(":");
+
+  // when
+  tree.addKeys(QList<QByteArray>()
+               << "b:x:y" << "a:1" << "c" << "a:2" << "a:");
+
+  // then
+  NamespaceTree::Items actualResult = tree.rootItems();
+
+  QCOMPARE(actualResult.first,
+           NamespaceTree::Namespaces() << qMakePair(QByteArray("a"), 3ul)
+                                       << qMakePair(QByteArray("b"), 1ul));
+  QCOMPARE(actualResult.second, NamespaceTree::Keys() << "c");
+  QCOMPARE(tree.keysCount(), 5ul);
+}
+
+void TestNamespaceTree::rootItemsWithFilter() {
+  // given
+  NamespaceTree tree(":", "user:");
+
+  // when
+  tree.addKeys(QList<QByteArray>()
+               << "user:1:name" << "user:1:email" << "user:count");
+
+  // then
+  NamespaceTree::Items actualResult = tree.rootItems();
+
+  QCOMPARE(actualResult.first, NamespaceTree::Namespaces() << qMakePair(
+                                   QByteArray("user:1"), 2ul));
+  QCOMPARE(actualResult.second, NamespaceTree::Keys() << "user:count");
+}
+
+void TestNamespaceTree::childNamespaces() {
+  // given
+  NamespaceTree tree(":");
+  tree.addKeys(QList<QByteArray>()
+               << "app:cache:1" << "app:cache:2" << "app:session:1"
+               << "app:config");
+
+  // when
+  NamespaceTree::Namespaces actualResult = tree.childNamespaces("app");
+
+  // then
+  QCOMPARE(actualResult, NamespaceTree::Namespaces()
+                             << qMakePair(QByteArray("app:cache"), 2ul)
+                             << qMakePair(QByteArray("app:session"), 1ul));
+  QVERIFY(tree.childNamespaces("unknown").isEmpty());
+}
+
+void TestNamespaceTree::multiByteSeparator() {
+  // given
+  NamespaceTree tree("::");
+
+  // when
+  tree.addKeys(QList<QByteArray>() << "a::b" << "a:b" << "a::c::d");
+
+  // then
+  NamespaceTree::Items actualResult = tree.rootItems();
+
+  QCOMPARE(actualResult.first, NamespaceTree::Namespaces()
+                                   << qMakePair(QByteArray("a"), 2ul));
+  QCOMPARE(actualResult.second, NamespaceTree::Keys() << "a:b");
+}
+
+void TestNamespaceTree::namespaceOfKey() {
+  // given
+  NamespaceTree tree(":", "app:");
+
+  // when - then
+  QCOMPARE(tree.namespaceOf("app:user:1:name"), QByteArray("app:user"));
+  QCOMPARE(tree.namespaceOf("app:user:1:name", 2), QByteArray("app:user:1"));
+  QCOMPARE(tree.namespaceOf("app:user:1:name", 5),
+           QByteArray("app:user:1"));
+  QCOMPARE(tree.namespaceOf("app:count"), QByteArray());
+  QCOMPARE(tree.keysCount(), 0ul);
+}
+
+void TestNamespaceTree::benchmarkAddKeys() {
+  QList<QByteArray> keys;
+
+  for (int i = 0; i < 100000; ++i)
+    keys.append(QString("app:%1:user:%2").arg(i % 100).arg(i).toUtf8());
+
+  QBENCHMARK {
+    NamespaceTree tree(":");
+    tree.addKeys(keys);
+  }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+
+class TestNamespaceTree : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void rootItems();
+  void rootItemsWithFilter();
+  void childNamespaces();
+  void multiByteSeparator();
+  void namespaceOfKey();
+  void benchmarkAddKeys();
+};
@@ -2,6 +2,7 @@
 #include <QTest>
 #include <QtCore>
 #include "qredisclient/response.h"
+#include "qredisclient/responsedecoder.h"
 #include "qredisclient/responseparser.h"
 
 void TestResponse::valueToHumanReadString() {
@@ -38,3 +39,90 @@ void TestResponse::scanResponse() {
   QCOMPARE(collection, QVariantList() << "Foo"
                                       << "Bar");
 }
+
+void TestResponse::typedAccessors() {
+  // given
+  QString testResponse =
+      "*3\r\n"
+      "$3\r\nfoo\r\n"
+      ":42\r\n"
+      "*1\r\n"
+      "$3\r\nbar\r\n";
+  RedisClient::ResponseParser parser;
+  parser.feedBuffer(testResponse.toUtf8());
+  RedisClient::Response test = parser.getNextResponse();
+
+  // when
+  QByteArray first = test.at(0).asBytes();
+  QByteArray firstAgain = test.at(0).asBytes();
+
+  // then
+  QVERIFY(test.isArray());
+  QCOMPARE(test.arraySize(), 3);
+  QCOMPARE(first, QByteArray("foo"));
+  QVERIFY(first.constData() == firstAgain.constData());
+  QCOMPARE(test.at(1).toInteger(), 42LL);
+  QCOMPARE(test.at(2).arraySize(), 1);
+  QCOMPARE(test.at(2).at(0).toByteArray(), QByteArray("bar"));
+  QVERIFY(!test.at(3).isValid());
+  QCOMPARE(test.value().toList().size(), 3);
+}
+
+void TestResponse::typedAccessorsOnVariant() {
+  // given
+  RedisClient::Response test(RedisClient::Response::Array,
+                             QVariantList() << "message"
+                                            << "ch1"
+                                            << "payload");
+
+  // when
+  QByteArray channel = test.getChannel();
+
+  // then
+  QVERIFY(test.isMessage());
+  QCOMPARE(channel, QByteArray("ch1"));
+  QCOMPARE(test.at(2).asBytes(), QByteArray("payload"));
+}
+
+void TestResponse::decodeTypedReplies() {
+  // given
+  QString testResponse =
+      "*4\r\n"
+      "$5\r\nfield\r\n"
+      "$5\r\nvalue\r\n"
+      "$3\r\nttl\r\n"
+      "$2\r\n42\r\n"
+      ":7\r\n"
+      "%1\r\n"
+      "+a\r\n"
+      "*2\r\n"
+      "$1\r\nb\r\n"
+      "$-1\r\n";
+  RedisClient::ResponseParser parser;
+  parser.feedBuffer(testResponse.toUtf8());
+  RedisClient::Response hgetall = parser.getNextResponse();
+  RedisClient::Response integer = parser.getNextResponse();
+  RedisClient::Response map = parser.getNextResponse();
+
+  // when
+  auto hash = RedisClient::decode<QHash<QByteArray, QByteArray>>(hgetall);
+  auto list = RedisClient::decode<QVector<QByteArray>>(hgetall);
+  qint64 number = RedisClient::decode<qint64>(integer);
+  auto nested = RedisClient::decode<QMap<QString, QList<QByteArray>>>(map);
+
+  QVector<qint64> mismatch;
+  bool mismatchDecoded = RedisClient::decode(hgetall.view(), mismatch);
+
+  // then
+  QCOMPARE(hash.size(), 2);
+  QCOMPARE(hash.value("field"), QByteArray("value"));
+  QCOMPARE(list.size(), 4);
+  QCOMPARE(RedisClient::decode<qint64>(RedisClient::Response(
+               RedisClient::Response::String, QByteArray("42"))),
+           qint64(42));
+  QCOMPARE(number, qint64(7));
+  QCOMPARE(nested.value("a"), QList<QByteArray>() << "b" << QByteArray());
+  QVERIFY(!mismatchDecoded);
+  QVERIFY_EXCEPTION_THROWN(RedisClient::decode<qint64>(hgetall),
+                           RedisClient::Response::Exception);
+}
@@ -8,4 +8,7 @@ class TestResponse : public QObject {
  private slots:
   void valueToHumanReadString();
   void scanResponse();
+  void typedAccessors();
+  void typedAccessorsOnVariant();
+  void decodeTypedReplies();
 };
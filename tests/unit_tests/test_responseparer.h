@@ -17,4 +17,10 @@ class TestResponseParser : public QObject {
   void hiredisBufferCleanup();
 
   void source();
+
+  void arenaAllocations();
+  void directWrite();
+  void maxBufferSize();
+  void resp3Types();
+  void benchmarkLargeArray();
 };
@@ -187,3 +187,142 @@ void TestResponseParser::hiredisBufferCleanup() {
   // then
   QVERIFY(resp.isValid());
 }
+
+QByteArray getLargeArrayReply(int size) {
+  QByteArray reply = QString("*%1\r\n").arg(size).toLatin1();
+
+  for (int i = 0; i < size; ++i) {
+    QByteArray item = QString("key:%1").arg(i).toLatin1();
+    reply.append(QString("$%1\r\n").arg(item.size()).toLatin1());
+    reply.append(item);
+    reply.append("\r\n");
+  }
+  return reply;
+}
+
+void TestResponseParser::arenaAllocations() {
+  // given
+  RedisClient::ResponseParser parser;
+  QByteArray reply = getLargeArrayReply(10000);
+
+  // when
+  parser.feedBuffer(reply);
+  RedisClient::Response first = parser.getNextResponse();
+  uint blocksAfterFirstReply = parser.arenaBlocksAllocated();
+
+  parser.feedBuffer(getLargeArrayReply(10));
+  RedisClient::Response second = parser.getNextResponse();
+
+  // then
+  QCOMPARE(first.value().toList().size(), 10000);
+  QCOMPARE(first.value().toList().at(9999).toByteArray(),
+           QByteArray("key:9999"));
+  QCOMPARE(second.value().toList().size(), 10);
+  // 10000 nodes fit into a handful of arena blocks
+  QVERIFY(blocksAfterFirstReply < 20);
+  // small reply reuses the block kept after reset
+  QCOMPARE(parser.arenaBlocksAllocated(), blocksAfterFirstReply);
+}
+
+void TestResponseParser::benchmarkLargeArray() {
+  QByteArray reply = getLargeArrayReply(10000);
+  RedisClient::ResponseParser parser;
+
+  QBENCHMARK {
+    parser.feedBuffer(reply);
+    parser.getNextResponse();
+  }
+}
+
+void TestResponseParser::resp3Types() {
+  if (!RedisClient::ResponseParser::isResp3Supported())
+    QSKIP("hiredis without RESP3 support");
+
+  // given
+  RedisClient::ResponseParser parser;
+  parser.feedBuffer(
+      "%2\r\n+a\r\n:1\r\n+b\r\n#t\r\n"
+      "~2\r\n$1\r\nx\r\n$1\r\ny\r\n"
+      ",3.14\r\n"
+      "=15\r\ntxt:Some string\r\n"
+      "(3492890328409238509324850943850943825024385\r\n"
+      ">3\r\n$7\r\nmessage\r\n$2\r\nch\r\n$3\r\nmsg\r\n");
+
+  // when
+  RedisClient::Response map = parser.getNextResponse();
+  RedisClient::Response set = parser.getNextResponse();
+  RedisClient::Response dbl = parser.getNextResponse();
+  RedisClient::Response verbatim = parser.getNextResponse();
+  RedisClient::Response bignum = parser.getNextResponse();
+  RedisClient::Response push = parser.getNextResponse();
+
+  // then
+  QCOMPARE(map.type(), RedisClient::Response::Map);
+  QCOMPARE(map.arraySize(), 4);
+  QCOMPARE(map.at(2).asBytes(), QByteArray("b"));
+  QCOMPARE(map.at(3).type(), int(RedisClient::Response::Boolean));
+  QVERIFY(map.at(3).toBool());
+
+  QCOMPARE(set.type(), RedisClient::Response::Set);
+  QVERIFY(set.isArray());
+  QCOMPARE(set.value().toList(), QVariantList() << "x" << "y");
+
+  QCOMPARE(dbl.type(), RedisClient::Response::Double);
+  QCOMPARE(dbl.view().toDouble(), 3.14);
+
+  QCOMPARE(verbatim.type(), RedisClient::Response::Verbatim);
+  QCOMPARE(verbatim.asBytes(), QByteArray("Some string"));
+
+  QCOMPARE(bignum.type(), RedisClient::Response::BigNumber);
+  QCOMPARE(bignum.asBytes(),
+           QByteArray("3492890328409238509324850943850943825024385"));
+
+  QVERIFY(push.isPush());
+  QVERIFY(push.isMessage());
+  QCOMPARE(push.getChannel(), QByteArray("ch"));
+}
+
+void TestResponseParser::directWrite() {
+  // given
+  RedisClient::ResponseParser parser;
+  QByteArray first("+OK\r\n$6\r\nfoo");
+  QByteArray second("bar\r\n");
+
+  // when
+  char* buffer = parser.prepareWrite(first.size());
+  memcpy(buffer, first.constData(), first.size());
+  bool firstCommitted = parser.commitWrite(first.size());
+  RedisClient::Response status = parser.getNextResponse();
+  RedisClient::Response incomplete = parser.getNextResponse();
+
+  buffer = parser.prepareWrite(second.size());
+  memcpy(buffer, second.constData(), second.size());
+  bool secondCommitted = parser.commitWrite(second.size());
+  RedisClient::Response bulk = parser.getNextResponse();
+
+  // then
+  QVERIFY(firstCommitted);
+  QVERIFY(secondCommitted);
+  QCOMPARE(status.value().toByteArray(), QByteArray("OK"));
+  QVERIFY(!incomplete.isValid());
+  QCOMPARE(bulk.value().toByteArray(), QByteArray("foobar"));
+  QVERIFY(!parser.hasUnusedBuffer());
+}
+
+void TestResponseParser::maxBufferSize() {
+  // given
+  RedisClient::ResponseParser parser;
+  parser.setMaxBufferSize(16);
+
+  // when
+  bool smallReplyFed = parser.feedBuffer("$3\r\nfoo\r\n");
+  RedisClient::Response small = parser.getNextResponse();
+  bool runawayReplyFed = parser.feedBuffer(QByteArray("$1000\r\n") +
+                                           QByteArray(100, 'x'));
+
+  // then
+  QVERIFY(smallReplyFed);
+  QCOMPARE(small.value().toByteArray(), QByteArray("foo"));
+  QVERIFY(!runawayReplyFed);
+  QVERIFY(parser.isBufferLimitExceeded());
+}
@@ -0,0 +1,157 @@
+#include "test_scriptcache.h"
+#include <QTest>
+#include "mocks/dummyconnection.h"
+#include "qredisclient/scriptcache.h"
+
+using RedisClient::ScriptCache;
+
+namespace {
+// Digest returned by SCRIPT LOAD "return 1"
+const QByteArray RETURN_ONE_SHA1 = "e0e1f9fabfc9d4800c877a703b823ac0578ff8db";
+
+QStringList commandNames(const QList<RedisClient::Command> &commands) {
+  QStringList result;
+
+  for (const RedisClient::Command &cmd : commands)
+    result.append(cmd.getPartAsString(0));
+
+  return result;
+}
+
+QString scriptLoadReply() {
+  return QString("$40\r\n%1\r\n").arg(QString::fromLatin1(RETURN_ONE_SHA1));
+}
+
+class FailoverConnection : public DummyConnection {
+ public:
+  using RedisClient::Connection::handshakeCompleted;
+
+  // State of connection after handshake with sentinel or data node
+  void connectedTo(const QString &redisMode) {
+    m_currentMode.storeRelease(static_cast<int>(Mode::Sentinel));
+    m_serverInfo = RedisClient::ServerInfo::fromString(
+        QString("# Server\r\nredis_mode:%1\r\n").arg(redisMode));
+    m_scripts->resetLoaded();
+  }
+};
+}  // namespace
+
+void TestScriptCache::sha1() {
+  // given
+  ScriptCache cache;
+
+  // when
+  QByteArray actualResult = cache.add("one", "return 1");
+
+  // then
+  QCOMPARE(actualResult, RETURN_ONE_SHA1);
+  QCOMPARE(ScriptCache::sha1("return 1"), RETURN_ONE_SHA1);
+  QCOMPARE(cache.script("one").body, QByteArray("return 1"));
+  QCOMPARE(cache.script("two").isValid(), false);
+}
+
+void TestScriptCache::loadedState() {
+  // given
+  ScriptCache cache;
+  QByteArray sha1 = cache.add("one", "return 1");
+
+  // when
+  cache.setLoaded(sha1);
+
+  // then
+  QCOMPARE(cache.isLoaded(sha1), true);
+
+  cache.resetLoaded();
+  QCOMPARE(cache.isLoaded(sha1), false);
+  QCOMPARE(cache.scripts().size(), 1);
+}
+
+void TestScriptCache::runScriptWithEvalSha() {
+  // given
+  DummyConnection connection;
+  connection.setFakeResponses(QStringList()
+                              << scriptLoadReply()
+                              << ":1\r\n"
+                              << ":1\r\n");
+  connection.registerScript("one", "return 1");
+  int callbacksCalled = 0;
+
+  auto callback = [&callbacksCalled](RedisClient::Response r, QString err) {
+    QCOMPARE(err, QString());
+    QCOMPARE(r.value().toInt(), 1);
+    callbacksCalled++;
+  };
+
+  // when
+  connection.runScript("one", {"key"}, {"arg"}, this, callback);
+  connection.runScript("one", {"key"}, {"arg"}, this, callback);
+
+  // then
+  QCOMPARE(callbacksCalled, 2);
+  QCOMPARE(commandNames(connection.executedCommands),
+           QStringList() << "SCRIPT" << "EVALSHA" << "EVALSHA");
+  QCOMPARE(connection.executedCommands.at(1).getRawString(),
+           QByteArray("EVALSHA " + RETURN_ONE_SHA1 + " 1 key arg"));
+}
+
+void TestScriptCache::runScriptFallbackOnNoScript() {
+  // given
+  DummyConnection connection;
+  connection.setFakeResponses(
+      QStringList() << scriptLoadReply()
+                    << "-NOSCRIPT No matching script. Please use EVAL.\r\n"
+                    << ":1\r\n");
+  connection.registerScript("one", "return 1");
+  RedisClient::Response result;
+
+  // when
+  connection.runScript("one", {}, {}, this,
+                       [&result](RedisClient::Response r, QString) {
+                         result = r;
+                       });
+
+  // then
+  QCOMPARE(result.value().toInt(), 1);
+  QCOMPARE(connection.runCommandCalled, 3u);
+  QVERIFY(commandNames(connection.executedCommands).contains("EVAL"));
+}
+
+void TestScriptCache::runNotRegisteredScript() {
+  // given
+  DummyConnection connection;
+
+  // when - then
+  QVERIFY_EXCEPTION_THROWN(
+      connection.runScript("unknown", {}, {}, this,
+                           [](RedisClient::Response, QString) {}),
+      RedisClient::Connection::Exception);
+}
+
+void TestScriptCache::loadScriptsAfterSentinelFailover() {
+  // given
+  FailoverConnection connection;
+  connection.registerScript("one", "return 1");
+  connection.setFakeResponses(QStringList() << scriptLoadReply()
+                                            << scriptLoadReply());
+
+  // when - socket still points at sentinel
+  connection.connectedTo("sentinel");
+  connection.handshakeCompleted();
+
+  // then
+  QCOMPARE(connection.runCommandCalled, 0u);
+
+  // when - connected to discovered master and to new master
+  // after +switch-master
+  connection.connectedTo("standalone");
+  connection.handshakeCompleted();
+  connection.connectedTo("standalone");
+  connection.handshakeCompleted();
+
+  // then
+  QCOMPARE(connection.mode(), RedisClient::Connection::Mode::Sentinel);
+  QCOMPARE(commandNames(connection.executedCommands),
+           QStringList() << "SCRIPT" << "SCRIPT");
+  QCOMPARE(connection.executedCommands.last().getPartAsString(1),
+           QString("LOAD"));
+}
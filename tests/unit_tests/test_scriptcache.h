@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+
+class TestScriptCache : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void sha1();
+  void loadedState();
+  void runScriptWithEvalSha();
+  void runScriptFallbackOnNoScript();
+  void runNotRegisteredScript();
+  void loadScriptsAfterSentinelFailover();
+};
@@ -0,0 +1,336 @@
+#include "test_serverinfo.h"
+#include <QTest>
+#include "qredisclient/serverinfo.h"
+
+using RedisClient::ServerInfo;
+
+namespace {
+// INFO ALL recorded from redis-server 7.2.4 (commandstats and
+// latencystats are truncated)
+const char REDIS_7_INFO_ALL[] =
+    "# Server\r\n"
+    "redis_version:7.2.4\r\n"
+    "redis_git_sha1:00000000\r\n"
+    "redis_git_dirty:0\r\n"
+    "redis_build_id:9f4b8de9bd3e6b1e\r\n"
+    "redis_mode:standalone\r\n"
+    "os:Linux 6.5.0-1015-azure x86_64\r\n"
+    "arch_bits:64\r\n"
+    "monotonic_clock:POSIX clock_gettime\r\n"
+    "multiplexing_api:epoll\r\n"
+    "atomicvar_api:c11-builtin\r\n"
+    "gcc_version:12.2.0\r\n"
+    "process_id:1\r\n"
+    "process_supervised:no\r\n"
+    "run_id:2f1e9a4a6d2cb0c3d3b1c4f77b4a1b8e6f9d0c21\r\n"
+    "tcp_port:6379\r\n"
+    "server_time_usec:1707207999773342\r\n"
+    "uptime_in_seconds:86412\r\n"
+    "uptime_in_days:1\r\n"
+    "hz:10\r\n"
+    "configured_hz:10\r\n"
+    "lru_clock:5518420\r\n"
+    "executable:/data/redis-server\r\n"
+    "config_file:\r\n"
+    "io_threads_active:0\r\n"
+    "listener0:name=tcp,bind=*,bind=-::*,port=6379\r\n"
+    "\r\n"
+    "# Clients\r\n"
+    "connected_clients:42\r\n"
+    "cluster_connections:0\r\n"
+    "maxclients:10000\r\n"
+    "client_recent_max_input_buffer:20480\r\n"
+    "client_recent_max_output_buffer:0\r\n"
+    "blocked_clients:0\r\n"
+    "tracking_clients:0\r\n"
+    "clients_in_timeout_table:0\r\n"
+    "total_blocking_keys:0\r\n"
+    "total_blocking_keys_on_nokey:0\r\n"
+    "\r\n"
+    "# Memory\r\n"
+    "used_memory:1482608\r\n"
+    "used_memory_human:1.41M\r\n"
+    "used_memory_rss:13631488\r\n"
+    "used_memory_rss_human:13.00M\r\n"
+    "used_memory_peak:1606152\r\n"
+    "used_memory_peak_human:1.53M\r\n"
+    "used_memory_peak_perc:92.31%\r\n"
+    "used_memory_overhead:1212880\r\n"
+    "used_memory_startup:865784\r\n"
+    "used_memory_dataset:269728\r\n"
+    "used_memory_dataset_perc:43.73%\r\n"
+    "allocator_allocated:1724032\r\n"
+    "allocator_active:2002944\r\n"
+    "allocator_resident:5279744\r\n"
+    "total_system_memory:16769363968\r\n"
+    "total_system_memory_human:15.62G\r\n"
+    "used_memory_lua:31744\r\n"
+    "used_memory_vm_eval:31744\r\n"
+    "used_memory_lua_human:31.00K\r\n"
+    "used_memory_scripts_eval:0\r\n"
+    "number_of_cached_scripts:0\r\n"
+    "number_of_functions:0\r\n"
+    "number_of_libraries:0\r\n"
+    "used_memory_vm_functions:32768\r\n"
+    "used_memory_vm_total:64512\r\n"
+    "used_memory_vm_total_human:63.00K\r\n"
+    "used_memory_functions:184\r\n"
+    "used_memory_scripts:184\r\n"
+    "used_memory_scripts_human:184B\r\n"
+    "maxmemory:0\r\n"
+    "maxmemory_human:0B\r\n"
+    "maxmemory_policy:noeviction\r\n"
+    "allocator_frag_ratio:1.16\r\n"
+    "allocator_frag_bytes:278912\r\n"
+    "allocator_rss_ratio:2.64\r\n"
+    "allocator_rss_bytes:3276800\r\n"
+    "rss_overhead_ratio:2.58\r\n"
+    "rss_overhead_bytes:8351744\r\n"
+    "mem_fragmentation_ratio:9.33\r\n"
+    "mem_fragmentation_bytes:12170104\r\n"
+    "mem_not_counted_for_evict:0\r\n"
+    "mem_replication_backlog:0\r\n"
+    "mem_total_replication_buffers:0\r\n"
+    "mem_clients_slaves:0\r\n"
+    "mem_clients_normal:345928\r\n"
+    "mem_cluster_links:0\r\n"
+    "mem_aof_buffer:0\r\n"
+    "mem_allocator:jemalloc-5.3.0\r\n"
+    "active_defrag_running:0\r\n"
+    "lazyfree_pending_objects:0\r\n"
+    "lazyfreed_objects:0\r\n"
+    "\r\n"
+    "# Persistence\r\n"
+    "loading:0\r\n"
+    "async_loading:0\r\n"
+    "current_cow_peak:0\r\n"
+    "current_cow_size:0\r\n"
+    "current_cow_size_age:0\r\n"
+    "current_fork_perc:0.00\r\n"
+    "current_save_keys_processed:0\r\n"
+    "current_save_keys_total:0\r\n"
+    "rdb_changes_since_last_save:17\r\n"
+    "rdb_bgsave_in_progress:0\r\n"
+    "rdb_last_save_time:1707121600\r\n"
+    "rdb_last_bgsave_status:ok\r\n"
+    "rdb_last_bgsave_time_sec:0\r\n"
+    "rdb_current_bgsave_time_sec:-1\r\n"
+    "rdb_saves:3\r\n"
+    "rdb_last_cow_size:462848\r\n"
+    "rdb_last_load_keys_expired:0\r\n"
+    "rdb_last_load_keys_loaded:1024\r\n"
+    "aof_enabled:0\r\n"
+    "aof_rewrite_in_progress:0\r\n"
+    "aof_rewrite_scheduled:0\r\n"
+    "aof_last_rewrite_time_sec:-1\r\n"
+    "aof_current_rewrite_time_sec:-1\r\n"
+    "aof_last_bgrewrite_status:ok\r\n"
+    "aof_rewrites:0\r\n"
+    "aof_rewrites_consecutive_failures:0\r\n"
+    "aof_last_write_status:ok\r\n"
+    "aof_last_cow_size:0\r\n"
+    "module_fork_in_progress:0\r\n"
+    "module_fork_last_cow_size:0\r\n"
+    "\r\n"
+    "# Stats\r\n"
+    "total_connections_received:1337\r\n"
+    "total_commands_processed:982451\r\n"
+    "instantaneous_ops_per_sec:124\r\n"
+    "total_net_input_bytes:45809357\r\n"
+    "total_net_output_bytes:91322841\r\n"
+    "total_net_repl_input_bytes:0\r\n"
+    "total_net_repl_output_bytes:0\r\n"
+    "instantaneous_input_kbps:5.12\r\n"
+    "instantaneous_output_kbps:9.87\r\n"
+    "instantaneous_input_repl_kbps:0.00\r\n"
+    "instantaneous_output_repl_kbps:0.00\r\n"
+    "rejected_connections:0\r\n"
+    "sync_full:0\r\n"
+    "sync_partial_ok:0\r\n"
+    "sync_partial_err:0\r\n"
+    "expired_keys:12\r\n"
+    "expired_stale_perc:0.00\r\n"
+    "expired_time_cap_reached_count:0\r\n"
+    "expire_cycle_cpu_milliseconds:412\r\n"
+    "evicted_keys:0\r\n"
+    "evicted_clients:0\r\n"
+    "total_eviction_exceeded_time:0\r\n"
+    "current_eviction_exceeded_time:0\r\n"
+    "keyspace_hits:500123\r\n"
+    "keyspace_misses:2048\r\n"
+    "pubsub_channels:2\r\n"
+    "pubsub_patterns:1\r\n"
+    "pubsubshard_channels:0\r\n"
+    "latest_fork_usec:512\r\n"
+    "total_forks:3\r\n"
+    "migrate_cached_sockets:0\r\n"
+    "slave_expires_tracked_keys:0\r\n"
+    "active_defrag_hits:0\r\n"
+    "active_defrag_misses:0\r\n"
+    "active_defrag_key_hits:0\r\n"
+    "active_defrag_key_misses:0\r\n"
+    "total_active_defrag_time:0\r\n"
+    "current_active_defrag_time:0\r\n"
+    "tracking_total_keys:0\r\n"
+    "tracking_total_items:0\r\n"
+    "tracking_total_prefixes:0\r\n"
+    "unexpected_error_replies:0\r\n"
+    "total_error_replies:31\r\n"
+    "dump_payload_sanitizations:0\r\n"
+    "total_reads_processed:984110\r\n"
+    "total_writes_processed:983021\r\n"
+    "io_threaded_reads_processed:0\r\n"
+    "io_threaded_writes_processed:0\r\n"
+    "reply_buffer_shrinks:87\r\n"
+    "reply_buffer_expands:54\r\n"
+    "eventloop_cycles:1203341\r\n"
+    "eventloop_duration_sum:98231442\r\n"
+    "eventloop_duration_cmd_sum:1893044\r\n"
+    "instantaneous_eventloop_cycles_per_sec:131\r\n"
+    "instantaneous_eventloop_duration_usec:64\r\n"
+    "acl_access_denied_auth:0\r\n"
+    "acl_access_denied_cmd:0\r\n"
+    "acl_access_denied_key:0\r\n"
+    "acl_access_denied_channel:0\r\n"
+    "\r\n"
+    "# Replication\r\n"
+    "role:master\r\n"
+    "connected_slaves:0\r\n"
+    "master_failover_state:no-failover\r\n"
+    "master_replid:5a7f1c0b9d8e2f3a4b6c7d8e9f0a1b2c3d4e5f60\r\n"
+    "master_replid2:0000000000000000000000000000000000000000\r\n"
+    "master_repl_offset:0\r\n"
+    "second_repl_offset:-1\r\n"
+    "repl_backlog_active:0\r\n"
+    "repl_backlog_size:1048576\r\n"
+    "repl_backlog_first_byte_offset:0\r\n"
+    "repl_backlog_histlen:0\r\n"
+    "\r\n"
+    "# CPU\r\n"
+    "used_cpu_sys:61.902713\r\n"
+    "used_cpu_user:48.311407\r\n"
+    "used_cpu_sys_children:0.012345\r\n"
+    "used_cpu_user_children:0.023456\r\n"
+    "used_cpu_sys_main_thread:61.814352\r\n"
+    "used_cpu_user_main_thread:48.235881\r\n"
+    "\r\n"
+    "# Modules\r\n"
+    "\r\n"
+    "# Commandstats\r\n"
+    "cmdstat_get:calls=500000,usec=312411,usec_per_call=0.62,rejected_calls=0,"
+    "failed_calls=0\r\n"
+    "cmdstat_set:calls=250000,usec=289001,usec_per_call=1.16,rejected_calls=0,"
+    "failed_calls=0\r\n"
+    "cmdstat_scan:calls=1200,usec=98021,usec_per_call=81.68,rejected_calls=0,"
+    "failed_calls=0\r\n"
+    "cmdstat_info:calls=86400,usec=4891204,usec_per_call=56.61,rejected_calls="
+    "0,failed_calls=0\r\n"
+    "cmdstat_ping:calls=86400,usec=21600,usec_per_call=0.25,rejected_calls=0,"
+    "failed_calls=0\r\n"
+    "\r\n"
+    "# Errorstats\r\n"
+    "errorstat_ERR:count=31\r\n"
+    "\r\n"
+    "# Latencystats\r\n"
+    "latency_percentiles_usec_get:p50=0.001,p99=2.007,p99.9=7.007\r\n"
+    "latency_percentiles_usec_set:p50=1.003,p99=3.007,p99.9=11.007\r\n"
+    "latency_percentiles_usec_info:p50=51.199,p99=110.079,p99.9=198.655\r\n"
+    "\r\n"
+    "# Cluster\r\n"
+    "cluster_enabled:0\r\n"
+    "\r\n"
+    "# Keyspace\r\n"
+    "db0:keys=1024,expires=12,avg_ttl=3412001\r\n"
+    "db2:keys=7,expires=0,avg_ttl=0\r\n";
+}  // namespace
+
+void TestServerInfo::parseWellKnownFields() {
+  // when
+  ServerInfo actualResult = ServerInfo::fromBytes(REDIS_7_INFO_ALL);
+
+  // then
+  QCOMPARE(actualResult.version, 7.2);
+  QCOMPARE(actualResult.versionString, QByteArray("7.2.4"));
+  QCOMPARE(actualResult.clusterMode, false);
+  QCOMPARE(actualResult.sentinelMode, false);
+  QCOMPARE(actualResult.role, QByteArray("master"));
+  QCOMPARE(actualResult.uptimeInSeconds, 86412LL);
+  QCOMPARE(actualResult.connectedClients, 42LL);
+  QCOMPARE(actualResult.usedMemory, 1482608LL);
+  QCOMPARE(actualResult.usedMemoryPeak, 1606152LL);
+  QCOMPARE(actualResult.totalCommandsProcessed, 982451LL);
+  QCOMPARE(actualResult.instantaneousOpsPerSec, 124LL);
+  QCOMPARE(actualResult.keyspaceHits, 500123LL);
+  QCOMPARE(actualResult.keyspaceMisses, 2048LL);
+}
+
+void TestServerInfo::parseKeyspace() {
+  // when
+  ServerInfo actualResult = ServerInfo::fromBytes(REDIS_7_INFO_ALL);
+
+  // then
+  RedisClient::DatabaseList expected;
+  expected.insert(0, 1024);
+  expected.insert(1, 0);
+  expected.insert(2, 7);
+
+  QCOMPARE(actualResult.databases, expected);
+}
+
+void TestServerInfo::parseClusterMode() {
+  // given
+  QByteArray info(
+      "# Server\n"
+      "redis_version:6.0.16\n"
+      "redis_mode:cluster\n"
+      "# Keyspace\n"
+      "db0:keys=5,expires=0,avg_ttl=0\n");
+
+  // when
+  ServerInfo actualResult = ServerInfo::fromBytes(info);
+
+  // then
+  QCOMPARE(actualResult.version, 6.0);
+  QCOMPARE(actualResult.clusterMode, true);
+  QCOMPARE(actualResult.databases.size(), 1);
+  QCOMPARE(actualResult.databases.value(0), 0);
+}
+
+void TestServerInfo::parseSectionsOnRequest() {
+  // when
+  ServerInfo actualResult = ServerInfo::fromBytes(REDIS_7_INFO_ALL);
+
+  // then
+  QVERIFY(actualResult.parsed.contains("memory"));
+  QVERIFY(!actualResult.parsed.contains("modules"));
+  QCOMPARE(actualResult.parsed.sections().first(), QString("server"));
+  QCOMPARE(actualResult.parsed.sections().last(), QString("keyspace"));
+  QCOMPARE(actualResult.parsed.value("memory", "maxmemory_policy"),
+           QString("noeviction"));
+  QCOMPARE(actualResult.parsed["server"].value("config_file"), QString());
+  QCOMPARE(actualResult.parsed["cpu"].size(), 6);
+}
+
+void TestServerInfo::cacheVariantMap() {
+  // given
+  ServerInfo info = ServerInfo::fromBytes(REDIS_7_INFO_ALL);
+  ServerInfo copy = info;
+
+  // when
+  QVariantMap actualResult = info.parsed.toVariantMap();
+
+  // then
+  QCOMPARE(actualResult.size(), info.parsed.sections().size());
+  QCOMPARE(actualResult["clients"].toMap()["connected_clients"].toString(),
+           QString("42"));
+  QCOMPARE(copy.parsed.toVariantMap(), actualResult);
+}
+
+void TestServerInfo::benchmarkParseInfoAll() {
+  QByteArray info(REDIS_7_INFO_ALL);
+  ServerInfo result;
+
+  QBENCHMARK { result = ServerInfo::fromBytes(info); }
+
+  QCOMPARE(result.databases.size(), 3);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+
+class TestServerInfo : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void parseWellKnownFields();
+  void parseKeyspace();
+  void parseClusterMode();
+  void parseSectionsOnRequest();
+  void cacheVariantMap();
+  void benchmarkParseInfoAll();
+};
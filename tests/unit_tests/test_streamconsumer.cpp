@@ -0,0 +1,104 @@
+#include "test_streamconsumer.h"
+#include <QTest>
+#include "mocks/dummyconnection.h"
+#include "qredisclient/streamconsumer.h"
+
+using RedisClient::StreamConsumer;
+
+namespace {
+StreamConsumer::Options consumerOptions() {
+  StreamConsumer::Options options;
+  options.group = "g";
+  options.consumer = "c";
+  options.streams << "s";
+  options.count = 10;
+  options.block = 100;
+  options.claimCount = 10;
+  return options;
+}
+}  // namespace
+
+void TestStreamConsumer::readAndAckInBatches() {
+  // given
+  QSharedPointer<DummyConnection> reader(new DummyConnection());
+  reader->setFakeResponses(
+      QStringList() << "*1\r\n*2\r\n$1\r\ns\r\n*2\r\n"
+                       "*2\r\n$3\r\n1-0\r\n*2\r\n$1\r\nf\r\n$2\r\nv1\r\n"
+                       "*2\r\n$3\r\n2-0\r\n*2\r\n$1\r\nf\r\n$2\r\nv2\r\n");
+  DummyConnection connection;
+  connection.setClone(reader);
+  connection.setFakeResponses(QStringList() << ":2\r\n");
+
+  StreamConsumer::Options options = consumerOptions();
+  options.ackBatch = 2;
+  StreamConsumer consumer(&connection, options);
+  QList<QByteArray> values;
+
+  QObject::connect(&consumer, &StreamConsumer::entriesReceived,
+                   [&consumer, &values](const StreamConsumer::Batch &batch) {
+                     for (const StreamConsumer::Entry &entry : batch.entries)
+                       values.append(entry.value("f"));
+
+                     consumer.ack(batch);
+                     consumer.stop();
+                   });
+
+  // when
+  consumer.start();
+
+  // then - both IDs are acked with a single XACK
+  QCOMPARE(values, QList<QByteArray>() << "v1"
+                                       << "v2");
+  QCOMPARE(reader->executedCommands.size(), 1);
+  QCOMPARE(reader->executedCommands.first().getRawString(),
+           QByteArray("XREADGROUP GROUP g c COUNT 10 BLOCK 100 STREAMS s >"));
+  QCOMPARE(connection.executedCommands.size(), 1);
+  QCOMPARE(connection.executedCommands.first().getRawString(),
+           QByteArray("XACK s g 1-0 2-0"));
+  QCOMPARE(consumer.stats().received, 2ull);
+  QCOMPARE(consumer.stats().acked, 2ull);
+  QCOMPARE(consumer.pendingAcks(), 0);
+  QVERIFY(!consumer.isRunning());
+}
+
+void TestStreamConsumer::claimIdleEntries() {
+  // given
+  QSharedPointer<DummyConnection> reader(new DummyConnection());
+  reader->returnErrorOnCmdRun = true;
+  DummyConnection connection;
+  connection.setClone(reader);
+  connection.setFakeResponses(
+      QStringList() << "*2\r\n$3\r\n0-0\r\n*1\r\n"
+                       "*2\r\n$3\r\n5-0\r\n*2\r\n$1\r\nf\r\n$1\r\nx\r\n");
+
+  StreamConsumer::Options options = consumerOptions();
+  options.claimMinIdle = 1000;
+  StreamConsumer consumer(&connection, options);
+  QList<StreamConsumer::Batch> batches;
+  QStringList errors;
+
+  QObject::connect(&consumer, &StreamConsumer::entriesReceived,
+                   [&batches](const StreamConsumer::Batch &batch) {
+                     batches.append(batch);
+                   });
+  QObject::connect(&consumer, &StreamConsumer::error,
+                   [&errors](const QString &err) { errors.append(err); });
+
+  // when
+  consumer.start();
+
+  // then - failed XREADGROUP is retried later, claim doesn't wait for it
+  QCOMPARE(errors.size(), 1);
+  QCOMPARE(connection.executedCommands.size(), 1);
+  QCOMPARE(connection.executedCommands.first().getRawString(),
+           QByteArray("XAUTOCLAIM s g c 1000 0-0 COUNT 10"));
+  QCOMPARE(batches.size(), 1);
+  QVERIFY(batches.first().claimed);
+  QCOMPARE(batches.first().entries.first().stream, QByteArray("s"));
+  QCOMPARE(batches.first().entries.first().id, QByteArray("5-0"));
+  QCOMPARE(batches.first().entries.first().value("f"), QByteArray("x"));
+  QCOMPARE(consumer.stats().claimed, 1ull);
+  QVERIFY(consumer.isRunning());
+
+  consumer.stop();
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+
+class TestStreamConsumer : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void readAndAckInBatches();
+  void claimIdleEntries();
+};
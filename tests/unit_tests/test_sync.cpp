@@ -0,0 +1,81 @@
+#include "test_sync.h"
+#include <QTest>
+#include <QThread>
+#include <thread>
+#include "qredisclient/utils/sync.h"
+
+using namespace RedisClient;
+
+void TestSync::waitForSignalFromAnotherThread() {
+  // given
+  QThread thread;
+  SignalWaiter waiter(10000);
+  waiter.addSuccessSignal(&thread, &QThread::started);
+
+  bool timerFired = false;
+  QTimer::singleShot(0, [&timerFired]() { timerFired = true; });
+
+  // when
+  thread.start();
+  bool result = waiter.wait();
+
+  // then
+  QCOMPARE(result, true);
+  QCOMPARE(timerFired, false);  // events of waiting thread are not processed
+
+  thread.quit();
+  thread.wait();
+}
+
+void TestSync::abortSignal() {
+  // given
+  QThread thread;
+  SignalWaiter waiter(10000);
+  waiter.addAbortSignal(&thread, &QThread::started);
+
+  // when
+  thread.start();
+  bool result = waiter.wait();
+
+  // then
+  QCOMPARE(result, false);
+
+  thread.quit();
+  thread.wait();
+}
+
+void TestSync::waitTimeout() {
+  // given
+  QTimer timer;
+  SignalWaiter waiter(10);
+  waiter.addSuccessSignal(&timer, &QTimer::timeout);
+  QElapsedTimer elapsed;
+  elapsed.start();
+
+  // when
+  bool result = waiter.wait();
+
+  // then
+  QCOMPARE(result, false);
+  QVERIFY(elapsed.elapsed() >= 10);
+}
+
+void TestSync::successTrigger() {
+  // given
+  std::function<void()> trigger;
+  bool result = false;
+
+  {
+    SignalWaiter waiter(10000);
+    trigger = waiter.successTrigger();
+
+    // when
+    std::thread thread(trigger);
+    result = waiter.wait();
+    thread.join();
+  }
+
+  // then
+  QCOMPARE(result, true);
+  trigger();  // waiter is destroyed, state is kept by trigger
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+
+class TestSync : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void waitForSignalFromAnotherThread();
+  void abortSignal();
+  void waitTimeout();
+  void successTrigger();
+};
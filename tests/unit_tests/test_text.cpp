@@ -42,3 +42,41 @@ void TestText::testPrintableString()
     //then
     QCOMPARE(actualResult, QString("\\x01\\x02\\x03"));
 }
+
+void TestText::testPrintableStringOfLargeValues()
+{
+    //given
+    QByteArray text = QByteArray("{\"name\": \"\xE2\x98\x82\"}\n").repeated(10000);
+    QByteArray binary = text;
+    binary[binary.size() - 2] = '\x01';
+
+    //when
+    QString printableText = printableString(text);
+    QString printableBinary = printableString(binary);
+
+    //then
+    QVERIFY(!isBinary(text));
+    QVERIFY(isBinary(binary));
+    QCOMPARE(printableText, QString::fromUtf8(text));
+    QCOMPARE(printableBinary.size(), binary.size() + 3 * 40001);
+    QVERIFY(printableBinary.endsWith("\\x82\"\\x01\\x0A"));
+    QVERIFY(isBinary(QByteArray("\xC0\x80")));  // overlong encoding
+    QVERIFY(isBinary(QByteArray("\xED\xA0\x80")));  // surrogate
+}
+
+void TestText::testPrintableStringPreview()
+{
+    //given
+    QByteArray value = QByteArray("\xE2\x98\x82").repeated(1000);
+    value.append('\x00');
+
+    //when
+    QString preview = printableString(value, false, 10);
+
+    //then
+    QCOMPARE(preview, QString::fromUtf8("\xE2\x98\x82\xE2\x98\x82\xE2\x98\x82"));
+    QVERIFY(!isBinary(value, 10));
+    QVERIFY(isBinary(value));
+    QCOMPARE(printableString(QByteArray("\x01\x02\x03"), false, 2),
+             QString("\\x01\\x02"));
+}
@@ -10,6 +10,8 @@ class TestText : public QObject
 private slots:
     void testPrintableStringToBinary();
     void testPrintableString();
+    void testPrintableStringOfLargeValues();
+    void testPrintableStringPreview();
 
 };
 
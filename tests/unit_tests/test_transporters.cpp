@@ -1,5 +1,15 @@
 #include "test_transporters.h"
+#include <QElapsedTimer>
+#include <QSslSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
 #include "mocks/dummyTransporter.h"
+#include "qredisclient/private/responsedispatcher.h"
+#include "qredisclient/private/sslcontextcache.h"
+#include "qredisclient/private/subscriberqueue.h"
+#include "qredisclient/transporterthreadpool.h"
+#include <thread>
+#include <vector>
 
 void TestTransporters::readPartialResponses() {
   // given
@@ -20,3 +30,779 @@ void TestTransporters::readPartialResponses() {
   // then
   QCOMPARE(transporter->catchedResponses.size(), 2);
 }
+
+void TestTransporters::streamBulkReply() {
+  // given
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(getDummyConfig()));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+
+  QList<QByteArray> chunks;
+  RedisClient::Command cmd({"GET", "big_key"});
+  cmd.setStreamCallback([&chunks](const RedisClient::Response& r) {
+    chunks.append(r.value().toByteArray());
+  });
+  transporter->addRunningCommand(cmd);
+
+  // when
+  transporter->setFakeReadBuffer("$10\r\n01234", false);
+  transporter->readyRead();
+  transporter->setFakeReadBuffer("56789\r", false);
+  transporter->readyRead();
+  transporter->setFakeReadBuffer("\n", false);
+  transporter->readyRead();
+  transporter->setFakeReadBuffer("+OK\r\n", true);
+  transporter->readyRead();
+
+  // then
+  QCOMPARE(chunks, QList<QByteArray>() << "01234"
+                                       << "56789");
+  QCOMPARE(cmd.getDeferred().future().result().value().toLongLong(), 10LL);
+  QCOMPARE(transporter->catchedResponses.size(), 1);
+}
+
+void TestTransporters::streamArrayReply() {
+  // given
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(getDummyConfig()));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+
+  QList<QByteArray> elements;
+  RedisClient::Command cmd({"LRANGE", "big_list", "0", "-1"});
+  cmd.setStreamCallback([&elements](const RedisClient::Response& r) {
+    elements.append(r.value().toByteArray());
+  });
+  transporter->addRunningCommand(cmd);
+
+  // when
+  transporter->setFakeReadBuffer("*3\r\n$1\r\na\r\n$1\r", false);
+  transporter->readyRead();
+  transporter->setFakeReadBuffer("\nb\r\n$1\r\nc\r\n", false);
+  transporter->readyRead();
+
+  // then
+  QCOMPARE(elements, QList<QByteArray>() << "a"
+                                         << "b"
+                                         << "c");
+  QCOMPARE(cmd.getDeferred().future().result().value().toLongLong(), 3LL);
+}
+
+void TestTransporters::coalesceWrites_data() {
+  QTest::addColumn<uint>("maxBytes");
+  QTest::addColumn<uint>("maxCommands");
+  QTest::addColumn<int>("expectedBatches");
+
+  QTest::newRow("Single batch") << 64u * 1024u << 1000u << 1;
+  QTest::newRow("Limited by commands count") << 64u * 1024u << 4u << 3;
+  QTest::newRow("Limited by bytes") << 1u << 1000u << 10;
+}
+
+void TestTransporters::coalesceWrites() {
+  // given
+  QFETCH(uint, maxBytes);
+  QFETCH(uint, maxCommands);
+  QFETCH(int, expectedBatches);
+
+  RedisClient::ConnectionConfig config = getDummyConfig();
+  config.setWriteBatchLimits(maxBytes, maxCommands);
+
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(config));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+  transporter->setWriteBatchingEnabled(true);
+
+  QList<RedisClient::Command> commands;
+  QByteArray expectedPayload;
+  for (int i = 0; i < 10; ++i) {
+    RedisClient::Command cmd({"GET", QString("key:%1").arg(i).toLatin1()});
+    expectedPayload.append(cmd.getByteRepresentation());
+    commands.append(cmd);
+  }
+
+  // when
+  transporter->addCommands(commands);
+
+  // then
+  QTRY_COMPARE(transporter->flushCalls, expectedBatches);
+
+  QByteArray written;
+  for (const QByteArray& buf : transporter->writtenBuffers) written.append(buf);
+
+  QCOMPARE(written, expectedPayload);
+
+  auto stats = transporter->writeBatchStats();
+  QCOMPARE(stats.batches, quint64(expectedBatches));
+  QCOMPARE(stats.commands, quint64(10));
+  QCOMPARE(stats.bytes, quint64(expectedPayload.size()));
+}
+
+void TestTransporters::skipRedundantSelect() {
+  // given
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(getDummyConfig()));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+  transporter->setWriteBatchingEnabled(true);
+
+  // when
+  transporter->addCommands({RedisClient::Command({"GET", "a"}, 3)});
+  transporter->addCommands({RedisClient::Command({"GET", "b"}, 3)});
+  transporter->addCommands({RedisClient::Command({"GET", "c"}, 0)});
+  transporter->addCommands({RedisClient::Command({"GET", "d"}, 0)});
+
+  // then
+  QStringList executed;
+  for (auto cmd : transporter->executedCommands)
+    executed.append(cmd.getRawString());
+
+  QCOMPARE(executed, QStringList() << "SELECT 3"
+                                   << "GET a"
+                                   << "GET b"
+                                   << "SELECT 0"
+                                   << "GET c"
+                                   << "GET d");
+}
+
+void TestTransporters::groupPipelinedCommandsByDb() {
+  // given
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(getDummyConfig()));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+  transporter->setWriteBatchingEnabled(true);
+
+  // when
+  transporter->addCommands({RedisClient::Command({"GET", "a"}, 1),
+                            RedisClient::Command({"GET", "b"}, 2),
+                            RedisClient::Command({"GET", "c"}, 1),
+                            RedisClient::Command({"GET", "d"}, 0),
+                            RedisClient::Command({"PING"}),
+                            RedisClient::Command({"GET", "e"}, 2)});
+
+  // then
+  QStringList executed;
+  for (auto cmd : transporter->executedCommands)
+    executed.append(cmd.getRawString());
+
+  QCOMPARE(executed, QStringList() << "GET d"
+                                   << "SELECT 1"
+                                   << "GET a"
+                                   << "GET c"
+                                   << "SELECT 2"
+                                   << "GET b"
+                                   << "PING"
+                                   << "GET e");
+}
+
+void TestTransporters::assignSharedThreadsByLoad() {
+  // given
+  RedisClient::TransporterThreadPool &pool =
+      RedisClient::TransporterThreadPool::instance();
+  int maxThreads = pool.maxThreads();
+  pool.setMaxThreads(2);
+
+  // when
+  QSharedPointer<QThread> first = pool.acquire();
+  QSharedPointer<QThread> second = pool.acquire();
+  QSharedPointer<QThread> third = pool.acquire();
+
+  // then
+  QCOMPARE(pool.threadsCount(), 2);
+  QCOMPARE(pool.connectionsCount(), 3);
+  QVERIFY(first != second);
+  QVERIFY(first->isRunning() && second->isRunning());
+  QCOMPARE(third, first);
+
+  // when
+  pool.release(second);
+  QSharedPointer<QThread> fourth = pool.acquire();
+
+  // then
+  QVERIFY(!second->isRunning());
+  QCOMPARE(pool.threadsCount(), 2);
+  QVERIFY(fourth != first);
+
+  pool.release(first);
+  pool.release(third);
+  pool.release(fourth);
+  pool.setMaxThreads(maxThreads);
+
+  QCOMPARE(pool.threadsCount(), 0);
+  QVERIFY(!first->isRunning());
+}
+
+void TestTransporters::submitCommandsFromManyThreads() {
+  // given
+  const int threadsCount = 4;
+  const int commandsPerThread = 250;
+
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(getDummyConfig()));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+  transporter->setWriteBatchingEnabled(true);
+
+  // when
+  std::vector<std::thread> producers;
+
+  for (int t = 0; t < threadsCount; ++t) {
+    producers.emplace_back([transporter, t]() {
+      for (int i = 0; i < commandsPerThread; ++i)
+        transporter->submitCommand(RedisClient::Command(
+            {"SET", QByteArray::number(t), QByteArray::number(i)}));
+    });
+  }
+
+  for (auto &p : producers) p.join();
+
+  // then
+  QTRY_COMPARE(transporter->executedCommands.size(),
+               threadsCount * commandsPerThread);
+
+  // Commands of each producer are executed in submission order
+  QVector<int> lastValue(threadsCount, -1);
+
+  for (auto cmd : transporter->executedCommands) {
+    int t = cmd.getPartAsString(1).toInt();
+    int i = cmd.getPartAsString(2).toInt();
+    QCOMPARE(i, lastValue[t] + 1);
+    lastValue[t] = i;
+  }
+}
+
+void TestTransporters::dispatchResponsesToOwnerThread() {
+  // given
+  QObject owner;
+  QScopedPointer<QObject> destroyedOwner(new QObject);
+  QThread *callbackThread = nullptr;
+  int callbackCalls = 0;
+  int destroyedOwnerCalls = 0;
+
+  RedisClient::Command cmd({"PING"}, &owner,
+                           [&](RedisClient::Response, QString) {
+                             callbackThread = QThread::currentThread();
+                             callbackCalls++;
+                           });
+  RedisClient::Command canceledCmd(
+      {"PING"}, destroyedOwner.data(),
+      [&](RedisClient::Response, QString) { destroyedOwnerCalls++; });
+
+  // when
+  std::thread transporterThread([cmd, canceledCmd]() {
+    RedisClient::ResponseDispatcher::dispatch(cmd, RedisClient::Response());
+    RedisClient::ResponseDispatcher::dispatch(canceledCmd,
+                                              RedisClient::Response());
+  });
+  transporterThread.join();
+  destroyedOwner.reset();
+
+  // then
+  QTRY_COMPARE(callbackCalls, 1);
+  QCOMPARE(callbackThread, owner.thread());
+  QCOMPARE(destroyedOwnerCalls, 0);
+
+  // when owner lives in current thread callback is called directly
+  RedisClient::ResponseDispatcher::dispatch(cmd, RedisClient::Response());
+
+  // then
+  QCOMPARE(callbackCalls, 2);
+}
+
+void TestTransporters::dispatchToRestartedOwnerThread() {
+  // given
+  QThread ownerThread;
+  QObject owner;
+  owner.moveToThread(&ownerThread);
+  QAtomicInt callbackCalls(0);
+
+  RedisClient::Command cmd({"PING"}, &owner,
+                           [&callbackCalls](RedisClient::Response, QString) {
+                             callbackCalls.ref();
+                           });
+
+  for (int run = 1; run <= 2; ++run) {
+    // when
+    ownerThread.start();
+    RedisClient::ResponseDispatcher::dispatch(cmd, RedisClient::Response());
+
+    // then
+    QTRY_COMPARE(callbackCalls.loadAcquire(), run);
+
+    // when dispatcher of finished thread is deleted
+    ownerThread.quit();
+    QVERIFY(ownerThread.wait(5000));
+    RedisClient::ResponseDispatcher::dispatch(cmd, RedisClient::Response());
+
+    // then response is dropped
+    QCOMPARE(callbackCalls.loadAcquire(), run);
+  }
+}
+
+void TestTransporters::dispatchPubSubMessages() {
+  // given
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(getDummyConfig()));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+
+  QObject owner;
+  QList<RedisClient::Response> channelMessages;
+  QList<RedisClient::Response> patternMessages;
+
+  // Channel and pattern with the same name are indexed separately
+  transporter->addRunningCommand(RedisClient::Command(
+      {"SUBSCRIBE", "news"}, &owner,
+      [&channelMessages](RedisClient::Response r, QString) {
+        channelMessages.append(r);
+      }));
+  transporter->addRunningCommand(RedisClient::Command(
+      {"PSUBSCRIBE", "news"}, &owner,
+      [&patternMessages](RedisClient::Response r, QString) {
+        patternMessages.append(r);
+      }));
+
+  // when
+  transporter->setFakeReadBuffer(
+      "*3\r\n$9\r\nsubscribe\r\n$4\r\nnews\r\n:1\r\n"
+      "*3\r\n$10\r\npsubscribe\r\n$4\r\nnews\r\n:2\r\n"
+      "*3\r\n$7\r\nmessage\r\n$4\r\nnews\r\n$2\r\nhi\r\n"
+      "*4\r\n$8\r\npmessage\r\n$4\r\nnews\r\n"
+      "$4\r\nnews\r\n$5\r\nhello\r\n"
+      "*3\r\n$7\r\nmessage\r\n$5\r\nother\r\n$2\r\nhi\r\n",
+      false);
+  transporter->readyRead();
+
+  // then
+  QCOMPARE(channelMessages.size(), 2);
+  QCOMPARE(channelMessages.last().getChannel(), QByteArray("news"));
+  QCOMPARE(channelMessages.last().getPayload(), QByteArray("hi"));
+
+  QCOMPARE(patternMessages.size(), 2);
+  QCOMPARE(patternMessages.last().getPattern(), QByteArray("news"));
+  QCOMPARE(patternMessages.last().getChannel(), QByteArray("news"));
+  QCOMPARE(patternMessages.last().getPayload(), QByteArray("hello"));
+}
+
+void TestTransporters::dropMessagesAfterLastSubscriberLeft() {
+  // given
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(getDummyConfig()));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+
+  QObject subscriber;
+  QObject owner;
+  QList<QByteArray> replies;
+  auto callback = [&replies](RedisClient::Response r, QString) {
+    replies.append(r.value().toByteArray());
+  };
+
+  transporter->addRunningCommand(RedisClient::Command(
+      {"SUBSCRIBE", "news"}, &subscriber,
+      [](RedisClient::Response, QString) {}));
+  transporter->setFakeReadBuffer(
+      "*3\r\n$9\r\nsubscribe\r\n$4\r\nnews\r\n:1\r\n", false);
+  transporter->readyRead();
+
+  // when
+  transporter->RedisClient::AbstractTransporter::cancelCommands(&subscriber);
+
+  transporter->addRunningCommand(
+      RedisClient::Command({"UNSUBSCRIBE", "news"}, &owner, callback));
+  transporter->addRunningCommand(
+      RedisClient::Command({"GET", "foo"}, &owner, callback));
+
+  // Message is still delivered before server processes UNSUBSCRIBE
+  transporter->setFakeReadBuffer(
+      "*3\r\n$7\r\nmessage\r\n$4\r\nnews\r\n$2\r\nhi\r\n"
+      "*3\r\n$11\r\nunsubscribe\r\n$4\r\nnews\r\n:0\r\n"
+      "$3\r\nbar\r\n",
+      false);
+  transporter->readyRead();
+
+  // then
+  QCOMPARE(transporter->addCommandCalls, 1);  // UNSUBSCRIBE news
+  QCOMPARE(replies.size(), 2);
+  QCOMPARE(replies.last(), QByteArray("bar"));
+}
+
+void TestTransporters::boundedSubscriberQueue_data() {
+  typedef RedisClient::ConnectionConfig::SubscriberOverflowPolicy Policy;
+
+  QTest::addColumn<int>("policy");
+  QTest::addColumn<QByteArray>("expectedMessages");
+  QTest::addColumn<quint64>("expectedDropped");
+  QTest::addColumn<bool>("expectedPause");
+
+  QTest::newRow("Drop oldest")
+      << static_cast<int>(Policy::DropOldest) << QByteArray("23")
+      << quint64(1) << false;
+  QTest::newRow("Drop newest")
+      << static_cast<int>(Policy::DropNewest) << QByteArray("12")
+      << quint64(1) << false;
+  QTest::newRow("Pause reading")
+      << static_cast<int>(Policy::PauseReading) << QByteArray("123")
+      << quint64(0) << true;
+}
+
+void TestTransporters::boundedSubscriberQueue() {
+  // given
+  QFETCH(int, policy);
+  QFETCH(QByteArray, expectedMessages);
+  QFETCH(quint64, expectedDropped);
+  QFETCH(bool, expectedPause);
+
+  QSharedPointer<RedisClient::SubscriberQueue::Counters> counters(
+      new RedisClient::SubscriberQueue::Counters());
+  QList<bool> pauseCalls;
+
+  RedisClient::SubscriberQueue queue(
+      2,
+      static_cast<RedisClient::ConnectionConfig::SubscriberOverflowPolicy>(
+          policy),
+      counters, [&pauseCalls](bool paused) { pauseCalls.append(paused); });
+
+  // when
+  QList<bool> scheduled;
+  for (QByteArray message : QList<QByteArray>() << "1" << "2" << "3") {
+    scheduled.append(queue.push(
+        RedisClient::Response(RedisClient::Response::String, message)));
+  }
+
+  // then
+  QCOMPARE(scheduled.count(true), 1);
+  QCOMPARE(queue.dropped(), expectedDropped);
+  QCOMPARE(counters->depth.loadAcquire(), qint64(expectedMessages.size()));
+  QCOMPARE(queue.isPaused(), expectedPause);
+
+  QByteArray actualMessages;
+  for (const RedisClient::Response &r : queue.takeBatch())
+    actualMessages.append(r.asBytes());
+
+  QCOMPARE(actualMessages, expectedMessages);
+  QCOMPARE(counters->depth.loadAcquire(), qint64(0));
+  QCOMPARE(queue.isPaused(), false);
+  QCOMPARE(pauseCalls,
+           expectedPause ? QList<bool>() << true << false : QList<bool>());
+}
+
+void TestTransporters::deliverMessagesInBatches() {
+  // given
+  QObject owner;
+  QList<int> batchSizes;
+
+  RedisClient::Command cmd({"SUBSCRIBE", "news"});
+  cmd.setCallBack(&owner, [](RedisClient::Response, QString) {});
+  cmd.setMessageBatchCallback(
+      [&batchSizes](const QVector<RedisClient::Response> &batch) {
+        batchSizes.append(batch.size());
+      });
+
+  QSharedPointer<RedisClient::SubscriberQueue> queue(
+      new RedisClient::SubscriberQueue(
+          100, RedisClient::ConnectionConfig::SubscriberOverflowPolicy::
+                   DropOldest));
+
+  // when
+  std::thread transporterThread([cmd, queue]() {
+    for (int i = 0; i < 10; ++i) {
+      if (queue->push(RedisClient::Response(RedisClient::Response::String,
+                                            QByteArray::number(i))))
+        RedisClient::ResponseDispatcher::dispatchMessages(cmd, queue);
+    }
+  });
+  transporterThread.join();
+
+  // then
+  QTRY_COMPARE(batchSizes, QList<int>() << 10);
+}
+
+void TestTransporters::queueWaitStatsByPriority() {
+  // given
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(getDummyConfig()));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+  transporter->setWriteBatchingEnabled(true);
+
+  // when
+  transporter->addCommands(QList<RedisClient::Command>()
+                           << RedisClient::Command({"GET", "a"})
+                           << RedisClient::Command({"GET", "b"})
+                           << RedisClient::Command({"KEYS", "*"}));
+
+  // then
+  QTRY_COMPARE(transporter->executedCommands.size(), 3);
+
+  auto normal =
+      transporter->queueWaitStats(RedisClient::Command::Priority::Normal);
+  auto bulk = transporter->queueWaitStats(RedisClient::Command::Priority::Bulk);
+  auto high = transporter->queueWaitStats(RedisClient::Command::Priority::High);
+
+  QCOMPARE(normal.commands, quint64(2));
+  QCOMPARE(bulk.commands, quint64(1));
+  QCOMPARE(high.commands, quint64(0));
+  QVERIFY(normal.maxWait * 2 >= normal.totalWait);
+}
+
+void TestTransporters::failOnlyExpiredCommand() {
+  // given
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(getDummyConfig()));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+  transporter->setWriteBatchingEnabled(true);
+
+  QObject owner;
+  QStringList blpopErrors;
+  int blpopCalls = 0;
+  QByteArray getResult;
+
+  RedisClient::Command blpop({"BLPOP", "list", "0"});
+  blpop.setTimeout(50);
+  blpop.setCallBack(&owner, [&blpopErrors, &blpopCalls](
+                                RedisClient::Response, QString err) {
+    blpopCalls++;
+    blpopErrors.append(err);
+  });
+
+  RedisClient::Command get({"GET", "key"});
+  get.setCallBack(&owner, [&getResult](RedisClient::Response r, QString) {
+    getResult = r.value().toByteArray();
+  });
+
+  // when
+  transporter->addCommands(QList<RedisClient::Command>() << blpop << get);
+  QTRY_COMPARE(blpopCalls, 1);
+
+  transporter->setFakeReadBuffer("*-1\r\n$5\r\nvalue\r\n", false);
+  transporter->readyRead();
+
+  // then
+  QByteArray written;
+  for (const QByteArray& buf : transporter->writtenBuffers) written.append(buf);
+
+  // Server-side timeout is limited by deadline
+  QVERIFY(written.startsWith(
+      "*3\r\n$5\r\nBLPOP\r\n$4\r\nlist\r\n$1\r\n1\r\n"));
+  QCOMPARE(blpopErrors, QStringList() << "Execution timeout");
+  QCOMPARE(blpopCalls, 1);
+  QVERIFY(blpop.getDeferred().future().isCanceled());
+  QCOMPARE(getResult, QByteArray("value"));
+}
+
+void TestTransporters::reuseSslSessionOfSameHost() {
+  // given
+  RedisClient::SslContextCache& cache = RedisClient::SslContextCache::instance();
+  cache.clear();
+
+  RedisClient::ConnectionConfig config("redis.example.com", "", 6380);
+  RedisClient::ConnectionConfig otherHost("redis2.example.com", "", 6380);
+  RedisClient::ConnectionConfig otherIdentity("redis.example.com", "", 6380);
+  otherIdentity.setSslLocalCertPath("other-client.pem");
+
+  QSslConfiguration established;
+  established.setSessionTicket("session-ticket");
+
+  // when
+  cache.storeSession(config, established);
+
+  // then
+  QCOMPARE(cache.configuration(config).sessionTicket(),
+           QByteArray("session-ticket"));
+  QVERIFY(cache.configuration(otherHost).sessionTicket().isEmpty());
+  QVERIFY(cache.configuration(otherIdentity).sessionTicket().isEmpty());
+  QCOMPARE(cache.configuration(config).testSslOption(
+               QSsl::SslOptionDisableSessionPersistence),
+           false);
+
+  cache.clear();
+}
+
+void TestTransporters::rejectCommandsWhenQueueIsFull() {
+  // given
+  RedisClient::ConnectionConfig config = getDummyConfig();
+  config.setCommandQueueLimits(
+      2, 0, RedisClient::ConnectionConfig::QueueOverflowPolicy::Fail);
+
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(config));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+  transporter->setWriteBatchingEnabled(true);
+
+  RedisClient::Command rejected({"GET", "c"});
+
+  // when
+  transporter->submitCommand(RedisClient::Command({"GET", "a"}));
+  transporter->submitCommand(RedisClient::Command({"GET", "b"}));
+  transporter->submitCommand(rejected);
+
+  // then
+  QVERIFY(rejected.getDeferred().future().isCanceled());
+  QCOMPARE(transporter->commandQueueStats().commands, 2);
+  QVERIFY(transporter->commandQueueStats().underPressure);
+
+  QTRY_COMPARE(transporter->executedCommands.size(), 2);
+  QCOMPARE(transporter->commandQueueStats().commands, 0);
+  QVERIFY(!transporter->commandQueueStats().underPressure);
+  QCOMPARE(connection->metrics().rejectedCommands, quint64(1));
+}
+
+void TestTransporters::shedLowestPriorityCommands() {
+  // given
+  RedisClient::ConnectionConfig config = getDummyConfig();
+  config.setCommandQueueLimits(
+      2, 0,
+      RedisClient::ConnectionConfig::QueueOverflowPolicy::ShedLowestPriority);
+
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(config));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+  transporter->setWriteBatchingEnabled(true);
+
+  RedisClient::Command bulk({"KEYS", "*"});
+
+  // when
+  transporter->submitCommand(bulk);
+  transporter->submitCommand(RedisClient::Command({"GET", "a"}));
+  transporter->submitCommand(RedisClient::Command({"GET", "b"}));
+
+  // then
+  QTRY_COMPARE(transporter->executedCommands.size(), 2);
+  QVERIFY(bulk.getDeferred().future().isCanceled());
+  QCOMPARE(transporter->executedCommands.first().getPartAsString(1),
+           QString("a"));
+  QCOMPARE(connection->metrics().shedCommands, quint64(1));
+}
+
+void TestTransporters::abortConnectOnTimeout() {
+  if (!QSslSocket::supportsSsl()) QSKIP("OpenSSL is not available");
+
+  // given
+  // TCP connection is accepted by OS, TLS handshake is never answered
+  QTcpServer server;
+  QVERIFY(server.listen(QHostAddress::LocalHost));
+
+  RedisClient::ConnectionConfig config("127.0.0.1", "", server.serverPort(),
+                                       "timeout");
+  config.setTimeouts(200, 2000);
+  config.setSsl(true);
+  RedisClient::Connection connection(config);
+  QElapsedTimer elapsed;
+  elapsed.start();
+
+  // when
+  bool connected = connection.connect(true);
+
+  // then
+  QCOMPARE(connected, false);
+  QVERIFY(elapsed.elapsed() >= 200);
+
+  // Socket of timed out attempt is aborted
+  QVERIFY(server.waitForNewConnection(1000));
+  QTcpSocket* client = server.nextPendingConnection();
+  QVERIFY(client);
+  QVERIFY(client->state() == QAbstractSocket::UnconnectedState ||
+          client->waitForDisconnected(1000));
+}
+
+void TestTransporters::reconnectDelaySchedule_data() {
+  QTest::addColumn<uint>("minDelay");
+  QTest::addColumn<uint>("maxDelay");
+  QTest::addColumn<uint>("attempt");
+  QTest::addColumn<uint>("fullDelay");
+
+  QTest::newRow("first attempt") << 100u << 1000u << 0u << 100u;
+  QTest::newRow("doubled") << 100u << 1000u << 1u << 200u;
+  QTest::newRow("doubled twice") << 100u << 1000u << 2u << 400u;
+  QTest::newRow("capped") << 100u << 1000u << 4u << 1000u;
+  QTest::newRow("many attempts") << 100u << 1000u << 100u << 1000u;
+  QTest::newRow("max below min") << 500u << 100u << 3u << 500u;
+}
+
+void TestTransporters::reconnectDelaySchedule() {
+  QFETCH(uint, minDelay);
+  QFETCH(uint, maxDelay);
+  QFETCH(uint, attempt);
+  QFETCH(uint, fullDelay);
+
+  for (int i = 0; i < 100; ++i) {
+    // when
+    uint delay = DummyTransporter::reconnectDelay(minDelay, maxDelay, attempt);
+
+    // then
+    // Half of delay is random
+    QVERIFY(delay >= fullDelay - fullDelay / 2);
+    QVERIFY(delay <= fullDelay);
+  }
+}
+
+void TestTransporters::failoverReplaysOnlyAllowedCommands() {
+  // given
+  RedisClient::ConnectionConfig config = getDummyConfig();
+  config.setReplayPolicy(
+      RedisClient::ConnectionConfig::ReplayPolicy::ReadOnly);
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(config));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+
+  QObject owner;
+  QStringList incrErrors;
+  RedisClient::Command incr(
+      {"INCR", "counter"}, &owner,
+      [&incrErrors](RedisClient::Response, QString err) {
+        incrErrors.append(err);
+      });
+  RedisClient::Command get({"GET", "key"});
+  transporter->addRunningCommand(incr);
+  transporter->addRunningCommand(get);
+
+  // when
+  // sentinel reported +switch-master
+  QMetaObject::invokeMethod(transporter.data(), "reconnectTo",
+                            Qt::DirectConnection,
+                            Q_ARG(QString, "10.0.0.2"), Q_ARG(int, 6380));
+
+  // then
+  // INCR may be applied by old master already
+  QCOMPARE(incrErrors, QStringList() << "Connection was interrupted");
+  QVERIFY(incr.getDeferred().future().isCanceled());
+  QCOMPARE(transporter->queuedCommands().size(), 1);
+  QCOMPARE(transporter->queuedCommands().first().getRawString(),
+           QByteArray("GET key"));
+  QCOMPARE(connection->getConfig().host(), QString("10.0.0.2"));
+}
+
+void TestTransporters::failDroppedCommandsOnDisconnect() {
+  // given
+  QSharedPointer<RedisClient::Connection> connection(
+      new RedisClient::Connection(getDummyConfig()));
+  QSharedPointer<DummyTransporter> transporter(
+      new DummyTransporter(connection.data()));
+
+  QObject owner;
+  QStringList errors;
+  auto callback = [&errors](RedisClient::Response, QString err) {
+    errors.append(err);
+  };
+  RedisClient::Command running({"GET", "running"}, &owner, callback);
+  RedisClient::Command queued({"GET", "queued"}, &owner, callback);
+  transporter->addRunningCommand(running);
+  transporter->addCommand(queued);
+
+  // when
+  transporter->disconnectFromHost();
+
+  // then
+  QCOMPARE(errors, QStringList() << "Connection was closed"
+                                 << "Connection was closed");
+  QVERIFY(running.getDeferred().future().isCanceled());
+  QVERIFY(queued.getDeferred().future().isCanceled());
+  QCOMPARE(transporter->queuedCommands().size(), 0);
+}
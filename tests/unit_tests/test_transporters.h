@@ -8,4 +8,29 @@ class TestTransporters : public BaseTestCase {
 
  private slots:
   void readPartialResponses();
+  void streamBulkReply();
+  void streamArrayReply();
+  void coalesceWrites();
+  void coalesceWrites_data();
+  void skipRedundantSelect();
+  void groupPipelinedCommandsByDb();
+  void assignSharedThreadsByLoad();
+  void submitCommandsFromManyThreads();
+  void dispatchResponsesToOwnerThread();
+  void dispatchToRestartedOwnerThread();
+  void dispatchPubSubMessages();
+  void dropMessagesAfterLastSubscriberLeft();
+  void boundedSubscriberQueue();
+  void boundedSubscriberQueue_data();
+  void deliverMessagesInBatches();
+  void queueWaitStatsByPriority();
+  void failOnlyExpiredCommand();
+  void reuseSslSessionOfSameHost();
+  void rejectCommandsWhenQueueIsFull();
+  void shedLowestPriorityCommands();
+  void abortConnectOnTimeout();
+  void reconnectDelaySchedule();
+  void reconnectDelaySchedule_data();
+  void failoverReplaysOnlyAllowedCommands();
+  void failDroppedCommandsOnDisconnect();
 };
@@ -0,0 +1,152 @@
+#include "test_valuereader.h"
+#include <QTest>
+#include "mocks/dummyconnection.h"
+#include "qredisclient/valuereader.h"
+
+using RedisClient::ValueReader;
+
+namespace {
+struct PageResult {
+  PageResult() : final(false), calls(0) {}
+
+  ValueReader::Page page;
+  QString err;
+  bool final;
+  int calls;
+};
+
+// Commands sent from callbacks are recorded by DummyConnection first
+QList<QByteArray> executedCommands(const DummyConnection &connection) {
+  QList<QByteArray> result;
+
+  for (const RedisClient::Command &cmd : connection.executedCommands)
+    result.append(cmd.getRawString());
+
+  return result;
+}
+
+ValueReader::PageCallback collectPage(PageResult &result) {
+  return [&result](const ValueReader::Page &page, const QString &err,
+                   bool final) {
+    result.page = page;
+    result.err = err;
+    result.final = final;
+    result.calls++;
+  };
+}
+}  // namespace
+
+void TestValueReader::readSortedSetInRanges() {
+  // given
+  DummyConnection connection;
+  connection.setFakeResponses(
+      QStringList() << ":3\r\n"
+                    << ":300000\r\n"
+                    << "*4\r\n$1\r\na\r\n$1\r\n1\r\n$1\r\nb\r\n$3\r\n2.5\r\n"
+                    << "*2\r\n$1\r\nc\r\n$1\r\n3\r\n");
+  ValueReader::Options options;
+  options.targetPageBytes = 200000;
+  options.minPageSize = 1;
+  ValueReader reader(&connection, "zset", ValueReader::Type::ZSet, options);
+  PageResult first, second;
+
+  // when
+  reader.next(collectPage(first));
+  reader.next(collectPage(second));
+
+  // then - page size is estimated from MEMORY USAGE and ZCARD
+  QCOMPARE(reader.length(), 3ll);
+  QCOMPARE(reader.pageSize(), 2u);
+  QList<QByteArray> commands = executedCommands(connection);
+  QCOMPARE(commands.size(), 4);
+  QVERIFY(commands.contains("ZCARD zset"));
+  QVERIFY(commands.contains("MEMORY USAGE zset SAMPLES 5"));
+  QVERIFY(commands.contains("ZRANGE zset 0 1 WITHSCORES"));
+  QVERIFY(commands.contains("ZRANGE zset 2 3 WITHSCORES"));
+
+  QCOMPARE(first.page.scored.size(), 2);
+  QCOMPARE(first.page.scored.at(1).first, QByteArray("b"));
+  QCOMPARE(first.page.scored.at(1).second, 2.5);
+  QCOMPARE(first.final, false);
+  QCOMPARE(second.page.offset, 2ll);
+  QCOMPARE(second.page.scored.size(), 1);
+  QCOMPARE(second.final, true);
+  QVERIFY(!reader.hasNext());
+}
+
+void TestValueReader::readHashPages() {
+  // given
+  DummyConnection connection;
+  connection.setFakeResponses(
+      QStringList() << "*2\r\n$1\r\n0\r\n*4\r\n"
+                       "$2\r\nf1\r\n$2\r\nv1\r\n$2\r\nf2\r\n$2\r\nv2\r\n");
+  ValueReader::Options options;
+  options.targetPageBytes = 0;
+  options.pageSize = 100;
+  ValueReader reader(&connection, "hash", ValueReader::Type::Hash, options);
+  PageResult result;
+
+  // when
+  reader.next(collectPage(result));
+
+  // then
+  QCOMPARE(connection.executedCommands.size(), 1);
+  QCOMPARE(connection.executedCommands.first().getRawString(),
+           QByteArray("HSCAN hash 0 COUNT 100"));
+  QCOMPARE(result.page.fields.size(), 2);
+  QCOMPARE(result.page.fields.at(1),
+           ValueReader::FieldValue("f2", "v2"));
+  QCOMPARE(result.final, true);
+}
+
+void TestValueReader::readStreamAfterLastId() {
+  // given
+  DummyConnection connection;
+  connection.setFakeResponses(
+      QStringList()
+      << "*1\r\n*2\r\n$3\r\n1-1\r\n*2\r\n$1\r\nf\r\n$1\r\nv\r\n"
+      << "*0\r\n");
+  ValueReader::Options options;
+  options.targetPageBytes = 0;
+  options.pageSize = 1;
+  options.minPageSize = 1;
+  ValueReader reader(&connection, "stream", ValueReader::Type::Stream,
+                     options);
+  PageResult first, second;
+
+  // when
+  reader.next(collectPage(first));
+  reader.next(collectPage(second));
+
+  // then
+  QList<QByteArray> commands = executedCommands(connection);
+  QCOMPARE(commands.size(), 2);
+  QVERIFY(commands.contains("XRANGE stream - + COUNT 1"));
+  QVERIFY(commands.contains("XRANGE stream 1-2 + COUNT 1"));
+  QCOMPARE(first.page.entries.size(), 1);
+  QCOMPARE(first.page.entries.first().id, QByteArray("1-1"));
+  QCOMPARE(first.page.entries.first().fields.first(),
+           ValueReader::FieldValue("f", "v"));
+  QCOMPARE(first.final, false);
+  QVERIFY(second.page.isEmpty());
+  QCOMPARE(second.final, true);
+}
+
+void TestValueReader::readEmptyKey() {
+  // given
+  DummyConnection connection;
+  connection.setFakeResponses(QStringList() << ":0\r\n"
+                                            << "-ERR unknown command\r\n");
+  ValueReader reader(&connection, "list", ValueReader::Type::List);
+  PageResult result;
+
+  // when
+  reader.next(collectPage(result));
+
+  // then - range isn't requested, missing MEMORY USAGE is not an error
+  QCOMPARE(connection.executedCommands.size(), 2);
+  QCOMPARE(result.calls, 1);
+  QCOMPARE(result.err, QString());
+  QVERIFY(result.page.isEmpty());
+  QCOMPARE(result.final, true);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QObject>
+#include <QtCore>
+
+class TestValueReader : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void readSortedSetInRanges();
+  void readHashPages();
+  void readStreamAfterLastId();
+  void readEmptyKey();
+};
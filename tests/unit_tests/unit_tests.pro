@@ -6,6 +6,14 @@ TEMPLATE = app
 CONFIG += debug c++11
 CONFIG-=app_bundle   
 
+# qmake CONFIG+=coroutines - build as C++20 to compile and run coroutine tests
+coroutines {
+    CONFIG -= c++11
+    CONFIG += c++2a
+    *-g++*: QMAKE_CXXFLAGS += -fcoroutines
+    DEFINES += QREDISCLIENT_REQUIRE_COROUTINES
+}
+
 PROJECT_ROOT = $$PWD/../..//
 SRC_DIR = $$PROJECT_ROOT/src//
 